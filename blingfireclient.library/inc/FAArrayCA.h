@@ -8,6 +8,7 @@
 #define _FA_ARRAYCA_H_
 
 #include "FAConfig.h"
+#include "FASecurity.h"
 
 ///
 /// This is a common interface for packed read-only arrays.
@@ -20,6 +21,13 @@ public:
     virtual const int GetAt (const int Idx) const = 0;
     /// returns number of elementes in the array
     virtual const int GetCount () const = 0;
+    /// copies values From..From+Count-1 into pOut, values out of 0..Count-1
+    /// are not copied, returns the number of values copied
+    virtual const int GetRange (
+            const int From,
+            const int Count,
+            __out_ecount(Count) int * pOut
+        ) const = 0;
 };
 
 #endif
@@ -29,6 +29,13 @@ public:
     const int GetAt (const int Idx) const;
     /// returns number of elementes in the array
     const int GetCount () const;
+    /// copies values From..From+Count-1 into pOut, returns the number of
+    /// values copied, decodes the values in blocks rather than one by one
+    const int GetRange (
+            const int From,
+            const int Count,
+            __out_ecount(Count) int * pOut
+        ) const;
 
 private:
     /// header
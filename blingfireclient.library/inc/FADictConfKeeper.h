@@ -54,6 +54,8 @@ public:
     const bool GetNoTrUse () const;
     const int GetDirection () const;
     const FAMultiMapCA * GetCharMap () const;
+    /// returns the id of unknown words, -1 if not specified
+    const int GetUnkId () const;
 
 private:
     // input LDB
@@ -74,6 +76,7 @@ private:
     bool m_NoTrUse;
     int m_Direction;
     FAMultiMap_pack_fixed * m_pCharMap;
+    int m_UnkId;
 };
 
 #endif
@@ -21,9 +21,25 @@
 #include "FAUtf32Utils.h"
 #include "FASecurity.h"
 
+#include <atomic>
+
 ///
 /// Dictionary run-time interpreter.
 ///
+/// Notes:
+///
+/// 1. A delta dictionary can be attached with SetDelta, it is a small
+///    separately loaded dictionary which is checked first. The delta maps
+///    words into the InfoIds of the main dictionary (see fa_vocab2dfa
+///    --delta), so it can add words, move them to other InfoIds or remove
+///    them, words mapped into FAFsmConst::DICT_DELETED_ID are treated as
+///    removed. The Info is always taken from the main dictionary, the
+///    delta's own I2Info, if any, is not used.
+///
+/// 2. SetDelta can be called while other threads make lookups, the caller
+///    should keep the previous delta alive until these lookups are done,
+///    e.g. blingfiretokdll's SetModelDelta waits for its readers for that.
+///
 
 template < class Ty >
 class FADictInterpreter_t {
@@ -40,6 +56,9 @@ public:
             const FATransformCA_t < Ty > * pInTr
         );
 
+    /// sets up the delta dictionary (see the Notes above), NULL removes it
+    void SetDelta (const FADictInterpreter_t < Ty > * pDelta);
+
 public:
     /// Word -> InfoId, returns -1 if Word does not exist
     const int GetInfoId (
@@ -48,6 +67,7 @@ public:
         ) const;
 
     /// Word -> Info, returns output size or -1 if Word does not exist
+    /// or the dictionary has no I2Info map
     const int GetInfo (
             const Ty * pIn,
             const int InSize,
@@ -71,6 +91,8 @@ private:
     inline const int GetInfoId_mph (const Ty * pIn, const int InSize) const;
     // uses Moore to get info id (takes normalized word)
     inline const int GetInfoId_moore (const Ty * pIn, const int InSize) const;
+    // Word -> InfoId, without the delta
+    inline const int GetInfoId_base (const Ty * pIn, const int InSize) const;
 
 private:
     // returns object into initial state
@@ -106,6 +128,8 @@ private:
 
     /// charmap
     const FAMultiMapCA * m_pCharMap;
+    // delta dictionary or NULL, does not change on SetConf
+    std::atomic < const FADictInterpreter_t < Ty > * > m_pDelta;
 
     enum {
         DefDelta = FALimits::MaxWordLen,
@@ -126,7 +150,8 @@ FADictInterpreter_t< Ty >::FADictInterpreter_t () :
     m_IgnoreCase (false),
     m_NoNorm (false),
     m_Ready (false),
-    m_pCharMap (NULL)
+    m_pCharMap (NULL),
+    m_pDelta (NULL)
 {
 }
 
@@ -184,8 +209,9 @@ void FADictInterpreter_t< Ty >::SetConf (
     }
 
     m_pCharMap = pConf->GetCharMap ();
+    // I2Info is optional, it is not needed for Word -> InfoId lookups
+    // (e.g. vocabularies which map words into ids)
     m_pI2Info = pConf->GetI2Info ();
-    m_Ready = m_Ready && (NULL != m_pI2Info);
 
     m_Direction = pConf->GetDirection ();
     m_IgnoreCase = pConf->GetIgnoreCase ();
@@ -203,6 +229,15 @@ void FADictInterpreter_t< Ty >::SetConf (
 }
 
 
+template < class Ty >
+void FADictInterpreter_t< Ty >::
+    SetDelta (const FADictInterpreter_t < Ty > * pDelta)
+{
+    LogAssert (this != pDelta);
+    m_pDelta.store (pDelta, std::memory_order_release);
+}
+
+
 template < class Ty >
 inline const int FADictInterpreter_t< Ty >::
     Normalize (
@@ -328,8 +363,8 @@ inline const int FADictInterpreter_t< Ty >::
 
 
 template < class Ty >
-const int FADictInterpreter_t< Ty >::
-    GetInfoId (
+inline const int FADictInterpreter_t< Ty >::
+    GetInfoId_base (
         const Ty * pIn, 
         const int InSize
     ) const
@@ -366,6 +401,33 @@ const int FADictInterpreter_t< Ty >::
 }
 
 
+template < class Ty >
+const int FADictInterpreter_t< Ty >::
+    GetInfoId (
+        const Ty * pIn, 
+        const int InSize
+    ) const
+{
+    // the delta is read once per lookup
+    const FADictInterpreter_t < Ty > * pDelta = \
+        m_pDelta.load (std::memory_order_acquire);
+
+    if (pDelta) {
+
+        const int DeltaId = pDelta->GetInfoId_base (pIn, InSize);
+
+        if (FAFsmConst::DICT_DELETED_ID == DeltaId) {
+            return -1;
+        } else if (-1 != DeltaId) {
+            return DeltaId;
+        }
+    }
+
+    const int Id = FADictInterpreter_t::GetInfoId_base (pIn, InSize);
+    return Id;
+}
+
+
 template < class Ty >
 const int FADictInterpreter_t< Ty >::
     GetInfo (
@@ -375,9 +437,11 @@ const int FADictInterpreter_t< Ty >::
         const int MaxOutSize
     ) const
 {
-    DebugLogAssert (m_Ready);
-    DebugLogAssert (m_pI2Info);
+    if (!m_pI2Info) {
+        return -1;
+    }
 
+    // the delta maps words into the InfoIds of this dictionary
     const int Id = FADictInterpreter_t::GetInfoId (pIn, InSize);
 
     if (-1 == Id) {
@@ -398,9 +462,7 @@ const int FADictInterpreter_t< Ty >::
         const int MaxOutSize
     ) const
 {
-    DebugLogAssert (m_pI2Info);
-
-    if (!m_Ready) {
+    if (!m_Ready || !m_pI2Info) {
         return -1;
     }
 
@@ -412,12 +474,10 @@ const int FADictInterpreter_t< Ty >::
 template < class Ty >
 const int FADictInterpreter_t< Ty >::GetMaxInfoSize () const
 {
-    if (!m_Ready) {
+    if (!m_Ready || !m_pI2Info) {
         return -1;
     }
 
-    DebugLogAssert (m_pI2Info);
-
     const int MaxCount = m_pI2Info->GetMaxCount ();
     return MaxCount;
 }
@@ -77,6 +77,11 @@ public:
         DFA_DEAD_STATE = -2, // as -1 indicates the absence of transition
     };
 
+    // delta dictionary values
+    enum {
+        DICT_DELETED_ID = 0x00ffffff, // InfoId of the words deleted by delta
+    };
+
     /// types of digitizers
     enum {
         DIGITIZER_TEXT = 0,
@@ -182,6 +187,10 @@ public:
         FUNC_N2TP,     // by the given ngram returns tags and p(t|ng) values
         FUNC_LAD,      // Language Auto-Detection (LAD)
         FUNC_U2L,      // returns a set of languages and possibly scores for the given url
+        FUNC_WORDPIECE,// splits a word into WordPiece subword ids
+        FUNC_VOCAB,    // maps a word into its vocabulary id
+        FUNC_WRE_CASCADE,// ordered list of WRE parser stages
+        FUNC_MWE,      // maps token id sequences into phrase ids
         FUNC_COUNT,
     };
 
@@ -370,6 +379,7 @@ public:
     // defaults in packed representation
     enum {
         TRIV_PACK_DEF_DST_SIZE = 3, // default dst size for triv packed
+        TRIV_PACK_OW_FIRST = 0x100, // DstSize header flag, Ow follows the info byte
     };
 
     // LDB bin validation
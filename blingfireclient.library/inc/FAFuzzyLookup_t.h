@@ -0,0 +1,629 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_FUZZYLOOKUP_T_H_
+#define _FA_FUZZYLOOKUP_T_H_
+
+#include "FAConfig.h"
+#include "FAFsmConst.h"
+#include "FALimits.h"
+#include "FADictConfKeeper.h"
+#include "FAWordToProb_t.h"
+#include "FARSDfaCA.h"
+#include "FAMealyDfaCA.h"
+#include "FAState2OwCA.h"
+#include "FAArrayCA.h"
+#include "FAMultiMapCA.h"
+#include "FAArray_cont_t.h"
+#include "FAUtf32Utils.h"
+#include "FAUtils_cl.h"
+#include "FASecurity.h"
+
+#include <algorithm>
+
+class FAAllocatorA;
+
+///
+/// Finds all the dictionary words within the given Levenshtein distance
+/// from the input word.
+///
+/// The dictionary automaton is traversed in lock-step with the Levenshtein
+/// automaton of the input word, the state of the Levenshtein automaton is
+/// the band of the edit-distance matrix row of the width 2*MaxDist + 1, the
+/// traversal stops at the dictionary states where all the band values are
+/// bigger than MaxDist. Insertions, deletions and substitutions cost 1.
+///
+/// The dictionary is the same as for FADictInterpreter_t, either Moore or
+/// MPH Mealy automaton, the input word is normalized the same way except
+/// for the transformation. Words are returned normalized (e.g. lower-cased
+/// for the ignore-case dictionaries).
+///
+/// Results are sorted by the distance, then by the W2P score, if set up,
+/// and then by the InfoId, and only the MaxCount best are kept.
+///
+/// Usage notes:
+///
+/// 1. The object keeps the results of the last call, so the object cannot
+///    be shared among threads, the configuration objects can.
+///
+/// 2. The dictionary alphabet is enumerated at the states where an edit is
+///    still possible, so the lookup is meant for dictionaries with moderate
+///    alphabets, e.g. letters of one script.
+///
+
+template < class Ty >
+class FAFuzzyLookup_t {
+
+public:
+    FAFuzzyLookup_t (FAAllocatorA * pAlloc);
+
+public:
+    /// Note: this method expects initialized configuration object
+    void SetConf (const FADictConfKeeper * pConf);
+    /// sets up the word probability model for ranking, can be NULL
+    void SetW2P (FAWordToProb_t < Ty > * pW2P);
+
+    /// finds the words within MaxDist from the input word, keeps MaxCount
+    /// best, returns the number of results or -1 in case of an error
+    const int Process (
+            const Ty * pIn,
+            const int InSize,
+            const int MaxDist,
+            const int MaxCount
+        );
+
+    /// returns the result word, Num is from 0 to the Process return value - 1
+    const int GetWord (const int Num, const Ty ** ppWord) const;
+    /// returns the InfoId of the result word
+    const int GetId (const int Num) const;
+    /// returns the edit distance of the result word from the input word
+    const int GetDist (const int Num) const;
+    /// returns the W2P log prob of the result word, 0 if W2P is not set up
+    const float GetScore (const int Num) const;
+
+public:
+    enum {
+        MaxEditDist = 2,
+    };
+
+private:
+    // returns object into initial state
+    inline void Clear ();
+    // normalizes the input word, the same way as FADictInterpreter_t does
+    inline const int Normalize (const Ty * pIn, const int InSize);
+    // returns the band value of the row at the given depth
+    inline const int GetCell (const int Depth, const int Pos) const;
+    // calculates the row at Depth + 1 for the Iw, returns its minimum
+    inline const int CalcRow (const int Depth, const int Iw);
+    // sets up Iws to try at the given depth
+    inline void SetupIws (const int Depth, const int MinVal);
+    // adds the word at the given depth into results
+    inline void AddResult (const int Depth, const int Id, const int Dist);
+    // walks the dictionary
+    void Traverse ();
+    // sorts the results and keeps MaxCount best
+    void SortResults (const int MaxCount);
+
+private:
+    // dictionary
+    int m_FsmType;
+    const FARSDfaCA * m_pDfa;
+    const FAMealyDfaCA * m_pMealy;
+    const FAState2OwCA * m_pState2Ow;
+    const FAArrayCA * m_pK2I;
+    const FAMultiMapCA * m_pCharMap;
+    int m_Direction;
+    bool m_IgnoreCase;
+    bool m_Ready;
+    // ranking
+    FAWordToProb_t < Ty > * m_pW2P;
+    // the dictionary alphabet
+    FAArray_cont_t < int > m_iws;
+
+    enum {
+        MaxDepth = FALimits::MaxWordLen + MaxEditDist,
+        BandSize = (2 * MaxEditDist) + 1,
+        Inf = MaxEditDist + 1,
+    };
+
+    // normalized input word
+    int m_Word [FALimits::MaxWordLen];
+    int m_WordLen;
+    int m_MaxDist;
+    // the traversal stack, for each depth: state, Mealy Ow sum, band of the
+    // row, Iws to try and the next Iw position
+    int m_States [MaxDepth + 1];
+    int m_Sums [MaxDepth + 1];
+    int m_Rows [(MaxDepth + 1) * BandSize];
+    const int * m_pIws [MaxDepth + 1];
+    int m_IwCounts [MaxDepth + 1];
+    int m_IwPos [MaxDepth + 1];
+    int m_WordIws [(MaxDepth + 1) * BandSize];
+    // the current path
+    int m_Path [MaxDepth];
+
+    // results: Id, Dist, Score, word offset in m_chars, word length
+    FAArray_cont_t < int > m_ids;
+    FAArray_cont_t < int > m_dists;
+    FAArray_cont_t < float > m_scores;
+    FAArray_cont_t < int > m_offsets;
+    FAArray_cont_t < int > m_lens;
+    FAArray_cont_t < Ty > m_chars;
+    // result indices in the rank order
+    FAArray_cont_t < int > m_order;
+
+private:
+    // smaller distance, then bigger score, then smaller id
+    class _TResultCmp {
+    public:
+        _TResultCmp (
+                const int * pDists,
+                const float * pScores,
+                const int * pIds
+            ) :
+            m_pDists (pDists),
+            m_pScores (pScores),
+            m_pIds (pIds)
+        {}
+
+    public:
+        const bool operator() (const int i, const int j) const
+        {
+            if (m_pDists [i] != m_pDists [j]) {
+                return m_pDists [i] < m_pDists [j];
+            }
+            if (m_pScores [i] != m_pScores [j]) {
+                return m_pScores [i] > m_pScores [j];
+            }
+            if (m_pIds [i] != m_pIds [j]) {
+                return m_pIds [i] < m_pIds [j];
+            }
+            return i < j;
+        }
+
+    private:
+        const int * m_pDists;
+        const float * m_pScores;
+        const int * m_pIds;
+    };
+};
+
+
+template < class Ty >
+FAFuzzyLookup_t< Ty >::FAFuzzyLookup_t (FAAllocatorA * pAlloc) :
+    m_FsmType (FAFsmConst::TYPE_MEALY_DFA),
+    m_pDfa (NULL),
+    m_pMealy (NULL),
+    m_pState2Ow (NULL),
+    m_pK2I (NULL),
+    m_pCharMap (NULL),
+    m_Direction (FAFsmConst::DIR_L2R),
+    m_IgnoreCase (false),
+    m_Ready (false),
+    m_pW2P (NULL),
+    m_WordLen (0),
+    m_MaxDist (0)
+{
+    m_iws.SetAllocator (pAlloc);
+    m_iws.Create ();
+    m_ids.SetAllocator (pAlloc);
+    m_ids.Create ();
+    m_dists.SetAllocator (pAlloc);
+    m_dists.Create ();
+    m_scores.SetAllocator (pAlloc);
+    m_scores.Create ();
+    m_offsets.SetAllocator (pAlloc);
+    m_offsets.Create ();
+    m_lens.SetAllocator (pAlloc);
+    m_lens.Create ();
+    m_chars.SetAllocator (pAlloc);
+    m_chars.Create ();
+    m_order.SetAllocator (pAlloc);
+    m_order.Create ();
+}
+
+
+template < class Ty >
+inline void FAFuzzyLookup_t< Ty >::Clear ()
+{
+    m_FsmType = FAFsmConst::TYPE_MEALY_DFA;
+    m_pDfa = NULL;
+    m_pMealy = NULL;
+    m_pState2Ow = NULL;
+    m_pK2I = NULL;
+    m_pCharMap = NULL;
+    m_Direction = FAFsmConst::DIR_L2R;
+    m_IgnoreCase = false;
+    m_Ready = false;
+    m_iws.resize (0);
+    m_order.resize (0);
+}
+
+
+template < class Ty >
+void FAFuzzyLookup_t< Ty >::SetConf (const FADictConfKeeper * pConf)
+{
+    FAFuzzyLookup_t< Ty >::Clear ();
+
+    if (NULL == pConf) {
+        return;
+    }
+
+    m_FsmType = pConf->GetFsmType ();
+    m_pDfa = pConf->GetRsDfa ();
+
+    if (FAFsmConst::TYPE_MEALY_DFA == m_FsmType) {
+
+        m_pMealy = pConf->GetMphMealy ();
+        m_pK2I = pConf->GetK2I ();
+        m_Ready = (NULL != m_pDfa) && (NULL != m_pMealy) && (NULL != m_pK2I);
+
+    } else if (FAFsmConst::TYPE_MOORE_DFA == m_FsmType) {
+
+        m_pState2Ow = pConf->GetState2Ow ();
+        m_Ready = (NULL != m_pDfa) && (NULL != m_pState2Ow);
+    }
+
+    m_pCharMap = pConf->GetCharMap ();
+    m_Direction = pConf->GetDirection ();
+    m_IgnoreCase = pConf->GetIgnoreCase ();
+
+    if (m_Ready) {
+
+        const int IwCount = m_pDfa->GetIWs (NULL, 0);
+        FAAssert (0 < IwCount, FAMsg::InvalidParameters);
+
+        m_iws.resize (IwCount, 0);
+        m_pDfa->GetIWs (m_iws.begin (), IwCount);
+    }
+}
+
+
+template < class Ty >
+void FAFuzzyLookup_t< Ty >::SetW2P (FAWordToProb_t < Ty > * pW2P)
+{
+    m_pW2P = pW2P;
+}
+
+
+template < class Ty >
+inline const int FAFuzzyLookup_t< Ty >::
+    Normalize (const Ty * pIn, const int InSize)
+{
+    DebugLogAssert (0 < InSize && FALimits::MaxWordLen >= InSize && pIn);
+
+    for (int i = 0; i < InSize; ++i) {
+        const int Symbol = (int) pIn [i];
+        m_Word [i] = m_IgnoreCase ? ::FAUtf32ToLower (Symbol) : Symbol;
+    }
+
+    int Size = InSize;
+
+    if (m_pCharMap) {
+        // in-place is fine
+        Size = ::FANormalizeWord (m_Word, Size, m_Word, \
+            FALimits::MaxWordLen, m_pCharMap);
+        if (0 >= Size || FALimits::MaxWordLen < Size) {
+            return -1;
+        }
+    }
+    // the distance does not depend on the order, so the input is reversed
+    // for R2L dictionaries and the results are reversed back
+    if (FAFsmConst::DIR_R2L == m_Direction) {
+        std::reverse (m_Word, m_Word + Size);
+    }
+
+    return Size;
+}
+
+
+template < class Ty >
+inline const int FAFuzzyLookup_t< Ty >::
+    GetCell (const int Depth, const int Pos) const
+{
+    const int Idx = Pos - Depth + MaxEditDist;
+
+    if (0 > Pos || m_WordLen < Pos || 0 > Idx || BandSize <= Idx) {
+        return Inf;
+    }
+
+    return m_Rows [(Depth * BandSize) + Idx];
+}
+
+
+template < class Ty >
+inline const int FAFuzzyLookup_t< Ty >::
+    CalcRow (const int Depth, const int Iw)
+{
+    DebugLogAssert (0 <= Depth && MaxDepth > Depth);
+
+    const int NewDepth = Depth + 1;
+    int * pRow = m_Rows + (NewDepth * BandSize);
+    int MinVal = Inf;
+
+    for (int Idx = 0; Idx < BandSize; ++Idx) {
+
+        const int Pos = NewDepth + Idx - MaxEditDist;
+        int Val = Inf;
+
+        if (0 == Pos) {
+            // NewDepth symbols are inserted
+            Val = NewDepth;
+
+        } else if (0 < Pos && m_WordLen >= Pos) {
+            // substitution or match
+            Val = GetCell (Depth, Pos - 1) + (Iw != m_Word [Pos - 1] ? 1 : 0);
+            // insertion
+            const int InsVal = GetCell (Depth, Pos) + 1;
+            if (InsVal < Val) {
+                Val = InsVal;
+            }
+            // deletion
+            if (0 < Idx) {
+                const int DelVal = pRow [Idx - 1] + 1;
+                if (DelVal < Val) {
+                    Val = DelVal;
+                }
+            }
+        }
+        if (Val > m_MaxDist) {
+            Val = Inf;
+        }
+
+        pRow [Idx] = Val;
+
+        if (Val < MinVal) {
+            MinVal = Val;
+        }
+    }
+
+    return MinVal;
+}
+
+
+template < class Ty >
+inline void FAFuzzyLookup_t< Ty >::
+    SetupIws (const int Depth, const int MinVal)
+{
+    DebugLogAssert (0 <= Depth && MaxDepth >= Depth);
+
+    m_IwPos [Depth] = 0;
+
+    if (MaxDepth == Depth) {
+        m_IwCounts [Depth] = 0;
+        return;
+    }
+
+    // any symbol can be substituted or inserted
+    if (MinVal < m_MaxDist) {
+        m_pIws [Depth] = m_iws.begin ();
+        m_IwCounts [Depth] = m_iws.size ();
+        return;
+    }
+
+    // no more edits, only the input symbols after the band cells at
+    // MaxDist can be matched
+    int * pWordIws = m_WordIws + (Depth * BandSize);
+    int Count = 0;
+
+    for (int Idx = 0; Idx < BandSize; ++Idx) {
+
+        const int Pos = Depth + Idx - MaxEditDist;
+
+        if (0 > Pos || m_WordLen <= Pos || Inf == GetCell (Depth, Pos)) {
+            continue;
+        }
+
+        const int Iw = m_Word [Pos];
+        int i = 0;
+        for (; i < Count && Iw != pWordIws [i]; ++i);
+        if (i == Count) {
+            pWordIws [Count++] = Iw;
+        }
+    }
+
+    m_pIws [Depth] = pWordIws;
+    m_IwCounts [Depth] = Count;
+}
+
+
+template < class Ty >
+inline void FAFuzzyLookup_t< Ty >::
+    AddResult (const int Depth, const int Id, const int Dist)
+{
+    const int Offset = m_chars.size ();
+
+    m_chars.resize (Offset + Depth);
+    Ty * pWord = m_chars.begin () + Offset;
+
+    for (int i = 0; i < Depth; ++i) {
+        pWord [i] = (Ty) m_Path [i];
+    }
+    if (FAFsmConst::DIR_R2L == m_Direction) {
+        std::reverse (pWord, pWord + Depth);
+    }
+
+    float Score = 0;
+    if (m_pW2P && 0 < Depth && FALimits::MaxWordLen >= Depth) {
+        Score = m_pW2P->GetProb (pWord, Depth);
+    }
+
+    m_ids.push_back (Id);
+    m_dists.push_back (Dist);
+    m_scores.push_back (Score);
+    m_offsets.push_back (Offset);
+    m_lens.push_back (Depth);
+}
+
+
+template < class Ty >
+void FAFuzzyLookup_t< Ty >::Traverse ()
+{
+    const int Initial = m_pDfa->GetInitial ();
+
+    // the initial row: the input prefixes are deleted
+    for (int Idx = 0; Idx < BandSize; ++Idx) {
+        const int Pos = Idx - MaxEditDist;
+        m_Rows [Idx] = (0 <= Pos && m_MaxDist >= Pos && m_WordLen >= Pos) ? \
+            Pos : Inf;
+    }
+    m_States [0] = Initial;
+    m_Sums [0] = 0;
+    SetupIws (0, GetCell (0, 0));
+
+    int Depth = 0;
+
+    while (0 <= Depth) {
+
+        if (m_IwPos [Depth] >= m_IwCounts [Depth]) {
+            Depth--;
+            continue;
+        }
+
+        const int Iw = m_pIws [Depth][m_IwPos [Depth]++];
+        const int State = m_States [Depth];
+
+        int Dst;
+        int Ow = 0;
+
+        if (m_pMealy) {
+            Dst = m_pMealy->GetDestOw (State, Iw, &Ow);
+        } else {
+            Dst = m_pDfa->GetDest (State, Iw);
+        }
+        if (-1 == Dst) {
+            continue;
+        }
+
+        const int MinVal = CalcRow (Depth, Iw);
+        if (Inf == MinVal) {
+            continue;
+        }
+
+        m_Path [Depth] = Iw;
+        Depth++;
+        m_States [Depth] = Dst;
+        m_Sums [Depth] = m_Sums [Depth - 1] + Ow;
+
+        const int Dist = GetCell (Depth, m_WordLen);
+
+        // the empty word is never returned, as Depth is at least 1 here
+        if (Inf != Dist && m_pDfa->IsFinal (Dst)) {
+
+            int Id;
+
+            if (m_pMealy) {
+                DebugLogAssert (0 <= m_Sums [Depth] && \
+                    m_Sums [Depth] < m_pK2I->GetCount ());
+                Id = m_pK2I->GetAt (m_Sums [Depth]);
+            } else {
+                Id = m_pState2Ow->GetOw (Dst);
+            }
+            if (-1 != Id) {
+                AddResult (Depth, Id, Dist);
+            }
+        }
+
+        SetupIws (Depth, MinVal);
+    }
+}
+
+
+template < class Ty >
+void FAFuzzyLookup_t< Ty >::SortResults (const int MaxCount)
+{
+    const int Count = m_ids.size ();
+
+    m_order.resize (Count);
+    int * pOrder = m_order.begin ();
+
+    for (int i = 0; i < Count; ++i) {
+        pOrder [i] = i;
+    }
+
+    std::sort (pOrder, pOrder + Count, \
+        _TResultCmp (m_dists.begin (), m_scores.begin (), m_ids.begin ()));
+
+    if (Count > MaxCount) {
+        m_order.resize (MaxCount);
+    }
+}
+
+
+template < class Ty >
+const int FAFuzzyLookup_t< Ty >::
+    Process (
+        const Ty * pIn,
+        const int InSize,
+        const int MaxDist,
+        const int MaxCount
+    )
+{
+    m_order.resize (0);
+
+    if (!m_Ready || 0 >= InSize || FALimits::MaxWordLen < InSize || !pIn || \
+        0 > MaxDist || MaxEditDist < MaxDist || 0 > MaxCount) {
+        return -1;
+    }
+
+    m_WordLen = Normalize (pIn, InSize);
+    if (-1 == m_WordLen) {
+        return -1;
+    }
+
+    m_MaxDist = MaxDist;
+
+    m_ids.resize (0);
+    m_dists.resize (0);
+    m_scores.resize (0);
+    m_offsets.resize (0);
+    m_lens.resize (0);
+    m_chars.resize (0);
+
+    Traverse ();
+    SortResults (MaxCount);
+
+    return m_order.size ();
+}
+
+
+template < class Ty >
+const int FAFuzzyLookup_t< Ty >::
+    GetWord (const int Num, const Ty ** ppWord) const
+{
+    DebugLogAssert (0 <= Num && (unsigned int) Num < m_order.size ());
+    DebugLogAssert (ppWord);
+
+    const int i = m_order [Num];
+    *ppWord = m_chars.begin () + m_offsets [i];
+    return m_lens [i];
+}
+
+
+template < class Ty >
+const int FAFuzzyLookup_t< Ty >::GetId (const int Num) const
+{
+    DebugLogAssert (0 <= Num && (unsigned int) Num < m_order.size ());
+    return m_ids [m_order [Num]];
+}
+
+
+template < class Ty >
+const int FAFuzzyLookup_t< Ty >::GetDist (const int Num) const
+{
+    DebugLogAssert (0 <= Num && (unsigned int) Num < m_order.size ());
+    return m_dists [m_order [Num]];
+}
+
+
+template < class Ty >
+const float FAFuzzyLookup_t< Ty >::GetScore (const int Num) const
+{
+    DebugLogAssert (0 <= Num && (unsigned int) Num < m_order.size ());
+    return m_scores [m_order [Num]];
+}
+
+#endif
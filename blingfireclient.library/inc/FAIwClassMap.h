@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_IWCLASSMAP_H_
+#define _FA_IWCLASSMAP_H_
+
+#include "FAConfig.h"
+#include "FARSDfa_pack_triv.h"
+
+///
+/// Maps UTF-32 symbols into the input weights of the automaton (alphabet
+/// classes) with the case folding and the control symbols substitution
+/// merged in, so the whole input can be classified once before lexing.
+///
+/// The map is a two-level table: the upper bits of a symbol select a block
+/// and the lower bits select a uint16 class id within the block, identical
+/// blocks are stored once. The map is built once for a given automaton and
+/// can be shared by any number of threads. Only the blocks with the alphabet,
+/// control or case folded symbols are classified, others share one block.
+///
+/// Note: the map cannot be built if the automaton has Iws bigger than 0xFFFE
+///
+
+class FAIwClassMap {
+
+public:
+    FAIwClassMap ();
+    ~FAIwClassMap ();
+
+public:
+    /// builds the map for the automaton, returns false if the alphabet does not fit
+    const bool Build (const FARSDfa_pack_triv * pDfa, const bool IgnoreCase);
+    /// returns object into the initial state
+    void Clear ();
+    /// returns true if the map was built with the case folding
+    const bool GetIgnoreCase () const;
+
+    /// returns the class id of the symbol, -1 if the automaton does not have it
+    inline const int GetClass (const int Symbol) const;
+    /// maps the whole input into class ids
+    template < class Ty >
+    void Process (const Ty * pIn, const int InSize, int * pOut) const;
+    /// returns the destination state for the given class id, -1 if none
+    inline const int GetDest (const int State, const int Class) const;
+
+private:
+    // computes the class id without the table
+    const int GetClass_slow (const int Symbol) const;
+
+private:
+    // the automaton
+    const FARSDfa_pack_triv * m_pDfa;
+    // the case folding flag
+    bool m_IgnoreCase;
+    // maps the block number into the offset of the block in m_pClasses
+    unsigned int * m_pBlocks;
+    // the unique blocks of class ids
+    unsigned short * m_pClasses;
+
+    enum {
+        BlockBits = 8,
+        BlockSize = 1 << BlockBits,
+        BlockMask = BlockSize - 1,
+        MaxSymbol = 0x10FFFF,
+        MaxCaseSymbol = 0x1FFFF, // FAUtf32ToLower does not change bigger symbols
+        BlockCount = (MaxSymbol + 1) >> BlockBits,
+        NoClass = 0xFFFF,
+    };
+};
+
+
+inline const int FAIwClassMap::GetClass (const int Symbol) const
+{
+    DebugLogAssert (m_pBlocks && m_pClasses);
+
+    if (0 <= Symbol && MaxSymbol >= Symbol) {
+
+        const unsigned int Class = m_pClasses [m_pBlocks [Symbol >> BlockBits] + (Symbol & BlockMask)];
+
+        if (NoClass != Class) {
+            return Class;
+        } else {
+            return -1;
+        }
+    }
+
+    return GetClass_slow (Symbol);
+}
+
+
+inline const int FAIwClassMap::GetDest (const int State, const int Class) const
+{
+    DebugLogAssert (m_pDfa);
+
+    if (0 > Class) {
+        return -1;
+    }
+
+    return m_pDfa->GetDestNewIw (State, Class);
+}
+
+
+template < class Ty >
+void FAIwClassMap::Process (const Ty * pIn, const int InSize, int * pOut) const
+{
+    DebugLogAssert (0 == InSize || (pIn && pOut));
+    DebugLogAssert (m_pBlocks && m_pClasses);
+
+    // classes of the ASCII symbols, the most frequent ones
+    const unsigned short * pAscii = m_pClasses + m_pBlocks [0];
+
+    for (int i = 0; i < InSize; ++i) {
+
+        const int Symbol = pIn [i];
+
+        if (0 <= Symbol && 0x80 > Symbol) {
+            const unsigned int Class = pAscii [Symbol];
+            pOut [i] = NoClass != Class ? (int) Class : -1;
+        } else {
+            pOut [i] = GetClass (Symbol);
+        }
+    }
+}
+
+#endif
@@ -16,6 +16,9 @@
 #include "FAWbdConfKeeper.h"
 #include "FALimits.h"
 #include "FASecurity.h"
+#include "FAIwClassMap.h"
+
+#include <memory>
 
 ///
 /// Lexical analyzer runtime. 
@@ -44,6 +47,14 @@
 ///  the values can be predefined (and frozen) in the tagset.txt file of the
 ///  the corresponding grammar.
 ///
+/// 3. If the configuration provides alphabet classes, the whole input is
+///  mapped into class ids once, rather than each time a scan passes over
+///  a symbol.
+///
+/// 4. ProcessPrefix can be used to process the beginning of a long text,
+///  only the tokens which cannot change if the text continues are returned,
+///  so they are the same as the first tokens returned for the whole text.
+///
 
 template < class Ty >
 class FALexTools_t {
@@ -72,16 +83,40 @@ public:
             const int MaxOutSize
         ) const;
 
+    /// makes a processing of the text prefix pIn [0, InSize), only tokens
+    /// starting no closer than the maximum token length to the end of the
+    /// prefix are extracted, the continuation of the text cannot affect them
+    const int ProcessPrefix (
+            const Ty * pIn,
+            const int InSize,
+            __out_ecount(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        ) const;
+
 private:
     /// validates consitensy between data structures
     inline void Validate () const;
 
-    // internal processing function, returns the size of the output array
+    // maps the input into class ids, if possible, and runs Process_int
+    const int Process_cls (
+            const int Initial,
+            const Ty * pIn,
+            const int InSize,
+            const int MaxFromPos,
+            __out_ecount(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        ) const;
+
+    // internal processing function, returns the size of the output array,
+    // fClasses indicates that pIn contains class ids rather than symbols,
+    // tokens are searched from the start positions less than MaxFromPos
+    template < class InTy, bool fClasses >
     const int Process_int (
             const int Initial,
             const int Offset,
-            const Ty * pIn,
+            const InTy * pIn,
             const int InSize,
+            const int MaxFromPos,
             __out_ecount(MaxOutSize) int * pOut,
             const int MaxOutSize,
             const int RecDepth,
@@ -93,6 +128,8 @@ private:
     const FARSDfaCA * m_pDfa;
     const FAState2OwCA * m_pState2Ow;
     const FAMultiMapCA * m_pActs;
+    /// alphabet classes of m_pDfa, can be NULL
+    const FAIwClassMap * m_pClassMap;
     bool m_IgnoreCase;
     int m_MaxDepth;
     /// maps function id into an initial state, or -1 if not valid
@@ -105,6 +142,7 @@ private:
         DefMaxDepth = 2,
         MinActSize = 3,
         DefSubIw = FAFsmConst::IW_EPSILON,
+        MaxStackClasses = 1024,
     };
 };
 
@@ -114,6 +152,7 @@ FALexTools_t< Ty >::FALexTools_t () :
     m_pDfa (NULL),
     m_pState2Ow (NULL),
     m_pActs (NULL),
+    m_pClassMap (NULL),
     m_IgnoreCase (false),
     m_MaxDepth (DefMaxDepth),
     m_pFn2Ini (NULL),
@@ -132,6 +171,7 @@ void FALexTools_t< Ty >::SetConf (const FAWbdConfKeeper * pWbdConf)
         m_IgnoreCase =  pWbdConf->GetIgnoreCase();
         m_MaxDepth = pWbdConf->GetMaxDepth ();
         m_pActs = pWbdConf->GetMMap ();
+        m_pClassMap = pWbdConf->GetIwClassMap ();
         m_Fn2IniSize = pWbdConf->GetFnIniStates (&m_pFn2Ini);
         m_MaxTokenLength = pWbdConf->GetMaxTokenLength ();
 
@@ -142,6 +182,7 @@ void FALexTools_t< Ty >::SetConf (const FAWbdConfKeeper * pWbdConf)
         m_IgnoreCase = false;
         m_MaxDepth = DefMaxDepth;
         m_pActs = NULL;
+        m_pClassMap = NULL;
         m_Fn2IniSize = 0;
         m_pFn2Ini = NULL;
         m_MaxTokenLength = FALimits::MaxWordLen;
@@ -200,12 +241,14 @@ inline void FALexTools_t< Ty >::Validate () const
 
 
 template < class Ty >
+template < class InTy, bool fClasses >
 const int FALexTools_t< Ty >::
     Process_int (
             const int Initial,
             const int Offset,
-            const Ty * pIn,
+            const InTy * pIn,
             const int InSize,
+            const int MaxFromPos,
             __out_ecount(MaxOutSize) int * pOut,
             const int MaxOutSize,
             const int RecDepth,
@@ -223,7 +266,7 @@ const int FALexTools_t< Ty >::
     const int MaxTokenLength = m_MaxTokenLength;
 
     /// iterate thru all possible start positions
-    for (int FromPos = -1; FromPos < InSize; ++FromPos) {
+    for (int FromPos = -1; FromPos < MaxFromPos; ++FromPos) {
 
         int State = Initial;
         int FinalState = -1;
@@ -251,15 +294,20 @@ const int FALexTools_t< Ty >::
         /// feed the letters
         for (; j < LengthBound; ++j) {
 
-            Iw = pIn [j];
-            // prevent regular input weights to match control input weights
-            if (FAFsmConst::IW_EPSILON > Iw) {
-                Iw = DefSubIw;
-            }
-            if (m_IgnoreCase) {
-                Iw = ::FAUtf32ToLower (Iw);
+            if (fClasses) {
+                // the substitution and the case folding are already applied
+                Dst = m_pClassMap->GetDest (State, pIn [j]);
+            } else {
+                Iw = pIn [j];
+                // prevent regular input weights to match control input weights
+                if (FAFsmConst::IW_EPSILON > Iw) {
+                    Iw = DefSubIw;
+                }
+                if (m_IgnoreCase) {
+                    Iw = ::FAUtf32ToLower (Iw);
+                }
+                Dst = m_pDfa->GetDest (State, Iw);
             }
-            Dst = m_pDfa->GetDest (State, Iw);
             if (-1 == Dst) {
                 Dst = m_pDfa->GetDest (State, FAFsmConst::IW_ANY);
                 if (-1 == Dst)
@@ -352,13 +400,13 @@ const int FALexTools_t< Ty >::
                 const int FnIni = m_pFn2Ini [FnId];
                 DebugLogAssert (-1 != FnIni);
 
-                const Ty * pFnIn = pIn + FnFrom;
+                const InTy * pFnIn = pIn + FnFrom;
                 const int FnInSize = ToPos2 - FnFrom + 1;
                 int * pFnOut = pOut + OutSize;
                 const int FnMaxOutSize = MaxOutSize - OutSize;
 
-                const int FnOutSize = Process_int (FnIni, FnFrom + Offset, \
-                  pFnIn, FnInSize, pFnOut, FnMaxOutSize, RecDepth + 1, \
+                const int FnOutSize = Process_int < InTy, fClasses > (FnIni, FnFrom + Offset, \
+                  pFnIn, FnInSize, FnInSize, pFnOut, FnMaxOutSize, RecDepth + 1, \
                   0 == FnId ? false : fFnOnce);
                 DebugLogAssert (0 == FnOutSize % 3);
 
@@ -397,6 +445,39 @@ const int FALexTools_t< Ty >::
 }
 
 
+template < class Ty >
+const int FALexTools_t< Ty >::
+    Process_cls (
+            const int Initial,
+            const Ty * pIn,
+            const int InSize,
+            const int MaxFromPos,
+            __out_ecount(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        ) const
+{
+    if (!m_pClassMap || 0 >= InSize) {
+        return Process_int < Ty, false > (Initial, 0, pIn, InSize, MaxFromPos, \
+            pOut, MaxOutSize, 1);
+    }
+
+    // short inputs are classified on the stack
+    int StackClasses [MaxStackClasses];
+    std::unique_ptr < int [] > HeapClasses;
+    int * pClasses = StackClasses;
+
+    if (MaxStackClasses < InSize) {
+        HeapClasses.reset (new int [InSize]);
+        pClasses = HeapClasses.get ();
+    }
+
+    m_pClassMap->Process (pIn, InSize, pClasses);
+
+    return Process_int < int, true > (Initial, 0, pClasses, InSize, MaxFromPos, \
+        pOut, MaxOutSize, 1);
+}
+
+
 template < class Ty >
 const int FALexTools_t< Ty >::
     Process (
@@ -412,7 +493,8 @@ const int FALexTools_t< Ty >::
 
     const int Initial = m_pDfa->GetInitial ();
 
-    const int OutSize = Process_int (Initial, 0, pIn, InSize, pOut, MaxOutSize, 1);
+    const int OutSize = \
+        Process_cls (Initial, pIn, InSize, InSize, pOut, MaxOutSize);
 
     return OutSize;
 }
@@ -435,7 +517,8 @@ const int FALexTools_t< Ty >::
     if (0 == FnTag) {
 
         const int Initial = m_pDfa->GetInitial ();
-        const int OutSize = Process_int (Initial, 0, pIn, InSize, pOut, MaxOutSize, 1);
+        const int OutSize = \
+            Process_cls (Initial, pIn, InSize, InSize, pOut, MaxOutSize);
         return OutSize;
 
     } else if (0 < FnTag && (unsigned int) FnTag < m_Fn2IniSize) {
@@ -445,7 +528,8 @@ const int FALexTools_t< Ty >::
             // the function tag is unknown
             return -1;
         }
-        const int OutSize = Process_int (FnIni, 0, pIn, InSize, pOut, MaxOutSize, 1);
+        const int OutSize = \
+            Process_cls (FnIni, pIn, InSize, InSize, pOut, MaxOutSize);
         return OutSize;
 
     }
@@ -454,4 +538,34 @@ const int FALexTools_t< Ty >::
     return -1;
 }
 
+
+template < class Ty >
+const int FALexTools_t< Ty >::
+    ProcessPrefix (
+            const Ty * pIn,
+            const int InSize,
+            __out_ecount(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        ) const
+{
+    if (!m_pActs || !m_pDfa || !m_pState2Ow) {
+        return -1;
+    }
+
+    // a scan from FromPos stops before FromPos + m_MaxTokenLength, so if this
+    // is less than InSize then neither the right anchor nor the symbols after
+    // the prefix can affect the result
+    const int MaxFromPos = InSize - m_MaxTokenLength;
+    if (-1 >= MaxFromPos) {
+        return 0;
+    }
+
+    const int Initial = m_pDfa->GetInitial ();
+
+    const int OutSize = \
+        Process_cls (Initial, pIn, InSize, MaxFromPos, pOut, MaxOutSize);
+
+    return OutSize;
+}
+
 #endif
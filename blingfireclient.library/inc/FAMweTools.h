@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_MWETOOLS_H_
+#define _FA_MWETOOLS_H_
+
+#include "FAConfig.h"
+#include "FASecurity.h"
+
+class FARSDfaCA;
+class FAState2OwCA;
+class FADictConfKeeper;
+
+///
+/// Multi-word expression (phrase) matching runtime.
+///
+/// The phrase dictionary is a Moore automaton over the token ids of a
+/// vocabulary, each final state gives the phrase id, see fa_vocab2dfa
+/// --type=mwe. Matches are merged by the left-most-longest algorithm, the
+/// same way as FAMergeMwe does it for the tagged text.
+///
+/// The input is an array of token ids, -1 for the tokens not in the
+/// vocabulary. The output is an array of triplets: <PhraseId, From, To>,
+/// From and To are token positions, To includes the last token. Tokens not
+/// covered by any phrase are not in the output.
+///
+/// Usage notes:
+///
+/// 1. The object supposed to be initialized before it's used, it is caller 
+///  responsibility to guarantee this.
+///
+/// 2. The object is safe to share among threads after the initialization.
+///
+
+class FAMweTools {
+
+public:
+    FAMweTools ();
+
+public:
+    /// sets up the data containers
+    void SetConf (const FADictConfKeeper * pConf);
+
+    /// finds the phrases, returns the output size or -1 if the object is
+    /// not initialized, if the returned value is bigger than MaxOutSize
+    /// then only the triplets which fit completely are stored
+    const int Process (
+            const int * pIn,
+            const int InSize,
+            __out_ecount(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        ) const;
+
+private:
+    /// input objects
+    const FARSDfaCA * m_pDfa;
+    const FAState2OwCA * m_pState2Ow;
+    int m_Initial;
+};
+
+#endif
@@ -47,6 +47,8 @@ public:
     const int GetMaxDepth () const;
     /// returns maximum allowed passes over the input
     const int GetMaxPassCount () const;
+    /// returns parser type, one of FAFsmConst::PARSER_*
+    const int GetParserType () const;
     /// returns an array of function initial states, the array contains -1
     /// for undefined function ids
     const unsigned int GetFnIniStates (const int ** ppFn2Ini) const;
@@ -71,6 +73,7 @@ private:
     bool m_IgnoreCase;
     int m_MaxDepth;
     int m_MaxPassCount;
+    int m_ParserType;
 
     const FAWREConfCA * m_pWreCA;
     const FAMultiMapCA * m_pActsCA;
@@ -36,6 +36,14 @@ public:
     const bool IsFinal (const int State) const;
     const int GetDest (const int State, const int Iw) const;
 
+public:
+    /// returns the Iw as it is stored in the automaton, -1 if it has no transitions on it
+    inline const int GetNewIw (const int Iw) const;
+    /// the same as GetDest, but takes the Iw returned by GetNewIw
+    const int GetDestNewIw (const int State, const int NewIw) const;
+    /// returns the alphabet as [IwFrom, IwTo] pairs, returns the number of ints
+    const int GetIwIntervals (const int ** ppIwIntervals) const;
+
 private:
     // interprets iw2iw map dump, if any
     FAIwMap_pack m_iw2iw;
@@ -51,6 +59,18 @@ private:
     bool m_RemapIws;
     // dst size
     int m_DstSize;
+    // true if Ow is stored right after the info byte
+    bool m_OwFirst;
 };
 
+
+inline const int FARSDfa_pack_triv::GetNewIw (const int Iw) const
+{
+    if (m_RemapIws) {
+        return m_iw2iw.GetNewIw (Iw);
+    } else {
+        return Iw;
+    }
+}
+
 #endif
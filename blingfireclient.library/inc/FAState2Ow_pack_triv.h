@@ -33,6 +33,8 @@ private:
     const unsigned char * m_pAutImage;
     // dst size
     int m_DstSize;
+    // true if Ow is stored right after the info byte
+    bool m_OwFirst;
 };
 
 #endif
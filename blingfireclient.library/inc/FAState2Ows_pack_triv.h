@@ -41,6 +41,8 @@ private:
     FAChains_pack_triv m_UnpackOws;
     // dst size
     int m_DstSize;
+    // true if Ows offset is stored right after the info byte
+    bool m_OwFirst;
 };
 
 #endif
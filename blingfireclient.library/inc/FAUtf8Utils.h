@@ -94,6 +94,19 @@ const int FAStrUtf8ToUtf16LE (
         const int MaxSize
     );
 
+/// Converts UTF-16LE string of specified length (in 16-bit code units) to the
+/// array of ints, surrogate pairs are decoded into one UTF-32 character, for
+/// each UTF-32 character returns its offset in code units in the pStr.
+/// Returns the number of used elements in the array.
+/// Returns -1 if the input sequence is invalid (e.g. has unpaired surrogates).
+const int FAStrUtf16LEToArray (
+        const uint16_t * pStr,
+        const int Len,
+        __out_ecount(MaxSize) int * pArray,
+        __out_ecount(MaxSize) int * pOffsets,
+        const int MaxSize
+    );
+
 /// Converts array of ints (UTF-32LE) into UTF-8 string of  upto MaxStrSize
 /// length, does not place terminating 0-byte. Returns output string length.
 /// Returns -1 for invalid input sequence.
@@ -19,6 +19,7 @@ class FARSDfaCA;
 class FAMultiMapCA;
 class FAState2OwCA;
 class FAState2OwsCA;
+class FAIwClassMap;
 
 ///
 /// Keeps dictionary object configuration and common containers.
@@ -62,6 +63,9 @@ public:
     const FAMultiMapCA * GetActData () const;
     /// returns maximum allowed token length, FALimits::MaxWordLen is used by default
     const int GetMaxTokenLength () const;
+    /// returns the alphabet classes of the automaton from the LDB with the
+    /// case folding merged in, or NULL if they are not available
+    const FAIwClassMap * GetIwClassMap () const;
 
 public:
     // overrides RS Dfa from the LDB
@@ -88,6 +92,7 @@ private:
     FAMultiMap_pack * m_pMMapTriv;
     FAMultiMap_pack_fixed * m_pCharMap;
     FAMultiMap_pack * m_pActData;
+    FAIwClassMap * m_pIwClassMap;
     bool m_IgnoreCase;
     int m_MaxDepth;
     int m_TagEos;
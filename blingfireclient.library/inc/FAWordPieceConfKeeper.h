@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_WORDPIECECONFKEEPER_H_
+#define _FA_WORDPIECECONFKEEPER_H_
+
+#include "FAConfig.h"
+
+class FALDB;
+class FARSDfa_pack_triv;
+class FAState2Ow_pack_triv;
+class FARSDfaCA;
+class FAState2OwCA;
+
+///
+/// Keeps WordPiece vocabulary configuration and containers, the vocabulary
+/// is a Moore automaton: Token -> Id, continuation tokens are prefixed
+/// with "##".
+///
+/// Note: The pointers can be NULL, if yet not initialized
+///
+
+class FAWordPieceConfKeeper {
+
+public:
+    FAWordPieceConfKeeper ();
+    ~FAWordPieceConfKeeper ();
+
+public:
+    /// initialization vector
+    void Initialize (const FALDB * pLDB, const int * pValues, const int Size);
+    /// returns object into the initial state
+    void Clear ();
+
+public:
+    const FARSDfaCA * GetRsDfa () const;
+    const FAState2OwCA * GetState2Ow () const;
+    const bool GetIgnoreCase () const;
+    /// returns an id for out of vocabulary words
+    const int GetUnkId () const;
+    /// returns maximum word length, longer words are mapped to UnkId
+    const int GetMaxTokenLength () const;
+
+private:
+    // vocabulary automaton
+    FARSDfa_pack_triv * m_pRsDfa;
+    FAState2Ow_pack_triv * m_pState2Ow;
+    // indicates whether the input should be lower cased
+    bool m_IgnoreCase;
+    // id for the unknown words
+    int m_UnkId;
+    // maximum word length
+    int m_MaxTokenLength;
+
+    enum {
+        DefUnkId = 0,
+        DefMaxTokenLength = 100,
+    };
+};
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_WORDPIECETOOLS_T_H_
+#define _FA_WORDPIECETOOLS_T_H_
+
+#include "FAConfig.h"
+#include "FAUtf32Utils.h"
+#include "FARSDfaCA.h"
+#include "FAState2OwCA.h"
+#include "FAWordPieceConfKeeper.h"
+#include "FALimits.h"
+#include "FASecurity.h"
+
+///
+/// WordPiece subword segmentation runtime.
+///
+/// Splits a single word into subword tokens by the greedy longest-match-first
+/// algorithm, tokens other than the first one are looked up with the "##"
+/// prefix. The output is an array of triplets: <Id, From, To>, positions are
+/// relative to the word beginning and include the last character.
+///
+/// If some part of the word cannot be matched or the word is longer than
+/// the maximum token length, then the whole word is mapped to the UnkId.
+///
+/// Usage notes:
+///
+/// 1. The object supposed to be initialized before it's used, it is caller 
+///  responsibility to guarantee this.
+///
+/// 2. The object is safe to share among threads after the initialization.
+///
+
+template < class Ty >
+class FAWordPieceTools_t {
+
+public:
+    FAWordPieceTools_t ();
+
+public:
+    /// sets up the data containers
+    void SetConf (const FAWordPieceConfKeeper * pConf);
+
+    /// makes the segmentation of one word, returns the output size or -1
+    /// if the object is not initialized
+    const int Process (
+            const Ty * pIn,
+            const int InSize,
+            __out_ecount(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        ) const;
+
+private:
+    /// the automaton state after the continuation prefix, or -1
+    inline const int CalcContState () const;
+
+private:
+    /// input objects
+    const FARSDfaCA * m_pDfa;
+    const FAState2OwCA * m_pState2Ow;
+    bool m_IgnoreCase;
+    int m_UnkId;
+    int m_MaxTokenLength;
+    /// the initial state and the state after the continuation prefix
+    int m_Initial;
+    int m_ContState;
+
+    /// constants
+    enum {
+        DefUnkId = 0,
+        ContPrefixChar = '#',
+        ContPrefixLen = 2,
+    };
+};
+
+
+template < class Ty >
+FAWordPieceTools_t< Ty >::FAWordPieceTools_t () :
+    m_pDfa (NULL),
+    m_pState2Ow (NULL),
+    m_IgnoreCase (false),
+    m_UnkId (DefUnkId),
+    m_MaxTokenLength (FALimits::MaxWordLen),
+    m_Initial (-1),
+    m_ContState (-1)
+{}
+
+
+template < class Ty >
+void FAWordPieceTools_t< Ty >::SetConf (const FAWordPieceConfKeeper * pConf)
+{
+    if (pConf) {
+
+        m_pDfa = pConf->GetRsDfa ();
+        m_pState2Ow = pConf->GetState2Ow ();
+        m_IgnoreCase = pConf->GetIgnoreCase ();
+        m_UnkId = pConf->GetUnkId ();
+        m_MaxTokenLength = pConf->GetMaxTokenLength ();
+
+    } else {
+
+        m_pDfa = NULL;
+        m_pState2Ow = NULL;
+        m_IgnoreCase = false;
+        m_UnkId = DefUnkId;
+        m_MaxTokenLength = FALimits::MaxWordLen;
+    }
+
+    m_Initial = -1;
+    m_ContState = -1;
+
+    if (m_pDfa) {
+        m_Initial = m_pDfa->GetInitial ();
+        m_ContState = CalcContState ();
+    }
+}
+
+
+template < class Ty >
+inline const int FAWordPieceTools_t< Ty >::CalcContState () const
+{
+    DebugLogAssert (m_pDfa);
+
+    int State = m_Initial;
+
+    for (int i = 0; i < ContPrefixLen && -1 != State; ++i) {
+        State = m_pDfa->GetDest (State, ContPrefixChar);
+    }
+
+    return State;
+}
+
+
+template < class Ty >
+const int FAWordPieceTools_t< Ty >::
+    Process (
+            const Ty * pIn,
+            const int InSize,
+            __out_ecount(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        ) const
+{
+    if (!m_pDfa || !m_pState2Ow) {
+        return -1;
+    }
+    if (0 >= InSize || !pIn || 3 > MaxOutSize) {
+        return 0;
+    }
+
+    int OutSize = 0;
+
+    if (InSize <= m_MaxTokenLength) {
+
+        int Pos = 0;
+
+        while (Pos < InSize) {
+
+            int State = 0 == Pos ? m_Initial : m_ContState;
+            int BestId = -1;
+            int BestPos = -1;
+
+            // find the longest vocabulary token starting at Pos
+            for (int j = Pos; j < InSize && -1 != State; ++j) {
+
+                int Iw = pIn [j];
+                if (m_IgnoreCase) {
+                    Iw = ::FAUtf32ToLower (Iw);
+                }
+
+                State = m_pDfa->GetDest (State, Iw);
+
+                if (-1 != State && m_pDfa->IsFinal (State)) {
+                    const int Ow = m_pState2Ow->GetOw (State);
+                    if (-1 != Ow) {
+                        BestId = Ow;
+                        BestPos = j;
+                    }
+                }
+            }
+
+            // the rest of the word cannot be covered
+            if (-1 == BestId) {
+                OutSize = 0;
+                break;
+            }
+            // stop processing, the output buffer is not enough
+            if (OutSize + 3 > MaxOutSize) {
+                return OutSize;
+            }
+
+            pOut [OutSize++] = BestId;
+            pOut [OutSize++] = Pos;
+            pOut [OutSize++] = BestPos;
+
+            Pos = BestPos + 1;
+        }
+    }
+
+    // map the whole word to the unknown id
+    if (0 == OutSize) {
+        pOut [0] = m_UnkId;
+        pOut [1] = 0;
+        pOut [2] = InSize - 1;
+        OutSize = 3;
+    }
+
+    return OutSize;
+}
+
+#endif
@@ -63,6 +63,53 @@ void FAArray_pack::SetImage (const unsigned char * pImage)
 }
 
 
+///
+/// Decodes Count consecutive values of the given size, the size switch is
+/// taken once per block and the loops are simple enough to be vectorized.
+///
+
+inline static void FADecodeBlock (
+        const unsigned char * pDump,
+        const int Count,
+        const int SizeOfValue,
+        int * pOut
+    )
+{
+    DebugLogAssert (pDump && pOut);
+
+    int i;
+
+    if (1 == SizeOfValue) {
+
+        for (i = 0; i < Count; ++i) {
+            pOut [i] = pDump [i];
+        }
+
+    } else if (2 == SizeOfValue) {
+
+        for (i = 0; i < Count; ++i) {
+            pOut [i] = (pDump [2 * i] << 8) | pDump [(2 * i) + 1];
+        }
+
+    } else if (3 == SizeOfValue) {
+
+        for (i = 0; i < Count; ++i) {
+            pOut [i] = (pDump [3 * i] << 16) | \
+                (pDump [(3 * i) + 1] << 8) | pDump [(3 * i) + 2];
+        }
+
+    } else {
+        DebugLogAssert (4 == SizeOfValue);
+
+        for (i = 0; i < Count; ++i) {
+            pOut [i] = (pDump [4 * i] << 24) | \
+                (pDump [(4 * i) + 1] << 16) | \
+                (pDump [(4 * i) + 2] << 8) | pDump [(4 * i) + 3];
+        }
+    }
+}
+
+
 const int FAArray_pack::GetAt (const int Idx) const
 {
     int Val, ChainIdx;
@@ -95,3 +142,54 @@ const int FAArray_pack::GetCount () const
 {
     return m_Count;
 }
+
+
+const int FAArray_pack::
+    GetRange (
+        const int From,
+        const int Count,
+        __out_ecount(Count) int * pOut
+    ) const
+{
+    DebugLogAssert (0 <= From && 0 <= Count);
+    DebugLogAssert (pOut || 0 == Count);
+
+    if (From >= m_Count) {
+        return 0;
+    }
+
+    const int OutCount = Count < m_Count - From ? Count : m_Count - From;
+
+    if (1 == m_M) {
+
+        FADecodeBlock (m_pData + (From * m_SizeOfValue), OutCount, \
+            m_SizeOfValue, pOut);
+
+    } else {
+
+        // decode each chain index once, then the chain values at once
+        int Idx1 = From / m_M;
+        int Idx2 = From % m_M;
+        int Left = OutCount;
+
+        while (0 < Left) {
+
+            int ChainIdx;
+            FADecode_1_2_3_4_idx (m_pIndex, Idx1, ChainIdx, m_SizeOfIndex);
+            DebugLogAssert (0 <= ChainIdx);
+
+            const unsigned char * pChainDump = \
+                m_pData + (ChainIdx * m_SizeOfChain) + (Idx2 * m_SizeOfValue);
+
+            const int BlockSize = m_M - Idx2 < Left ? m_M - Idx2 : Left;
+            FADecodeBlock (pChainDump, BlockSize, m_SizeOfValue, pOut);
+
+            pOut += BlockSize;
+            Left -= BlockSize;
+            Idx1++;
+            Idx2 = 0;
+        }
+    }
+
+    return OutCount;
+}
@@ -31,7 +31,8 @@ FADictConfKeeper::FADictConfKeeper () :
     m_IgnoreCase (false),
     m_NoTrUse (true),
     m_Direction (FAFsmConst::DIR_L2R),
-    m_pCharMap (NULL)
+    m_pCharMap (NULL),
+    m_UnkId (-1)
 {}
 
 
@@ -142,6 +143,11 @@ void FADictConfKeeper::Init (const int * pValues, const int Size)
 
             break;
         }
+        case FAFsmConst::PARAM_UNKNOWN:
+        {
+            m_UnkId = pValues [++i];
+            break;
+        }
         case FAFsmConst::PARAM_CHARMAP:
         {
             const int DumpNum = pValues [++i];
@@ -224,6 +230,7 @@ void FADictConfKeeper::Clear ()
     m_Direction = FAFsmConst::DIR_L2R;
     m_pI2Info = NULL;
     m_FsmType = FAFsmConst::TYPE_MEALY_DFA;
+    m_UnkId = -1;
 }
 
 
@@ -284,3 +291,9 @@ const FAMultiMapCA * FADictConfKeeper::GetCharMap () const
 {
     return m_pCharMap;
 }
+
+
+const int FADictConfKeeper::GetUnkId () const
+{
+    return m_UnkId;
+}
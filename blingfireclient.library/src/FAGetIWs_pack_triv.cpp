@@ -13,7 +13,8 @@
 
 FAGetIWs_pack_triv::FAGetIWs_pack_triv () :
     m_pAutImage (NULL),
-    m_DstSize (FAFsmConst::TRIV_PACK_DEF_DST_SIZE)
+    m_DstSize (FAFsmConst::TRIV_PACK_DEF_DST_SIZE),
+    m_OwFirst (false)
 {}
 
 
@@ -28,6 +29,11 @@ void FAGetIWs_pack_triv::SetImage (const unsigned char * pAutImage)
         // get dst size
         m_DstSize = *(const int *)(m_pAutImage + Offset);
         Offset += sizeof (int);
+        // see whether Ows are stored right after the info byte
+        m_OwFirst = FAFsmConst::TRIV_PACK_OW_FIRST == (m_DstSize & ~0xff);
+        if (m_OwFirst) {
+            m_DstSize &= 0xff;
+        }
         if (1 > m_DstSize || 4 < m_DstSize) {
             m_DstSize = FAFsmConst::TRIV_PACK_DEF_DST_SIZE;
         }
@@ -65,6 +71,12 @@ const int FAGetIWs_pack_triv::
     // skip info
     pCurrPtr++;
 
+    // skip Ow, if it goes before the transitions
+    if (m_OwFirst) {
+        const int OwSizeCode = (info & 0x60) >> 5;
+        pCurrPtr += (3 == OwSizeCode) ? sizeof (int) : OwSizeCode;
+    }
+
     const int IwSize = ((info & 0x18) >> 3) + 1;
     DebugLogAssert (sizeof (char) <= (unsigned int) IwSize && \
             sizeof (int) >= (unsigned int) IwSize);
@@ -231,11 +231,11 @@ const int FAHmmTagger_l1::Process (int * pOut, const int MaxOutSize)
     float * pProbs = m_probs.begin ();
     DebugLogAssert (pProbs);
 
-    /// allocate array to keep back references
+    /// allocate array to keep back references, the array of the previous
+    /// sequence is reused
     const int TotalTagCount = pCounts [m_WordCount - 1];
-    const int MprevOldSize = m_prev_best_idx.size ();
-    m_prev_best_idx.resize (MprevOldSize + TotalTagCount);
-    int * pBackRefIdxs = m_prev_best_idx.begin () + MprevOldSize;
+    m_prev_best_idx.resize (TotalTagCount);
+    int * pBackRefIdxs = m_prev_best_idx.begin ();
     LogAssert (pBackRefIdxs);
     *pBackRefIdxs = -1;
 
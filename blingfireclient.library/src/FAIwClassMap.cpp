@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-client_src_pch.h"
+#include "FAConfig.h"
+#include "FAIwClassMap.h"
+#include "FAFsmConst.h"
+#include "FAUtf32Utils.h"
+
+#include <map>
+#include <string.h>
+
+
+FAIwClassMap::FAIwClassMap () :
+    m_pDfa (NULL),
+    m_IgnoreCase (false),
+    m_pBlocks (NULL),
+    m_pClasses (NULL)
+{}
+
+
+FAIwClassMap::~FAIwClassMap ()
+{
+    FAIwClassMap::Clear ();
+}
+
+
+void FAIwClassMap::Clear ()
+{
+    if (m_pBlocks) {
+        delete [] m_pBlocks;
+        m_pBlocks = NULL;
+    }
+    if (m_pClasses) {
+        delete [] m_pClasses;
+        m_pClasses = NULL;
+    }
+
+    m_pDfa = NULL;
+    m_IgnoreCase = false;
+}
+
+
+const bool FAIwClassMap::GetIgnoreCase () const
+{
+    return m_IgnoreCase;
+}
+
+
+const int FAIwClassMap::GetClass_slow (const int Symbol) const
+{
+    DebugLogAssert (m_pDfa);
+
+    int Iw = Symbol;
+
+    // prevent regular input weights to match control input weights
+    if (FAFsmConst::IW_EPSILON > Iw) {
+        Iw = FAFsmConst::IW_EPSILON;
+    }
+    if (m_IgnoreCase) {
+        Iw = ::FAUtf32ToLower (Iw);
+    }
+
+    return m_pDfa->GetNewIw (Iw);
+}
+
+
+const bool FAIwClassMap::Build (const FARSDfa_pack_triv * pDfa, const bool IgnoreCase)
+{
+    FAIwClassMap::Clear ();
+
+    if (!pDfa) {
+        return false;
+    }
+
+    m_pDfa = pDfa;
+    m_IgnoreCase = IgnoreCase;
+
+    // a symbol outside of the alphabet has no class, unless it is a control
+    // symbol or it can be case folded, so only the blocks which have such
+    // symbols are classified, the rest share one block without classes
+    unsigned char * pLive = new unsigned char [BlockCount];
+    LogAssert (pLive);
+    memset (pLive, 0, BlockCount);
+
+    // the control symbols are in the block 0
+    pLive [0] = 1;
+
+    if (m_IgnoreCase) {
+        memset (pLive, 1, (MaxCaseSymbol >> BlockBits) + 1);
+    }
+
+    const int * pIwIntervals = NULL;
+    const int IwIntervalsSize = pDfa->GetIwIntervals (&pIwIntervals);
+    DebugLogAssert (pIwIntervals && 0 == IwIntervalsSize % 2);
+
+    for (int i = 0; i < IwIntervalsSize; i += 2) {
+
+        const int IwFrom = pIwIntervals [i] < 0 ? 0 : pIwIntervals [i];
+        const int IwTo = pIwIntervals [i + 1] > MaxSymbol ? MaxSymbol : pIwIntervals [i + 1];
+
+        for (int Block = IwFrom >> BlockBits; Block <= (IwTo >> BlockBits); ++Block) {
+            pLive [Block] = 1;
+        }
+    }
+
+    int LiveCount = 0;
+
+    for (int Block = 0; Block < BlockCount; ++Block) {
+        LiveCount += pLive [Block];
+    }
+
+    // the unique blocks found so far, a block's hash --> the block's offset
+    std::multimap < unsigned long long, unsigned int > Hash2Offset;
+    // the unique blocks, there are no more of them than live blocks and the empty one
+    unsigned short * pClasses = new unsigned short [(LiveCount + 1) * BlockSize];
+    LogAssert (pClasses);
+
+    m_pBlocks = new unsigned int [BlockCount];
+    LogAssert (m_pBlocks);
+
+    unsigned int UniqueCount = 0;
+    // the offset of the block without classes, if added
+    unsigned int EmptyOffset = (unsigned int) -1;
+
+    for (int Block = 0; Block < BlockCount; ++Block) {
+
+        if (!pLive [Block] && (unsigned int) -1 != EmptyOffset) {
+            m_pBlocks [Block] = EmptyOffset;
+            continue;
+        }
+
+        unsigned short * pBlock = pClasses + (UniqueCount * BlockSize);
+        unsigned long long Hash = 14695981039346656037ULL;
+
+        for (int i = 0; i < BlockSize; ++i) {
+
+            const int Class = pLive [Block] ? GetClass_slow ((Block << BlockBits) | i) : -1;
+
+            // the alphabet does not fit into the class ids
+            if (NoClass <= Class) {
+                delete [] pLive;
+                delete [] pClasses;
+                FAIwClassMap::Clear ();
+                return false;
+            }
+
+            pBlock [i] = (unsigned short) (0 > Class ? NoClass : Class);
+            Hash = (Hash ^ pBlock [i]) * 1099511628211ULL;
+        }
+
+        // see if the same block already exists
+        unsigned int Offset = UniqueCount * BlockSize;
+
+        typedef std::multimap < unsigned long long, unsigned int >::const_iterator TIter;
+        const std::pair < TIter, TIter > Range = Hash2Offset.equal_range (Hash);
+
+        for (TIter it = Range.first; it != Range.second; ++it) {
+            if (0 == memcmp (pClasses + it->second, pBlock, BlockSize * sizeof (unsigned short))) {
+                Offset = it->second;
+                break;
+            }
+        }
+        if (UniqueCount * BlockSize == Offset) {
+            Hash2Offset.insert (std::make_pair (Hash, Offset));
+            UniqueCount++;
+        }
+        if (!pLive [Block]) {
+            EmptyOffset = Offset;
+        }
+
+        m_pBlocks [Block] = Offset;
+    }
+
+    delete [] pLive;
+
+    // keep the unique blocks only
+    m_pClasses = new unsigned short [UniqueCount * BlockSize];
+    LogAssert (m_pClasses);
+    memcpy (m_pClasses, pClasses, UniqueCount * BlockSize * sizeof (unsigned short));
+    delete [] pClasses;
+
+    return true;
+}
+
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-client_src_pch.h"
+#include "FAConfig.h"
+#include "FAMweTools.h"
+#include "FARSDfaCA.h"
+#include "FAState2OwCA.h"
+#include "FADictConfKeeper.h"
+
+
+FAMweTools::FAMweTools () :
+    m_pDfa (NULL),
+    m_pState2Ow (NULL),
+    m_Initial (-1)
+{}
+
+
+void FAMweTools::SetConf (const FADictConfKeeper * pConf)
+{
+    m_pDfa = NULL;
+    m_pState2Ow = NULL;
+    m_Initial = -1;
+
+    if (pConf) {
+        m_pDfa = pConf->GetRsDfa ();
+        m_pState2Ow = pConf->GetState2Ow ();
+    }
+    if (m_pDfa) {
+        m_Initial = m_pDfa->GetInitial ();
+    }
+}
+
+
+const int FAMweTools::
+    Process (
+            const int * pIn,
+            const int InSize,
+            __out_ecount(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        ) const
+{
+    if (!m_pDfa || !m_pState2Ow || -1 == m_Initial) {
+        return -1;
+    }
+
+    DebugLogAssert (0 == InSize || pIn);
+
+    int OutSize = 0;
+
+    for (int i = 0; i < InSize; ++i) {
+
+        int State = m_Initial;
+        int FinalState = -1;
+        int FinalPos = -1;
+
+        // follow the tokens as long as a phrase may continue
+        for (int j = i; j < InSize; ++j) {
+
+            const int Id = pIn [j];
+            if (0 > Id) {
+                break;
+            }
+            State = m_pDfa->GetDest (State, Id);
+            if (-1 == State) {
+                break;
+            }
+            if (m_pDfa->IsFinal (State)) {
+                FinalState = State;
+                FinalPos = j;
+            }
+        }
+
+        // the longest phrase starting at i, if any
+        if (-1 != FinalPos) {
+
+            if (OutSize + 3 <= MaxOutSize) {
+                DebugLogAssert (pOut);
+                pOut [OutSize] = m_pState2Ow->GetOw (FinalState);
+                pOut [OutSize + 1] = i;
+                pOut [OutSize + 2] = FinalPos;
+            }
+            OutSize += 3;
+
+            // skip the middle tokens
+            i = FinalPos;
+        }
+    }
+
+    return OutSize;
+}
@@ -30,6 +30,8 @@ void FAOw2Iw_pack_triv::SetImage (const unsigned char * pAutImage)
         // get dst size
         m_DstSize = *(const int *)(m_pAutImage + Offset);
         Offset += sizeof (int);
+        // Ow-first layout is not supported for Mealy automata
+        LogAssert (FAFsmConst::TRIV_PACK_OW_FIRST != (m_DstSize & ~0xff));
         if (1 > m_DstSize || 4 < m_DstSize) {
             m_DstSize = FAFsmConst::TRIV_PACK_DEF_DST_SIZE;
         }
@@ -23,6 +23,7 @@ FAParserConfKeeper::FAParserConfKeeper () :
     m_IgnoreCase (false),
     m_MaxDepth (DefMaxDepth),
     m_MaxPassCount (DefMaxPassCount),
+    m_ParserType (FAFsmConst::PARSER_TRIV),
     m_pWreCA (NULL),
     m_pActsCA (NULL),
     m_pActDataCA (NULL),
@@ -67,6 +68,14 @@ void FAParserConfKeeper::Initialize (const FALDB * pLDB, const int * pValues, co
             m_IgnoreCase = true;
             break;
         }
+        case FAFsmConst::PARAM_TYPE:
+        {
+            m_ParserType = pValues [++i];
+            LogAssert (FAFsmConst::PARSER_TRIV == m_ParserType || \
+                FAFsmConst::PARSER_NEST == m_ParserType || \
+                FAFsmConst::PARSER_WRE_LEX == m_ParserType);
+            break;
+        }
         case FAFsmConst::PARAM_WRE_CONF:
         {
             const int DumpNum = pValues [++i];
@@ -304,6 +313,7 @@ void FAParserConfKeeper::Clear ()
     m_IgnoreCase = false;
     m_MaxDepth = DefMaxDepth;
     m_MaxPassCount = DefMaxPassCount;
+    m_ParserType = FAFsmConst::PARSER_TRIV;
     m_Fn2IniSize = 0;
 }
 
@@ -338,6 +348,11 @@ const int FAParserConfKeeper::GetMaxPassCount () const
     return m_MaxPassCount;
 }
 
+const int FAParserConfKeeper::GetParserType () const
+{
+    return m_ParserType;
+}
+
 
 void FAParserConfKeeper::SetWre (const FAWREConfCA * pWre)
 {
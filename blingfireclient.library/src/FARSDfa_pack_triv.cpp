@@ -18,7 +18,8 @@ FARSDfa_pack_triv::FARSDfa_pack_triv () :
     m_pIws (NULL),
     m_InitialState (0),
     m_RemapIws (false),
-    m_DstSize (FAFsmConst::TRIV_PACK_DEF_DST_SIZE)
+    m_DstSize (FAFsmConst::TRIV_PACK_DEF_DST_SIZE),
+    m_OwFirst (false)
 {}
 
 
@@ -33,6 +34,11 @@ void FARSDfa_pack_triv::SetImage (const unsigned char * pAutImage)
         // get dst size
         m_DstSize = *(const int *)(m_pAutImage + Offset);
         Offset += sizeof (int);
+        // see whether Ows are stored right after the info byte
+        m_OwFirst = FAFsmConst::TRIV_PACK_OW_FIRST == (m_DstSize & ~0xff);
+        if (m_OwFirst) {
+            m_DstSize &= 0xff;
+        }
         if (1 > m_DstSize || 4 < m_DstSize) {
             m_DstSize = FAFsmConst::TRIV_PACK_DEF_DST_SIZE;
         }
@@ -123,6 +129,17 @@ const int FARSDfa_pack_triv::
 }
 
 
+const int FARSDfa_pack_triv::
+    GetIwIntervals (const int ** ppIwIntervals) const
+{
+    DebugLogAssert (m_pIws && 0 < m_IwCount && 0 == m_IwCount % 2);
+    DebugLogAssert (ppIwIntervals);
+
+    *ppIwIntervals = m_pIws;
+    return m_IwCount;
+}
+
+
 const bool FARSDfa_pack_triv::IsFinal (const int State) const
 {
     if (0 > State) {
@@ -138,21 +155,18 @@ const bool FARSDfa_pack_triv::IsFinal (const int State) const
 
 const int FARSDfa_pack_triv::GetDest (const int State, const int Iw) const
 {
-    if (0 > State) {
+    const int NewIw = GetNewIw (Iw);
+    if (-1 == NewIw)
         return -1;
-    }
 
-    int NewIw;
-
-    if (m_RemapIws) {
-
-        NewIw = m_iw2iw.GetNewIw (Iw);
-        if (-1 == NewIw)
-            return -1;
+    return GetDestNewIw (State, NewIw);
+}
 
-    } else {
 
-        NewIw = Iw;
+const int FARSDfa_pack_triv::GetDestNewIw (const int State, const int NewIw) const
+{
+    if (0 > State) {
+        return -1;
     }
 
     const unsigned char * pCurrPtr = m_pAutImage + State;
@@ -161,6 +175,12 @@ const int FARSDfa_pack_triv::GetDest (const int State, const int Iw) const
     // skip info
     pCurrPtr++;
 
+    // skip Ow, if it goes before the transitions
+    if (m_OwFirst) {
+        const int OwSizeCode = (info & 0x60) >> 5;
+        pCurrPtr += (3 == OwSizeCode) ? sizeof (int) : OwSizeCode;
+    }
+
     const int IwSize = ((info & 0x18) >> 3) + 1;
     DebugLogAssert (sizeof (char) <= (unsigned int) IwSize && \
             sizeof (int) >= (unsigned int) IwSize);
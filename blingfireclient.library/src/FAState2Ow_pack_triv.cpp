@@ -13,7 +13,8 @@
 
 FAState2Ow_pack_triv::FAState2Ow_pack_triv () :
     m_pAutImage (NULL),
-    m_DstSize (FAFsmConst::TRIV_PACK_DEF_DST_SIZE)
+    m_DstSize (FAFsmConst::TRIV_PACK_DEF_DST_SIZE),
+    m_OwFirst (false)
 {}
 
 void FAState2Ow_pack_triv::SetImage (const unsigned char * pAutImage)
@@ -23,6 +24,11 @@ void FAState2Ow_pack_triv::SetImage (const unsigned char * pAutImage)
     if (NULL != m_pAutImage) {
         // get dst size
         m_DstSize = *(const int *)(m_pAutImage);
+        // see whether Ows are stored right after the info byte
+        m_OwFirst = FAFsmConst::TRIV_PACK_OW_FIRST == (m_DstSize & ~0xff);
+        if (m_OwFirst) {
+            m_DstSize &= 0xff;
+        }
         if (1 > m_DstSize || 4 < m_DstSize) {
             m_DstSize = FAFsmConst::TRIV_PACK_DEF_DST_SIZE;
         }
@@ -47,70 +53,75 @@ const int FAState2Ow_pack_triv::GetOw (const int State) const
     // skip info
     pCurrPtr += sizeof (char);
 
-    // calc input weight size
-    const int IwSize = ((info & 0x18) >> 3) + 1;
-    DebugLogAssert (sizeof (char) <= (unsigned int) IwSize && \
-            sizeof (int) >= (unsigned int) IwSize);
-
-    const char TrType = info & 0x07;
-
-    // skip transitions
-    switch (TrType) {
-
-    // prallel arrays
-    case FAFsmConst::TRS_PARA:
-    {
-        unsigned int DstCount;
-        // decode (DstCount - 1) value
-        FADecode_UC_US_UI(pCurrPtr, 0, DstCount, IwSize);
-        // skip encoded (DstCount - 1) value
-        pCurrPtr += IwSize;
-        // skip two parallel arrays of Iws and Dsts 
-        pCurrPtr += ((DstCount + 1) * (m_DstSize + IwSize));
-        break;
-    }
+    // no need to skip the transitions, if Ow goes first
+    if (!m_OwFirst) {
+
+        // calc input weight size
+        const int IwSize = ((info & 0x18) >> 3) + 1;
+        DebugLogAssert (sizeof (char) <= (unsigned int) IwSize && \
+                sizeof (int) >= (unsigned int) IwSize);
+
+        const char TrType = info & 0x07;
+
+        // skip transitions
+        switch (TrType) {
+
+        // prallel arrays
+        case FAFsmConst::TRS_PARA:
+        {
+            unsigned int DstCount;
+            // decode (DstCount - 1) value
+            FADecode_UC_US_UI(pCurrPtr, 0, DstCount, IwSize);
+            // skip encoded (DstCount - 1) value
+            pCurrPtr += IwSize;
+            // skip two parallel arrays of Iws and Dsts 
+            pCurrPtr += ((DstCount + 1) * (m_DstSize + IwSize));
+            break;
+        }
 
-    // Iw-index array
-    case FAFsmConst::TRS_IWIA:
-    {
-        unsigned int IwBase;
-        unsigned int IwMax;
+        // Iw-index array
+        case FAFsmConst::TRS_IWIA:
+        {
+            unsigned int IwBase;
+            unsigned int IwMax;
 
-        FADecode_UC_US_UI(pCurrPtr, 0, IwBase, IwSize);
-        pCurrPtr += IwSize;
-        FADecode_UC_US_UI(pCurrPtr, 0, IwMax, IwSize);
-        pCurrPtr += IwSize;
+            FADecode_UC_US_UI(pCurrPtr, 0, IwBase, IwSize);
+            pCurrPtr += IwSize;
+            FADecode_UC_US_UI(pCurrPtr, 0, IwMax, IwSize);
+            pCurrPtr += IwSize;
 
-        DebugLogAssert (IwMax >= IwBase);
-        const unsigned int DstCount = IwMax - IwBase + 1;
+            DebugLogAssert (IwMax >= IwBase);
+            const unsigned int DstCount = IwMax - IwBase + 1;
 
-        // skip Destination Offsets
-        pCurrPtr += (m_DstSize * DstCount);
-        break;
-    }
+            // skip Destination Offsets
+            pCurrPtr += (m_DstSize * DstCount);
+            break;
+        }
 
-    // ranges
-    case FAFsmConst::TRS_RANGE:
-    {
-        unsigned int RangeCount;
-        // decode (RangeCount - 1) value
-        FADecode_UC_US_UI(pCurrPtr, 0, RangeCount, IwSize);
-        // skip encoded (RangeCount - 1) value
-        pCurrPtr += IwSize;
-        // skip FromIws, ToIws and Dsts
-        pCurrPtr += ((RangeCount + 1) * (m_DstSize + (IwSize * 2)));
-        break;
-    }
+        // ranges
+        case FAFsmConst::TRS_RANGE:
+        {
+            unsigned int RangeCount;
+            // decode (RangeCount - 1) value
+            FADecode_UC_US_UI(pCurrPtr, 0, RangeCount, IwSize);
+            // skip encoded (RangeCount - 1) value
+            pCurrPtr += IwSize;
+            // skip FromIws, ToIws and Dsts
+            pCurrPtr += ((RangeCount + 1) * (m_DstSize + (IwSize * 2)));
+            break;
+        }
 
-    // implicit transition
-    case FAFsmConst::TRS_IMPL:
-    {
-        // skip input weight
-        pCurrPtr += IwSize;
-        break;
-    }
+        // implicit transition
+        case FAFsmConst::TRS_IMPL:
+        {
+            // skip input weight
+            pCurrPtr += IwSize;
+            break;
+        }
+
+        }; // of switch (TrType) ...
 
-    }; // of switch (TrType) ...
+    } // of if (!m_OwFirst) ...
 
     int Ow;
 
@@ -395,6 +395,51 @@ const int FAStrUtf8ToUtf16LE (
     return i;
 }
 
+const int FAStrUtf16LEToArray (
+        const uint16_t * pStr,
+        const int Len,
+        __out_ecount(MaxSize) int * pArray,
+        __out_ecount(MaxSize) int * pOffsets,
+        const int MaxSize
+    )
+{
+    DebugLogAssert (0 == Len || pStr);
+    DebugLogAssert (pArray && pOffsets);
+
+    int i = 0;
+
+    // skip Byte-Order-Mark (U+FEFF symbol)
+    if (0 < Len && 0xFEFF == pStr [0]) {
+        i = 1;
+    }
+
+    // process symbol sequence
+    int Count = 0;
+
+    while (i < Len && Count < MaxSize) {
+
+        const int Offset = i;
+        int Symbol = pStr [i++];
+
+        if (FAIsSurrogate (Symbol)) {
+
+            // the high surrogate should be followed by the low one
+            if (0xDBFF < Symbol || i >= Len || 0xDC00 != (0xFC00 & pStr [i])) {
+                // invalid input sequence
+                return -1;
+            }
+
+            Symbol = 0x10000 + (((Symbol & 0x3FF) << 10) | (pStr [i++] & 0x3FF));
+        }
+
+        pArray [Count] = Symbol;
+        pOffsets [Count] = Offset;
+        Count++;
+    }
+
+    return Count;
+}
+
 char * FAIntToUtf8 (
         const int Symbol, 
         __out_ecount(MaxSize) char * ptr, 
@@ -15,6 +15,7 @@
 #include "FAMultiMap_pack.h"
 #include "FAMultiMap_pack_mph.h"
 #include "FAMultiMap_pack_fixed.h"
+#include "FAIwClassMap.h"
 #include "FALimits.h"
 
 
@@ -24,6 +25,7 @@ FAWbdConfKeeper::FAWbdConfKeeper () :
     m_pState2Ows (NULL),
     m_pMMapTriv(NULL),
     m_pActData (NULL),
+    m_pIwClassMap (NULL),
     m_IgnoreCase(false),
     m_pRsDfaA (NULL),
     m_pState2OwA (NULL),
@@ -214,6 +216,16 @@ void FAWbdConfKeeper::Initialize (const FALDB * pLDB, const int * pValues, const
         }
         m_pState2Ow->SetImage (pFsmDump);
         m_pState2OwA = m_pState2Ow;
+
+        // pre-compute the alphabet classes, so the input can be classified at once
+        if (!m_pIwClassMap) {
+            m_pIwClassMap = new FAIwClassMap;
+            LogAssert (m_pIwClassMap);
+        }
+        if (!m_pIwClassMap->Build (m_pRsDfa, m_IgnoreCase)) {
+            delete m_pIwClassMap;
+            m_pIwClassMap = NULL;
+        }
     } else if (FAFsmConst::TYPE_MOORE_MULTI_DFA == FsmType) {
         if (!m_pState2Ows) {
             m_pState2Ows = new FAState2Ows_pack_triv;
@@ -338,6 +350,10 @@ void FAWbdConfKeeper::Clear ()
         delete m_pActData;
         m_pActData = NULL;
     }
+    if (m_pIwClassMap) {
+        delete m_pIwClassMap;
+        m_pIwClassMap = NULL;
+    }
     if (m_pFn2Ini) {
         delete [] m_pFn2Ini;
         m_pFn2Ini = NULL;
@@ -490,3 +506,13 @@ const int FAWbdConfKeeper::GetMaxTokenLength () const
 {
     return m_MaxTokenLength;
 }
+
+const FAIwClassMap * FAWbdConfKeeper::GetIwClassMap () const
+{
+    // the classes are valid only for the automaton and the case folding they were built for
+    if (m_pIwClassMap && m_pRsDfaA == m_pRsDfa &&
+        m_IgnoreCase == m_pIwClassMap->GetIgnoreCase ()) {
+        return m_pIwClassMap;
+    }
+    return NULL;
+}
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-client_src_pch.h"
+#include "FAConfig.h"
+#include "FAWordPieceConfKeeper.h"
+#include "FAFsmConst.h"
+#include "FALDB.h"
+#include "FARSDfa_pack_triv.h"
+#include "FAState2Ow_pack_triv.h"
+#include "FALimits.h"
+
+
+FAWordPieceConfKeeper::FAWordPieceConfKeeper () :
+    m_pRsDfa (NULL),
+    m_pState2Ow (NULL),
+    m_IgnoreCase (false),
+    m_UnkId (DefUnkId),
+    m_MaxTokenLength (DefMaxTokenLength)
+{}
+
+
+FAWordPieceConfKeeper::~FAWordPieceConfKeeper ()
+{
+    FAWordPieceConfKeeper::Clear ();
+}
+
+
+void FAWordPieceConfKeeper::Initialize (
+        const FALDB * pLDB, 
+        const int * pValues, 
+        const int Size
+    )
+{
+    LogAssert (pLDB);
+    LogAssert (pValues || 0 >= Size);
+
+    FAWordPieceConfKeeper::Clear ();
+
+    for (int i = 0; i < Size; ++i) {
+
+        const int Param = pValues [i];
+
+        switch (Param) {
+
+        case FAFsmConst::PARAM_IGNORE_CASE:
+        {
+            m_IgnoreCase = true;
+            break;
+        }
+        case FAFsmConst::PARAM_UNKNOWN:
+        {
+            m_UnkId = pValues [++i];
+            LogAssert (0 <= m_UnkId);
+            break;
+        }
+        case FAFsmConst::PARAM_MAX_LENGTH:
+        {
+            m_MaxTokenLength = pValues [++i];
+            LogAssert (0 < m_MaxTokenLength && \
+                FALimits::MaxWordLen >= m_MaxTokenLength);
+            break;
+        }
+        case FAFsmConst::PARAM_FSM_TYPE:
+        {
+            const int FsmType = pValues [++i];
+            LogAssert (FAFsmConst::TYPE_MOORE_DFA == FsmType);
+            break;
+        }
+        case FAFsmConst::PARAM_FSM:
+        {
+            const int DumpNum = pValues [++i];
+            const unsigned char * pDump = pLDB->GetDump (DumpNum);
+            LogAssert (pDump);
+
+            if (!m_pRsDfa) {
+                m_pRsDfa = new FARSDfa_pack_triv;
+                LogAssert (m_pRsDfa);
+            }
+            m_pRsDfa->SetImage (pDump);
+
+            if (!m_pState2Ow) {
+                m_pState2Ow = new FAState2Ow_pack_triv;
+                LogAssert (m_pState2Ow);
+            }
+            m_pState2Ow->SetImage (pDump);
+
+            break;
+        }
+        default:
+            // unknown parameters in the configuration file
+            LogAssert (false);
+        }
+    } // of for (int i = 0; ...
+}
+
+
+void FAWordPieceConfKeeper::Clear ()
+{
+    if (m_pRsDfa) {
+        delete m_pRsDfa;
+        m_pRsDfa = NULL;
+    }
+    if (m_pState2Ow) {
+        delete m_pState2Ow;
+        m_pState2Ow = NULL;
+    }
+
+    m_IgnoreCase = false;
+    m_UnkId = DefUnkId;
+    m_MaxTokenLength = DefMaxTokenLength;
+}
+
+
+const FARSDfaCA * FAWordPieceConfKeeper::GetRsDfa () const
+{
+    return m_pRsDfa;
+}
+
+
+const FAState2OwCA * FAWordPieceConfKeeper::GetState2Ow () const
+{
+    return m_pState2Ow;
+}
+
+
+const bool FAWordPieceConfKeeper::GetIgnoreCase () const
+{
+    return m_IgnoreCase;
+}
+
+
+const int FAWordPieceConfKeeper::GetUnkId () const
+{
+    return m_UnkId;
+}
+
+
+const int FAWordPieceConfKeeper::GetMaxTokenLength () const
+{
+    return m_MaxTokenLength;
+}
@@ -8,6 +8,7 @@
 #define _FA_ANY2ANYOTHER_GLOBAL_T_H_
 
 #include "FAConfig.h"
+#include "FAFsmConst.h"
 #include "FASetUtils.h"
 #include "FAUtils.h"
 #include "FALimits.h"
@@ -228,6 +229,14 @@ void FAAny2AnyOther_global_t< NFA_in, NFA_out >::
             const int * pDst;
             int DstCount = m_pInNfa->GetDest (State, Iw, &pDst);
 
+            // an explicitly dead transition, e.g. from [^a], stays dead
+            if (0 == DstCount || \
+                (1 == DstCount && FAFsmConst::NFA_DEAD_STATE == *pDst)) {
+                const int DeadState = FAFsmConst::NFA_DEAD_STATE;
+                m_pOutNfa->SetTransition (State, Iw, &DeadState, 1);
+                continue;
+            }
+
             m_sets.SetRes (pDst, DstCount, SET_DSTS);
             m_sets.SelfUnion (pAnyDst, AnyDstCount, SET_DSTS);
             DstCount = m_sets.GetRes (&pDst, SET_DSTS);
@@ -21,6 +21,11 @@ public:
 public:
     const int GetAt (const int Idx) const;
     const int GetCount () const;
+    const int GetRange (
+            const int From,
+            const int Count,
+            __out_ecount(Count) int * pOut
+        ) const;
     void SetArray (const int * pA, const int Count);
 
 private:
@@ -236,7 +236,7 @@ const bool FAAutInterpretTools_trbr_t< Ty >::
     m_pos_chain.resize (Size);
     int * pPosChain = m_pos_chain.begin ();
 
-    if (true == Chain2PosChain_local (pInChain, pPosChain, Size)) {
+    if (true == this->Chain2PosChain_local (pInChain, pPosChain, Size)) {
 
         ExtractBrackets (pPosChain, Size, pBrRes);
 
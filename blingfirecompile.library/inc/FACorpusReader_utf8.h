@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_CORPUSREADER_UTF8_H_
+#define _FA_CORPUSREADER_UTF8_H_
+
+#include "FAConfig.h"
+#include "FATaggedTextCA.h"
+#include "FAArray_cont_t.h"
+
+#include <iostream>
+#include <string>
+
+class FAAllocatorA;
+class FATagSet;
+
+///
+/// Reads a tagged corpus sentence by sentence, the object itself is the
+/// current sentence. The input is either the text in FACorpusIOTools_utf8
+/// format or the binary format written by FACorpusWriter_bin.
+///
+/// A file is memory mapped and its format is detected by the header, a
+/// stream is read line by line and should be a text. The text is parsed
+/// in place, words and tags are kept in the buffers reused for all the
+/// sentences. The binary corpus is not parsed at all, words point into the
+/// lexicon of the mapped file.
+///
+/// Binary format, native-endian ints:
+///
+///   Magic, Version, LexOffset, then for each sentence:
+///   WordCount, (WordId, Tag, Offset) * WordCount
+///   and at LexOffset (in ints from the beginning):
+///   LexCount, (Length, Symbol_1, ..., Symbol_Length) * LexCount
+///
+/// Note: the tags are stored as ids, the same tagset should be used for
+///   reading and writing.
+///
+
+class FACorpusReader_utf8 : public FATaggedTextCA {
+
+public:
+    FACorpusReader_utf8 (FAAllocatorA * pAlloc);
+    virtual ~FACorpusReader_utf8 ();
+
+public:
+    /// sets up the tagset, not needed for the binary input
+    void SetTagSet (const FATagSet * pTagSet);
+    /// specifies whether words don't have POS tags
+    void SetNoPosTags (const bool NoPosTags);
+
+    /// maps the file, detects its format
+    void Open (const char * pFileName);
+    /// reads the text from the stream
+    void Open (std::istream * pIs);
+    /// releases the input
+    void Close ();
+
+    /// reads the next sentence, the same as FACorpusIOTools_utf8::Read does
+    void Read ();
+    /// returns true if the input is over, the same as std::istream::eof
+    const bool IsEof () const;
+    /// returns true if the input is in binary format
+    const bool IsBinary () const;
+    /// makes the current sentence empty
+    void Clear ();
+
+public:
+    const int GetWordCount () const;
+    const int GetWord (const int Num, const int ** pWord) const;
+    const int GetTag (const int Num) const;
+    const int GetOffset (const int Num) const;
+
+public:
+    /// binary format constants
+    enum {
+        BinMagic = 0x00425446,
+        BinVersion = 1,
+        BinHeaderSize = 3,
+    };
+
+private:
+    // gets the next line of the text
+    inline const bool GetLine (const char ** ppStr, int * pLen);
+    // parses the text line
+    void ParseLine (const char * pStr, const int Len);
+    // adds a word of the text line
+    inline void AddWord (
+            const char * pWord,
+            const int WordLen,
+            const char * pTag,
+            const int TagLen,
+            const int Offset
+        );
+    // validates the binary header and indexes the lexicon
+    void OpenBin ();
+    // reads the binary sentence
+    void ReadBin ();
+
+    void Map (const char * pFileName);
+    void Unmap ();
+
+private:
+    const FATagSet * m_pTagSet;
+    bool m_NoPosTags;
+
+    // mapped data
+    const char * m_pData;
+    size_t m_Size;
+#ifndef BLING_FIRE_NOWINDOWS
+    HANDLE m_hFileMapping;
+#endif
+    // the current position and the end of the mapped data
+    const char * m_pPos;
+    const char * m_pEnd;
+    bool m_Binary;
+    bool m_Eof;
+
+    // the stream input
+    std::istream * m_pIs;
+    std::string m_line;
+
+    // UTF-32 symbols of the text sentence
+    FAArray_cont_t < int > m_chars;
+    // the symbols of the current sentence
+    const int * m_pChars;
+    // (Pos, Length, Tag, Offset) for each word, Pos is relative to m_pChars
+    FAArray_cont_t < int > m_words;
+    int m_WordCount;
+    // WordId -> position of the word in the binary data, in ints
+    FAArray_cont_t < int > m_lex;
+
+    enum {
+        WordInfoSize = 4,
+    };
+};
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_CORPUSWRITER_BIN_H_
+#define _FA_CORPUSWRITER_BIN_H_
+
+#include "FAConfig.h"
+#include "FAChain2Num_hash.h"
+
+#include <iostream>
+
+class FAAllocatorA;
+class FATaggedTextCA;
+
+///
+/// Writes tagged sentences in the binary corpus format, see
+/// FACorpusReader_utf8.h for the format description.
+///
+/// Words are interned, each sentence is stored as the word ids, tags and
+/// offsets, the word lexicon is written once by Finish.
+///
+/// Note: the output stream should be seekable and opened in binary mode.
+///
+
+class FACorpusWriter_bin {
+
+public:
+    FACorpusWriter_bin (FAAllocatorA * pAlloc);
+
+public:
+    /// sets up the output stream and writes the header
+    void SetStream (std::ostream * pOs);
+    /// writes the sentence
+    void Print (const FATaggedTextCA * pS);
+    /// writes the lexicon and updates the header
+    void Finish ();
+
+private:
+    inline void PrintInt (const int Val);
+
+private:
+    std::ostream * m_pOs;
+    // the size of the data written so far, in ints
+    int m_Size;
+    // word -> word id
+    FAChain2Num_hash m_word2id;
+};
+
+#endif
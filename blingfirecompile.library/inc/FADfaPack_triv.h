@@ -26,7 +26,7 @@ class FAMealyDfaA;
 ///
 /// BEGIN
 /// Header:
-///   <DstSize>                                  : int; valid values are 1..4
+///   <DstSize> | [TRIV_PACK_OW_FIRST]           : int; valid values are 1..4
 ///   <offset of the encoded Ows sets>           : int; 0 if does not exist
 ///   if (RemapIws) {
 ///     0x80000000 | <AlphabetSize>              : int
@@ -50,6 +50,9 @@ class FAMealyDfaA;
 /// State representation format:
 /// BEGIN
 ///   <info>                                     : char
+///   if (OwFirst) {
+///     [<Ow> | <Ows set offset>]                : <OwSize>
+///   }
 ///   if (TRS_IMPL) {
 ///      <iw>                                    : <IwSize>
 ///    } else if (TRS_PARA) {
@@ -66,7 +69,9 @@ class FAMealyDfaA;
 ///      <ToIws>                                 : <IwSize> * Count
 ///      <parallel array of destination states>  : <DstSize> * Count
 ///    }
-///    [<Ow> | <Ows set offset>]                 : <OwSize>
+///    if (!OwFirst) {
+///      [<Ow> | <Ows set offset>]               : <OwSize>
+///    }
 /// END
 ///
 /// <info> bits description:
@@ -85,6 +90,9 @@ class FAMealyDfaA;
 /// END
 ///
 /// Note:
+/// OwFirst layout is for Moore automata only, it makes GetOw/GetOws to be
+/// O(1) as no transitions have to be skipped.
+///
 /// See FARSDfa_pack_triv, FAState2Ow_pack_triv, FAState2Ows_pack_triv,
 /// FAMealyDfa_pack_triv and FAOw2Iw_pack_triv for interpretation of this dump.
 ///
@@ -109,6 +117,8 @@ public:
     void SetUseIwIA (const bool UseIwIA);
     /// uses ranges whenever possible, false by default
     void SetUseRanges (const bool UseRanges);
+    /// stores Ow (Ows set offset) right after the info byte, false by default
+    void SetOwFirst (const bool OwFirst);
     /// sets up Dst (DstOffset) size, 3 is used by default
     void SetDstSize (const int DstSize);
     /// builds dump
@@ -224,6 +234,8 @@ private:
     bool m_UseIwIA;
     // indicates whether Iw ranges are allowed to use
     bool m_UseRanges;
+    // Ow goes right after the info byte
+    bool m_OwFirst;
     // output buffer pointer
     unsigned char * m_pOutBuff;
     // mapping from state number into offset
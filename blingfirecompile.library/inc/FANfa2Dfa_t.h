@@ -17,6 +17,7 @@
 #include "FAState2OwsA.h"
 #include "FAFsmConst.h"
 #include "FAUtils.h"
+#include "FAException.h"
 
 #include <algorithm>
 
@@ -49,6 +50,9 @@ public:
   /// specifies whether it is necessary to map new states to old ones,
   /// does not do mapping by default
   void SetNew2Old (FAState2OwsA * pNew2Old);
+  /// sets up the maximum number of DFA states, if the DFA gets bigger
+  /// Process throws FAException, -1 means no limit (the default)
+  void SetMaxStateCount (const int MaxStateCount);
 
   /// makes determinization
   void Process ();
@@ -85,6 +89,8 @@ private:
   void add_transitions ();
   // adds transitions into Dfa (with any symbol)
   void add_transitions_any ();
+  // frees unprocessed sets, pFromSet is the set being processed
+  void free_stack (int * pFromSet);
 
 private:
 
@@ -135,6 +141,9 @@ private:
   /// holds: If false == m_any_iw Then false == m_has_any;
   bool m_has_any;
 
+  /// maximum number of states, -1 if not limited
+  int m_MaxStateCount;
+
   /// memory allocator
   FAAllocatorA * m_pAlloc;
 
@@ -150,6 +159,7 @@ FANfa2Dfa_t<_TNfa, _TDfa>::FANfa2Dfa_t (FAAllocatorA * pAlloc) :
     m_process_any (false),
     m_any_iw (-1),
     m_has_any (false),
+    m_MaxStateCount (-1),
     m_pAlloc (pAlloc)
 {
     m_stack.SetAllocator (m_pAlloc);
@@ -246,6 +256,28 @@ void FANfa2Dfa_t<_TNfa, _TDfa>::SetNew2Old (FAState2OwsA * pNew2Old)
 }
 
 
+template <class _TNfa, class _TDfa>
+void FANfa2Dfa_t<_TNfa, _TDfa>::SetMaxStateCount (const int MaxStateCount)
+{
+    m_MaxStateCount = MaxStateCount;
+}
+
+
+template <class _TNfa, class _TDfa>
+void FANfa2Dfa_t<_TNfa, _TDfa>::free_stack (int * pFromSet)
+{
+    FAFree (m_pAlloc, pFromSet);
+
+    const int Count = m_stack.size ();
+
+    for (int i = 0; i < Count; ++i) {
+        FAFree (m_pAlloc, m_stack [i]);
+    }
+
+    m_stack.resize (0);
+}
+
+
 template <class _TNfa, class _TDfa>
 void FANfa2Dfa_t<_TNfa, _TDfa>::Clear ()
 {
@@ -771,6 +803,12 @@ void FANfa2Dfa_t<_TNfa, _TDfa>::Process ()
                 /// check if we should add this state for further processing
                 if (true == m_was_added) {
 
+                    // stop if the DFA gets too big
+                    if (-1 != m_MaxStateCount && m_states > m_MaxStateCount) {
+                        free_stack (pFromSet);
+                        FAError (FAMsg::LimitIsExceeded);
+                    }
+
                     int * pDstState_DstSet = 
                     (int*) FAAlloc (m_pAlloc, sizeof (int) * (DstSetSize + 1));
 
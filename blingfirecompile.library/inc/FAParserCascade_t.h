@@ -0,0 +1,703 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_PARSERCASCADE_T_H_
+#define _FA_PARSERCASCADE_T_H_
+
+#include "FAConfig.h"
+#include "FAFsmConst.h"
+#include "FALimits.h"
+#include "FALDB.h"
+#include "FAArray_cont_t.h"
+#include "FAMap_judy.h"
+#include "FARSDfaCA.h"
+#include "FAState2OwCA.h"
+#include "FAArrayCA.h"
+#include "FAWREConfCA.h"
+#include "FAParseTreeA.h"
+#include "FAParserConfKeeper.h"
+#include "FADigitizer_t.h"
+#include "FADigitizer_dct_t.h"
+#include "FADictInterpreter_t.h"
+#include "FAParser_base_t.h"
+#include "FAParser_triv_t.h"
+#include "FAParser_nest_t.h"
+
+class FAAllocatorA;
+
+///
+/// Runs an ordered list of WRE parser stages over the same sentence. Each
+/// stage works on the parse tree left by the previous one, so constituents
+/// built by a stage are the input labels of the following stages.
+///
+/// Each word is digitized once per distinct digitizer, stages compiled with
+/// identical text digitizers, dictionary digitizers or tag Ow bases share
+/// the same Ow arrays. All stages use the same allocator.
+///
+/// The stages are read from the FAFsmConst::FUNC_WRE_CASCADE section of the
+/// LDB, each stage starts with the wre-conf parameter and may be followed by
+/// any parameter accepted by FAParserConfKeeper, e.g.:
+///
+///   [wre-cascade]
+///   wre-conf 5
+///   action-map 6
+///   type 0
+///   wre-conf 7
+///   action-map 8
+///   type 1
+///   max-pass-count 2
+///
+/// where type 0 is FAFsmConst::PARSER_TRIV and type 1 is PARSER_NEST.
+///
+/// Usage:
+///   1. Initialize
+///   2. SetTagDict, if any stage uses dictionary digitizer
+///   3. SetParseTree
+///   foreach (Sentence in Input) do
+///     foreach (Word in Sentence) do
+///       4. AddWord (Word)
+///     done
+///     5. Process ()
+///   done
+///
+
+template < class Ty >
+class FAParserCascade_t {
+
+public:
+    FAParserCascade_t (FAAllocatorA * pAlloc);
+    ~FAParserCascade_t ();
+
+public:
+    /// reads the stages, pValues is the FUNC_WRE_CASCADE initialization vector
+    void Initialize (const FALDB * pLDB, const int * pValues, const int Size);
+    /// sets up tag dictionary (needed for stages with dictionary digitizer)
+    void SetTagDict (const FADictInterpreter_t < Ty > * pTagDict);
+    /// sets up output tree container
+    void SetParseTree (FAParseTreeA * pTree);
+    /// sets up whether the first stage should resume from preexisting tree
+    void SetResume (const bool Resume);
+
+    /// returns the number of stages
+    const int GetStageCount () const;
+    /// returns the number of distinct text digitizers
+    const int GetTxtDigitizerCount () const;
+
+    /// adds next word, the object should already be initialized
+    void AddWord (
+            const Ty * pText,       // word text
+            const int TextLen,      // word text length
+            const int Tag,          // POS tag (after disambiguation)
+            const int DctSetId = -1 // tag dictionary id for the given word
+        );
+    /// runs all the stages
+    void Process ();
+
+private:
+    /// returns object into the initial state
+    void Clear ();
+    /// returns true if two Moore automata are isomorphic
+    const bool IsEqual (
+            const FARSDfaCA * pDfa1,
+            const FAState2OwCA * pOws1,
+            const FARSDfaCA * pDfa2,
+            const FAState2OwCA * pOws2
+        ) const;
+    /// returns true if the parameter has no value
+    static inline const bool IsBooleanParam (const int Param);
+    /// returns true if two arrays have the same elements
+    static inline const bool IsEqual (
+            const FAArrayCA * pArr1,
+            const FAArrayCA * pArr2
+        );
+    /// returns digitizer index for the stage, adds a new one if needed
+    const int GetTxtDig (const FAWREConfCA * pWre, const bool IgnoreCase);
+    const int GetDctDig (const FAWREConfCA * pWre);
+    const int GetTagDig (const FAWREConfCA * pWre);
+
+private:
+    /// a common allocator
+    FAAllocatorA * m_pAlloc;
+
+    /// stage configurations and parsers
+    FAParserConfKeeper ** m_ppConfs;
+    FAParser_base_t < Ty > ** m_ppParsers;
+    /// stage -> digitizer indices, -1 if the stage does not need it
+    int * m_pStage2Txt;
+    int * m_pStage2Tag;
+    int * m_pStage2Dct;
+    int m_StageCount;
+
+    /// distinct text digitizers and their Ows
+    FADigitizer_t < Ty > ** m_ppTxtDigs;
+    const FAWREConfCA ** m_ppTxtWres;
+    bool * m_pTxtIgnoreCase;
+    FAArray_cont_t < int > * m_pTxtOws;
+    int m_TxtCount;
+    /// distinct dictionary digitizers and their Ows
+    FADigitizer_dct_t < Ty > * m_pDctDigs;
+    const FAArrayCA ** m_ppDctArrs;
+    FAArray_cont_t < int > * m_pDctOws;
+    int m_DctCount;
+    /// distinct tag Ow bases and their Ows
+    int * m_pTagOwBases;
+    FAArray_cont_t < int > * m_pTagOws;
+    int m_TagCount;
+
+    /// the output tree
+    FAParseTreeA * m_pTree;
+    bool m_Resume;
+    /// number of added words
+    int m_WordCount;
+
+    enum {
+        BlockSize = 256,
+    };
+};
+
+
+template < class Ty >
+FAParserCascade_t< Ty >::FAParserCascade_t (FAAllocatorA * pAlloc) :
+    m_pAlloc (pAlloc),
+    m_ppConfs (NULL),
+    m_ppParsers (NULL),
+    m_pStage2Txt (NULL),
+    m_pStage2Tag (NULL),
+    m_pStage2Dct (NULL),
+    m_StageCount (0),
+    m_ppTxtDigs (NULL),
+    m_ppTxtWres (NULL),
+    m_pTxtIgnoreCase (NULL),
+    m_pTxtOws (NULL),
+    m_TxtCount (0),
+    m_pDctDigs (NULL),
+    m_ppDctArrs (NULL),
+    m_pDctOws (NULL),
+    m_DctCount (0),
+    m_pTagOwBases (NULL),
+    m_pTagOws (NULL),
+    m_TagCount (0),
+    m_pTree (NULL),
+    m_Resume (false),
+    m_WordCount (0)
+{}
+
+
+template < class Ty >
+FAParserCascade_t< Ty >::~FAParserCascade_t ()
+{
+    FAParserCascade_t< Ty >::Clear ();
+}
+
+
+template < class Ty >
+void FAParserCascade_t< Ty >::Clear ()
+{
+    for (int i = 0; i < m_StageCount; ++i) {
+        delete m_ppParsers [i];
+        delete m_ppConfs [i];
+    }
+    for (int i = 0; i < m_TxtCount; ++i) {
+        delete m_ppTxtDigs [i];
+    }
+
+    delete [] m_ppParsers;
+    m_ppParsers = NULL;
+    delete [] m_ppConfs;
+    m_ppConfs = NULL;
+    delete [] m_pStage2Txt;
+    m_pStage2Txt = NULL;
+    delete [] m_pStage2Tag;
+    m_pStage2Tag = NULL;
+    delete [] m_pStage2Dct;
+    m_pStage2Dct = NULL;
+    m_StageCount = 0;
+
+    delete [] m_ppTxtDigs;
+    m_ppTxtDigs = NULL;
+    delete [] m_ppTxtWres;
+    m_ppTxtWres = NULL;
+    delete [] m_pTxtIgnoreCase;
+    m_pTxtIgnoreCase = NULL;
+    delete [] m_pTxtOws;
+    m_pTxtOws = NULL;
+    m_TxtCount = 0;
+
+    delete [] m_pDctDigs;
+    m_pDctDigs = NULL;
+    delete [] m_ppDctArrs;
+    m_ppDctArrs = NULL;
+    delete [] m_pDctOws;
+    m_pDctOws = NULL;
+    m_DctCount = 0;
+
+    delete [] m_pTagOwBases;
+    m_pTagOwBases = NULL;
+    delete [] m_pTagOws;
+    m_pTagOws = NULL;
+    m_TagCount = 0;
+
+    m_WordCount = 0;
+}
+
+
+template < class Ty >
+void FAParserCascade_t< Ty >::
+    Initialize (const FALDB * pLDB, const int * pValues, const int Size)
+{
+    LogAssert (pLDB);
+    LogAssert (pValues && 0 < Size);
+
+    FAParserCascade_t< Ty >::Clear ();
+
+    // count the stages, each starts with PARAM_WRE_CONF
+    LogAssert (FAFsmConst::PARAM_WRE_CONF == pValues [0]);
+
+    int StageCount = 0;
+    for (int i = 0; i < Size; ++i) {
+        const int Param = pValues [i];
+        if (FAFsmConst::PARAM_WRE_CONF == Param) {
+            StageCount++;
+        }
+        if (!IsBooleanParam (Param)) {
+            ++i;
+        }
+    }
+
+    m_ppConfs = new FAParserConfKeeper * [StageCount];
+    m_ppParsers = new FAParser_base_t < Ty > * [StageCount];
+    m_pStage2Txt = new int [StageCount];
+    m_pStage2Tag = new int [StageCount];
+    m_pStage2Dct = new int [StageCount];
+    LogAssert (m_ppConfs && m_ppParsers && m_pStage2Txt && m_pStage2Tag && \
+        m_pStage2Dct);
+
+    // there cannot be more distinct digitizers than stages
+    m_ppTxtDigs = new FADigitizer_t < Ty > * [StageCount];
+    m_ppTxtWres = new const FAWREConfCA * [StageCount];
+    m_pTxtIgnoreCase = new bool [StageCount];
+    m_pTxtOws = new FAArray_cont_t < int > [StageCount];
+    m_pDctDigs = new FADigitizer_dct_t < Ty > [StageCount];
+    m_ppDctArrs = new const FAArrayCA * [StageCount];
+    m_pDctOws = new FAArray_cont_t < int > [StageCount];
+    m_pTagOwBases = new int [StageCount];
+    m_pTagOws = new FAArray_cont_t < int > [StageCount];
+    LogAssert (m_ppTxtDigs && m_ppTxtWres && m_pTxtIgnoreCase && m_pTxtOws && \
+        m_pDctDigs && m_ppDctArrs && m_pDctOws && m_pTagOwBases && m_pTagOws);
+
+    for (int i = 0; i < StageCount; ++i) {
+        m_pTxtOws [i].SetAllocator (m_pAlloc);
+        m_pTxtOws [i].Create ();
+        m_pDctOws [i].SetAllocator (m_pAlloc);
+        m_pDctOws [i].Create ();
+        m_pTagOws [i].SetAllocator (m_pAlloc);
+        m_pTagOws [i].Create ();
+    }
+
+    // create the stages
+    int From = 0;
+
+    while (From < Size) {
+
+        int To = From;
+        do {
+            To += IsBooleanParam (pValues [To]) ? 1 : 2;
+        } while (To < Size && FAFsmConst::PARAM_WRE_CONF != pValues [To]);
+        LogAssert (To <= Size);
+
+        FAParserConfKeeper * pConf = new FAParserConfKeeper;
+        LogAssert (pConf);
+        m_ppConfs [m_StageCount] = pConf;
+        m_ppParsers [m_StageCount] = NULL;
+        m_StageCount++;
+
+        pConf->Initialize (pLDB, pValues + From, To - From);
+
+        const FAWREConfCA * pWre = pConf->GetWre ();
+        const FAMultiMapCA * pActs = pConf->GetActs ();
+        LogAssert (pWre && pActs);
+        LogAssert (FAFsmConst::WRE_TYPE_MOORE == pWre->GetType ());
+
+        const int ParserType = pConf->GetParserType ();
+        const bool IgnoreCase = pConf->GetIgnoreCase ();
+
+        FAParser_base_t < Ty > * pParser = NULL;
+
+        if (FAFsmConst::PARSER_TRIV == ParserType) {
+            pParser = new FAParser_triv_t < Ty > (m_pAlloc);
+        } else if (FAFsmConst::PARSER_NEST == ParserType) {
+            pParser = new FAParser_nest_t < Ty > (m_pAlloc);
+        }
+        LogAssert (pParser);
+        m_ppParsers [m_StageCount - 1] = pParser;
+
+        // digitizers are owned by the cascade, the parser gets Ows only
+        pParser->SetRules (pWre->GetDfa1 (), pWre->GetState2Ows ());
+        pParser->SetActions (pActs);
+        pParser->SetTokenType (pWre->GetTokenType ());
+        pParser->SetTagOwBase (pWre->GetTagOwBase ());
+        pParser->SetMaxPassCount (pConf->GetMaxPassCount ());
+
+        const int TokenType = pWre->GetTokenType ();
+
+        m_pStage2Txt [m_StageCount - 1] = \
+            (FAFsmConst::WRE_TT_TEXT & TokenType) ? \
+                GetTxtDig (pWre, IgnoreCase) : -1;
+        m_pStage2Tag [m_StageCount - 1] = \
+            (FAFsmConst::WRE_TT_TAGS & TokenType) ? GetTagDig (pWre) : -1;
+        m_pStage2Dct [m_StageCount - 1] = \
+            (FAFsmConst::WRE_TT_DCTS & TokenType) ? GetDctDig (pWre) : -1;
+
+        From = To;
+    }
+
+    DebugLogAssert (StageCount == m_StageCount);
+
+    if (m_pTree) {
+        SetParseTree (m_pTree);
+    }
+}
+
+
+template < class Ty >
+inline const bool FAParserCascade_t< Ty >::IsBooleanParam (const int Param)
+{
+    return FAFsmConst::PARAM_IGNORE_CASE == Param;
+}
+
+
+template < class Ty >
+inline const bool FAParserCascade_t< Ty >::
+    IsEqual (const FAArrayCA * pArr1, const FAArrayCA * pArr2)
+{
+    DebugLogAssert (pArr1 && pArr2);
+
+    if (pArr1 == pArr2) {
+        return true;
+    }
+
+    const int Count = pArr1->GetCount ();
+
+    if (Count != pArr2->GetCount ()) {
+        return false;
+    }
+
+    // compare block by block
+    int Block1 [BlockSize];
+    int Block2 [BlockSize];
+
+    for (int i = 0; i < Count; i += BlockSize) {
+
+        const int Size1 = pArr1->GetRange (i, BlockSize, Block1);
+        const int Size2 = pArr2->GetRange (i, BlockSize, Block2);
+
+        if (Size1 != Size2 || \
+            0 != memcmp (Block1, Block2, sizeof (int) * Size1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template < class Ty >
+const bool FAParserCascade_t< Ty >::
+    IsEqual (
+        const FARSDfaCA * pDfa1,
+        const FAState2OwCA * pOws1,
+        const FARSDfaCA * pDfa2,
+        const FAState2OwCA * pOws2
+    ) const
+{
+    DebugLogAssert (pDfa1 && pOws1 && pDfa2 && pOws2);
+
+    if (pDfa1 == pDfa2 && pOws1 == pOws2) {
+        return true;
+    }
+
+    // compare the alphabets
+    const int IwCount = pDfa1->GetIWs (NULL, 0);
+
+    if (IwCount != pDfa2->GetIWs (NULL, 0) || 0 >= IwCount) {
+        return false;
+    }
+
+    int * pIws = new int [2 * IwCount];
+    LogAssert (pIws);
+
+    pDfa1->GetIWs (pIws, IwCount);
+    pDfa2->GetIWs (pIws + IwCount, IwCount);
+
+    bool Equal = 0 == memcmp (pIws, pIws + IwCount, IwCount * sizeof (int));
+
+    // traverse both automata simultaneously, the state mapping must be 1:1
+    FAMap_judy s1_s2;
+    FAMap_judy s2_s1;
+    FAArray_cont_t < int > stack;
+    stack.SetAllocator (m_pAlloc);
+    stack.Create ();
+
+    const int Initial1 = pDfa1->GetInitial ();
+    const int Initial2 = pDfa2->GetInitial ();
+
+    s1_s2.Set (Initial1, Initial2);
+    s2_s1.Set (Initial2, Initial1);
+    stack.push_back (Initial1);
+    stack.push_back (Initial2);
+
+    while (Equal && 0 < stack.size ()) {
+
+        const int State2 = stack [stack.size () - 1];
+        const int State1 = stack [stack.size () - 2];
+        stack.resize (stack.size () - 2);
+
+        if (pDfa1->IsFinal (State1) != pDfa2->IsFinal (State2) || \
+            pOws1->GetOw (State1) != pOws2->GetOw (State2)) {
+            Equal = false;
+            break;
+        }
+
+        for (int i = 0; i < IwCount; ++i) {
+
+            const int Iw = pIws [i];
+            const int Dst1 = pDfa1->GetDest (State1, Iw);
+            const int Dst2 = pDfa2->GetDest (State2, Iw);
+
+            if (0 > Dst1 || 0 > Dst2) {
+                if (0 > Dst1 && 0 > Dst2) {
+                    continue;
+                }
+                Equal = false;
+                break;
+            }
+
+            const int * pDst2 = s1_s2.Get (Dst1);
+            const int * pDst1 = s2_s1.Get (Dst2);
+
+            if (!pDst1 && !pDst2) {
+                s1_s2.Set (Dst1, Dst2);
+                s2_s1.Set (Dst2, Dst1);
+                stack.push_back (Dst1);
+                stack.push_back (Dst2);
+            } else if (!pDst1 || !pDst2 || *pDst2 != Dst2 || *pDst1 != Dst1) {
+                Equal = false;
+                break;
+            }
+        }
+    }
+
+    delete [] pIws;
+
+    return Equal;
+}
+
+
+template < class Ty >
+const int FAParserCascade_t< Ty >::
+    GetTxtDig (const FAWREConfCA * pWre, const bool IgnoreCase)
+{
+    DebugLogAssert (pWre);
+
+    const FARSDfaCA * pDfa = pWre->GetTxtDigDfa ();
+    const FAState2OwCA * pOws = pWre->GetTxtDigOws ();
+    LogAssert (pDfa && pOws);
+
+    for (int i = 0; i < m_TxtCount; ++i) {
+
+        const FAWREConfCA * pWre2 = m_ppTxtWres [i];
+
+        if (IgnoreCase == m_pTxtIgnoreCase [i] && \
+            IsEqual (pDfa, pOws, pWre2->GetTxtDigDfa (), pWre2->GetTxtDigOws ())) {
+            return i;
+        }
+    }
+
+    FADigitizer_t < Ty > * pDig = new FADigitizer_t < Ty >;
+    LogAssert (pDig);
+
+    pDig->SetAnyIw (FAFsmConst::IW_ANY);
+    pDig->SetAnyOw (FAFsmConst::IW_ANY);
+    pDig->SetIgnoreCase (IgnoreCase);
+    pDig->SetRsDfa (pDfa);
+    pDig->SetState2Ow (pOws);
+    pDig->Prepare ();
+
+    m_ppTxtDigs [m_TxtCount] = pDig;
+    m_ppTxtWres [m_TxtCount] = pWre;
+    m_pTxtIgnoreCase [m_TxtCount] = IgnoreCase;
+
+    return m_TxtCount++;
+}
+
+
+template < class Ty >
+const int FAParserCascade_t< Ty >::GetDctDig (const FAWREConfCA * pWre)
+{
+    DebugLogAssert (pWre);
+
+    const FAArrayCA * pSet2Ow = pWre->GetDictDig ();
+    LogAssert (pSet2Ow);
+
+    for (int i = 0; i < m_DctCount; ++i) {
+        if (IsEqual (pSet2Ow, m_ppDctArrs [i])) {
+            return i;
+        }
+    }
+
+    m_pDctDigs [m_DctCount].SetAnyOw (FAFsmConst::IW_ANY);
+    m_pDctDigs [m_DctCount].SetSet2Ow (pSet2Ow);
+    m_ppDctArrs [m_DctCount] = pSet2Ow;
+
+    return m_DctCount++;
+}
+
+
+template < class Ty >
+const int FAParserCascade_t< Ty >::GetTagDig (const FAWREConfCA * pWre)
+{
+    DebugLogAssert (pWre);
+
+    const int TagOwBase = pWre->GetTagOwBase ();
+
+    for (int i = 0; i < m_TagCount; ++i) {
+        if (TagOwBase == m_pTagOwBases [i]) {
+            return i;
+        }
+    }
+
+    m_pTagOwBases [m_TagCount] = TagOwBase;
+
+    return m_TagCount++;
+}
+
+
+template < class Ty >
+void FAParserCascade_t< Ty >::
+    SetTagDict (const FADictInterpreter_t < Ty > * pTagDict)
+{
+    for (int i = 0; i < m_DctCount; ++i) {
+        m_pDctDigs [i].SetTagDict (pTagDict);
+    }
+}
+
+
+template < class Ty >
+void FAParserCascade_t< Ty >::SetParseTree (FAParseTreeA * pTree)
+{
+    DebugLogAssert (pTree);
+
+    m_pTree = pTree;
+
+    for (int i = 0; i < m_StageCount; ++i) {
+        m_ppParsers [i]->SetParseTree (pTree);
+    }
+}
+
+
+template < class Ty >
+void FAParserCascade_t< Ty >::SetResume (const bool Resume)
+{
+    m_Resume = Resume;
+}
+
+
+template < class Ty >
+const int FAParserCascade_t< Ty >::GetStageCount () const
+{
+    return m_StageCount;
+}
+
+
+template < class Ty >
+const int FAParserCascade_t< Ty >::GetTxtDigitizerCount () const
+{
+    return m_TxtCount;
+}
+
+
+template < class Ty >
+void FAParserCascade_t< Ty >::
+    AddWord (
+        const Ty * pText,
+        const int TextLen,
+        const int Tag,
+        const int DctSetId
+    )
+{
+    DebugLogAssert (FALimits::MinTag <= Tag && FALimits::MaxTag >= Tag);
+    DebugLogAssert (pText && 0 < TextLen);
+
+    int i;
+
+    for (i = 0; i < m_TxtCount; ++i) {
+        const int Ow = m_ppTxtDigs [i]->Process (pText, TextLen);
+        m_pTxtOws [i].push_back (Ow);
+    }
+    for (i = 0; i < m_TagCount; ++i) {
+        const int Ow = Tag + m_pTagOwBases [i];
+        m_pTagOws [i].push_back (Ow);
+    }
+    for (i = 0; i < m_DctCount; ++i) {
+        int Ow;
+        if (-1 == DctSetId) {
+            Ow = m_pDctDigs [i].Process (pText, TextLen);
+        } else {
+            Ow = m_pDctDigs [i].Process (DctSetId);
+        }
+        m_pDctOws [i].push_back (Ow);
+    }
+
+    m_WordCount++;
+}
+
+
+template < class Ty >
+void FAParserCascade_t< Ty >::Process ()
+{
+    LogAssert (m_pTree);
+
+    int i;
+
+    if (0 < m_WordCount) {
+
+        // all the stages work on the same tree
+        if (!m_Resume) {
+            m_pTree->Init (m_WordCount);
+        }
+
+        for (i = 0; i < m_StageCount; ++i) {
+
+            const int TxtDig = m_pStage2Txt [i];
+            const int TagDig = m_pStage2Tag [i];
+            const int DctDig = m_pStage2Dct [i];
+
+            const int * pTxtOws = -1 != TxtDig ? m_pTxtOws [TxtDig].begin () : NULL;
+            const int * pTagOws = -1 != TagDig ? m_pTagOws [TagDig].begin () : NULL;
+            const int * pDctOws = -1 != DctDig ? m_pDctOws [DctDig].begin () : NULL;
+
+            FAParser_base_t < Ty > * pParser = m_ppParsers [i];
+
+            pParser->SetResume (true);
+            pParser->SetWordOws (pTxtOws, pTagOws, pDctOws, m_WordCount);
+            pParser->Process ();
+        }
+    }
+
+    // clear the word Ows
+    for (i = 0; i < m_TxtCount; ++i) {
+        m_pTxtOws [i].resize (0);
+    }
+    for (i = 0; i < m_TagCount; ++i) {
+        m_pTagOws [i].resize (0);
+    }
+    for (i = 0; i < m_DctCount; ++i) {
+        m_pDctOws [i].resize (0);
+    }
+
+    m_WordCount = 0;
+}
+
+#endif
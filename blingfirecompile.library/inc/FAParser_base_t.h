@@ -73,6 +73,15 @@ public:
             const int Tag,          // POS tag (after disambiguation)
             const int DctSetId = -1 // tag dictionary id for the given word
         );
+    /// sets up already digitized words, can be used instead of AddWord,
+    /// the arrays are not copied and must stay valid until Process returns,
+    /// an array can be NULL if the token type does not need it
+    void SetWordOws (
+            const int * pTxtOws,    // text digitizer Ows
+            const int * pTagOws,    // tag Ows, Tag + TagOwBase
+            const int * pDctOws,    // dict digitizer Ows
+            const int WordCount     // number of words
+        );
     /// makes parsing
     void Process ();
 
@@ -143,6 +152,13 @@ protected:
     /// dict "digitizer" output weights
     FAArray_cont_t < int > m_i2ow_dct;
     const int * m_pI2Ow_dct;
+    /// externally digitized words, see SetWordOws
+    const int * m_pExtOw_txt;
+    const int * m_pExtOw_tag;
+    const int * m_pExtOw_dct;
+    bool m_UseExtOws;
+    /// number of digitized words
+    int m_OwCount;
 
     /// rule nums storage
     FAArray_cont_t < int > m_Rules;
@@ -172,6 +188,11 @@ FAParser_base_t< Ty >::FAParser_base_t (FAAllocatorA * pAlloc) :
     m_pI2Ow_txt (NULL),
     m_pI2Ow_tag (NULL),
     m_pI2Ow_dct (NULL),
+    m_pExtOw_txt (NULL),
+    m_pExtOw_tag (NULL),
+    m_pExtOw_dct (NULL),
+    m_UseExtOws (false),
+    m_OwCount (0),
     m_pRules (NULL),
     m_MaxRulesSize (0)
 {
@@ -347,12 +368,34 @@ void FAParser_base_t< Ty >::AddWord (
 }
 
 
+template < class Ty >
+void FAParser_base_t< Ty >::SetWordOws (
+        const int * pTxtOws,
+        const int * pTagOws,
+        const int * pDctOws,
+        const int WordCount
+    )
+{
+    DebugLogAssert (0 == m_UpperCount);
+    DebugLogAssert (0 < WordCount);
+    DebugLogAssert (pTxtOws || !(FAFsmConst::WRE_TT_TEXT & m_TokenType));
+    DebugLogAssert (pTagOws || !(FAFsmConst::WRE_TT_TAGS & m_TokenType));
+    DebugLogAssert (pDctOws || !(FAFsmConst::WRE_TT_DCTS & m_TokenType));
+
+    m_pExtOw_txt = pTxtOws;
+    m_pExtOw_tag = pTagOws;
+    m_pExtOw_dct = pDctOws;
+    m_UseExtOws = true;
+
+    m_UpperCount = WordCount;
+}
+
+
 template < class Ty >
 inline const int FAParser_base_t< Ty >::
     GetNextState (int State, const int i) const
 {
-    DebugLogAssert (m_pLabels && m_pRulesDfa && \
-            m_pI2Ow_txt && m_pI2Ow_tag && m_pI2Ow_dct);
+    DebugLogAssert (m_pLabels && m_pRulesDfa);
 
     int Iw;
 
@@ -364,7 +407,7 @@ inline const int FAParser_base_t< Ty >::
         if (FAFsmConst::WRE_TT_TEXT & m_TokenType && -1 != State) {
 
             if (0 <= L) {
-                DebugLogAssert ((unsigned int) L < m_i2ow_txt.size ());
+                DebugLogAssert (L < m_OwCount && m_pI2Ow_txt);
                 Iw = m_pI2Ow_txt [L];
             } else {
                 Iw = FAFsmConst::IW_ANY;
@@ -374,7 +417,7 @@ inline const int FAParser_base_t< Ty >::
         if (FAFsmConst::WRE_TT_TAGS & m_TokenType && -1 != State) {
 
             if (0 <= L) {
-                DebugLogAssert ((unsigned int) L < m_i2ow_tag.size ());
+                DebugLogAssert (L < m_OwCount && m_pI2Ow_tag);
                 Iw = m_pI2Ow_tag [L];
             } else {
                 Iw = m_TagOwBase - L;
@@ -384,7 +427,7 @@ inline const int FAParser_base_t< Ty >::
         if (FAFsmConst::WRE_TT_DCTS & m_TokenType && -1 != State) {
 
             if (0 <= L) {
-                DebugLogAssert ((unsigned int) L < m_i2ow_dct.size ());
+                DebugLogAssert (L < m_OwCount && m_pI2Ow_dct);
                 Iw = m_pI2Ow_dct [L];
             } else {
                 Iw = FAFsmConst::IW_ANY;
@@ -474,6 +517,12 @@ void FAParser_base_t< Ty >::Clear ()
     m_i2ow_tag.resize (0);
     m_i2ow_dct.resize (0);
 
+    m_pExtOw_txt = NULL;
+    m_pExtOw_tag = NULL;
+    m_pExtOw_dct = NULL;
+    m_UseExtOws = false;
+    m_OwCount = 0;
+
     m_UpperCount = 0;
     m_pLabels = NULL;
 }
@@ -483,9 +532,16 @@ template < class Ty >
 void FAParser_base_t< Ty >::Prepare ()
 {
     // update fast access pointers
-    m_pI2Ow_txt = m_i2ow_txt.begin ();
-    m_pI2Ow_tag = m_i2ow_tag.begin ();
-    m_pI2Ow_dct = m_i2ow_dct.begin ();
+    if (m_UseExtOws) {
+        m_pI2Ow_txt = m_pExtOw_txt;
+        m_pI2Ow_tag = m_pExtOw_tag;
+        m_pI2Ow_dct = m_pExtOw_dct;
+    } else {
+        m_pI2Ow_txt = m_i2ow_txt.begin ();
+        m_pI2Ow_tag = m_i2ow_tag.begin ();
+        m_pI2Ow_dct = m_i2ow_dct.begin ();
+    }
+    m_OwCount = m_UpperCount;
 
     // create an empty tree, if needed
     if (!m_Resume) {
@@ -34,6 +34,12 @@ public:
     void SetEncodingName (const char * pEncStr);
     /// sets up input regexp text
     void SetRegexp (const char * pRegexp, const int Length);
+    /// sets up the maximum number of DFA states, if the subset construction
+    /// gets bigger Process throws FAException, -1 means no limit (default)
+    void SetMaxStateCount (const int MaxStateCount);
+    /// sets up the maximum number of NFA states, it is checked before the
+    /// '.' expansion, -1 means no limit (default)
+    void SetMaxNfaStateCount (const int MaxNfaStateCount);
     /// makes the construction
     void Process ();
     /// returns read-only interface to the corresponding Min DFA
@@ -52,6 +58,8 @@ private:
     // DFA -> Min DFA
     FADfa2MinDfa_hg_t < FARSDfa_wo_ro, FARSDfa_ro > m_dfa2mindfa;
     FARSDfa_ro m_min_dfa;
+    // NFA state count limit
+    int m_MaxNfaStateCount;
 };
 
 #endif
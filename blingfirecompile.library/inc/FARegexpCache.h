@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_REGEXPCACHE_H_
+#define _FA_REGEXPCACHE_H_
+
+#include "FAConfig.h"
+#include "FARSDfaCA.h"
+
+#include <memory>
+#include <mutex>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+class FAAllocatorA;
+
+///
+/// Compiles regular expressions into packed minimal DFAs in memory and keeps
+/// the most recently used ones, so repeated patterns are compiled once.
+///
+/// The regular expression syntax is the same as for fa_re2nfa --label=char,
+/// the pipeline is FARegexp2MinDfa + FADfaPack_triv. The resulting automaton
+/// follows the fa_re2nfa conventions: '^' and '$' are FAFsmConst::IW_L_ANCHOR
+/// and FAFsmConst::IW_R_ANCHOR transitions, '.' is expanded over the pattern
+/// alphabet and other symbols should be tried as FAFsmConst::IW_ANY.
+///
+/// Notes:
+/// 1. The cache key is the pattern text and the encoding name.
+/// 2. The returned automaton stays valid while the caller holds the pointer,
+///    even if it has already been evicted from the cache.
+/// 3. Get is thread-safe, compilation is done outside of the lock, so the
+///    allocator must be thread-safe as well, FAAllocator is.
+/// 4. Compilation errors and exceeded limits are reported as FAException,
+///    failed patterns are not cached.
+///
+
+class FARegexpCache {
+
+public:
+    FARegexpCache (FAAllocatorA * pAlloc);
+    ~FARegexpCache ();
+
+public:
+    /// sets up the maximum number of cached automata, 128 by default,
+    /// -1 means no limit
+    void SetMaxCount (const int MaxCount);
+    /// sets up the maximum number of DFA states of one pattern, 10000 by
+    /// default, -1 means no limit
+    void SetMaxStateCount (const int MaxStateCount);
+    /// sets up the maximum number of NFA states of one pattern, -1 means
+    /// no limit (default)
+    void SetMaxNfaStateCount (const int MaxNfaStateCount);
+
+    /// returns the automaton for the regular expression, compiles it if
+    /// it is not in the cache
+    std::shared_ptr < const FARSDfaCA > Get (
+            const char * pRegexp,
+            const int Length,
+            const char * pEncName = "UTF-8"
+        );
+
+    /// returns the number of cached automata
+    const int GetCount () const;
+    /// removes all automata from the cache
+    void Clear ();
+
+private:
+    // compiled pattern
+    class FAEntry;
+    typedef std::shared_ptr < const FAEntry > FAEntryPtr;
+    typedef std::list < std::pair < std::string, FAEntryPtr > > FALruList;
+
+    // builds the automaton
+    FAEntryPtr Compile (
+            const char * pRegexp,
+            const int Length,
+            const char * pEncName
+        ) const;
+    // removes least recently used entries above the limit
+    void Evict ();
+
+private:
+    FAAllocatorA * m_pAlloc;
+    // most recently used entries go first
+    FALruList m_lru;
+    // key -> position in m_lru
+    std::unordered_map < std::string, FALruList::iterator > m_key2pos;
+    // guards all the fields
+    mutable std::mutex m_mutex;
+    // limits
+    int m_MaxCount;
+    int m_MaxStateCount;
+    int m_MaxNfaStateCount;
+
+    enum {
+        DefMaxCount = 128,
+        DefMaxStateCount = 10000,
+    };
+};
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_SCANNERCOMPILER_H_
+#define _FA_SCANNERCOMPILER_H_
+
+#include "FAConfig.h"
+#include "FAArray_cont_t.h"
+#include "FARSNfa_wo_ro.h"
+#include "FARSDfa_wo_ro.h"
+#include "FARegexp2Nfa.h"
+#include "FANfaCreator_char.h"
+#include "FANfas2CommonENfa.h"
+
+class FAAllocatorA;
+class FARSDfaA;
+class FAState2Ows;
+
+///
+/// Compiles a set of regular expressions into a single scanner image, see
+/// FAScanner_pack and FAScannerTools_t for the runtime.
+///
+/// The image consists of the minimal Moore DFA of the union of all patterns,
+/// the reaction of a state is the set of pattern ids which end at it and
+/// PatternCount + PatId for every pattern which can still be matched from it,
+/// the minimal Moore DFA of .* followed by the union of the reversed patterns,
+/// read right to left its reaction is the set of pattern ids which start at
+/// the current position, and for every pattern with triangular brackets of its own position DFA and
+/// position NFA with bracket maps (the same data as fa_re2nfa --keep-pos and
+/// fa_nfa2dfa --fsm=pos-rs-nfa produce for the single pattern).
+///
+/// Image format:
+/// BEGIN
+///   <PatternCount>                                : int
+///   <offset to the union Moore DFA>               : int
+///   <offset to the reverse union Moore DFA>       : int
+///   <offset to the position DFA of pattern 0>     : int, 0 if no brackets
+///   <offset to the position NFA of pattern 0>     : int, 0 if no brackets
+///   ...
+///   <offset to the position DFA of pattern N-1>   : int
+///   <offset to the position NFA of pattern N-1>   : int
+///   <dumps>                                       : 4-bytes aligned
+/// END
+///
+/// Notes:
+/// 1. Patterns use the fa_re2nfa --label=char syntax in UTF-8.
+/// 2. Pattern ids are assigned in the order of AddPattern calls.
+///
+
+class FAScannerCompiler {
+
+public:
+    FAScannerCompiler (FAAllocatorA * pAlloc);
+
+public:
+    /// adds one more pattern, the text is copied
+    void AddPattern (const char * pRe, const int Length);
+    /// builds the image
+    void Process ();
+    /// returns the image
+    const int GetDump (const unsigned char ** ppDump) const;
+    /// returns object into the initial state
+    void Clear ();
+
+private:
+    // builds NFA of the pattern PatId in m_nfa
+    void BuildNfa (const int PatId);
+    // collects the symbols of all patterns into m_alphabet
+    void BuildAlphabet ();
+    // builds NFA for the union DFA from the pattern PatId, reversed if
+    // fReverse is true, the '.'-symbol is expanded with m_alphabet
+    void AddUnionNfa (const int PatId, const bool fReverse);
+    // builds union Moore DFA from m_common and stores its dump at the
+    // header position HeaderPos, the reverse DFA gets .* prefix
+    void StoreUnionDfa (const bool fReverse, const int HeaderPos);
+    // builds and stores position automata of the pattern PatId, if needed
+    void StorePosAutomata (const int PatId);
+    // adds PatCount + PatId reaction to every state of pDfa from which the
+    // pattern PatId can still be matched
+    void AddLiveOws (
+            const FARSDfaA * pDfa,
+            FAState2Ows * pOws,
+            const int PatCount
+        ) const;
+    // appends dump to the image, returns its offset
+    const int StoreDump (const unsigned char * pDump, const int Size);
+    // returns the text of the pattern
+    const char * GetPattern (const int PatId, int * pLength) const;
+
+private:
+    FAAllocatorA * m_pAlloc;
+    // pattern texts, one after another
+    FAArray_cont_t < char > m_text;
+    // pattern -> offset in m_text, the last element is the end
+    FAArray_cont_t < int > m_pat2offset;
+    // Regexp -> NFA, for the union
+    FARegexp2Nfa m_re2nfa;
+    FANfaCreator_char m_nfa;
+    // Regexp -> position NFA, for the brackets
+    FARegexp2Nfa m_re2pos;
+    FANfaCreator_char m_pos_nfa;
+    // the '.'-expansion alphabet, symbols of all patterns
+    FAArray_cont_t < int > m_alphabet;
+    // union of the patterns
+    FANfas2CommonENfa m_common;
+    // output image
+    FAArray_cont_t < unsigned char > m_dump;
+
+    enum {
+        // pattern ids are added as Iws after all Unicode symbols
+        PatIdBase = 0x110000,
+        // header size in ints, without per pattern offsets
+        HeaderSize = 3,
+    };
+};
+
+#endif
@@ -0,0 +1,606 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_SCANNERTOOLS_T_H_
+#define _FA_SCANNERTOOLS_T_H_
+
+#include "FAConfig.h"
+#include "FAScanner_pack.h"
+#include "FARSDfaCA.h"
+#include "FAState2OwsCA.h"
+#include "FAAutInterpretTools_trbr_t.h"
+#include "FABrResultA.h"
+#include "FAArray_cont_t.h"
+#include "FAFsmConst.h"
+#include "FAUtils.h"
+
+#include <algorithm>
+#include <string.h>
+
+class FAAllocatorA;
+
+///
+/// Finds all matches of the pattern set compiled by FAScannerCompiler. For
+/// every pattern the matches are leftmost-longest and do not overlap, so the
+/// result is the same as if each pattern was searched separately, the matches
+/// of different patterns may overlap.
+///
+/// The output is an array of records:
+///   <PatId> <From> <To> <BrCount> [<BrId> <BrFrom> <BrTo>] * BrCount
+/// the records are sorted by <From> and then by <PatId>, <To> and <BrTo>
+/// are inclusive.
+///
+/// Notes:
+/// 1. One right to left pass of the reverse union DFA finds for every position
+///    the patterns which have a match starting there. The union DFA is run
+///    only from the positions where such a pattern does not overlap its
+///    previous match and only while one of these patterns can still be
+///    matched, so matches are not limited in length. The cost is linear
+///    unless a pattern has long partial matches, as for the patterns
+///    searched separately.
+/// 2. The bracket positions are recovered from the position DFA of the
+///    matched pattern only, so patterns without brackets cost nothing extra.
+/// 3. Not thread safe, use one object per thread, the scanner image can be
+///    shared.
+///
+
+template < class Ty >
+class FAScannerTools_t {
+
+public:
+    FAScannerTools_t (FAAllocatorA * pAlloc);
+    ~FAScannerTools_t ();
+
+public:
+    /// sets up the scanner image
+    void SetScanner (const FAScanner_pack * pScanner);
+
+    /// Finds matches in pIn, returns the size of the output. If the returned
+    /// value is bigger than MaxOutSize then the output is not complete, only
+    /// the records which fit completely are stored.
+    const int Process (
+            const Ty * pIn,
+            const int InSize,
+            __out_ecount_opt(MaxOutSize) int * pOut,
+            const int MaxOutSize
+        );
+
+private:
+    // maps input symbol into the DFA alphabet
+    inline static const int Symbol2Iw (const int Symbol);
+    // remembers the longest match end for the patterns of the State,
+    // returns false if none of m_starts can be matched from the State
+    inline const bool AddEnds (
+            const int State,
+            const int End,
+            const int Anchors
+        );
+    // walks the union DFA from the position From, -1 stands for the left
+    // anchor, adds the matched patterns into m_touched
+    inline void Match (const Ty * pIn, const int InSize, const int From);
+    // reads the text from the right to the left with the reverse union DFA,
+    // fills in m_rev_states, returns the state after the left anchor
+    inline const int MatchStarts (const Ty * pIn, const int InSize);
+    // fills in m_starts with the patterns of the reverse DFA State which do
+    // not overlap their previous matches at From, returns their count
+    inline const int GetStarts (const int State, const int From);
+    // writes down the match, returns the new output size
+    inline const int Emit (
+            const Ty * pIn,
+            const int InSize,
+            const int PatId,
+            const int From,
+            int * pOut,
+            const int OutSize,
+            const int MaxOutSize
+        );
+    // returns all the objects into the initial state
+    void Clear ();
+
+private:
+    // collects bracket results
+    class FABrRes : public FABrResultA {
+    public:
+        void AddRes (const int BrId, const int From, const int To);
+    public:
+        FAArray_cont_t < int > m_res;
+    };
+
+private:
+    FAAllocatorA * m_pAlloc;
+    const FAScanner_pack * m_pScanner;
+    const FARSDfaCA * m_pDfa;
+    const FAState2OwsCA * m_pState2Ows;
+    const FARSDfaCA * m_pRevDfa;
+    const FAState2OwsCA * m_pRevState2Ows;
+    int m_PatCount;
+    // bracket interpreters, NULL for the patterns without brackets
+    FAArray_cont_t < FAAutInterpretTools_trbr_t < int > * > m_trbrs;
+    // pattern -> the leftmost position of the next match
+    FAArray_cont_t < int > m_next_from;
+    // pattern -> the end of the longest match from the current position
+    FAArray_cont_t < int > m_ends;
+    // pattern -> anchors used by the longest match, AnchorL | AnchorR
+    FAArray_cont_t < int > m_anchors;
+    // patterns touched from the current position
+    FAArray_cont_t < int > m_touched;
+    // patterns starting at the current position
+    FAArray_cont_t < int > m_starts;
+    // position -> reverse DFA state after reading the text from the position
+    FAArray_cont_t < int > m_rev_states;
+    // Ows buffer
+    FAArray_cont_t < int > m_ows;
+    // chain for the bracket extraction
+    FAArray_cont_t < int > m_chain;
+    // bracket results
+    FABrRes m_br_res;
+
+    enum {
+        AnchorL = 1,
+        AnchorR = 2,
+    };
+};
+
+
+template < class Ty >
+void FAScannerTools_t< Ty >::FABrRes::
+    AddRes (const int BrId, const int From, const int To)
+{
+    m_res.push_back (BrId);
+    m_res.push_back (From);
+    m_res.push_back (To);
+}
+
+
+template < class Ty >
+FAScannerTools_t< Ty >::FAScannerTools_t (FAAllocatorA * pAlloc) :
+    m_pAlloc (pAlloc),
+    m_pScanner (NULL),
+    m_pDfa (NULL),
+    m_pState2Ows (NULL),
+    m_pRevDfa (NULL),
+    m_pRevState2Ows (NULL),
+    m_PatCount (0)
+{
+    m_trbrs.SetAllocator (pAlloc);
+    m_trbrs.Create ();
+    m_next_from.SetAllocator (pAlloc);
+    m_next_from.Create ();
+    m_ends.SetAllocator (pAlloc);
+    m_ends.Create ();
+    m_anchors.SetAllocator (pAlloc);
+    m_anchors.Create ();
+    m_touched.SetAllocator (pAlloc);
+    m_touched.Create ();
+    m_starts.SetAllocator (pAlloc);
+    m_starts.Create ();
+    m_rev_states.SetAllocator (pAlloc);
+    m_rev_states.Create ();
+    m_ows.SetAllocator (pAlloc);
+    m_ows.Create ();
+    m_chain.SetAllocator (pAlloc);
+    m_chain.Create ();
+    m_br_res.m_res.SetAllocator (pAlloc);
+    m_br_res.m_res.Create ();
+}
+
+
+template < class Ty >
+FAScannerTools_t< Ty >::~FAScannerTools_t ()
+{
+    FAScannerTools_t< Ty >::Clear ();
+}
+
+
+template < class Ty >
+void FAScannerTools_t< Ty >::Clear ()
+{
+    for (unsigned int i = 0; i < m_trbrs.size (); ++i) {
+        if (m_trbrs [i]) {
+            delete m_trbrs [i];
+        }
+    }
+    m_trbrs.resize (0);
+
+    m_pScanner = NULL;
+    m_pDfa = NULL;
+    m_pState2Ows = NULL;
+    m_pRevDfa = NULL;
+    m_pRevState2Ows = NULL;
+    m_PatCount = 0;
+}
+
+
+template < class Ty >
+void FAScannerTools_t< Ty >::SetScanner (const FAScanner_pack * pScanner)
+{
+    Clear ();
+
+    if (NULL == pScanner) {
+        return;
+    }
+
+    m_pScanner = pScanner;
+    m_pDfa = pScanner->GetDfa ();
+    m_pState2Ows = pScanner->GetState2Ows ();
+    m_pRevDfa = pScanner->GetRevDfa ();
+    m_pRevState2Ows = pScanner->GetRevState2Ows ();
+    m_PatCount = pScanner->GetPatternCount ();
+
+    int MaxOwsCount = m_pState2Ows->GetMaxOwsCount ();
+    if (MaxOwsCount < m_pRevState2Ows->GetMaxOwsCount ()) {
+        MaxOwsCount = m_pRevState2Ows->GetMaxOwsCount ();
+    }
+    m_ows.resize (MaxOwsCount + 1);
+    m_next_from.resize (m_PatCount);
+    m_ends.resize (m_PatCount);
+    m_anchors.resize (m_PatCount);
+    m_trbrs.resize (m_PatCount);
+
+    for (int PatId = 0; PatId < m_PatCount; ++PatId) {
+
+        m_ends [PatId] = -1;
+        m_anchors [PatId] = 0;
+        m_trbrs [PatId] = NULL;
+
+        if (!pScanner->HasBrackets (PatId)) {
+            continue;
+        }
+
+        FAAutInterpretTools_trbr_t < int > * pTrBr = \
+            NEW FAAutInterpretTools_trbr_t < int > (m_pAlloc);
+        LogAssert (pTrBr);
+
+        pTrBr->SetAnyIw (FAFsmConst::IW_ANY);
+        pTrBr->SetRsDfa (pScanner->GetPosDfa (PatId));
+        pTrBr->SetState2Ows (pScanner->GetPosState2Ows (PatId));
+        pTrBr->SetFollow (pScanner->GetFollow (PatId));
+        pTrBr->SetPos2BrBegin (pScanner->GetPos2BrBegin (PatId));
+        pTrBr->SetPos2BrEnd (pScanner->GetPos2BrEnd (PatId));
+
+        m_trbrs [PatId] = pTrBr;
+    }
+}
+
+
+template < class Ty >
+inline const int FAScannerTools_t< Ty >::Symbol2Iw (const int Symbol)
+{
+    // symbols colliding with the special Iws match '.' only
+    if (FAFsmConst::IW_EPSILON >= Symbol) {
+        return FAFsmConst::IW_EPSILON;
+    }
+    return Symbol;
+}
+
+
+template < class Ty >
+inline const bool FAScannerTools_t< Ty >::
+    AddEnds (const int State, const int End, const int Anchors)
+{
+    int * pOws = m_ows.begin ();
+    const int MaxOwsCount = m_ows.size ();
+
+    const int OwsCount = m_pState2Ows->GetOws (State, pOws, MaxOwsCount);
+    DebugLogAssert (OwsCount <= MaxOwsCount);
+
+    int i = 0;
+
+    for (; i < OwsCount; ++i) {
+
+        const int PatId = pOws [i];
+        DebugLogAssert (0 <= PatId);
+
+        // the rest are the patterns which can still be matched
+        if (m_PatCount <= PatId) {
+            break;
+        }
+
+        const int OldEnd = m_ends [PatId];
+
+        if (-1 == OldEnd) {
+            m_touched.push_back (PatId);
+        } else if (OldEnd > End || \
+                   (OldEnd == End && m_anchors [PatId] <= Anchors)) {
+            // keep the longest match, which uses fewer anchors
+            continue;
+        }
+
+        m_ends [PatId] = End;
+        m_anchors [PatId] = Anchors;
+    }
+
+    const int * pLive = pOws + i;
+    const int LiveCount = 0 < OwsCount ? OwsCount - i : 0;
+
+    const int StartCount = m_starts.size ();
+
+    for (int j = 0; j < StartCount; ++j) {
+
+        const int Ow = m_PatCount + m_starts [j];
+
+        if (-1 != ::FAFind_log (pLive, LiveCount, Ow)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+template < class Ty >
+inline void FAScannerTools_t< Ty >::
+    Match (const Ty * pIn, const int InSize, const int From)
+{
+    DebugLogAssert (m_pDfa && m_pState2Ows);
+
+    int State = m_pDfa->GetInitial ();
+    int Pos = From;
+    int Anchors = 0;
+
+    // the left anchor is matched only if there is a transition for it
+    if (-1 == From) {
+        State = m_pDfa->GetDest (State, FAFsmConst::IW_L_ANCHOR);
+        if (-1 == State) {
+            return;
+        }
+        Pos = 0;
+        Anchors = AnchorL;
+    }
+
+    const int Start = Pos;
+
+    for (; Pos < InSize; ++Pos) {
+
+        const int Iw = Symbol2Iw (pIn [Pos]);
+
+        int Dst = m_pDfa->GetDest (State, Iw);
+
+        if (-1 == Dst) {
+            Dst = m_pDfa->GetDest (State, FAFsmConst::IW_ANY);
+            if (-1 == Dst) {
+                break;
+            }
+        }
+
+        State = Dst;
+
+        if (!AddEnds (State, Pos, Anchors)) {
+            break;
+        }
+    }
+
+    // see whether the match can continue with the right anchor
+    if (Pos == InSize && Start < Pos) {
+        State = m_pDfa->GetDest (State, FAFsmConst::IW_R_ANCHOR);
+        if (-1 != State) {
+            AddEnds (State, InSize - 1, Anchors | AnchorR);
+        }
+    }
+}
+
+
+template < class Ty >
+inline const int FAScannerTools_t< Ty >::
+    MatchStarts (const Ty * pIn, const int InSize)
+{
+    DebugLogAssert (m_pRevDfa && m_pRevState2Ows);
+
+    m_rev_states.resize (InSize);
+    int * pRevStates = m_rev_states.begin ();
+
+    // the initial state loops over any symbol and the right anchor, so the
+    // automaton never dies
+    int State = m_pRevDfa->GetInitial ();
+    State = m_pRevDfa->GetDest (State, FAFsmConst::IW_R_ANCHOR);
+    DebugLogAssert (-1 != State);
+
+    for (int Pos = InSize - 1; Pos >= 0; --Pos) {
+
+        const int Iw = Symbol2Iw (pIn [Pos]);
+
+        int Dst = m_pRevDfa->GetDest (State, Iw);
+
+        if (-1 == Dst) {
+            Dst = m_pRevDfa->GetDest (State, FAFsmConst::IW_ANY);
+            DebugLogAssert (-1 != Dst);
+        }
+
+        State = Dst;
+        pRevStates [Pos] = State;
+    }
+
+    return m_pRevDfa->GetDest (State, FAFsmConst::IW_L_ANCHOR);
+}
+
+
+template < class Ty >
+inline const int FAScannerTools_t< Ty >::
+    GetStarts (const int State, const int From)
+{
+    m_starts.resize (0);
+
+    if (-1 == State) {
+        return 0;
+    }
+
+    int * pOws = m_ows.begin ();
+    const int MaxOwsCount = m_ows.size ();
+
+    const int OwsCount = m_pRevState2Ows->GetOws (State, pOws, MaxOwsCount);
+    DebugLogAssert (OwsCount <= MaxOwsCount);
+
+    const int * pNextFrom = m_next_from.begin ();
+
+    for (int i = 0; i < OwsCount; ++i) {
+
+        const int PatId = pOws [i];
+        DebugLogAssert (0 <= PatId && PatId < m_PatCount);
+
+        if (pNextFrom [PatId] <= From) {
+            m_starts.push_back (PatId);
+        }
+    }
+
+    return m_starts.size ();
+}
+
+
+template < class Ty >
+inline const int FAScannerTools_t< Ty >::
+    Emit (
+        const Ty * pIn,
+        const int InSize,
+        const int PatId,
+        const int From,
+        int * pOut,
+        const int OutSize,
+        const int MaxOutSize
+    )
+{
+    const int To = m_ends [PatId];
+    DebugLogAssert (From <= To && To < InSize);
+
+    m_br_res.m_res.resize (0);
+
+    FAAutInterpretTools_trbr_t < int > * pTrBr = m_trbrs [PatId];
+
+    if (pTrBr) {
+
+        // build the chain the pattern has matched
+        const int Anchors = m_anchors [PatId];
+        const int Shift = (Anchors & AnchorL) ? 1 : 0;
+
+        m_chain.resize (0);
+        if (Anchors & AnchorL) {
+            m_chain.push_back (FAFsmConst::IW_L_ANCHOR);
+        }
+        for (int i = From; i <= To; ++i) {
+            m_chain.push_back (Symbol2Iw (pIn [i]));
+        }
+        if (Anchors & AnchorR) {
+            m_chain.push_back (FAFsmConst::IW_R_ANCHOR);
+        }
+
+        const int ChainSize = m_chain.size ();
+
+        if (pTrBr->Chain2BrRes_local (m_chain.begin (), ChainSize, &m_br_res)) {
+
+            // convert chain positions into the text positions
+            int * pRes = m_br_res.m_res.begin ();
+            const int ResSize = m_br_res.m_res.size ();
+
+            for (int i = 0; i < ResSize; i += 3) {
+
+                int BrFrom = From + pRes [i + 1] - Shift;
+                int BrTo = From + pRes [i + 2] - Shift;
+
+                if (BrFrom < From) {
+                    BrFrom = From;
+                }
+                if (BrTo > To) {
+                    BrTo = To;
+                }
+
+                pRes [i + 1] = BrFrom;
+                pRes [i + 2] = BrTo;
+            }
+
+        } else {
+            // should not happen, the match is reported without brackets
+            DebugLogAssert (0);
+            m_br_res.m_res.resize (0);
+        }
+    }
+
+    const int BrResSize = m_br_res.m_res.size ();
+    const int RecSize = 4 + BrResSize;
+
+    // once a record does not fit, all the following do not fit either
+    if (pOut && OutSize + RecSize <= MaxOutSize) {
+
+        int * pRec = pOut + OutSize;
+
+        pRec [0] = PatId;
+        pRec [1] = From;
+        pRec [2] = To;
+        pRec [3] = BrResSize / 3;
+
+        if (0 < BrResSize) {
+            memcpy (pRec + 4, m_br_res.m_res.begin (), sizeof (int) * BrResSize);
+        }
+    }
+
+    return OutSize + RecSize;
+}
+
+
+template < class Ty >
+const int FAScannerTools_t< Ty >::
+    Process (
+        const Ty * pIn,
+        const int InSize,
+        __out_ecount_opt(MaxOutSize) int * pOut,
+        const int MaxOutSize
+    )
+{
+    DebugLogAssert (m_pScanner);
+
+    if (0 >= InSize || NULL == pIn) {
+        return 0;
+    }
+
+    int OutSize = 0;
+
+    int * pNextFrom = m_next_from.begin ();
+    for (int PatId = 0; PatId < m_PatCount; ++PatId) {
+        pNextFrom [PatId] = 0;
+    }
+
+    // find out where the matches start
+    const int AnchorState = MatchStarts (pIn, InSize);
+    const int * pRevStates = m_rev_states.begin ();
+
+    for (int From = 0; From < InSize; ++From) {
+
+        m_touched.resize (0);
+
+        // matches at the beginning may start with the left anchor
+        if (0 == From && 0 < GetStarts (AnchorState, From)) {
+            Match (pIn, InSize, -1);
+        }
+        if (0 < GetStarts (pRevStates [From], From)) {
+            Match (pIn, InSize, From);
+        }
+
+        const int Count = m_touched.size ();
+
+        if (1 < Count) {
+            std::sort (m_touched.begin (), m_touched.end ());
+        }
+
+        for (int i = 0; i < Count; ++i) {
+
+            const int PatId = m_touched [i];
+
+            // matches of the same pattern do not overlap
+            if (pNextFrom [PatId] <= From) {
+
+                OutSize = Emit (pIn, InSize, PatId, From, \
+                    pOut, OutSize, MaxOutSize);
+
+                pNextFrom [PatId] = m_ends [PatId] + 1;
+            }
+
+            m_ends [PatId] = -1;
+            m_anchors [PatId] = 0;
+        }
+    }
+
+    return OutSize;
+}
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_SCANNER_PACK_H_
+#define _FA_SCANNER_PACK_H_
+
+#include "FAConfig.h"
+#include "FASetImageA.h"
+#include "FARSDfa_pack_triv.h"
+#include "FAState2Ows_pack_triv.h"
+#include "FAPosNfa_pack_triv.h"
+#include "FAState2TrBr_pack_triv.h"
+
+class FARSDfaCA;
+class FAState2OwsCA;
+class FARSNfaCA;
+class FAMultiMapCA;
+
+///
+/// Interprets the scanner image built by FAScannerCompiler.
+///
+/// Note: the object does not copy the image, it can be memory mapped.
+///
+
+class FAScanner_pack : public FASetImageA {
+
+public:
+    FAScanner_pack ();
+    ~FAScanner_pack ();
+
+public:
+    void SetImage (const unsigned char * pImage);
+
+public:
+    /// returns the number of patterns
+    const int GetPatternCount () const;
+    /// returns the union Moore DFA, the reaction is the set of pattern ids
+    const FARSDfaCA * GetDfa () const;
+    const FAState2OwsCA * GetState2Ows () const;
+    /// returns the reverse union Moore DFA, read from the right to the left
+    /// its reaction is the set of pattern ids starting at the position
+    const FARSDfaCA * GetRevDfa () const;
+    const FAState2OwsCA * GetRevState2Ows () const;
+
+    /// returns true if the pattern has triangular brackets
+    const bool HasBrackets (const int PatId) const;
+    /// returns position DFA of the pattern with brackets
+    const FARSDfaCA * GetPosDfa (const int PatId) const;
+    const FAState2OwsCA * GetPosState2Ows (const int PatId) const;
+    /// returns reverse position NFA of the pattern with brackets
+    const FARSNfaCA * GetFollow (const int PatId) const;
+    /// returns position -> bracket maps of the pattern with brackets
+    const FAMultiMapCA * GetPos2BrBegin (const int PatId) const;
+    const FAMultiMapCA * GetPos2BrEnd (const int PatId) const;
+
+private:
+    // returns object into the initial state
+    void Clear ();
+
+private:
+    // bracket extraction data of one pattern
+    struct FAPatternData {
+
+        FAPatternData ();
+
+        bool m_HasBrackets;
+        FARSDfa_pack_triv m_pos_dfa;
+        FAState2Ows_pack_triv m_pos_ows;
+        FAPosNfa_pack_triv m_follow;
+        FAState2TrBr_pack_triv m_pos2br_begin;
+        FAState2TrBr_pack_triv m_pos2br_end;
+    };
+
+    // pattern count
+    int m_PatCount;
+    // union DFA
+    FARSDfa_pack_triv m_dfa;
+    FAState2Ows_pack_triv m_ows;
+    // reverse union DFA
+    FARSDfa_pack_triv m_rev_dfa;
+    FAState2Ows_pack_triv m_rev_ows;
+    // per pattern data, m_PatCount elements
+    FAPatternData * m_pPats;
+};
+
+#endif
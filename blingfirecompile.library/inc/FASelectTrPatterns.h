@@ -44,6 +44,19 @@ public:
     void SetI2Info (const FAMultiMapCA * pI2Info);
     /// extracts "best" patterns for the given Iws/Ows input pair
     void AddIwsOws (const int * pIws, const int * pOws, const int Count);
+    /// finds patterns covering each position of the Iws/Ows input pair,
+    /// does not change the selection, returns the cover size, the cover is
+    /// a sequence of [Pos, IdCount, Id_1, ..., Id_IdCount]
+    const int GetCover (
+            const int * pIws,
+            const int * pOws,
+            const int Count,
+            const int ** ppCover
+        );
+    /// extracts "best" patterns for the cover returned by GetCover,
+    /// AddIwsOws == GetCover + AddCover, so the covers can be calculated
+    /// by different objects (threads) but have to be added in input order
+    void AddCover (const int * pCover, const int Size);
     /// finishes processing
     void Process ();
 
@@ -73,7 +86,7 @@ private:
     /// validate patterns by the current input and identify unsolved
     void CalcCover (const int * pIws, const int * pOws, const int Count);
     /// select best
-    void UpdateBest (const int * pOws, const int Count);
+    void UpdateBest (const int * pCover, const int Size);
     /// returns the "don't-care" symbol count
     inline static const int GetDcCount (const int * pOws, const int Count);
     /// returns true if pattern Id1 is better than pattern Id2
@@ -92,6 +105,8 @@ private:
     FAMultiMap_judy m_pos2ids_cover;
     /// a set of selected patterns
     FAArray_cont_t < int > m_used_ids;
+    /// the cover of the last input, see GetCover
+    FAArray_cont_t < int > m_cover;
     /// tmp array for resulting Iws/Ows, etc.
     FAArray_cont_t < int > m_tmp;
     /// mph tools, PAT <--> ID
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#ifndef _FA_STRALIGNER_H_
+#define _FA_STRALIGNER_H_
+
+#include "FAConfig.h"
+#include "FASecurity.h"
+#include "FAFsmConst.h"
+#include "FAArray_cont_t.h"
+
+class FAAllocatorA;
+
+///
+/// Aligns two strings of ints by the maximum score (Needleman-Wunsch) and
+/// returns the alignment as pairs of < str1 symbol, str2 symbol >, a gap is
+/// represented by the filler symbol. This is the fa_align cost model:
+///
+///   equal symbols       -- 1 (or Equal2 at str1 positions <= MinPos)
+///   non-equal symbols   -- NotEqual (or NotEqual2 at str1 positions <= MinPos)
+///   a gap in str1       -- Gap1
+///   a gap in str2       -- Gap2
+///
+/// The score matrix is computed within a diagonal band first, the band is
+/// accepted only if no alignment leaving it can score as high as the best
+/// one inside, otherwise it is doubled, so the result is always identical
+/// to the full matrix computation. The scratch memory is reused between
+/// calls. The object is not thread-safe, use one object per thread.
+///
+
+class FAStrAligner {
+
+public:
+    FAStrAligner (FAAllocatorA * pAlloc);
+
+public:
+    /// a score for inserting a gap into the first string, -1 by default
+    void SetGap1 (const int Gap1);
+    /// a score for inserting a gap into the second string, -1 by default
+    void SetGap2 (const int Gap2);
+    /// a score for aligning two non-equal symbols, 0 by default
+    void SetNotEqual (const int NotEqual);
+    /// a score for non-equal symbols at positions <= MinPos, 0 by default
+    void SetNotEqual2 (const int NotEqual2);
+    /// a score for equal symbols at positions <= MinPos, 1 by default
+    void SetEqual2 (const int Equal2);
+    /// the last 0-based str1 position for Equal2/NotEqual2, -1 by default
+    void SetMinPos (const int MinPos);
+    /// aligns from the left most symbols, the right most ones by default
+    void SetReverse (const bool Reverse);
+    /// gap filler symbol, FAFsmConst::IW_EPSILON by default
+    void SetFiller (const int Filler);
+    /// initial band half-width, 0 computes the full matrix, 8 by default
+    void SetBand (const int Band);
+
+    /// returns the number of output symbols, 2 per alignment position, or
+    /// -1 if MaxOutSize is not enough (MaxOutSize >= 2 * (Count1 + Count2))
+    const int Process (
+            const int * pStr1,
+            const int Count1,
+            const int * pStr2,
+            const int Count2,
+            __out_ecount (MaxOutSize) int * pOut,
+            const int MaxOutSize
+        );
+
+private:
+    // copies (and reverses if needed) the input, computes column scores
+    inline void Prepare (
+            const int * pStr1,
+            const int Count1,
+            const int * pStr2,
+            const int Count2
+        );
+    // fills in the matrix for diagonals Lo..Hi, Lo = i - j, returns the score
+    inline const int Fill (const int Lo, const int Hi);
+    // returns true if no path outside of Lo..Hi can score Score or more
+    inline const bool IsExact (const int Lo, const int Hi, const int Score) const;
+    // returns matrix value, NegInf if (i, j) is outside of the band
+    inline const int GetD (const int i, const int j) const;
+    // builds the output from the matrix
+    inline const int Traceback (int * pOut, const int MaxOutSize) const;
+
+private:
+    int m_Gap1;
+    int m_Gap2;
+    int m_NotEqual;
+    int m_NotEqual2;
+    int m_Equal2;
+    int m_MinPos;
+    bool m_Reverse;
+    int m_Filler;
+    int m_Band;
+
+    // input strings (reversed, if needed)
+    FAArray_cont_t < int > m_str1;
+    const int * m_pStr1;
+    int m_Count1;
+    FAArray_cont_t < int > m_str2;
+    const int * m_pStr2;
+    int m_Count2;
+    // str1 column -> score of equal and non-equal symbols
+    FAArray_cont_t < int > m_eq;
+    const int * m_pEq;
+    FAArray_cont_t < int > m_neq;
+    const int * m_pNeq;
+    // (Count2 + 1) x (Count1 + 1) score matrix
+    FAArray_cont_t < int > m_d;
+    int * m_pD;
+    // the band, Lo <= i - j <= Hi
+    int m_Lo;
+    int m_Hi;
+
+    enum {
+        DefBand = 8,
+        NegInf = -0x3FFFFFFF,
+    };
+};
+
+#endif
@@ -8,8 +8,6 @@
 #define _FA_TESTCMPDFA_H_
 
 #include "FAConfig.h"
-#include "FAArray_t.h"
-#include "FABitArray.h"
 #include "FAArray_cont_t.h"
 
 class FAAllocatorA;
@@ -22,6 +20,13 @@ class FAMealyDfaCA;
 /// For the given two triplets: < FARSDfaCA, FAState2OwCA, FAState2OwsCA > 
 /// identifies whether these triplets have the same behavior.
 ///
+/// The check is Hopcroft-Karp's: pairs of states are merged with union-find
+/// and each pair is compared once, so the run time is almost linear in the
+/// number of states times the alphabet size. Automata do not have to be
+/// isomorphic, e.g. minimal and non-minimal automata can be compared. Missing
+/// transitions are treated as transitions into a non-final state without
+/// outputs, the dead state is only equal to the dead state.
+///
 /// Note: States can be renumerated in defeerent orders.
 ///
 
@@ -47,14 +52,26 @@ public:
         );
     // returns true if interfaces behave identically
     const bool Process (const int MaxState, const int MaxIw);
+    // returns an input chain leading to different behavior,
+    // returns -1 if Process has not found the difference in states
+    const int GetCounterExample (const int ** ppIws) const;
 
 private:
     // returns object into initial state
     void Clear ();
-    // helper, returns true if state has already been procesed
-    const bool WasSeen (const FABitArray * pVisited, const int State) const;
-    // helper, marks state as been processed
-    void SetSeen (FABitArray * pVisited, const int State);
+    // returns union-find element for the state of pDfa1 or pDfa2
+    inline const int GetElement (
+            FAArray_cont_t < int > * pState2Elem,
+            const int State
+        );
+    // returns set representative of the element
+    inline const int Find (int Elem);
+    // merges two sets, returns false if they were already merged
+    inline const bool Merge (const int Elem1, const int Elem2);
+    // returns true if states have the same outputs
+    const bool CmpStates (const int State1, const int State2);
+    // builds counter-example for the pair of states at Idx and Iw
+    void SetCounterExample (const int Idx, const int Iw);
     /// compares DFA's alphabets
     const bool CmpAlphabets ();
 
@@ -72,12 +89,19 @@ private:
     const FAMealyDfaCA * m_pSigma1;
     const FAMealyDfaCA * m_pSigma2;
 
-    // stack of pairs: <State1, State2>, State2 \in pDfa1, State2 \in pDfa2
-    FAArray_t < int > m_stack;
-    // indicates whether State \in pDfa1 has already been processed
-    FABitArray m_visited1;
-    // indicates whether State \in pDfa2 has already been processed
-    FABitArray m_visited2;
+    // queue of <State1, State2, ParentIdx, Iw>, State1 \in pDfa1,
+    // State2 \in pDfa2, the pair was reached from ParentIdx pair by Iw
+    FAArray_cont_t < int > m_queue;
+    // maps State \in pDfa1 into union-find element, -1 if not assigned
+    FAArray_cont_t < int > m_state2elem1;
+    // maps State \in pDfa2 into union-find element, -1 if not assigned
+    FAArray_cont_t < int > m_state2elem2;
+    // union-find parents and ranks
+    FAArray_cont_t < int > m_parent;
+    FAArray_cont_t < int > m_rank;
+    // counter-example
+    FAArray_cont_t < int > m_cex;
+    bool m_HasCex;
     // temporary storage for Ows1
     FAArray_cont_t < int > m_ows1;
     int * m_pOws1;
@@ -90,6 +114,13 @@ private:
     FAArray_cont_t < int > m_iws1;
     FAArray_cont_t < int > m_iws2;
 
+    enum {
+        // union-find elements for the missing transition and the dead state
+        ElemNone = 0,
+        ElemDead = 1,
+        // the size of the queue record
+        QueueRecSize = 4,
+    };
 };
 
 #endif
@@ -16,6 +16,9 @@ class FAMultiMapCA;
 ///
 /// Compares whether two FAMultiMapCA interfaces behave the same way.
 ///
+/// Note: Different objects can compare different key ranges of the same
+///   maps in parallel, as the maps are only read.
+///
 
 class FATestCmpMultiMap {
 
@@ -29,8 +32,16 @@ public:
     void SetMap2 (const FAMultiMapCA * pMMap2);
     // returns true if interfaces behave identically
     const bool Process (const int MaxKey);
+    // returns true if interfaces behave identically for keys in
+    // [FromKey, ToKey]
+    const bool Process (const int FromKey, const int ToKey);
+    // returns the first key with different values, or -1 if it has not
+    // been found by the last Process call
+    const int GetDiffKey () const;
 
 private:
+    // allocates the chain buffers, returns false if maps are not valid
+    const bool Prepare ();
     inline const int GetChain1 (const int Key, const int ** ppChain);
     inline const int GetChain2 (const int Key, const int ** ppChain);
     // returns true if chains are equal
@@ -53,6 +64,8 @@ private:
     int * m_pChainBuff2;
     int m_MaxChainSize2;
 
+    int m_DiffKey;
+
 };
 
 #endif
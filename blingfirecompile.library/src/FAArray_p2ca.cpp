@@ -24,6 +24,25 @@ const int FAArray_p2ca::GetCount () const
     return m_Count;
 }
 
+const int FAArray_p2ca::
+    GetRange (
+        const int From,
+        const int Count,
+        __out_ecount(Count) int * pOut
+    ) const
+{
+    DebugLogAssert (0 <= From && 0 <= Count);
+
+    if (From >= m_Count) {
+        return 0;
+    }
+
+    const int OutCount = Count < m_Count - From ? Count : m_Count - From;
+    memcpy (pOut, m_pA + From, sizeof (int) * OutCount);
+
+    return OutCount;
+}
+
 void FAArray_p2ca::SetArray (const int * pA, const int Count)
 {
     m_pA = pA;
@@ -0,0 +1,523 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-compile_src_pch.h"
+#include "FAConfig.h"
+#include "FACorpusReader_utf8.h"
+#include "FAFsmConst.h"
+#include "FAUtf8Utils.h"
+#include "FATagSet.h"
+#include "FAException.h"
+#include "FALimits.h"
+
+#ifdef BLING_FIRE_NOWINDOWS
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+FACorpusReader_utf8::FACorpusReader_utf8 (FAAllocatorA * pAlloc) :
+    m_pTagSet (NULL),
+    m_NoPosTags (false),
+    m_pData (NULL),
+    m_Size (0),
+#ifndef BLING_FIRE_NOWINDOWS
+    m_hFileMapping (0),
+#endif
+    m_pPos (NULL),
+    m_pEnd (NULL),
+    m_Binary (false),
+    m_Eof (true),
+    m_pIs (NULL),
+    m_pChars (NULL),
+    m_WordCount (0)
+{
+    m_chars.SetAllocator (pAlloc);
+    m_chars.Create (FALimits::MaxWordLen);
+
+    m_words.SetAllocator (pAlloc);
+    m_words.Create ();
+
+    m_lex.SetAllocator (pAlloc);
+    m_lex.Create ();
+}
+
+
+FACorpusReader_utf8::~FACorpusReader_utf8 ()
+{
+    FACorpusReader_utf8::Unmap ();
+}
+
+
+void FACorpusReader_utf8::SetTagSet (const FATagSet * pTagSet)
+{
+    m_pTagSet = pTagSet;
+}
+
+
+void FACorpusReader_utf8::SetNoPosTags (const bool NoPosTags)
+{
+    m_NoPosTags = NoPosTags;
+}
+
+
+void FACorpusReader_utf8::Map (const char * pFileName)
+{
+    LogAssert (pFileName);
+
+#ifndef BLING_FIRE_NOWINDOWS
+
+    HANDLE hFile = ::CreateFileA (pFileName, GENERIC_READ, FILE_SHARE_READ,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LogAssert (INVALID_HANDLE_VALUE != hFile, "Failed to open a file %s for memory mapping, GetLastError()=%lu",
+        pFileName, GetLastError());
+
+    LARGE_INTEGER Size;
+    BOOL fRes = ::GetFileSizeEx (hFile, &Size);
+    LogAssert (0 != fRes, "Cannot get the size of file %s, GetLastError()=%lu",
+        pFileName, GetLastError());
+    m_Size = (size_t) Size.QuadPart;
+
+    if (0 < m_Size) {
+
+        m_hFileMapping = ::CreateFileMapping (hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        LogAssert (0 != m_hFileMapping, "Failed to create a memory mapping for file %s, GetLastError()=%lu",
+            pFileName, GetLastError());
+
+        m_pData = (const char *) ::MapViewOfFile (m_hFileMapping, FILE_MAP_READ, 0, 0, 0);
+        LogAssert (NULL != m_pData, "Failed to get a pointer from the memory mapped file %s, GetLastError()=%lu",
+            pFileName, GetLastError());
+    }
+
+    fRes = ::CloseHandle (hFile);
+    LogAssert (0 != fRes, "Cannot close handle, GetLastError()=%lu", GetLastError());
+
+#else
+
+    const int fd = ::open (pFileName, O_RDONLY);
+    LogAssert (-1 != fd, "Failed to open a file %s for memory mapping", pFileName);
+
+    struct stat st;
+    int res = ::fstat (fd, &st);
+    LogAssert (0 == res, "Cannot get the size of file %s", pFileName);
+    m_Size = (size_t) st.st_size;
+
+    if (0 < m_Size) {
+
+        void * p = ::mmap (NULL, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        LogAssert (MAP_FAILED != p, "Failed to memory map file %s", pFileName);
+        m_pData = (const char *) p;
+
+        // the corpus is read once from the beginning to the end
+        ::madvise (p, m_Size, MADV_SEQUENTIAL);
+    }
+
+    res = ::close (fd);
+    LogAssert (0 == res);
+
+#endif
+}
+
+
+void FACorpusReader_utf8::Unmap ()
+{
+#ifndef BLING_FIRE_NOWINDOWS
+
+    if (m_pData) {
+        BOOL fRes = ::UnmapViewOfFile ((const void*) m_pData);
+        LogAssert (0 != fRes, "Cannot unmap the view of a file, GetLastError()=%lu", GetLastError());
+    }
+    if (m_hFileMapping) {
+        BOOL fRes = ::CloseHandle (m_hFileMapping);
+        LogAssert (0 != fRes, "Cannot close handle, GetLastError()=%lu", GetLastError());
+        m_hFileMapping = 0;
+    }
+
+#else
+
+    if (m_pData) {
+        const int res = ::munmap ((void*) m_pData, m_Size);
+        LogAssert (0 == res);
+    }
+
+#endif
+
+    m_pData = NULL;
+    m_Size = 0;
+}
+
+
+void FACorpusReader_utf8::Open (const char * pFileName)
+{
+    FAAssert (pFileName, FAMsg::InvalidParameters);
+
+    FACorpusReader_utf8::Close ();
+    FACorpusReader_utf8::Map (pFileName);
+
+    m_pPos = m_pData;
+    m_pEnd = m_pData + m_Size;
+    m_Eof = false;
+
+    // see whether the file starts with the binary header, the text
+    // cannot start with it as it contains 0
+    if (sizeof (int) <= m_Size && \
+        BinMagic == ((const int *) m_pData) [0]) {
+        OpenBin ();
+    }
+}
+
+
+void FACorpusReader_utf8::OpenBin ()
+{
+    DebugLogAssert (m_pData);
+
+    const int * pData = (const int *) m_pData;
+
+    FAAssert (BinHeaderSize * sizeof (int) <= m_Size && \
+        0 == m_Size % sizeof (int) && m_Size / sizeof (int) <= INT_MAX && \
+        BinVersion == pData [1], FAMsg::IOError);
+
+    const int Size = int (m_Size / sizeof (int));
+    const int LexOffset = pData [2];
+    FAAssert (BinHeaderSize <= LexOffset && LexOffset < Size, \
+        FAMsg::IOError);
+
+    // index the lexicon
+    const int LexCount = pData [LexOffset];
+    FAAssert (0 <= LexCount, FAMsg::IOError);
+
+    m_lex.resize (LexCount);
+    int * pLex = m_lex.begin ();
+
+    int Pos = LexOffset + 1;
+
+    for (int i = 0; i < LexCount; ++i) {
+
+        FAAssert (Pos < Size, FAMsg::IOError);
+        const int Len = pData [Pos];
+        FAAssert (0 < Len && Len <= FALimits::MaxWordLen && \
+            Len < Size - Pos, FAMsg::IOError);
+
+        pLex [i] = Pos;
+        Pos += Len + 1;
+    }
+
+    m_Binary = true;
+    m_pPos = (const char *) (pData + BinHeaderSize);
+    m_pEnd = (const char *) (pData + LexOffset);
+}
+
+
+void FACorpusReader_utf8::Open (std::istream * pIs)
+{
+    FAAssert (pIs, FAMsg::InvalidParameters);
+
+    FACorpusReader_utf8::Close ();
+
+    m_pIs = pIs;
+    m_Eof = false;
+}
+
+
+void FACorpusReader_utf8::Close ()
+{
+    FACorpusReader_utf8::Unmap ();
+    FACorpusReader_utf8::Clear ();
+
+    m_lex.resize (0);
+    m_pPos = NULL;
+    m_pEnd = NULL;
+    m_Binary = false;
+    m_Eof = true;
+    m_pIs = NULL;
+}
+
+
+const bool FACorpusReader_utf8::IsEof () const
+{
+    return m_Eof;
+}
+
+
+const bool FACorpusReader_utf8::IsBinary () const
+{
+    return m_Binary;
+}
+
+
+void FACorpusReader_utf8::Clear ()
+{
+    m_chars.resize (0);
+    m_words.resize (0);
+    m_pChars = NULL;
+    m_WordCount = 0;
+}
+
+
+inline const bool FACorpusReader_utf8::
+    GetLine (const char ** ppStr, int * pLen)
+{
+    DebugLogAssert (ppStr && pLen);
+
+    if (m_pIs) {
+
+        if (!std::getline (*m_pIs, m_line)) {
+            m_Eof = true;
+            return false;
+        }
+        m_Eof = m_pIs->eof ();
+
+        *ppStr = m_line.c_str ();
+        *pLen = (const int) m_line.length ();
+
+    } else {
+
+        if (m_pPos >= m_pEnd) {
+            m_Eof = true;
+            return false;
+        }
+
+        const char * pStr = m_pPos;
+        const char * pNl = (const char *) \
+            memchr (pStr, '\n', m_pEnd - pStr);
+
+        if (pNl) {
+            m_pPos = pNl + 1;
+        } else {
+            // the last line without new line character
+            pNl = m_pEnd;
+            m_pPos = m_pEnd;
+            m_Eof = true;
+        }
+
+        FAAssert (pNl - pStr <= INT_MAX, FAMsg::IOError);
+
+        *ppStr = pStr;
+        *pLen = int (pNl - pStr);
+    }
+
+    return true;
+}
+
+
+void FACorpusReader_utf8::Read ()
+{
+    FACorpusReader_utf8::Clear ();
+
+    if (m_Eof) {
+        return;
+    }
+    if (m_Binary) {
+        ReadBin ();
+        return;
+    }
+
+    const char * pStr;
+    int Len;
+
+    if (!GetLine (&pStr, &Len)) {
+        return;
+    }
+
+    if (0 < Len) {
+        DebugLogAssert (pStr);
+        if (0x0D == (unsigned char) pStr [Len - 1])
+            Len--;
+    }
+    if (0 < Len) {
+        ParseLine (pStr, Len);
+    }
+
+    m_pChars = m_chars.begin ();
+}
+
+
+inline void FACorpusReader_utf8::
+    AddWord (
+        const char * pWord,
+        const int WordLen,
+        const char * pTag,
+        const int TagLen,
+        const int Offset
+    )
+{
+    int Tag = FAFsmConst::POS_TAG_DEFAULT;
+
+    FAAssert (m_pTagSet || 0 == TagLen, FAMsg::InvalidParameters);
+    FAAssert (0 < WordLen && 0 <= TagLen, FAMsg::IOError);
+
+    // UTF-8 -> UTF-32, directly into the sentence buffer
+    const unsigned int Pos = m_chars.size ();
+    m_chars.resize (Pos + FALimits::MaxWordLen);
+    int * pOut = m_chars.begin () + Pos;
+
+    const int SymbolCount = \
+        ::FAStrUtf8ToArray (pWord, WordLen, pOut, FALimits::MaxWordLen);
+    FAAssert (0 <= SymbolCount && SymbolCount <= FALimits::MaxWordLen, \
+        FAMsg::IOError);
+
+    m_chars.resize (Pos + SymbolCount);
+
+    // change MWE separator to space
+    for (int i = 0; i < SymbolCount; ++i) {
+        if (FAFsmConst::CHAR_MWE_DELIM == pOut [i]) {
+            pOut [i] = FAFsmConst::CHAR_SPACE;
+        }
+    }
+
+    // see whether input contained POS tag
+    if (TagLen) {
+        // get tag value
+        Tag = m_pTagSet->Str2Tag (pTag, TagLen);
+        // see if Tag is found
+        FAAssert (-1 != Tag, std::string( std::string (FAMsg::IOError) + \
+         std::string (" Unknown Tag ") + std::string (pTag, TagLen)).c_str ());
+    }
+
+    m_words.push_back (Pos);
+    m_words.push_back (SymbolCount);
+    m_words.push_back (Tag);
+    m_words.push_back (Offset);
+    m_WordCount++;
+}
+
+
+void FACorpusReader_utf8::ParseLine (const char * pStr, const int Len)
+{
+    DebugLogAssert (pStr && 0 < Len);
+
+    const char * pBegin = pStr;
+    const char * pEnd = pStr;
+    const char * pDelim = NULL;
+
+    // Len + 1 - to treat the end of string as if it was a CHAR_WORD_DELIM
+    for (int i = 0; i < Len + 1; ++i) {
+
+        char C = FAFsmConst::CHAR_WORD_DELIM;
+        if (i < Len) {
+            C = *pEnd;
+        }
+
+        if (FAFsmConst::CHAR_TAG_DELIM == C && false == m_NoPosTags) {
+
+            pDelim = pStr + i;
+
+        } else if (FAFsmConst::CHAR_WORD_DELIM == C) {
+
+            if (false == m_NoPosTags) {
+
+                const int WordLen = int (pDelim - pBegin);
+                const int Offset = int (pBegin - pStr);
+                const int TagLen = int (pEnd - pDelim - 1);
+
+                // no word/tag delimiter found, no tag or bad word
+                FAAssert (pDelim && 0 <= Offset && 0 < TagLen && 0 < WordLen \
+                    && WordLen <= FALimits::MaxWordLen, FAMsg::IOError);
+
+                AddWord (pBegin, WordLen, pDelim + 1, TagLen, Offset);
+
+            } else {
+
+                const int WordLen = int (pEnd - pBegin);
+                const int Offset = int (pBegin - pStr);
+
+                // bad word
+                FAAssert (0 <= Offset && 0 < WordLen && \
+                    WordLen <= FALimits::MaxWordLen, FAMsg::IOError);
+
+                AddWord (pBegin, WordLen, NULL, 0, Offset);
+            }
+
+            pBegin = pEnd + 1;
+        }
+
+        pEnd++;
+
+    } // of for (int i = 0; ...
+}
+
+
+void FACorpusReader_utf8::ReadBin ()
+{
+    DebugLogAssert (m_Binary && m_pPos && m_pEnd);
+
+    // stops reading if the data are corrupted or there are no sentences
+    m_Eof = true;
+    if (m_pPos >= m_pEnd) {
+        return;
+    }
+
+    const int * pData = (const int *) m_pData;
+    const int * pCurr = (const int *) m_pPos;
+    const int * pEnd = (const int *) m_pEnd;
+
+    const int WordCount = *pCurr++;
+    FAAssert (0 <= WordCount && WordCount <= (pEnd - pCurr) / 3, \
+        FAMsg::IOError);
+
+    const int LexCount = m_lex.size ();
+    const int * pLex = m_lex.begin ();
+
+    m_words.resize (WordInfoSize * WordCount);
+    int * pInfo = m_words.begin ();
+
+    for (int i = 0; i < WordCount; ++i) {
+
+        const int WordId = pCurr [0];
+        FAAssert (0 <= WordId && WordId < LexCount, FAMsg::IOError);
+
+        const int Pos = pLex [WordId];
+
+        pInfo [0] = Pos + 1;
+        pInfo [1] = pData [Pos];
+        pInfo [2] = pCurr [1];
+        pInfo [3] = pCurr [2];
+
+        pInfo += WordInfoSize;
+        pCurr += 3;
+    }
+
+    m_WordCount = WordCount;
+    m_pChars = pData;
+    m_pPos = (const char *) pCurr;
+    // the writer keeps all the sentences the text reader has returned,
+    // including the empty one after the last new line
+    m_Eof = m_pPos >= m_pEnd;
+}
+
+
+const int FACorpusReader_utf8::GetWordCount () const
+{
+    return m_WordCount;
+}
+
+
+const int FACorpusReader_utf8::
+    GetWord (const int Num, const int ** pWord) const
+{
+    DebugLogAssert (0 <= Num && Num < m_WordCount);
+    DebugLogAssert (pWord);
+
+    const int * pInfo = m_words.begin () + (WordInfoSize * Num);
+    *pWord = m_pChars + pInfo [0];
+    return pInfo [1];
+}
+
+
+const int FACorpusReader_utf8::GetTag (const int Num) const
+{
+    DebugLogAssert (0 <= Num && Num < m_WordCount);
+
+    return m_words [(WordInfoSize * Num) + 2];
+}
+
+
+const int FACorpusReader_utf8::GetOffset (const int Num) const
+{
+    DebugLogAssert (0 <= Num && Num < m_WordCount);
+
+    return m_words [(WordInfoSize * Num) + 3];
+}
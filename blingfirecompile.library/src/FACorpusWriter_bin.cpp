@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-compile_src_pch.h"
+#include "FAConfig.h"
+#include "FACorpusWriter_bin.h"
+#include "FACorpusReader_utf8.h"
+#include "FATaggedTextCA.h"
+#include "FAException.h"
+
+
+FACorpusWriter_bin::FACorpusWriter_bin (FAAllocatorA * pAlloc) :
+    m_pOs (NULL),
+    m_Size (0)
+{
+    m_word2id.SetAllocator (pAlloc);
+}
+
+
+inline void FACorpusWriter_bin::PrintInt (const int Val)
+{
+    DebugLogAssert (m_pOs);
+
+    m_pOs->write ((const char *) &Val, sizeof (int));
+    m_Size++;
+}
+
+
+void FACorpusWriter_bin::SetStream (std::ostream * pOs)
+{
+    FAAssert (pOs, FAMsg::InvalidParameters);
+
+    m_pOs = pOs;
+    m_Size = 0;
+    m_word2id.Clear ();
+
+    PrintInt (FACorpusReader_utf8::BinMagic);
+    PrintInt (FACorpusReader_utf8::BinVersion);
+    // the lexicon offset, is updated by Finish
+    PrintInt (0);
+}
+
+
+void FACorpusWriter_bin::Print (const FATaggedTextCA * pS)
+{
+    FAAssert (m_pOs && pS, FAMsg::InvalidParameters);
+
+    const int WordCount = pS->GetWordCount ();
+
+    // the size is kept in ints
+    FAAssert (WordCount < (INT_MAX - m_Size) / 3, FAMsg::LimitIsExceeded);
+
+    PrintInt (WordCount);
+
+    for (int i = 0; i < WordCount; ++i) {
+
+        const int * pWord;
+        const int WordLen = pS->GetWord (i, &pWord);
+
+        const int WordId = m_word2id.Add (pWord, WordLen, 0);
+
+        PrintInt (WordId);
+        PrintInt (pS->GetTag (i));
+        PrintInt (pS->GetOffset (i));
+    }
+}
+
+
+void FACorpusWriter_bin::Finish ()
+{
+    FAAssert (m_pOs, FAMsg::ObjectIsNotReady);
+
+    const int LexOffset = m_Size;
+    const int LexCount = m_word2id.GetChainCount ();
+
+    PrintInt (LexCount);
+
+    for (int i = 0; i < LexCount; ++i) {
+
+        const int * pWord;
+        const int WordLen = m_word2id.GetChain (i, &pWord);
+        FAAssert (WordLen < INT_MAX - m_Size, FAMsg::LimitIsExceeded);
+
+        PrintInt (WordLen);
+        m_pOs->write ((const char *) pWord, WordLen * sizeof (int));
+        m_Size += WordLen;
+    }
+
+    // update the lexicon offset in the header
+    m_pOs->seekp (2 * sizeof (int));
+    m_pOs->write ((const char *) &LexOffset, sizeof (int));
+    m_pOs->seekp (0, std::ios::end);
+
+    FAAssert (!m_pOs->fail (), FAMsg::IOError);
+
+    m_pOs = NULL;
+    m_word2id.Clear ();
+}
@@ -27,6 +27,7 @@ FADfaPack_triv::FADfaPack_triv (FAAllocatorA * pAlloc) :
     m_RemapIws (false),
     m_UseIwIA (false),
     m_UseRanges (false),
+    m_OwFirst (false),
     m_pOutBuff (NULL),
     m_LastOffset (0),
     m_ows2dump (pAlloc),
@@ -112,6 +113,12 @@ void FADfaPack_triv::SetUseRanges (const bool UseRanges)
 }
 
 
+void FADfaPack_triv::SetOwFirst (const bool OwFirst)
+{
+    m_OwFirst = OwFirst;
+}
+
+
 void FADfaPack_triv::SetDstSize (const int DstSize)
 {
     FAAssert (1 <= DstSize && 4 >= DstSize, \
@@ -880,6 +887,11 @@ void FADfaPack_triv::EncodeState (const int State)
     // encode info byte
     EncodeInfo (State, IwSize);
 
+    // encode Ow right after the info, if asked so
+    if (m_OwFirst) {
+        EncodeOw (State);
+    }
+
     if (0 < DstCount) {
 
         const int TrsType = GetTrType (State, IwSize);
@@ -898,7 +910,9 @@ void FADfaPack_triv::EncodeState (const int State)
     } // of if (0 < DstCount) ...
 
     // encode Ow, if there is any
-    EncodeOw (State);
+    if (!m_OwFirst) {
+        EncodeOw (State);
+    }
 }
 
 
@@ -1019,6 +1033,11 @@ void FADfaPack_triv::State2Offset (const int State)
     const unsigned char info = m_pOutBuff [Offset];
     Offset++;
 
+    // skip Ow, if it goes before the transitions
+    if (m_OwFirst) {
+        Offset += CalcOwSize (State);
+    }
+
     const int IwSize = ((info & 0x18) >> 3) + 1;
     DebugLogAssert (sizeof (char) <= (unsigned int) IwSize && 
             sizeof (int) >= (unsigned int) IwSize);
@@ -1404,6 +1423,8 @@ void FADfaPack_triv::Process ()
     if (m_DstMask <= (unsigned int) m_pDfa->GetMaxState ()) {
         throw FAException (FAMsg::InternalError, __FILE__, __LINE__);
     }
+    // Ow-first layout is supported for Moore automata only
+    FAAssert (!(m_OwFirst && m_pSigma), FAMsg::InvalidParameters);
 
     // 1. return all structures into the initial state
     // 2. calc automaton size
@@ -1412,8 +1433,9 @@ void FADfaPack_triv::Process ()
     DebugLogAssert (m_pOutBuff && 0 == m_LastOffset);
 
     // <Header>
-    // store DstSize
-    *(int *)(m_pOutBuff + m_LastOffset) = m_DstSize;
+    // store DstSize and the layout flag
+    *(int *)(m_pOutBuff + m_LastOffset) = m_DstSize | \
+        (m_OwFirst ? FAFsmConst::TRIV_PACK_OW_FIRST : 0);
     m_LastOffset += sizeof (int);
     // offset of Ows sets, 0 if there are no FAState2OwsA specified
     *(int *)(m_pOutBuff + m_LastOffset) = 0;
@@ -75,7 +75,7 @@ void FANfas2CommonENfa::AddTransitions (const int StateOffset)
 
     const int InMaxState = m_pInNfa->GetMaxState ();
 
-    for (int State = 0; State < InMaxState; ++State) {
+    for (int State = 0; State <= InMaxState; ++State) {
 
         const int * pIw;
         const int IwCount = m_pInNfa->GetIWs (State, &pIw);
@@ -139,7 +139,7 @@ void FARSDfaRenum_depth_first::build_dsts (const int State)
             const int Iw = m_pIws [iw_idx];
             const int DstState = m_pDfa->GetDest (State, Iw);
 
-            if (-1 != DstState) {
+            if (0 <= DstState) {
 
                 const int Idx = ::FAFind_log (pDst, DstCount, DstState);
                 DebugLogAssert (0 <= Idx && DstCount > Idx);
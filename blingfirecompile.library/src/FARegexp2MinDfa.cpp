@@ -8,6 +8,7 @@
 #include "FARegexp2MinDfa.h"
 #include "FAFsmConst.h"
 #include "FAUtf8Utils.h"
+#include "FAException.h"
 
 
 FARegexp2MinDfa::FARegexp2MinDfa (FAAllocatorA * pAlloc) :
@@ -18,7 +19,8 @@ FARegexp2MinDfa::FARegexp2MinDfa (FAAllocatorA * pAlloc) :
     m_nfa2dfa (pAlloc),
     m_dfa (pAlloc),
     m_dfa2mindfa (pAlloc),
-    m_min_dfa (pAlloc)
+    m_min_dfa (pAlloc),
+    m_MaxNfaStateCount (-1)
 {
     m_nfa_char.SetAnyIw (FAFsmConst::IW_ANY);
     m_nfa_char.SetAnchorLIw (FAFsmConst::IW_L_ANCHOR);
@@ -56,6 +58,18 @@ void FARegexp2MinDfa::SetRegexp (const char * pRegexp, const int Length)
 }
 
 
+void FARegexp2MinDfa::SetMaxStateCount (const int MaxStateCount)
+{
+    m_nfa2dfa.SetMaxStateCount (MaxStateCount);
+}
+
+
+void FARegexp2MinDfa::SetMaxNfaStateCount (const int MaxNfaStateCount)
+{
+    m_MaxNfaStateCount = MaxNfaStateCount;
+}
+
+
 ///
 /// This function Clears containers and processors as soon as possible
 /// in order to minimize memory usage.
@@ -73,6 +87,13 @@ void FARegexp2MinDfa::Process ()
     const FARSNfaA * pNfa = m_nfa_char.GetNfa ();
     DebugLogAssert (pNfa);
 
+    // check the limit before any expansion
+    if (-1 != m_MaxNfaStateCount && \
+        pNfa->GetMaxState () >= m_MaxNfaStateCount) {
+        m_nfa_char.Clear ();
+        FAError (FAMsg::LimitIsExceeded);
+    }
+
     // make global expansion for the '.'-symbol
     m_dot_exp.SetInNfa (pNfa);
     m_dot_exp.Process ();
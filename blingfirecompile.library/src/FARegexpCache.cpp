@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-compile_src_pch.h"
+#include "FAConfig.h"
+#include "FARegexpCache.h"
+#include "FARegexp2MinDfa.h"
+#include "FARSDfaRenum_depth_first.h"
+#include "FARSDfa_renum.h"
+#include "FADfaPack_triv.h"
+#include "FARSDfa_pack_triv.h"
+#include "FAException.h"
+
+#include <vector>
+
+
+class FARegexpCache::FAEntry {
+
+public:
+    FAEntry (const unsigned char * pDump, const int Size) :
+        m_dump (pDump, pDump + Size)
+    {
+        m_dfa.SetImage (m_dump.data ());
+    }
+
+public:
+    // the packed automaton
+    const std::vector < unsigned char > m_dump;
+    // reader of m_dump
+    FARSDfa_pack_triv m_dfa;
+};
+
+
+FARegexpCache::FARegexpCache (FAAllocatorA * pAlloc) :
+    m_pAlloc (pAlloc),
+    m_MaxCount (DefMaxCount),
+    m_MaxStateCount (DefMaxStateCount),
+    m_MaxNfaStateCount (-1)
+{}
+
+
+FARegexpCache::~FARegexpCache ()
+{}
+
+
+void FARegexpCache::SetMaxCount (const int MaxCount)
+{
+    std::lock_guard < std::mutex > guard (m_mutex);
+
+    m_MaxCount = MaxCount;
+    Evict ();
+}
+
+
+void FARegexpCache::SetMaxStateCount (const int MaxStateCount)
+{
+    std::lock_guard < std::mutex > guard (m_mutex);
+
+    m_MaxStateCount = MaxStateCount;
+}
+
+
+void FARegexpCache::SetMaxNfaStateCount (const int MaxNfaStateCount)
+{
+    std::lock_guard < std::mutex > guard (m_mutex);
+
+    m_MaxNfaStateCount = MaxNfaStateCount;
+}
+
+
+const int FARegexpCache::GetCount () const
+{
+    std::lock_guard < std::mutex > guard (m_mutex);
+
+    return (int) m_lru.size ();
+}
+
+
+void FARegexpCache::Clear ()
+{
+    std::lock_guard < std::mutex > guard (m_mutex);
+
+    m_key2pos.clear ();
+    m_lru.clear ();
+}
+
+
+void FARegexpCache::Evict ()
+{
+    while (-1 != m_MaxCount && (int) m_lru.size () > m_MaxCount) {
+
+        m_key2pos.erase (m_lru.back ().first);
+        m_lru.pop_back ();
+    }
+}
+
+
+FARegexpCache::FAEntryPtr FARegexpCache::
+    Compile (
+        const char * pRegexp,
+        const int Length,
+        const char * pEncName
+    ) const
+{
+    int MaxStateCount;
+    int MaxNfaStateCount;
+    {
+        std::lock_guard < std::mutex > guard (m_mutex);
+        MaxStateCount = m_MaxStateCount;
+        MaxNfaStateCount = m_MaxNfaStateCount;
+    }
+
+    // Regexp -> Min DFA
+    FARegexp2MinDfa re2dfa (m_pAlloc);
+
+    re2dfa.SetEncodingName (pEncName);
+    re2dfa.SetMaxStateCount (MaxStateCount);
+    re2dfa.SetMaxNfaStateCount (MaxNfaStateCount);
+    re2dfa.SetRegexp (pRegexp, Length);
+    re2dfa.Process ();
+
+    // the packed DFA starts from the first state, make the initial be 0
+    FARSDfaRenum_depth_first renum (m_pAlloc);
+
+    renum.SetDfa (re2dfa.GetRsDfa ());
+    renum.Process ();
+
+    FARSDfa_renum renum_dfa (m_pAlloc);
+
+    renum_dfa.SetOldDfa (re2dfa.GetRsDfa ());
+    renum_dfa.SetOld2New (renum.GetOld2NewMap ());
+    renum_dfa.Prepare ();
+    DebugLogAssert (0 == renum_dfa.GetInitial ());
+
+    // Min DFA -> memory dump
+    FADfaPack_triv dfa2dump (m_pAlloc);
+
+    dfa2dump.SetDfa (&renum_dfa);
+    dfa2dump.SetRemapIws (true);
+    dfa2dump.Process ();
+
+    const unsigned char * pDump = NULL;
+    const int Size = dfa2dump.GetDump (&pDump);
+    FAAssert (0 < Size && pDump, FAMsg::InternalError);
+
+    return std::make_shared < const FAEntry > (pDump, Size);
+}
+
+
+std::shared_ptr < const FARSDfaCA > FARegexpCache::
+    Get (
+        const char * pRegexp,
+        const int Length,
+        const char * pEncName
+    )
+{
+    FAAssert (0 < Length && pRegexp && pEncName, FAMsg::InvalidParameters);
+
+    // the key is the encoding name and the pattern
+    std::string Key (pEncName);
+    Key.push_back ('\0');
+    Key.append (pRegexp, Length);
+
+    {
+        std::lock_guard < std::mutex > guard (m_mutex);
+
+        std::unordered_map < std::string, FALruList::iterator >::iterator it = \
+            m_key2pos.find (Key);
+
+        if (m_key2pos.end () != it) {
+            // move it to the front
+            m_lru.splice (m_lru.begin (), m_lru, it->second);
+            const FAEntryPtr & pEntry = it->second->second;
+            return std::shared_ptr < const FARSDfaCA > (pEntry, &(pEntry->m_dfa));
+        }
+    }
+
+    // compile without holding the lock, throws on errors
+    FAEntryPtr pEntry = Compile (pRegexp, Length, pEncName);
+
+    {
+        std::lock_guard < std::mutex > guard (m_mutex);
+
+        std::unordered_map < std::string, FALruList::iterator >::iterator it = \
+            m_key2pos.find (Key);
+
+        if (m_key2pos.end () != it) {
+            // another thread has compiled the same pattern, use its result
+            m_lru.splice (m_lru.begin (), m_lru, it->second);
+            pEntry = it->second->second;
+
+        } else {
+
+            m_lru.push_front (std::make_pair (Key, pEntry));
+            m_key2pos [Key] = m_lru.begin ();
+            Evict ();
+        }
+    }
+
+    return std::shared_ptr < const FARSDfaCA > (pEntry, &(pEntry->m_dfa));
+}
@@ -0,0 +1,606 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-compile_src_pch.h"
+#include "FAConfig.h"
+#include "FAScannerCompiler.h"
+#include "FAAllocatorA.h"
+#include "FAFsmConst.h"
+#include "FAUtils.h"
+#include "FAEpsilonRemoval.h"
+#include "FAAny2AnyOther_global_t.h"
+#include "FAAny2AnyOther_t.h"
+#include "FANfa2Dfa_t.h"
+#include "FADfa2MinDfa_hg_t.h"
+#include "FARSDfaA.h"
+#include "FARSDfa_ro.h"
+#include "FARSNfa_ar_judy.h"
+#include "FARSDfa2MooreDfa.h"
+#include "FARSDfaRenum_depth_first.h"
+#include "FARSDfa_renum.h"
+#include "FARSNfa2RevNfa.h"
+#include "FAState2Ows.h"
+#include "FAState2Ows_amb.h"
+#include "FAMultiMap_judy.h"
+#include "FAParsedRegexp2TrBrMaps.h"
+#include "FADfaPack_triv.h"
+#include "FAPosNfaPack_triv.h"
+#include "FAException.h"
+
+#include <string.h>
+
+
+FAScannerCompiler::FAScannerCompiler (FAAllocatorA * pAlloc) :
+    m_pAlloc (pAlloc),
+    m_re2nfa (pAlloc),
+    m_nfa (pAlloc),
+    m_re2pos (pAlloc),
+    m_pos_nfa (pAlloc),
+    m_common (pAlloc)
+{
+    m_text.SetAllocator (pAlloc);
+    m_text.Create ();
+
+    m_pat2offset.SetAllocator (pAlloc);
+    m_pat2offset.Create ();
+    m_pat2offset.push_back (0);
+
+    m_dump.SetAllocator (pAlloc);
+    m_dump.Create ();
+
+    m_alphabet.SetAllocator (pAlloc);
+    m_alphabet.Create ();
+
+    FANfaCreator_char * pNfas [2] = { &m_nfa, &m_pos_nfa };
+
+    for (int i = 0; i < 2; ++i) {
+        pNfas [i]->SetEncodingName ("UTF-8");
+        pNfas [i]->SetAnyIw (FAFsmConst::IW_ANY);
+        pNfas [i]->SetAnchorLIw (FAFsmConst::IW_L_ANCHOR);
+        pNfas [i]->SetAnchorRIw (FAFsmConst::IW_R_ANCHOR);
+        pNfas [i]->SetTrBr2Iw (false);
+        pNfas [i]->SetTrBrBaseIw (0);
+    }
+
+    m_re2nfa.SetTrBr2Iw (false);
+    m_re2nfa.SetKeepPos (false);
+    m_re2nfa.SetUseUtf8 (true);
+    m_re2nfa.SetNfa (&m_nfa);
+    m_re2nfa.SetLabelType (FAFsmConst::LABEL_CHAR);
+
+    m_re2pos.SetTrBr2Iw (false);
+    m_re2pos.SetKeepPos (true);
+    m_re2pos.SetUseUtf8 (true);
+    m_re2pos.SetNfa (&m_pos_nfa);
+    m_re2pos.SetLabelType (FAFsmConst::LABEL_CHAR);
+
+    m_common.SetAddNfaNums (true);
+    m_common.SetNfaNumBase (PatIdBase);
+    m_common.SetEpsilonIw (FAFsmConst::IW_EPSILON);
+}
+
+
+void FAScannerCompiler::AddPattern (const char * pRe, const int Length)
+{
+    DebugLogAssert (0 < Length && pRe);
+
+    const int Offset = m_text.size ();
+    m_text.resize (Offset + Length);
+    memcpy (m_text.begin () + Offset, pRe, Length);
+
+    m_pat2offset.push_back (Offset + Length);
+}
+
+
+const char * FAScannerCompiler::
+    GetPattern (const int PatId, int * pLength) const
+{
+    DebugLogAssert (pLength);
+    DebugLogAssert (0 <= PatId && (unsigned int) PatId + 1 < m_pat2offset.size ());
+
+    const int Offset = m_pat2offset [PatId];
+    *pLength = m_pat2offset [PatId + 1] - Offset;
+
+    return m_text.begin () + Offset;
+}
+
+
+const int FAScannerCompiler::
+    StoreDump (const unsigned char * pDump, const int Size)
+{
+    DebugLogAssert (0 < Size && pDump);
+
+    // keep every dump 4-bytes aligned
+    const int OldSize = m_dump.size ();
+    const int Offset = (OldSize + sizeof (int) - 1) & ~(sizeof (int) - 1);
+
+    m_dump.resize (Offset + Size);
+    memset (m_dump.begin () + OldSize, 0, Offset - OldSize);
+    memcpy (m_dump.begin () + Offset, pDump, Size);
+
+    return Offset;
+}
+
+
+void FAScannerCompiler::BuildNfa (const int PatId)
+{
+    int Length;
+    const char * pRe = GetPattern (PatId, &Length);
+
+    m_nfa.Clear ();
+    m_nfa.SetRegexp (pRe, Length);
+
+    m_re2nfa.SetRegexp (pRe, Length);
+    m_re2nfa.Process ();
+    m_re2nfa.Clear ();
+
+    m_nfa.Prepare ();
+}
+
+
+void FAScannerCompiler::BuildAlphabet ()
+{
+    m_alphabet.resize (0);
+
+    const int PatCount = m_pat2offset.size () - 1;
+
+    for (int PatId = 0; PatId < PatCount; ++PatId) {
+
+        BuildNfa (PatId);
+
+        const FARSNfaA * pNfa = m_nfa.GetNfa ();
+        DebugLogAssert (pNfa);
+
+        const int MaxState = pNfa->GetMaxState ();
+
+        for (int State = 0; State <= MaxState; ++State) {
+
+            const int * pIws;
+            const int IwCount = pNfa->GetIWs (State, &pIws);
+
+            // anchors and pattern ids are not a part of the alphabet
+            for (int i = 0; i < IwCount; ++i) {
+                const int Iw = pIws [i];
+                if (FAFsmConst::IW_EPSILON < Iw && PatIdBase > Iw) {
+                    m_alphabet.push_back (Iw);
+                }
+            }
+        }
+
+        const int NewSize = ::FASortUniq (m_alphabet.begin (), m_alphabet.end ());
+        m_alphabet.resize (NewSize);
+
+        m_nfa.Clear ();
+    }
+}
+
+
+void FAScannerCompiler::AddUnionNfa (const int PatId, const bool fReverse)
+{
+    BuildNfa (PatId);
+
+    // expand the '.'-symbol before the union, so the symbols excluded by
+    // [^...] stay dead for this pattern only
+    FARSNfa_wo_ro nfa (m_pAlloc);
+    FAAny2AnyOther_global_t < FARSNfaA, FARSNfa_wo_ro > dot_exp (m_pAlloc);
+
+    dot_exp.SetAnyIw (FAFsmConst::IW_ANY);
+    dot_exp.SetExpIws (m_alphabet.begin (), m_alphabet.size ());
+    dot_exp.SetInNfa (m_nfa.GetNfa ());
+    dot_exp.SetOutNfa (&nfa);
+    dot_exp.Process ();
+    m_nfa.Clear ();
+
+    if (fReverse) {
+
+        FARSNfa_wo_ro rev_nfa (m_pAlloc);
+        FARSNfa2RevNfa rev (m_pAlloc);
+
+        rev.SetAnyIw (FAFsmConst::IW_ANY);
+        rev.SetInNfa (&nfa);
+        rev.SetOutNfa (&rev_nfa);
+        rev.Process ();
+
+        m_common.AddNfa (&rev_nfa);
+
+    } else {
+
+        m_common.AddNfa (&nfa);
+    }
+}
+
+
+void FAScannerCompiler::
+    StoreUnionDfa (const bool fReverse, const int HeaderPos)
+{
+    m_common.Process ();
+
+    // remove epsilon transitions
+    FARSNfa_ar_judy enfa (m_pAlloc);
+    FAEpsilonRemoval e_removal (m_pAlloc);
+
+    e_removal.SetInNfa (m_common.GetCommonNfa ());
+    e_removal.SetOutNfa (&enfa);
+    e_removal.SetEpsilonIw (FAFsmConst::IW_EPSILON);
+    e_removal.Process ();
+    e_removal.Clear ();
+    m_common.Clear ();
+
+    // the common initial state has no incoming transitions, so the loop
+    // over it makes L = .* L, the right anchor is read before the text,
+    // the '.'-symbol is already expanded, so the loop is over every symbol
+    if (fReverse) {
+
+        const int * pInitials = NULL;
+        enfa.GetInitials (&pInitials);
+        DebugLogAssert (pInitials);
+
+        const int Initial = *pInitials;
+        const int AlphabetSize = m_alphabet.size ();
+
+        for (int i = 0; i < AlphabetSize; ++i) {
+            enfa.SetTransition (Initial, m_alphabet [i], Initial);
+        }
+
+        enfa.SetTransition (Initial, FAFsmConst::IW_ANY, Initial);
+        enfa.SetTransition (Initial, FAFsmConst::IW_R_ANCHOR, Initial);
+        enfa.Prepare ();
+    }
+
+    // build DFA
+    FARSDfa_wo_ro dfa (m_pAlloc);
+    FANfa2Dfa_t < FARSNfaA, FARSDfa_wo_ro > nfa2dfa (m_pAlloc);
+
+    nfa2dfa.SetNFA (&enfa);
+    nfa2dfa.SetDFA (&dfa);
+    nfa2dfa.Process ();
+    nfa2dfa.Clear ();
+    enfa.Clear ();
+
+    // add one more state, to be used as a dead
+    const int MaxState = dfa.GetMaxState ();
+    dfa.SetMaxState (MaxState + 1);
+
+    // build Min DFA
+    FARSDfa_ro min_dfa (m_pAlloc);
+    FADfa2MinDfa_hg_t < FARSDfa_wo_ro, FARSDfa_ro > dfa2mindfa (m_pAlloc);
+
+    dfa2mindfa.SetInDfa (&dfa);
+    dfa2mindfa.SetOutDfa (&min_dfa);
+    dfa2mindfa.Process ();
+    dfa2mindfa.Clear ();
+    dfa.Clear ();
+
+    // move pattern ids into the Moore reaction
+    const int PatCount = m_pat2offset.size () - 1;
+
+    FARSDfa_ro moore_dfa (m_pAlloc);
+    FAState2Ows moore_ows (m_pAlloc);
+    FARSDfa2MooreDfa rs2moore (m_pAlloc);
+
+    rs2moore.SetRSDfa (&min_dfa);
+    rs2moore.SetMooreDfa (&moore_dfa);
+    rs2moore.SetState2Ows (&moore_ows);
+    rs2moore.SetOwsRange (PatIdBase, PatIdBase + PatCount - 1);
+    rs2moore.Process ();
+    min_dfa.Clear ();
+
+    // the packed DFA starts from the first state, make the initial be 0
+    FARSDfaRenum_depth_first renum (m_pAlloc);
+
+    renum.SetDfa (&moore_dfa);
+    renum.Process ();
+
+    const int * pOld2New = renum.GetOld2NewMap ();
+    DebugLogAssert (pOld2New);
+
+    FARSDfa_renum renum_dfa (m_pAlloc);
+
+    renum_dfa.SetOldDfa (&moore_dfa);
+    renum_dfa.SetOld2New (pOld2New);
+    renum_dfa.Prepare ();
+    DebugLogAssert (0 == renum_dfa.GetInitial ());
+
+    FAState2Ows renum_ows (m_pAlloc);
+    const int OldMaxState = moore_dfa.GetMaxState ();
+
+    for (int State = 0; State <= OldMaxState; ++State) {
+
+        const int * pOws;
+        const int OwsCount = moore_ows.GetOws (State, &pOws);
+        const int NewState = pOld2New [State];
+
+        if (0 < OwsCount && -1 != NewState) {
+            renum_ows.SetOws (NewState, pOws, OwsCount);
+        }
+    }
+
+    // the forward walk stops once the started patterns cannot be matched
+    if (!fReverse) {
+        AddLiveOws (&renum_dfa, &renum_ows, PatCount);
+    }
+
+    // pack it
+    FADfaPack_triv dfa2dump (m_pAlloc);
+
+    dfa2dump.SetDfa (&renum_dfa);
+    dfa2dump.SetState2Ows (&renum_ows);
+    dfa2dump.SetRemapIws (true);
+    dfa2dump.Process ();
+
+    const unsigned char * pDump = NULL;
+    const int Size = dfa2dump.GetDump (&pDump);
+    FAAssert (0 < Size && pDump, FAMsg::InternalError);
+
+    const int Offset = StoreDump (pDump, Size);
+    ((int *) m_dump.begin ()) [HeaderPos] = Offset;
+}
+
+
+void FAScannerCompiler::AddLiveOws (
+        const FARSDfaA * pDfa,
+        FAState2Ows * pOws,
+        const int PatCount
+    ) const
+{
+    DebugLogAssert (pDfa && pOws);
+
+    const int MaxState = pDfa->GetMaxState ();
+
+    const int * pIws;
+    const int IwCount = pDfa->GetIWs (&pIws);
+
+    // build the reverse transitions and the pattern -> end states map
+    FAMultiMap_judy dst2src;
+    dst2src.SetAllocator (m_pAlloc);
+
+    FAMultiMap_judy pat2ends;
+    pat2ends.SetAllocator (m_pAlloc);
+
+    int State;
+
+    for (State = 0; State <= MaxState; ++State) {
+
+        for (int i = 0; i < IwCount; ++i) {
+
+            const int Dst = pDfa->GetDest (State, pIws [i]);
+
+            if (0 <= Dst) {
+                dst2src.Add (Dst, State);
+            }
+        }
+
+        const int * pEnds;
+        const int EndCount = pOws->GetOws (State, &pEnds);
+
+        for (int i = 0; i < EndCount; ++i) {
+            pat2ends.Add (pEnds [i], State);
+        }
+    }
+
+    dst2src.SortUniq ();
+
+    // state -> the last pattern it was visited for
+    FAArray_cont_t < int > state2pat;
+    state2pat.SetAllocator (m_pAlloc);
+    state2pat.Create ();
+    state2pat.resize (MaxState + 1);
+
+    for (State = 0; State <= MaxState; ++State) {
+        state2pat [State] = -1;
+    }
+
+    FAArray_cont_t < int > stack;
+    stack.SetAllocator (m_pAlloc);
+    stack.Create ();
+
+    // mark all the states leading to the end states of each pattern
+    for (int PatId = 0; PatId < PatCount; ++PatId) {
+
+        const int * pEnds;
+        const int EndCount = pat2ends.Get (PatId, &pEnds);
+
+        for (int i = 0; i < EndCount; ++i) {
+
+            State = pEnds [i];
+
+            if (PatId != state2pat [State]) {
+                state2pat [State] = PatId;
+                stack.push_back (State);
+            }
+        }
+
+        while (0 < stack.size ()) {
+
+            State = stack [stack.size () - 1];
+            stack.pop_back ();
+
+            pOws->AddOw (State, PatCount + PatId);
+
+            const int * pSrcs;
+            const int SrcCount = dst2src.Get (State, &pSrcs);
+
+            for (int i = 0; i < SrcCount; ++i) {
+
+                const int Src = pSrcs [i];
+
+                if (PatId != state2pat [Src]) {
+                    state2pat [Src] = PatId;
+                    stack.push_back (Src);
+                }
+            }
+        }
+    }
+
+    pOws->Prepare ();
+}
+
+
+void FAScannerCompiler::StorePosAutomata (const int PatId)
+{
+    int Length;
+    const char * pRe = GetPattern (PatId, &Length);
+
+    m_pos_nfa.Clear ();
+    m_pos_nfa.SetRegexp (pRe, Length);
+
+    m_re2pos.SetRegexp (pRe, Length);
+    m_re2pos.Process ();
+
+    m_pos_nfa.Prepare ();
+    const FARSNfaA * pNfa = m_pos_nfa.GetNfa ();
+    DebugLogAssert (pNfa);
+
+    // calc triangular bracket maps
+    FAMultiMap_judy pos2br_begin;
+    FAMultiMap_judy pos2br_end;
+
+    pos2br_begin.SetAllocator (m_pAlloc);
+    pos2br_end.SetAllocator (m_pAlloc);
+
+    FAParsedRegexp2TrBrMaps re2trbrmaps (m_pAlloc);
+
+    re2trbrmaps.SetRegexpFuncs (m_re2pos.GetRegexpFuncs ());
+    re2trbrmaps.SetRegexpTree (m_re2pos.GetRegexpTree ());
+    re2trbrmaps.SetPos2Class (m_re2pos.GetPos2Class ());
+    re2trbrmaps.SetStartMap (&pos2br_begin);
+    re2trbrmaps.SetEndMap (&pos2br_end);
+    re2trbrmaps.Process ();
+
+    m_re2pos.Clear ();
+
+    // the pattern has no brackets, nothing to store
+    if (0 >= pos2br_begin.GetMaxCount ()) {
+        m_pos_nfa.Clear ();
+        return;
+    }
+
+    // build reverse position NFA, expand Any symbol locally
+    FARSNfa_wo_ro rev_follow (m_pAlloc);
+    FARSNfa2RevNfa rev (m_pAlloc);
+
+    rev.SetInNfa (pNfa);
+    rev.SetOutNfa (&rev_follow);
+    rev.Process ();
+
+    FARSNfa_wo_ro follow (m_pAlloc);
+    FAAny2AnyOther_t < FARSNfaA, FARSNfa_wo_ro > any_exp (m_pAlloc);
+
+    any_exp.SetAnyIw (FAFsmConst::IW_ANY);
+    any_exp.SetInNfa (&rev_follow);
+    any_exp.SetOutNfa (&follow);
+    any_exp.Process ();
+    rev_follow.Clear ();
+
+    // build position DFA, Any symbol is expanded locally
+    FARSDfa_wo_ro pos_dfa (m_pAlloc);
+    FAState2Ows_amb state2pos (m_pAlloc);
+
+    state2pos.SetRevPosNfa (&follow);
+    state2pos.Prepare ();
+
+    FANfa2Dfa_t < FARSNfaA, FARSDfa_wo_ro > nfa2dfa (m_pAlloc);
+
+    nfa2dfa.SetNew2Old (&state2pos);
+    nfa2dfa.SetNFA (pNfa);
+    nfa2dfa.SetDFA (&pos_dfa);
+    nfa2dfa.SetAnyIw (FAFsmConst::IW_ANY);
+    nfa2dfa.Process ();
+    nfa2dfa.Clear ();
+    m_pos_nfa.Clear ();
+
+    // pack position DFA
+    const unsigned char * pDump = NULL;
+    int Size;
+
+    FADfaPack_triv dfa2dump (m_pAlloc);
+
+    dfa2dump.SetDfa (&pos_dfa);
+    dfa2dump.SetState2Ows (&state2pos);
+    dfa2dump.Process ();
+
+    Size = dfa2dump.GetDump (&pDump);
+    FAAssert (0 < Size && pDump, FAMsg::InternalError);
+
+    const int DfaOffset = StoreDump (pDump, Size);
+
+    // pack position NFA with the bracket maps
+    FAPosNfaPack_triv nfa2dump (m_pAlloc);
+
+    nfa2dump.SetNfa (&follow);
+    nfa2dump.SetPos2BrBegin (&pos2br_begin);
+    nfa2dump.SetPos2BrEnd (&pos2br_end);
+    nfa2dump.Process ();
+
+    Size = nfa2dump.GetDump (&pDump);
+    FAAssert (0 < Size && pDump, FAMsg::InternalError);
+
+    const int NfaOffset = StoreDump (pDump, Size);
+
+    int * pHeader = (int *) m_dump.begin ();
+    pHeader [HeaderSize + (2 * PatId)] = DfaOffset;
+    pHeader [HeaderSize + (2 * PatId) + 1] = NfaOffset;
+}
+
+
+void FAScannerCompiler::Process ()
+{
+    const int PatCount = m_pat2offset.size () - 1;
+    FAAssert (0 < PatCount, FAMsg::InvalidParameters);
+
+    // reserve the header
+    const int HeaderInts = HeaderSize + (2 * PatCount);
+
+    m_dump.resize (HeaderInts * sizeof (int));
+    memset (m_dump.begin (), 0, HeaderInts * sizeof (int));
+    ((int *) m_dump.begin ()) [0] = PatCount;
+
+    BuildAlphabet ();
+
+    // build the union
+    for (int PatId = 0; PatId < PatCount; ++PatId) {
+        AddUnionNfa (PatId, false);
+    }
+
+    StoreUnionDfa (false, 1);
+
+    // build the reverse union
+    for (int PatId = 0; PatId < PatCount; ++PatId) {
+        AddUnionNfa (PatId, true);
+    }
+
+    StoreUnionDfa (true, 2);
+
+    // build bracket extraction data
+    for (int PatId = 0; PatId < PatCount; ++PatId) {
+        StorePosAutomata (PatId);
+    }
+}
+
+
+const int FAScannerCompiler::GetDump (const unsigned char ** ppDump) const
+{
+    DebugLogAssert (ppDump);
+
+    *ppDump = m_dump.begin ();
+    return m_dump.size ();
+}
+
+
+void FAScannerCompiler::Clear ()
+{
+    m_text.Clear ();
+    m_text.Create ();
+
+    m_pat2offset.Clear ();
+    m_pat2offset.Create ();
+    m_pat2offset.push_back (0);
+
+    m_dump.Clear ();
+    m_dump.Create ();
+
+    m_common.Clear ();
+}
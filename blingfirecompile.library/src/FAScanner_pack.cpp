@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-compile_src_pch.h"
+#include "FAConfig.h"
+#include "FAScanner_pack.h"
+#include "FAException.h"
+
+
+FAScanner_pack::FAPatternData::FAPatternData () :
+    m_HasBrackets (false),
+    m_pos2br_begin (FAState2TrBr_pack_triv::MapTypeTrBrBegin),
+    m_pos2br_end (FAState2TrBr_pack_triv::MapTypeTrBrEnd)
+{}
+
+
+FAScanner_pack::FAScanner_pack () :
+    m_PatCount (0),
+    m_pPats (NULL)
+{}
+
+
+FAScanner_pack::~FAScanner_pack ()
+{
+    FAScanner_pack::Clear ();
+}
+
+
+void FAScanner_pack::Clear ()
+{
+    if (m_pPats) {
+        delete [] m_pPats;
+        m_pPats = NULL;
+    }
+
+    m_PatCount = 0;
+    m_dfa.SetImage (NULL);
+    m_ows.SetImage (NULL);
+    m_rev_dfa.SetImage (NULL);
+    m_rev_ows.SetImage (NULL);
+}
+
+
+void FAScanner_pack::SetImage (const unsigned char * pImage)
+{
+    Clear ();
+
+    if (NULL == pImage) {
+        return;
+    }
+
+    const int * pHeader = (const int *) pImage;
+
+    const int PatCount = pHeader [0];
+    FAAssert (0 < PatCount, FAMsg::InitializationError);
+
+    const int DfaOffset = pHeader [1];
+    FAAssert (0 < DfaOffset, FAMsg::InitializationError);
+
+    m_dfa.SetImage (pImage + DfaOffset);
+    m_ows.SetImage (pImage + DfaOffset);
+
+    const int RevDfaOffset = pHeader [2];
+    FAAssert (0 < RevDfaOffset, FAMsg::InitializationError);
+
+    m_rev_dfa.SetImage (pImage + RevDfaOffset);
+    m_rev_ows.SetImage (pImage + RevDfaOffset);
+
+    m_pPats = new FAPatternData [PatCount];
+    FAAssert (m_pPats, FAMsg::OutOfMemory);
+
+    m_PatCount = PatCount;
+
+    for (int PatId = 0; PatId < PatCount; ++PatId) {
+
+        const int PosDfaOffset = pHeader [3 + (2 * PatId)];
+        const int PosNfaOffset = pHeader [4 + (2 * PatId)];
+
+        if (0 == PosDfaOffset || 0 == PosNfaOffset) {
+            continue;
+        }
+
+        FAPatternData * pPat = m_pPats + PatId;
+
+        pPat->m_HasBrackets = true;
+        pPat->m_pos_dfa.SetImage (pImage + PosDfaOffset);
+        pPat->m_pos_ows.SetImage (pImage + PosDfaOffset);
+        pPat->m_follow.SetImage (pImage + PosNfaOffset);
+        pPat->m_pos2br_begin.SetImage (pImage + PosNfaOffset);
+        pPat->m_pos2br_end.SetImage (pImage + PosNfaOffset);
+    }
+}
+
+
+const int FAScanner_pack::GetPatternCount () const
+{
+    return m_PatCount;
+}
+
+
+const FARSDfaCA * FAScanner_pack::GetDfa () const
+{
+    return & m_dfa;
+}
+
+
+const FAState2OwsCA * FAScanner_pack::GetState2Ows () const
+{
+    return & m_ows;
+}
+
+
+const FARSDfaCA * FAScanner_pack::GetRevDfa () const
+{
+    return & m_rev_dfa;
+}
+
+
+const FAState2OwsCA * FAScanner_pack::GetRevState2Ows () const
+{
+    return & m_rev_ows;
+}
+
+
+const bool FAScanner_pack::HasBrackets (const int PatId) const
+{
+    DebugLogAssert (0 <= PatId && PatId < m_PatCount);
+    return m_pPats [PatId].m_HasBrackets;
+}
+
+
+const FARSDfaCA * FAScanner_pack::GetPosDfa (const int PatId) const
+{
+    DebugLogAssert (HasBrackets (PatId));
+    return & (m_pPats [PatId].m_pos_dfa);
+}
+
+
+const FAState2OwsCA * FAScanner_pack::GetPosState2Ows (const int PatId) const
+{
+    DebugLogAssert (HasBrackets (PatId));
+    return & (m_pPats [PatId].m_pos_ows);
+}
+
+
+const FARSNfaCA * FAScanner_pack::GetFollow (const int PatId) const
+{
+    DebugLogAssert (HasBrackets (PatId));
+    return & (m_pPats [PatId].m_follow);
+}
+
+
+const FAMultiMapCA * FAScanner_pack::GetPos2BrBegin (const int PatId) const
+{
+    DebugLogAssert (HasBrackets (PatId));
+    return & (m_pPats [PatId].m_pos2br_begin);
+}
+
+
+const FAMultiMapCA * FAScanner_pack::GetPos2BrEnd (const int PatId) const
+{
+    DebugLogAssert (HasBrackets (PatId));
+    return & (m_pPats [PatId].m_pos2br_end);
+}
@@ -26,6 +26,9 @@ FASelectTrPatterns::FASelectTrPatterns (FAAllocatorA * pAlloc) :
     m_used_ids.SetAllocator (pAlloc);
     m_used_ids.Create ();
 
+    m_cover.SetAllocator (pAlloc);
+    m_cover.Create ();
+
     m_tmp.SetAllocator (pAlloc);
     m_tmp.Create ();
 
@@ -218,9 +221,9 @@ const bool FASelectTrPatterns::Better (const int Id1, const int Id2) const
 }
 
 
-void FASelectTrPatterns::UpdateBest (const int * pOws, const int Count)
+void FASelectTrPatterns::UpdateBest (const int * pCover, const int Size)
 {
-    DebugLogAssert (pOws);
+    DebugLogAssert (pCover || 0 == Size);
 
     int i, j;
 
@@ -231,17 +234,13 @@ void FASelectTrPatterns::UpdateBest (const int * pOws, const int Count)
     const int UsedIdsCount = m_used_ids.size ();
     DebugLogAssert (::FAIsSortUniqed (pUsedIds, UsedIdsCount));
 
-    for (i = 0; i < Count; ++i) {
+    for (i = 0; i < Size; i += (2 + pCover [i + 1])) {
 
-        // skip non-hyphenating position, if asked
-        if (m_NoEmpty) {
-            const int Ow = pOws [i];
-            if (FAFsmConst::HYPH_NO_HYPH == Ow)
-                continue;
-        }
+        DebugLogAssert (i + 1 < Size);
 
-        const int * pIds;
-        const int IdCount = m_pos2ids_cover.Get (i, &pIds);
+        const int * pIds = pCover + i + 2;
+        const int IdCount = pCover [i + 1];
+        DebugLogAssert (i + 2 + IdCount <= Size);
 
         if (0 < IdCount) {
 
@@ -291,11 +290,16 @@ void FASelectTrPatterns::UpdateBest (const int * pOws, const int Count)
 }
 
 
-void FASelectTrPatterns::
-    AddIwsOws (const int * pIws, const int * pOws, const int Count)
+const int FASelectTrPatterns::
+    GetCover (
+        const int * pIws,
+        const int * pOws,
+        const int Count,
+        const int ** ppCover
+    )
 {
     DebugLogAssert (m_pDfa && m_pMealy && m_pK2I);
-    DebugLogAssert (0 < Count && pIws && pOws);
+    DebugLogAssert (0 < Count && pIws && pOws && ppCover);
 
     m_pos2ids_ends.Clear ();
 
@@ -329,7 +333,55 @@ void FASelectTrPatterns::
 
     CalcCover (pIws, pOws, Count);
 
-    UpdateBest (pOws, Count);
+    // store the cover as [Pos, IdCount, Id_1, ..., Id_IdCount]
+    m_cover.resize (0);
+
+    for (int i = 0; i < Count; ++i) {
+
+        // skip non-hyphenating position, if asked
+        if (m_NoEmpty) {
+            const int Ow = pOws [i];
+            if (FAFsmConst::HYPH_NO_HYPH == Ow)
+                continue;
+        }
+
+        const int * pIds;
+        const int IdCount = m_pos2ids_cover.Get (i, &pIds);
+
+        if (0 < IdCount) {
+
+            DebugLogAssert (pIds);
+
+            const int CoverSize = m_cover.size ();
+            m_cover.resize (CoverSize + 2 + IdCount);
+            int * pOut = m_cover.begin () + CoverSize;
+
+            pOut [0] = i;
+            pOut [1] = IdCount;
+            memcpy (pOut + 2, pIds, sizeof (int) * IdCount);
+        }
+    }
+
+    *ppCover = m_cover.begin ();
+    return m_cover.size ();
+}
+
+
+void FASelectTrPatterns::AddCover (const int * pCover, const int Size)
+{
+    DebugLogAssert (m_pK2I && m_pI2Info);
+
+    UpdateBest (pCover, Size);
+}
+
+
+void FASelectTrPatterns::
+    AddIwsOws (const int * pIws, const int * pOws, const int Count)
+{
+    const int * pCover = NULL;
+    const int Size = GetCover (pIws, pOws, Count, &pCover);
+
+    UpdateBest (pCover, Size);
 }
 
 
@@ -0,0 +1,400 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "blingfire-compile_src_pch.h"
+#include "FAConfig.h"
+#include "FAStrAligner.h"
+#include "FALimits.h"
+#include "FAException.h"
+
+
+FAStrAligner::FAStrAligner (FAAllocatorA * pAlloc) :
+    m_Gap1 (-1),
+    m_Gap2 (-1),
+    m_NotEqual (0),
+    m_NotEqual2 (0),
+    m_Equal2 (1),
+    m_MinPos (-1),
+    m_Reverse (false),
+    m_Filler (FAFsmConst::IW_EPSILON),
+    m_Band (DefBand),
+    m_pStr1 (NULL),
+    m_Count1 (0),
+    m_pStr2 (NULL),
+    m_Count2 (0),
+    m_pEq (NULL),
+    m_pNeq (NULL),
+    m_pD (NULL),
+    m_Lo (0),
+    m_Hi (0)
+{
+    m_str1.SetAllocator (pAlloc);
+    m_str1.Create ();
+    m_str2.SetAllocator (pAlloc);
+    m_str2.Create ();
+    m_eq.SetAllocator (pAlloc);
+    m_eq.Create ();
+    m_neq.SetAllocator (pAlloc);
+    m_neq.Create ();
+    m_d.SetAllocator (pAlloc);
+    m_d.Create ();
+}
+
+
+void FAStrAligner::SetGap1 (const int Gap1)
+{
+    m_Gap1 = Gap1;
+}
+
+
+void FAStrAligner::SetGap2 (const int Gap2)
+{
+    m_Gap2 = Gap2;
+}
+
+
+void FAStrAligner::SetNotEqual (const int NotEqual)
+{
+    m_NotEqual = NotEqual;
+}
+
+
+void FAStrAligner::SetNotEqual2 (const int NotEqual2)
+{
+    m_NotEqual2 = NotEqual2;
+}
+
+
+void FAStrAligner::SetEqual2 (const int Equal2)
+{
+    m_Equal2 = Equal2;
+}
+
+
+void FAStrAligner::SetMinPos (const int MinPos)
+{
+    m_MinPos = MinPos;
+}
+
+
+void FAStrAligner::SetReverse (const bool Reverse)
+{
+    m_Reverse = Reverse;
+}
+
+
+void FAStrAligner::SetFiller (const int Filler)
+{
+    m_Filler = Filler;
+}
+
+
+void FAStrAligner::SetBand (const int Band)
+{
+    DebugLogAssert (0 <= Band);
+    m_Band = Band;
+}
+
+
+inline void FAStrAligner::
+    Prepare (
+        const int * pStr1,
+        const int Count1,
+        const int * pStr2,
+        const int Count2
+    )
+{
+    int k;
+
+    m_Count1 = Count1;
+    m_Count2 = Count2;
+
+    m_str1.resize (Count1);
+    int * pS1 = m_str1.begin ();
+    m_str2.resize (Count2);
+    int * pS2 = m_str2.begin ();
+
+    if (m_Reverse) {
+        for (k = 0; k < Count1; ++k) {
+            pS1 [k] = pStr1 [Count1 - k - 1];
+        }
+        for (k = 0; k < Count2; ++k) {
+            pS2 [k] = pStr2 [Count2 - k - 1];
+        }
+    } else {
+        memcpy (pS1, pStr1, sizeof (int) * Count1);
+        memcpy (pS2, pStr2, sizeof (int) * Count2);
+    }
+
+    m_pStr1 = pS1;
+    m_pStr2 = pS2;
+
+    // the score depends on the str1 position and the symbols equality only
+    m_eq.resize (Count1);
+    int * pEq = m_eq.begin ();
+    m_neq.resize (Count1);
+    int * pNeq = m_neq.begin ();
+
+    for (k = 0; k < Count1; ++k) {
+
+        bool fLeft = k <= m_MinPos;
+        if (m_Reverse) {
+            fLeft = Count1 - k - 1 <= m_MinPos;
+        }
+
+        pEq [k] = fLeft ? m_Equal2 : 1;
+        pNeq [k] = fLeft ? m_NotEqual2 : m_NotEqual;
+    }
+
+    m_pEq = pEq;
+    m_pNeq = pNeq;
+
+    // overflow check: (Count1 + 1) * (Count2 + 1)
+    FAAssert (FALimits::MaxArrSize / (unsigned int) (Count1 + 1) >= \
+        (unsigned int) (Count2 + 1), FAMsg::LimitIsExceeded);
+
+    m_d.resize ((Count1 + 1) * (Count2 + 1));
+    m_pD = m_d.begin ();
+}
+
+
+inline const int FAStrAligner::GetD (const int i, const int j) const
+{
+    DebugLogAssert (0 <= i && i <= m_Count2 && 0 <= j && j <= m_Count1);
+
+    const int Diag = i - j;
+
+    if (Diag < m_Lo || Diag > m_Hi) {
+        return NegInf;
+    }
+    return m_pD [(i * (m_Count1 + 1)) + j];
+}
+
+
+///
+/// m_pD [i][j] keeps an alignment score of str2 [0..i-1] with str1 [0..j-1],
+/// only the cells with Lo <= i - j <= Hi are computed.
+///
+
+inline const int FAStrAligner::Fill (const int Lo, const int Hi)
+{
+    DebugLogAssert (Lo <= 0 && Lo <= m_Count2 - m_Count1);
+    DebugLogAssert (Hi >= 0 && Hi >= m_Count2 - m_Count1);
+
+    m_Lo = Lo;
+    m_Hi = Hi;
+
+    const int Width = m_Count1 + 1;
+
+    int i, j;
+
+    m_pD [0] = 0;
+
+    const int MaxJ0 = m_Count1 < -Lo ? m_Count1 : -Lo;
+    for (j = 0; j < MaxJ0; ++j) {
+        m_pD [j + 1] = (j + 1) * m_Gap2;
+    }
+    const int MaxI0 = m_Count2 < Hi ? m_Count2 : Hi;
+    for (i = 0; i < MaxI0; ++i) {
+        m_pD [(i + 1) * Width] = (i + 1) * m_Gap1;
+    }
+
+    for (i = 1; i < m_Count2 + 1; ++i) {
+
+        // j within [i - Hi, i - Lo] and [1, Count1]
+        const int From = 1 < i - Hi ? i - Hi : 1;
+        const int To = m_Count1 < i - Lo ? m_Count1 : i - Lo;
+
+        const int Iw2 = m_pStr2 [i - 1];
+        int * pRow = m_pD + (i * Width);
+        const int * pPrevRow = pRow - Width;
+
+        for (j = From; j <= To; ++j) {
+
+            const int Score = Iw2 == m_pStr1 [j - 1] ? \
+                m_pEq [j - 1] : m_pNeq [j - 1];
+
+            const int S1 = pPrevRow [j - 1] + Score;
+            // (i, j - 1) is outside if i - j + 1 > Hi
+            const int S2 = (j > From || i - j + 1 <= Hi) ? \
+                pRow [j - 1] + m_Gap2 : NegInf;
+            // (i - 1, j) is outside if i - 1 - j < Lo
+            const int S3 = (j < To || i - 1 - j >= Lo) ? \
+                pPrevRow [j] + m_Gap1 : NegInf;
+
+            if (S1 >= S2 && S1 >= S3) {
+                pRow [j] = S1;
+            } else if (S2 >= S1 && S2 >= S3) {
+                pRow [j] = S2;
+            } else {
+                pRow [j] = S3;
+            }
+        }
+    }
+
+    return m_pD [(m_Count2 * Width) + m_Count1];
+}
+
+
+///
+/// A path which leaves the band has at least MinH horizontal steps (gaps in
+/// str2), and with H horizontal steps it scores at most:
+///
+///   (Count1 - H) * MaxDiag + H * Gap2 + (H + Count2 - Count1) * Gap1
+///
+/// if this is less than the score found within the band, then all optimal
+/// paths are inside of the band, and so are all the cells traceback reads.
+///
+
+inline const bool FAStrAligner::
+    IsExact (const int Lo, const int Hi, const int Score) const
+{
+    const int D0 = m_Count2 - m_Count1;
+
+    // the whole matrix is computed
+    if (Lo <= -m_Count1 && Hi >= m_Count2) {
+        return true;
+    }
+
+    int MaxDiag = 1 > m_NotEqual ? 1 : m_NotEqual;
+    if (0 <= m_MinPos) {
+        if (MaxDiag < m_Equal2)
+            MaxDiag = m_Equal2;
+        if (MaxDiag < m_NotEqual2)
+            MaxDiag = m_NotEqual2;
+    }
+
+    const int Slope = m_Gap1 + m_Gap2 - MaxDiag;
+
+    // leaving the band is not penalized
+    if (0 <= Slope) {
+        return false;
+    }
+
+    const int MinHHi = Hi + 1 - D0;
+    const int MinHLo = 1 - Lo;
+    const int MinH = MinHHi < MinHLo ? MinHHi : MinHLo;
+
+    const int MaxOut = (m_Count1 * MaxDiag) + (D0 * m_Gap1) + (MinH * Slope);
+
+    return MaxOut < Score;
+}
+
+
+inline const int FAStrAligner::
+    Traceback (int * pOut, const int MaxOutSize) const
+{
+    int i = m_Count2;
+    int j = m_Count1;
+    int k;
+
+    const int Width = m_Count1 + 1;
+    const int n = m_Reverse ? 1 : 0;
+    const int m = m_Reverse ? 0 : 1;
+
+    int OutCount = 0;
+
+    if (MaxOutSize < 2 * (m_Count1 + m_Count2)) {
+        return -1;
+    }
+
+    while (i > 0 && j > 0) {
+
+        const int Iw1 = m_pStr1 [j - 1];
+        const int Iw2 = m_pStr2 [i - 1];
+        const int Score = Iw1 == Iw2 ? m_pEq [j - 1] : m_pNeq [j - 1];
+        const int D = m_pD [(i * Width) + j];
+
+        if (D - Score == m_pD [((i - 1) * Width) + j - 1]) {
+            pOut [OutCount + n] = Iw2;
+            pOut [OutCount + m] = Iw1;
+            OutCount += 2;
+            j--;
+            i--;
+        } else if (D - m_Gap2 == GetD (i, j - 1)) {
+            pOut [OutCount + n] = m_Filler;
+            pOut [OutCount + m] = Iw1;
+            OutCount += 2;
+            j--;
+        } else {
+            DebugLogAssert (D - m_Gap1 == GetD (i - 1, j));
+            pOut [OutCount + n] = Iw2;
+            pOut [OutCount + m] = m_Filler;
+            OutCount += 2;
+            i--;
+        }
+    } // of while (i > 0 && j > 0) ...
+
+    while (i > 0) {
+        pOut [OutCount + n] = m_pStr2 [i - 1];
+        pOut [OutCount + m] = m_Filler;
+        OutCount += 2;
+        i--;
+    }
+    while (j > 0) {
+        pOut [OutCount + n] = m_Filler;
+        pOut [OutCount + m] = m_pStr1 [j - 1];
+        OutCount += 2;
+        j--;
+    }
+
+    if (!m_Reverse) {
+        for (k = 0; k < OutCount / 2; ++k) {
+            const int T = pOut [k];
+            pOut [k] = pOut [OutCount - k - 1];
+            pOut [OutCount - k - 1] = T;
+        }
+    }
+
+    return OutCount;
+}
+
+
+const int FAStrAligner::
+    Process (
+        const int * pStr1,
+        const int Count1,
+        const int * pStr2,
+        const int Count2,
+        __out_ecount (MaxOutSize) int * pOut,
+        const int MaxOutSize
+    )
+{
+    DebugLogAssert (pStr1 && 0 < Count1 && pStr2 && 0 < Count2);
+    DebugLogAssert (pOut);
+
+    Prepare (pStr1, Count1, pStr2, Count2);
+
+    const int D0 = Count2 - Count1;
+    const int MinLo = -Count1;
+    const int MaxHi = Count2;
+
+    // the band always contains the main diagonal and the end-point diagonal
+    int Band = m_Band;
+
+    while (true) {
+
+        int Lo = (0 < D0 ? 0 : D0) - Band;
+        int Hi = (0 < D0 ? D0 : 0) + Band;
+
+        if (0 == m_Band || Lo < MinLo) {
+            Lo = MinLo;
+        }
+        if (0 == m_Band || Hi > MaxHi) {
+            Hi = MaxHi;
+        }
+
+        const int Score = Fill (Lo, Hi);
+
+        if (IsExact (Lo, Hi, Score)) {
+            break;
+        }
+
+        Band *= 2;
+    }
+
+    return Traceback (pOut, MaxOutSize);
+}
@@ -24,19 +24,29 @@ FATestCmpDfa::FATestCmpDfa (FAAllocatorA * pAlloc) :
     m_pState2Ows2 (NULL),
     m_pSigma1 (NULL),
     m_pSigma2 (NULL),
+    m_HasCex (false),
     m_pOws1 (NULL),
     m_MaxOws1Count (0),
     m_pOws2 (NULL),
     m_MaxOws2Count (0)
 {
-    m_stack.SetAllocator (pAlloc);
-    m_stack.Create ();
+    m_queue.SetAllocator (pAlloc);
+    m_queue.Create ();
 
-    m_visited1.SetAllocator (pAlloc);
-    m_visited1.Create ();
+    m_state2elem1.SetAllocator (pAlloc);
+    m_state2elem1.Create ();
 
-    m_visited2.SetAllocator (pAlloc);
-    m_visited2.Create ();
+    m_state2elem2.SetAllocator (pAlloc);
+    m_state2elem2.Create ();
+
+    m_parent.SetAllocator (pAlloc);
+    m_parent.Create ();
+
+    m_rank.SetAllocator (pAlloc);
+    m_rank.Create ();
+
+    m_cex.SetAllocator (pAlloc);
+    m_cex.Create ();
 
     m_ows1.SetAllocator (pAlloc);
     m_ows1.Create ();
@@ -100,50 +110,191 @@ void FATestCmpDfa::SetFsm2 (
 
 void FATestCmpDfa::Clear ()
 {
-    m_stack.resize (0);
-    m_visited1.resize (0);
-    m_visited2.resize (0);
+    m_queue.resize (0);
+    m_state2elem1.resize (0);
+    m_state2elem2.resize (0);
+    m_parent.resize (0);
+    m_rank.resize (0);
+    m_cex.resize (0);
+    m_HasCex = false;
 }
 
 
-const bool FATestCmpDfa::
-    WasSeen (const FABitArray * pVisited, const int State) const
+inline const int FATestCmpDfa::
+    GetElement (FAArray_cont_t < int > * pState2Elem, const int State)
 {
-    if (FAFsmConst::DFA_DEAD_STATE == State) {
-        return true;
+    DebugLogAssert (pState2Elem);
+
+    if (-1 == State) {
+        return ElemNone;
+    } else if (FAFsmConst::DFA_DEAD_STATE == State) {
+        return ElemDead;
     }
 
-    DebugLogAssert (pVisited);
     DebugLogAssert (0 <= State);
 
-    const int Size = pVisited->size ();
+    const int Size = pState2Elem->size ();
+
+    if (Size <= State) {
+        pState2Elem->resize (State + 1);
+        int * pBegin = pState2Elem->begin ();
+        for (int i = Size; i <= State; ++i) {
+            pBegin [i] = -1;
+        }
+    }
+
+    int * pElem = pState2Elem->begin () + State;
+
+    if (-1 == *pElem) {
+        *pElem = m_parent.size ();
+        m_parent.push_back (*pElem);
+        m_rank.push_back (0);
+    }
+
+    return *pElem;
+}
+
 
-    if (Size > State) {
+inline const int FATestCmpDfa::Find (int Elem)
+{
+    int * pParent = m_parent.begin ();
 
-        const bool Res = pVisited->get_bit (State);
-        return Res;
+    // path halving
+    while (pParent [Elem] != Elem) {
+        pParent [Elem] = pParent [pParent [Elem]];
+        Elem = pParent [Elem];
+    }
 
-    } else {
+    return Elem;
+}
 
+
+inline const bool FATestCmpDfa::Merge (const int Elem1, const int Elem2)
+{
+    int Root1 = Find (Elem1);
+    int Root2 = Find (Elem2);
+
+    if (Root1 == Root2) {
         return false;
     }
+
+    int * pRank = m_rank.begin ();
+
+    if (pRank [Root1] < pRank [Root2]) {
+        const int Tmp = Root1;
+        Root1 = Root2;
+        Root2 = Tmp;
+    }
+
+    m_parent [Root2] = Root1;
+
+    if (pRank [Root1] == pRank [Root2]) {
+        pRank [Root1]++;
+    }
+
+    return true;
 }
 
 
-void FATestCmpDfa::SetSeen (FABitArray * pVisited, const int State)
+const bool FATestCmpDfa::CmpStates (const int State1, const int State2)
 {
-    DebugLogAssert (pVisited);
-    DebugLogAssert (0 <= State);
+    // the dead state is merged only with the dead state
+    if (FAFsmConst::DFA_DEAD_STATE == State1 || \
+        FAFsmConst::DFA_DEAD_STATE == State2) {
+        return false;
+    }
 
-    const int Size = pVisited->size ();
+    // the missing transition leads to non-final state without outputs
+    const bool IsFinal1 = -1 != State1 && m_pDfa1->IsFinal (State1);
+    const bool IsFinal2 = -1 != State2 && m_pDfa2->IsFinal (State2);
 
-    if (Size <= State) {
+    if (IsFinal1 != IsFinal2) {
+        // both should be final or non-final
+        return false;
+    }
+
+    // check whether they both have same Ows associated
+    if (m_pState2Ow1 && m_pState2Ow2) {
+
+        const int Ow1 = -1 != State1 ? m_pState2Ow1->GetOw (State1) : -1;
+        const int Ow2 = -1 != State2 ? m_pState2Ow2->GetOw (State2) : -1;
 
-        pVisited->resize (State + 1);
-        pVisited->set_bits (Size, State, false);
+        if (Ow1 != Ow2) {
+            // Ows different
+            return false;
+        }
     }
+    // check whether they both have same Ow-sets associated
+    if (m_pState2Ows1 && m_pState2Ows2) {
+
+        int Count1 = -1 != State1 ? \
+            m_pState2Ows1->GetOws (State1, m_pOws1, m_MaxOws1Count) : -1;
+        int Count2 = -1 != State2 ? \
+            m_pState2Ows2->GetOws (State2, m_pOws2, m_MaxOws2Count) : -1;
 
-    pVisited->set_bit (State, true);
+        if (Count1 > m_MaxOws1Count || Count2 > m_MaxOws2Count) {
+            // problems with max values
+            return false;
+        }
+        // empty set is the same as no set
+        if (0 == Count1) {
+            Count1 = -1;
+        }
+        if (0 == Count2) {
+            Count2 = -1;
+        }
+        if (Count1 != Count2 || (-1 != Count1 && \
+            0 != memcmp (m_pOws1, m_pOws2, Count1 * sizeof (int)))) {
+            // different Ows
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void FATestCmpDfa::SetCounterExample (const int Idx, const int Iw)
+{
+    DebugLogAssert (0 <= Idx);
+
+    m_cex.resize (0);
+
+    if (-1 != Iw) {
+        m_cex.push_back (Iw);
+    }
+
+    const int * pQueue = m_queue.begin ();
+
+    for (int i = Idx; -1 != pQueue [(QueueRecSize * i) + 2]; \
+         i = pQueue [(QueueRecSize * i) + 2]) {
+        m_cex.push_back (pQueue [(QueueRecSize * i) + 3]);
+    }
+
+    // the chain has been collected from the end
+    const int Count = m_cex.size ();
+    int * pCex = m_cex.begin ();
+
+    for (int i = 0; i < Count / 2; ++i) {
+        const int Tmp = pCex [i];
+        pCex [i] = pCex [Count - i - 1];
+        pCex [Count - i - 1] = Tmp;
+    }
+
+    m_HasCex = true;
+}
+
+
+const int FATestCmpDfa::GetCounterExample (const int ** ppIws) const
+{
+    DebugLogAssert (ppIws);
+
+    if (!m_HasCex) {
+        return -1;
+    }
+
+    *ppIws = m_cex.begin ();
+    return m_cex.size ();
 }
 
 
@@ -179,14 +330,14 @@ const bool FATestCmpDfa::CmpAlphabets ()
         return false;
     }
 
-    m_iws1.resize (0);
+    // m_iws1 is kept as the alphabet to iterate over
     m_iws2.resize (0);
 
     return true;
 }
 
 
-const bool FATestCmpDfa::Process (const int /*MaxState*/, const int MaxIw)
+const bool FATestCmpDfa::Process (const int MaxState, const int MaxIw)
 {
     DebugLogAssert (0 < MaxIw);
     DebugLogAssert (m_pDfa1 && m_pDfa2);
@@ -197,140 +348,84 @@ const bool FATestCmpDfa::Process (const int /*MaxState*/, const int MaxIw)
         return false;
     }
 
-    int State1 = m_pDfa1->GetInitial ();
-    int State2 = m_pDfa2->GetInitial ();
-
-    m_stack.push_back (State1);
-    m_stack.push_back (State2);
+    const int IwCount = m_iws1.size ();
+    const int * pIws = m_iws1.begin ();
 
-    // mark the as "seen"
-    SetSeen (&m_visited1, State1);
-    SetSeen (&m_visited2, State2);
+    // reserve elements for the missing transition and the dead state
+    m_parent.push_back (ElemNone);
+    m_rank.push_back (0);
+    m_parent.push_back (ElemDead);
+    m_rank.push_back (0);
 
-    int StackSize = 2;
-    DebugLogAssert (m_stack.size () == (unsigned int) StackSize);
-
-    while (0 < StackSize) {
-
-        DebugLogAssert (m_stack.size () == (unsigned int) StackSize && \
-                0 == (StackSize & 1));
+    if (0 <= MaxState) {
+        m_state2elem1.resize (MaxState + 1);
+        memset (m_state2elem1.begin (), -1, sizeof (int) * (MaxState + 1));
+    }
 
-        State2 = m_stack [StackSize - 1];
-        State1 = m_stack [StackSize - 2];
-        m_stack.resize (StackSize - 2);
-        StackSize -= 2;
+    const int Initial1 = m_pDfa1->GetInitial ();
+    const int Initial2 = m_pDfa2->GetInitial ();
 
-        /// // check whether they both final
-        /// const bool IsFinal1 = m_pDfa1->IsFinal (State1);
-        /// const bool IsFinal2 = m_pDfa2->IsFinal (State2);
+    Merge (GetElement (&m_state2elem1, Initial1), \
+        GetElement (&m_state2elem2, Initial2));
 
-        /// if (IsFinal1 != IsFinal2) {
-        ///     // both should be final or non-final
-        ///     DebugLogAssert (0);
-        ///     return false;
-        /// }
+    m_queue.push_back (Initial1);
+    m_queue.push_back (Initial2);
+    m_queue.push_back (-1);
+    m_queue.push_back (-1);
 
-        // check whether they both have same Ows associated
-        if (m_pState2Ow1 && m_pState2Ow2) {
+    // pairs are processed in breadth-first order, so the counter-example
+    // is short, but not always the shortest as merged pairs are skipped
+    for (int Idx = 0; (unsigned int) (QueueRecSize * Idx) < m_queue.size (); \
+         ++Idx) {
 
-            const int Ow1 = m_pState2Ow1->GetOw (State1);
-            const int Ow2 = m_pState2Ow2->GetOw (State2);
+        const int State1 = m_queue [QueueRecSize * Idx];
+        const int State2 = m_queue [(QueueRecSize * Idx) + 1];
 
-            if (Ow1 != Ow2) {
-                // Ows different
-                DebugLogAssert (0);
-                return false;
-            }
-        }
-        // check whether they both have same Ow-sets associated
-        if (m_pState2Ows1 && m_pState2Ows2) {
-
-            const int Count1 = 
-                m_pState2Ows1->GetOws (State1, m_pOws1, m_MaxOws1Count);
-            const int Count2 = 
-                m_pState2Ows2->GetOws (State2, m_pOws2, m_MaxOws2Count);
-
-            if (Count1 != Count2 || \
-                Count1 > m_MaxOws1Count || \
-                Count2 > m_MaxOws2Count) {
-                // problems with max values or different Ows
-                DebugLogAssert (0);
-                return false;
-            }
-            if (-1 != Count1 && \
-                0 != memcmp (m_pOws1, m_pOws2, Count1 * sizeof (int))) {
-                // different Ows
-                DebugLogAssert (0);
-                return false;
-            }
+        if (!CmpStates (State1, State2)) {
+            SetCounterExample (Idx, -1);
+            return false;
         }
 
         // process destination states
-        for (int iw = 0; iw <= MaxIw; ++iw) {
+        for (int i = 0; i < IwCount; ++i) {
+
+            const int Iw = pIws [i];
 
-            const int Dest1 = m_pDfa1->GetDest (State1, iw);
-            const int Dest2 = m_pDfa2->GetDest (State2, iw);
+            const int Dest1 = -1 != State1 ? m_pDfa1->GetDest (State1, Iw) : -1;
+            const int Dest2 = -1 != State2 ? m_pDfa2->GetDest (State2, Iw) : -1;
 
             // transition does not exist
             if (-1 == Dest1 && -1 == Dest2) {
                 continue;
             }
 
-            if ((-1 == Dest1 || -1 == Dest2) && \
-                Dest2 != Dest1) {
-                // missing transition
-                DebugLogAssert (0);
-                return false;
-            }
-            if ((FAFsmConst::DFA_DEAD_STATE == Dest1 || \
-                 FAFsmConst::DFA_DEAD_STATE == Dest2) && \
-                Dest2 != Dest1) {
-                // dead-state misrepresentation
-                DebugLogAssert (0);
-                return false;
-            }
-
-            const bool IsSeen1 = WasSeen (&m_visited1, Dest1);
-            const bool IsSeen2 = WasSeen (&m_visited2, Dest2);
-
-            if (IsSeen1 != IsSeen2) {
-                // transition graphs have different structure
-                DebugLogAssert (0);
-                return false;
-            }
-
-            if (m_pSigma1 && m_pSigma2) {
+            if (m_pSigma1 && m_pSigma2 && -1 != Dest1 && -1 != Dest2) {
 
                 int Ow1 = -2;
-                const int D1 = m_pSigma1->GetDestOw (State1, iw, &Ow1);
+                const int D1 = m_pSigma1->GetDestOw (State1, Iw, &Ow1);
 
                 int Ow2 = -3;
-                const int D2 = m_pSigma2->GetDestOw (State2, iw, &Ow2);
+                const int D2 = m_pSigma2->GetDestOw (State2, Iw, &Ow2);
 
-                if (Ow1 != Ow2) {
-                    // sigma difference in Ows
-                    DebugLogAssert (0);
-                    return false;
-                }
-                if (D1 != Dest1 || D2 != Dest2) {
-                    // sigma difference in Dsts
+                if (Ow1 != Ow2 || D1 != Dest1 || D2 != Dest2) {
+                    // sigma difference in Ows or in Dsts
+                    SetCounterExample (Idx, Iw);
                     return false;
                 }
             }
 
-            if (!IsSeen1) {
-
-                m_stack.push_back (Dest1);
-                m_stack.push_back (Dest2);
-
-                StackSize += 2;
+            const int Elem1 = GetElement (&m_state2elem1, Dest1);
+            const int Elem2 = GetElement (&m_state2elem2, Dest2);
 
-                SetSeen (&m_visited1, Dest1);
-                SetSeen (&m_visited2, Dest2);
+            if (Merge (Elem1, Elem2)) {
+                m_queue.push_back (Dest1);
+                m_queue.push_back (Dest2);
+                m_queue.push_back (Idx);
+                m_queue.push_back (Iw);
             }
-        } // of for (int iw = 0; ...
+        } // of for (int i = 0; ...
 
-    } // of while (0 < StackSize) ...
+    } // of for (int Idx = 0; ...
 
     return true;
 }
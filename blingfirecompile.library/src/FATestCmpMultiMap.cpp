@@ -16,7 +16,8 @@ FATestCmpMultiMap::FATestCmpMultiMap (FAAllocatorA * pAlloc) :
     m_pChainBuff1 (NULL),
     m_MaxChainSize1 (0),
     m_pChainBuff2 (NULL),
-    m_MaxChainSize2 (0)
+    m_MaxChainSize2 (0),
+    m_DiffKey (-1)
 {
     m_chain1.SetAllocator (pAlloc);
     m_chain1.Create ();
@@ -107,7 +108,7 @@ inline const bool FATestCmpMultiMap::
 }
 
 
-const bool FATestCmpMultiMap::Process (const int MaxKey)
+const bool FATestCmpMultiMap::Prepare ()
 {
     DebugLogAssert (m_pMMap1 && m_pMMap2);
 
@@ -129,23 +130,39 @@ const bool FATestCmpMultiMap::Process (const int MaxKey)
         m_pChainBuff2 = m_chain2.begin ();
     }
 
+    return true;
+}
+
+
+const bool FATestCmpMultiMap::Process (const int MaxKey)
+{
+    return Process (0, MaxKey);
+}
+
+
+const bool FATestCmpMultiMap::Process (const int FromKey, const int ToKey)
+{
+    DebugLogAssert (0 <= FromKey);
+
+    m_DiffKey = -1;
+
+    if (!Prepare ()) {
+        return false;
+    }
+
     // compare the outputs
 
-    for (int Key = 0; Key <= MaxKey; ++Key) {
+    for (int Key = FromKey; Key <= ToKey; ++Key) {
 
         const int * pVals1;
         const int Size1 = GetChain1 (Key, &pVals1);
-        if (Size1 > m_MaxChainSize1) {
-            return false;
-        }
 
         const int * pVals2;
         const int Size2 = GetChain2 (Key, &pVals2);
-        if (Size2 > m_MaxChainSize2) {
-            return false;
-        }
 
-        if (!Equal (pVals1, Size1, pVals2, Size2)) {
+        if (Size1 > m_MaxChainSize1 || Size2 > m_MaxChainSize2 || \
+            !Equal (pVals1, Size1, pVals2, Size2)) {
+            m_DiffKey = Key;
             return false;
         }
     }
@@ -153,3 +170,8 @@ const bool FATestCmpMultiMap::Process (const int MaxKey)
     return true;
 }
 
+
+const int FATestCmpMultiMap::GetDiffKey () const
+{
+    return m_DiffKey;
+}
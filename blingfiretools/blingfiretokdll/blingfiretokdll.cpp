@@ -5,12 +5,26 @@
 #include "FAWbdConfKeeper.h"
 #include "FALDB.h"
 #include "FALexTools_t.h"
+#include "FAWordPieceConfKeeper.h"
+#include "FAWordPieceTools_t.h"
+#include "FAMweTools.h"
+#include "FAFuzzyLookup_t.h"
+#include "FADictConfKeeper.h"
+#include "FADictInterpreter_t.h"
+#include "FAMorphLDB_t_packaged.h"
+#include "FAWordGuesser_prob_t.h"
+#include "FAT2PTable.h"
+#include "FATs2PTable.h"
+#include "FAHmmTagger_l1.h"
+#include "FAAllocator.h"
 
 #include <algorithm>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <assert.h>
 
 /*
@@ -47,9 +61,15 @@ FALexTools_t < int > g_Sbd;
 
 const int WBD_IGNORE_TAG = 4;
 
-// flag indicating the one-time initialization is done
-volatile bool g_fInitialized = false;
-std::mutex g_InitializationMutex;
+// flag indicating the one-time initialization is done, set with the release
+// semantics after all the objects above are initialized
+std::atomic < bool > g_fInitialized (false);
+std::once_flag g_InitializationFlag;
+
+// InitializeBlingFire flags
+enum {
+    FA_INIT_PREFAULT = 1,   // touch every page of the built-in models
+};
 
 
 
@@ -82,10 +102,62 @@ void InitializeWbdSbd()
     iSize = g_SbdLdb.GetHeader()->Get(FAFsmConst::FUNC_WBD, &pValues);
     g_SbdConf.Initialize(&g_SbdLdb, pValues, iSize);
     g_Sbd.SetConf(&g_SbdConf);
+
+    g_fInitialized.store(true, std::memory_order_release);
+}
+
+
+// makes sure the built-in models are initialized, after the first call costs one load
+inline void FAEnsureInitialized()
+{
+    if (!g_fInitialized.load(std::memory_order_acquire)) {
+        std::call_once(g_InitializationFlag, InitializeWbdSbd);
+    }
+}
+
+
+// reads one byte of every memory page, so the page faults happen now and not on the first request
+inline void FAPrefaultPages(const unsigned char * pData, const size_t Size)
+{
+    const size_t PageSize = 4096;
+    volatile unsigned char Sum = 0;
+
+    for (size_t i = 0; i < Size; i += PageSize) {
+        Sum += pData [i];
+    }
+    if (0 < Size) {
+        Sum += pData [Size - 1];
+    }
+}
+
+
+//
+// Initializes the built-in word-breaking and sentence-breaking models.
+//
+// Calling this function is optional, other functions initialize the library
+// on their first call, but this way the initialization cost is paid upfront,
+// e.g. at the start of a worker, rather than by the first requests.
+//
+// Flags - a combination of the following values:
+//   1 - touch every page of the built-in models, so that they are resident in memory
+//
+// Returns 0 on success.
+//
+extern "C"
+const int InitializeBlingFire(const int Flags)
+{
+    FAEnsureInitialized();
+
+    if (0 != (FA_INIT_PREFAULT & Flags)) {
+        FAPrefaultPages(g_dumpBlingFireTokLibWbdData, sizeof(g_dumpBlingFireTokLibWbdData));
+        FAPrefaultPages(g_dumpBlingFireTokLibSbdData, sizeof(g_dumpBlingFireTokLibSbdData));
+    }
+
+    return 0;
 }
 
 
-inline int FAGetFirstNonWhiteSpace(int * pStr, const int StrLen)
+inline int FAGetFirstNonWhiteSpace(const int * pStr, const int StrLen)
 {
     for (int i = 0; i < StrLen; ++i)
     {
@@ -105,347 +177,563 @@ inline int FAGetFirstNonWhiteSpace(int * pStr, const int StrLen)
 }
 
 
+// the size of the output chunks of the streaming functions, in bytes
+const int FA_STREAM_CHUNK_SIZE = 4096;
+
 //
-// See TextToSentences description below, this one also returns original offsets from the input buffer for each sentence.
-//
-// pStartOffsets is an array of integers (first character of each sentence) with upto MaxOutUtf8StrByteCount elements
-// pEndOffsets is an array of integers (last character of each sentence) with upto MaxOutUtf8StrByteCount elements
+// Callback of the streaming functions, gets the next chunk of the output,
+// ChunkCount is the number of elements (bytes or hashes) in the chunk.
+// Returns 0 to continue the processing or any other value to stop it.
 //
-extern "C"
-const int TextToSentencesWithOffsets(const char * pInUtf8Str, int InUtf8StrByteCount,
-    char * pOutUtf8Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf8StrByteCount)
-{
-    // check if the initilization is needed
-    if (false == g_fInitialized) {
-        // make sure only one thread can get the mutex
-        std::lock_guard<std::mutex> guard(g_InitializationMutex);
-        // see if the g_fInitialized is still false
-        if (false == g_fInitialized) {
-            InitializeWbdSbd();
-            g_fInitialized = true;
-        }
-    }
+typedef int (*FAStreamCallback)(void * pContext, const void * pChunk, const int ChunkCount);
 
-    // validate the parameters
-    if (0 == InUtf8StrByteCount) {
-        return 0;
+
+// collects the output into a string, used by the functions with the output buffer
+class FAStringOutput {
+public:
+    inline void Put(const char C)
+    {
+        m_Str.push_back(C);
     }
-    if (0 > InUtf8StrByteCount || InUtf8StrByteCount > FALimits::MaxArrSize) {
-        return -1;
+    inline void Put(const char * pStr, const int Size)
+    {
+        m_Str.append(pStr, Size);
     }
-    if (NULL == pInUtf8Str) {
-        return -1;
+    inline const bool IsStopped() const
+    {
+        return false;
+    }
+    inline const bool IsCountOnly() const
+    {
+        return false;
     }
 
-    // allocate buffer for UTF-32, sentence breaking results, word-breaking results
-    std::vector< int > utf32input(InUtf8StrByteCount);
-    int * pBuff = utf32input.data();
-    if (NULL == pBuff) {
-        return -1;
+public:
+    std::string m_Str;
+};
+
+
+// copies the output into the array of a fixed size, counts the elements which did not fit too
+template < class Ty >
+class FAArrayOutput {
+public:
+    FAArrayOutput(Ty * pArr, const int MaxCount) :
+        m_pArr(pArr),
+        m_MaxCount(MaxCount),
+        m_Count(0)
+    {}
+
+    inline void Put(const Ty Value)
+    {
+        if (m_Count < m_MaxCount) {
+            m_pArr[m_Count] = Value;
+        }
+        m_Count++;
     }
-    std::vector< int > utf32offsets(InUtf8StrByteCount);
-    int * pOffsets = utf32offsets.data();
-    if (NULL == pOffsets) {
-        return -1;
+    inline const bool IsStopped() const
+    {
+        return false;
     }
-    // make sure there are no uninitialized offsets
-    if (pStartOffsets) {
-        memset(pStartOffsets, 0, MaxOutUtf8StrByteCount * sizeof(int));
+    inline const bool IsCountOnly() const
+    {
+        return false;
     }
-    if (pEndOffsets) {
-        memset(pEndOffsets, 0, MaxOutUtf8StrByteCount * sizeof(int));
+    inline const int GetCount() const
+    {
+        return m_Count;
     }
 
-    // convert input to UTF-32
-    const int MaxBuffSize = ::FAStrUtf8ToArray(pInUtf8Str, InUtf8StrByteCount, pBuff, pOffsets, InUtf8StrByteCount);
-    if (MaxBuffSize <= 0 || MaxBuffSize > InUtf8StrByteCount) {
-        return -1;
+private:
+    Ty * m_pArr;
+    const int m_MaxCount;
+    int m_Count;
+};
+
+
+// sends the output to the caller's callback in chunks of upto FA_STREAM_CHUNK_SIZE bytes
+template < class Ty >
+class FAStreamOutput {
+public:
+    FAStreamOutput(FAStreamCallback pfnCallback, void * pContext) :
+        m_pfnCallback(pfnCallback),
+        m_pContext(pContext),
+        m_Size(0),
+        m_Count(0),
+        m_fStopped(false)
+    {}
+
+    inline void Put(const Ty Value)
+    {
+        if (m_fStopped) {
+            return;
+        }
+        m_Chunk[m_Size++] = Value;
+        m_Count++;
+        if (MaxChunkSize == m_Size) {
+            Flush();
+        }
     }
-    // make sure the utf32input does not contain 'U+0000' elements
-    std::replace(pBuff, pBuff + MaxBuffSize, 0, 0x20);
-
-    // allocated a buffer for UTF-8 output
-    std::vector< char > utf8output(InUtf8StrByteCount + 1);
-    char * pTmpUtf8 = utf8output.data();
-    if (NULL == pTmpUtf8) {
-        return -1;
+    inline void Put(const Ty * pValues, int Size)
+    {
+        while (0 < Size && !m_fStopped) {
+            const int CopySize = std::min(Size, MaxChunkSize - m_Size);
+            memcpy(m_Chunk + m_Size, pValues, CopySize * sizeof(Ty));
+            m_Size += CopySize;
+            m_Count += CopySize;
+            pValues += CopySize;
+            Size -= CopySize;
+            if (MaxChunkSize == m_Size) {
+                Flush();
+            }
+        }
     }
-
-    // keep sentence boundary information here
-    std::vector< int > SbdRes(MaxBuffSize * 3);
-    int * pSbdRes = SbdRes.data();
-    if (NULL == pSbdRes) {
-        return -1;
+    // sends the buffered output to the callback, if any
+    inline void Flush()
+    {
+        if (0 < m_Size && !m_fStopped) {
+            m_fStopped = 0 != (*m_pfnCallback)(m_pContext, m_Chunk, m_Size);
+        }
+        m_Size = 0;
+    }
+    inline const bool IsStopped() const
+    {
+        return m_fStopped;
+    }
+    inline const bool IsCountOnly() const
+    {
+        return false;
+    }
+    // returns the number of elements output so far
+    inline const int GetCount() const
+    {
+        return m_Count;
     }
 
-    // get the sentence breaking results
-    const int SbdOutSize = g_Sbd.Process(pBuff, MaxBuffSize, pSbdRes, MaxBuffSize * 3);
-    if (SbdOutSize > MaxBuffSize * 3 || 0 != SbdOutSize % 3) {
-        return -1;
+private:
+    enum { MaxChunkSize = FA_STREAM_CHUNK_SIZE / sizeof(Ty) };
+
+    FAStreamCallback m_pfnCallback;
+    void * m_pContext;
+    Ty m_Chunk[MaxChunkSize];
+    int m_Size;
+    int m_Count;
+    bool m_fStopped;
+};
+
+
+// ignores the output, used by the functions which only count words or sentences
+class FACountOutput {
+public:
+    inline void Put(const char)
+    {}
+    inline void Put(const char *, const int)
+    {}
+    inline const bool IsStopped() const
+    {
+        return false;
+    }
+    inline const bool IsCountOnly() const
+    {
+        return true;
     }
+};
 
-    // number of sentences
-    int SentCount = 0;
-    // accumulate the output here
-    std::ostringstream Os;
-    // keep track if a sentence was already added
-    bool fAdded = false;
-    // set previous sentence end to -1
-    int PrevEnd = -1;
 
-    for (int i = 0; i < SbdOutSize; i += 3) {
+// collects the UTF-16LE output, used by the UTF-16 functions with the output buffer
+class FAUtf16StringOutput {
+public:
+    inline void Put(const uint16_t C)
+    {
+        m_Str.push_back(C);
+    }
+    inline void Put(const uint16_t * pStr, const int Size)
+    {
+        m_Str.insert(m_Str.end(), pStr, pStr + Size);
+    }
+    inline const bool IsStopped() const
+    {
+        return false;
+    }
+    inline const bool IsCountOnly() const
+    {
+        return false;
+    }
 
-        // we don't care about Tag or From for p2s task
-        const int From = PrevEnd + 1;
-        const int To = pSbdRes[i + 2];
-        const int Len = To - From + 1;
-        PrevEnd = To;
+public:
+    std::vector< uint16_t > m_Str;
+};
 
-        // adjust sentence start if needed
-        const int Delta = FAGetFirstNonWhiteSpace(pBuff + From, Len);
-        if (Delta < Len) {
-            // convert buffer to a UTF-8 string, we temporary use pOutUtf8Str, MaxOutUtf8StrByteCount
-            const int StrOutSize = ::FAArrayToStrUtf8(pBuff + From + Delta, Len - Delta, pTmpUtf8, InUtf8StrByteCount);
-            if (pStartOffsets && SentCount < MaxOutUtf8StrByteCount) {
-                pStartOffsets[SentCount] = pOffsets[From + Delta];
-            }
-            if (pEndOffsets && SentCount < MaxOutUtf8StrByteCount) {
-                const int ToCharSize = ::FAUtf8Size(pInUtf8Str + pOffsets[To]);
-                pEndOffsets[SentCount] = pOffsets[To] + (0 < ToCharSize ? ToCharSize - 1 : 0);
-            }
-            SentCount++;
 
-            // check the output size
-            if (0 > StrOutSize || StrOutSize > InUtf8StrByteCount) {
-                // should never happen, but happened :-(
-                return -1;
-            }
-            else {
-                // add a new line separator
-                if (fAdded) {
-                    Os << '\n';
+//
+// The input encodings of the text functions, selected by the code unit type: char is UTF-8 and
+// uint16_t is UTF-16LE. The offsets and sizes of the text functions are in code units of the input.
+//
+template < class Ty >
+class FATextCodec;
+
+template <>
+class FATextCodec < char > {
+public:
+    // returns true if the code unit is not the first one of a character
+    inline static const bool IsTrail(const char C)
+    {
+        return 0x80 == (0xC0 & (unsigned char) C);
+    }
+    // decodes the input into UTF-32, gets the offset of each character
+    inline static const int Decode(const char * pIn, const int InSize, int * pBuff, int * pOffsets, const int MaxBuffSize)
+    {
+        return ::FAStrUtf8ToArray(pIn, InSize, pBuff, pOffsets, MaxBuffSize);
+    }
+    // returns the offset of the last code unit of the character Symbol at the Offset
+    inline static const int GetLastUnit(const char * pIn, const int Offset, const int /*Symbol*/)
+    {
+        const int CharSize = ::FAUtf8Size(pIn + Offset);
+        return Offset + (0 < CharSize ? CharSize - 1 : 0);
+    }
+    // encodes UTF-32 symbols, returns the output size or -1 if it does not fit
+    inline static const int Encode(const int * pBuff, const int Size, char * pOut, const int MaxOutSize)
+    {
+        return ::FAArrayToStrUtf8(pBuff, Size, pOut, MaxOutSize);
+    }
+};
+
+template <>
+class FATextCodec < uint16_t > {
+public:
+    inline static const bool IsTrail(const uint16_t C)
+    {
+        return 0xDC00 == (0xFC00 & C);
+    }
+    inline static const int Decode(const uint16_t * pIn, const int InSize, int * pBuff, int * pOffsets, const int MaxBuffSize)
+    {
+        return ::FAStrUtf16LEToArray(pIn, InSize, pBuff, pOffsets, MaxBuffSize);
+    }
+    inline static const int GetLastUnit(const uint16_t * /*pIn*/, const int Offset, const int Symbol)
+    {
+        // a character outside of BMP takes two code units
+        return Offset + (0xFFFF < Symbol ? 1 : 0);
+    }
+    inline static const int Encode(const int * pBuff, const int Size, uint16_t * pOut, const int MaxOutSize)
+    {
+        int OutSize = 0;
+        for (int i = 0; i < Size; ++i) {
+            int Symbol = pBuff[i];
+            if (0xFFFF >= (unsigned int) Symbol) {
+                if (OutSize >= MaxOutSize) {
+                    return -1;
                 }
-                // make sure this buffer does not contain '\n' since it is a delimiter
-                std::replace(pTmpUtf8, pTmpUtf8 + StrOutSize, '\n', ' ');
-                // actually copy the data into the string builder
-                pTmpUtf8[StrOutSize] = 0;
-                Os << pTmpUtf8;
-                fAdded = true;
+                pOut[OutSize++] = (uint16_t) Symbol;
+            } else {
+                if (OutSize + 1 >= MaxOutSize) {
+                    return -1;
+                }
+                Symbol -= 0x10000;
+                pOut[OutSize++] = (uint16_t) (0xD800 | (Symbol >> 10));
+                pOut[OutSize++] = (uint16_t) (0xDC00 | (Symbol & 0x3FF));
             }
         }
+        return OutSize;
     }
+};
 
-    // always use the end of paragraph as the end of sentence
-    if (PrevEnd + 1 < MaxBuffSize) {
 
-        const int From = PrevEnd + 1;
-        const int To = MaxBuffSize - 1;
-        const int Len = To - From + 1;
+// the smallest input prefix processed by the functions with a limit, in code units
+const int FA_MIN_PREFIX_SIZE = 4096;
+// the expected sizes of a word and a sentence, used to guess the input prefix size, in code units
+const int FA_AVG_WORD_SIZE = 8;
+const int FA_AVG_SENTENCE_SIZE = 256;
 
-        // adjust sentence start if needed
-        const int Delta = FAGetFirstNonWhiteSpace(pBuff + From, Len);
-        if (Delta < Len) {
-            // convert buffer to a UTF-8 string, we temporary use pOutUtf8Str, MaxOutUtf8StrByteCount
-            const int StrOutSize = ::FAArrayToStrUtf8(pBuff + From + Delta, Len - Delta, pTmpUtf8, InUtf8StrByteCount);
-            if (pStartOffsets && SentCount < MaxOutUtf8StrByteCount) {
-                pStartOffsets[SentCount] = pOffsets[From + Delta];
-            }
-            if (pEndOffsets && SentCount < MaxOutUtf8StrByteCount) {
-                const int ToCharSize = ::FAUtf8Size(pInUtf8Str + pOffsets[To]);
-                pEndOffsets[SentCount] = pOffsets[To] + (0 < ToCharSize ? ToCharSize - 1 : 0);
-            }
-            SentCount++;
 
-            // check the output size
-            if (0 > StrOutSize || StrOutSize > InUtf8StrByteCount) {
-                // should never happen, but happened :-(
-                return -1;
-            }
-            else {
-                // add a new line separator
-                if (fAdded) {
-                    Os << '\n';
-                }
-                // make sure this buffer does not contain '\n' since it is a delimiter
-                std::replace(pTmpUtf8, pTmpUtf8 + StrOutSize, '\n', ' ');
-                // actually copy the data into the string builder
-                pTmpUtf8[StrOutSize] = 0;
-                Os << pTmpUtf8;
+// counts the words in the word breaking results
+class FAWordCounter {
+public:
+    inline const int operator()(const int * /*pBuff*/, const int * pWbdRes, const int WbdOutSize) const
+    {
+        int Count = 0;
+        for (int i = 0; i < WbdOutSize; i += 3) {
+            if (WBD_IGNORE_TAG != pWbdRes[i]) {
+                Count++;
             }
         }
+        return Count;
     }
+};
 
-    // we will include the 0 just in case some scriping languages expect 0-terminated buffers and cannot use the size
-    Os << char(0);
-
-    // get the actual output buffer as one string
-    const std::string & OsStr = Os.str();
-    const char * pStr = OsStr.c_str();
-    const int StrLen = (int)OsStr.length();
 
-    if (StrLen <= MaxOutUtf8StrByteCount) {
-        memcpy(pOutUtf8Str, pStr, StrLen);
+// counts the non-empty sentences in the sentence breaking results
+class FASentenceCounter {
+public:
+    inline const int operator()(const int * pBuff, const int * pSbdRes, const int SbdOutSize) const
+    {
+        int Count = 0;
+        int PrevEnd = -1;
+        for (int i = 0; i < SbdOutSize; i += 3) {
+            const int From = PrevEnd + 1;
+            const int To = pSbdRes[i + 2];
+            const int Len = To - From + 1;
+            PrevEnd = To;
+            if (FAGetFirstNonWhiteSpace(pBuff + From, Len) < Len) {
+                Count++;
+            }
+        }
+        return Count;
     }
-    return StrLen;
-}
+};
+
 
 //
-// Splits plain-text in UTF-8 encoding into sentences.
-//
-// Input:  UTF-8 string of one paragraph or document
-// Output: Size in bytes of the output string and UTF-8 string of '\n' delimited sentences, if the return size <= MaxOutUtf8StrByteCount
-//
-//  Notes:  
+// Converts the UTF-8 or UTF-16 input into UTF-32 and runs the Lex over it. If MaxCount is positive
+// then only a prefix of the input is converted and processed, the prefix grows until the lexer results
+// have at least MaxCount units counted by the Counter or until it is the whole input. The results for
+// a prefix are the same as the beginning of the results for the whole input.
 //
-//  1. The return value is -1 in case of an error (make sure your input is a valid UTF-8, BOM is not required)
-//  2. We do not use "\r\n" to delimit sentences, it is always '\n'
-//  3. It is not necessary to remove '\n' from the input paragraph, sentence breaking algorithm will take care of them
-//  4. The output sentences will not contain '\n' in them
+// Returns 0 on success and -1 in case of an error. Buff and Offsets get *pBuffSize UTF-32 symbols
+// of the first *pPrefixLen code units and their offsets, LexRes gets *pLexOutSize lexer results,
+// *pfAll is set to true if the whole input has been processed.
 //
-extern "C"
-const int TextToSentences(const char * pInUtf8Str, int InUtf8StrByteCount, char * pOutUtf8Str, const int MaxOutUtf8StrByteCount)
+template < class Ty, class CounterT >
+const int FALexPrefix(const FALexTools_t < int > & Lex, const CounterT & Counter, const int AvgUnitSize,
+    const Ty * pInStr, const int InStrLen, const int MaxCount,
+    std::vector< int > & Buff, std::vector< int > & Offsets, int * pBuffSize,
+    std::vector< int > & LexRes, int * pLexOutSize, int * pPrefixLen, bool * pfAll)
 {
-    return TextToSentencesWithOffsets(pInUtf8Str, InUtf8StrByteCount, pOutUtf8Str, NULL, NULL, MaxOutUtf8StrByteCount);
+    // start with the prefix which is expected to have MaxCount units
+    int PrefixLen = InStrLen;
+    if (0 < MaxCount && MaxCount < (InStrLen - FA_MIN_PREFIX_SIZE) / AvgUnitSize) {
+        PrefixLen = FA_MIN_PREFIX_SIZE + (MaxCount * AvgUnitSize);
+    }
+
+    while (true) {
+
+        // don't split a character
+        while (PrefixLen < InStrLen && FATextCodec < Ty >::IsTrail(pInStr[PrefixLen])) {
+            PrefixLen++;
+        }
+        const bool fAll = InStrLen == PrefixLen;
+
+        // convert the prefix to UTF-32
+        Buff.resize(PrefixLen);
+        Offsets.resize(PrefixLen);
+        const int BuffSize = FATextCodec < Ty >::Decode(pInStr, PrefixLen, Buff.data(), Offsets.data(), PrefixLen);
+        if (BuffSize <= 0 || BuffSize > PrefixLen) {
+            return -1;
+        }
+        // make sure the utf32input does not contain 'U+0000' elements
+        std::replace(Buff.begin(), Buff.begin() + BuffSize, 0, 0x20);
+
+        // get the lexer results, for a prefix only the ones which cannot change with the rest of the input
+        LexRes.resize(BuffSize * 3);
+        const int LexOutSize = fAll ?
+            Lex.Process(Buff.data(), BuffSize, LexRes.data(), BuffSize * 3) :
+            Lex.ProcessPrefix(Buff.data(), BuffSize, LexRes.data(), BuffSize * 3);
+        if (LexOutSize > BuffSize * 3 || 0 != LexOutSize % 3) {
+            return -1;
+        }
+
+        if (fAll || MaxCount <= Counter(Buff.data(), LexRes.data(), LexOutSize)) {
+            *pBuffSize = BuffSize;
+            *pLexOutSize = LexOutSize;
+            *pPrefixLen = PrefixLen;
+            *pfAll = fAll;
+            return 0;
+        }
+
+        // try a twice longer prefix
+        PrefixLen = PrefixLen < InStrLen / 2 ? PrefixLen * 2 : InStrLen;
+    }
 }
 
 
 //
-// Same as TextToWords, but also returns original offsets from the input buffer for each word.
+// Splits plain-text in UTF-8 or UTF-16LE encoding into sentences and puts them into the Output in
+// the same encoding, the sentences are delimited with '\n', offsets are stored for upto MaxOffsetCount
+// sentences. The sizes and offsets are in code units of the input, see FATextCodec.
 //
-// pStartOffsets is an array of integers (first character of each word) with upto MaxOutUtf8StrByteCount elements
-// pEndOffsets is an array of integers (last character of each word) with upto MaxOutUtf8StrByteCount elements
+// If MaxSentCount is positive, the processing stops after MaxSentCount sentences and only the
+// beginning of the input needed to find them is processed. *pStopOffset, if not NULL, gets the
+// offset right after the last sentence if the limit is reached, InStrLen otherwise.
 //
-extern "C"
-const int TextToWordsWithOffsets(const char * pInUtf8Str, int InUtf8StrByteCount,
-    char * pOutUtf8Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf8StrByteCount)
+// Returns the number of sentences and -1 in case of an error.
+//
+template < class Ty, class OutputT >
+const int TextToSentencesImpl(const Ty * pInStr, int InStrLen,
+    int * pStartOffsets, int * pEndOffsets, const int MaxOffsetCount, OutputT & Output,
+    const int MaxSentCount = 0, int * pStopOffset = NULL)
 {
     // check if the initilization is needed
-    if (false == g_fInitialized) {
-        // make sure only one thread can get the mutex
-        std::lock_guard<std::mutex> guard(g_InitializationMutex);
-        // see if the g_fInitialized is still false
-        if (false == g_fInitialized) {
-            InitializeWbdSbd();
-            g_fInitialized = true;
-        }
+    FAEnsureInitialized();
+
+    if (pStopOffset) {
+        *pStopOffset = 0;
     }
 
     // validate the parameters
-    if (0 == InUtf8StrByteCount) {
+    if (0 == InStrLen) {
         return 0;
     }
-    if (0 > InUtf8StrByteCount || InUtf8StrByteCount > FALimits::MaxArrSize) {
-        return -1;
-    }
-    if (NULL == pInUtf8Str) {
+    if (0 > InStrLen || InStrLen > FALimits::MaxArrSize) {
         return -1;
     }
-
-    // allocate buffer for UTF-32, sentence breaking results, word-breaking results
-    std::vector< int > utf32input(InUtf8StrByteCount);
-    int * pBuff = utf32input.data();
-    if (NULL == pBuff) {
+    if (NULL == pInStr) {
         return -1;
     }
 
-    std::vector< int > utf32offsets(InUtf8StrByteCount);
-    int * pOffsets = utf32offsets.data();
-    if (NULL == pOffsets) {
-        return -1;
-    }
     // make sure there are no uninitialized offsets
     if (pStartOffsets) {
-        memset(pStartOffsets, 0, MaxOutUtf8StrByteCount * sizeof(int));
+        memset(pStartOffsets, 0, MaxOffsetCount * sizeof(int));
     }
     if (pEndOffsets) {
-        memset(pEndOffsets, 0, MaxOutUtf8StrByteCount * sizeof(int));
-    }
-
-    // convert input to UTF-32
-    const int MaxBuffSize = ::FAStrUtf8ToArray(pInUtf8Str, InUtf8StrByteCount, pBuff, pOffsets, InUtf8StrByteCount);
-    if (MaxBuffSize <= 0 || MaxBuffSize > InUtf8StrByteCount) {
-        return -1;
-    }
-    // make sure the utf32input does not contain 'U+0000' elements
-    std::replace(pBuff, pBuff + MaxBuffSize, 0, 0x20);
-
-    // allocated a buffer for UTF-8 output
-    std::vector< char > utf8output(InUtf8StrByteCount + 1);
-    char * pTmpUtf8 = utf8output.data();
-    if (NULL == pTmpUtf8) {
-        return -1;
+        memset(pEndOffsets, 0, MaxOffsetCount * sizeof(int));
     }
 
-    // keep sentence boundary information here
-    std::vector< int > WbdRes(MaxBuffSize * 3);
-    int * pWbdRes = WbdRes.data();
-    if (NULL == pWbdRes) {
+    // convert input, or its prefix, to UTF-32 and get the sentence breaking results
+    std::vector< int > utf32input;
+    std::vector< int > utf32offsets;
+    std::vector< int > SbdRes;
+    int MaxBuffSize = 0;
+    int SbdOutSize = 0;
+    int PrefixLen = 0;
+    bool fAll = false;
+
+    if (0 != FALexPrefix(g_Sbd, FASentenceCounter(), FA_AVG_SENTENCE_SIZE,
+            pInStr, InStrLen, MaxSentCount, utf32input, utf32offsets, &MaxBuffSize,
+            SbdRes, &SbdOutSize, &PrefixLen, &fAll)) {
         return -1;
     }
-
-    // get the sentence breaking results
-    const int WbdOutSize = g_Wbd.Process(pBuff, MaxBuffSize, pWbdRes, MaxBuffSize * 3);
-    if (WbdOutSize > MaxBuffSize * 3 || 0 != WbdOutSize % 3) {
-        return -1;
+    const int * pBuff = utf32input.data();
+    const int * pOffsets = utf32offsets.data();
+    const int * pSbdRes = SbdRes.data();
+
+    // allocated a buffer for the output, nothing is converted if only the count is needed
+    std::vector< Ty > TmpOutput;
+    if (!Output.IsCountOnly()) {
+        TmpOutput.resize(PrefixLen + 1);
     }
+    Ty * pTmpOut = TmpOutput.data();
 
-    // keep track of the word count
-    int WordCount = 0;
-    // accumulate the output here
-    std::ostringstream Os;
-    // keep track if a word was already added
+    // number of sentences
+    int SentCount = 0;
+    // keep track if a sentence was already added
     bool fAdded = false;
+    // the offset right after the last sentence
+    int StopOffset = 0;
 
-    for (int i = 0; i < WbdOutSize; i += 3) {
+    // adds the sentence From..To, returns false in case of an error
+    auto AddSentence = [&](const int From, const int To) -> bool
+    {
+        const int Len = To - From + 1;
 
-        // ignore tokens with IGNORE tag
-        const int Tag = pWbdRes[i];
-        if (WBD_IGNORE_TAG == Tag) {
-            continue;
+        // adjust sentence start if needed
+        const int Delta = FAGetFirstNonWhiteSpace(pBuff + From, Len);
+        if (Delta >= Len) {
+            return true;
         }
 
-        const int From = pWbdRes[i + 1];
-        const int To = pWbdRes[i + 2];
-        const int Len = To - From + 1;
-
-        // convert buffer to a UTF-8 string, we temporary use pOutUtf8Str, MaxOutUtf8StrByteCount
-        const int StrOutSize = ::FAArrayToStrUtf8(pBuff + From, Len, pTmpUtf8, InUtf8StrByteCount);
-        if (pStartOffsets && WordCount < MaxOutUtf8StrByteCount) {
-            pStartOffsets[WordCount] = pOffsets[From];
+        const int LastUnit = FATextCodec < Ty >::GetLastUnit(pInStr, pOffsets[To], pBuff[To]);
+        if (pStartOffsets && SentCount < MaxOffsetCount) {
+            pStartOffsets[SentCount] = pOffsets[From + Delta];
         }
-        if (pEndOffsets && WordCount < MaxOutUtf8StrByteCount) {
-            // offset of last UTF-32 character plus its length in bytes in the original string - 1
-            const int ToCharSize = ::FAUtf8Size(pInUtf8Str + pOffsets[To]);
-            pEndOffsets[WordCount] = pOffsets[To] + (0 < ToCharSize ? ToCharSize - 1 : 0);
+        if (pEndOffsets && SentCount < MaxOffsetCount) {
+            pEndOffsets[SentCount] = LastUnit;
         }
-        WordCount++;
+        SentCount++;
+        StopOffset = LastUnit + 1;
+
+        if (Output.IsCountOnly()) {
+            return true;
+        }
+
+        // convert buffer to the encoding of the input
+        const int StrOutSize = FATextCodec < Ty >::Encode(pBuff + From + Delta, Len - Delta, pTmpOut, PrefixLen);
 
         // check the output size
-        if (0 > StrOutSize || StrOutSize > InUtf8StrByteCount) {
+        if (0 > StrOutSize || StrOutSize > PrefixLen) {
             // should never happen, but happened :-(
+            return false;
+        }
+        // add a new line separator
+        if (fAdded) {
+            Output.Put('\n');
+        }
+        // make sure this buffer does not contain '\n' since it is a delimiter
+        std::replace(pTmpOut, pTmpOut + StrOutSize, '\n', ' ');
+        // actually copy the data into the output
+        Output.Put(pTmpOut, StrOutSize);
+        fAdded = true;
+        return true;
+    };
+
+    // set previous sentence end to -1
+    int PrevEnd = -1;
+    // becomes true if MaxSentCount sentences are found
+    bool fLimit = false;
+
+    for (int i = 0; i < SbdOutSize && !Output.IsStopped(); i += 3) {
+
+        if (0 < MaxSentCount && MaxSentCount == SentCount) {
+            fLimit = true;
+            break;
+        }
+
+        // we don't care about Tag or From for p2s task
+        const int From = PrevEnd + 1;
+        const int To = pSbdRes[i + 2];
+        PrevEnd = To;
+
+        if (!AddSentence(From, To)) {
             return -1;
         }
-        else {
-            // add a new line separator
-            if (fAdded) {
-                Os << ' ';
-            }
-            // make sure this buffer does not contain ' ' since it is a delimiter
-            std::replace(pTmpUtf8, pTmpUtf8 + StrOutSize, ' ', '_');
-            // actually copy the data into the string builder
-            pTmpUtf8[StrOutSize] = 0;
-            Os << pTmpUtf8;
-            fAdded = true;
+    }
+    if (0 < MaxSentCount && MaxSentCount == SentCount) {
+        fLimit = true;
+    }
+
+    // always use the end of paragraph as the end of sentence, if the whole paragraph is processed
+    if (fAll && !fLimit && PrevEnd + 1 < MaxBuffSize && !Output.IsStopped()) {
+        if (!AddSentence(PrevEnd + 1, MaxBuffSize - 1)) {
+            return -1;
         }
     }
 
+    if (pStopOffset) {
+        *pStopOffset = fLimit ? StopOffset : InStrLen;
+    }
+    return SentCount;
+}
+
+
+//
+// Same as TextToSentencesWithOffsets, but at most MaxSentCount sentences are returned, if MaxSentCount is positive.
+// The processing stops as soon as they are found, so only the beginning of a long input is decoded and
+// processed. *pStopOffset gets the byte offset right after the last returned sentence if the limit is
+// reached and InUtf8StrByteCount otherwise, the rest of the input can be processed from there.
+//
+extern "C"
+const int TextToSentencesWithLimit(const char * pInUtf8Str, int InUtf8StrByteCount,
+    char * pOutUtf8Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf8StrByteCount,
+    const int MaxSentCount, int * pStopOffset)
+{
+    if (pStopOffset) {
+        *pStopOffset = 0;
+    }
+    if (0 == InUtf8StrByteCount) {
+        return 0;
+    }
+
+    // accumulate the output here
+    FAStringOutput Os;
+
+    if (0 > TextToSentencesImpl(pInUtf8Str, InUtf8StrByteCount, pStartOffsets, pEndOffsets, MaxOutUtf8StrByteCount, Os,
+            MaxSentCount, pStopOffset)) {
+        return -1;
+    }
+
     // we will include the 0 just in case some scriping languages expect 0-terminated buffers and cannot use the size
-    Os << char(0);
+    Os.Put(char(0));
 
     // get the actual output buffer as one string
-    const std::string & OsStr = Os.str();
-    const char * pStr = OsStr.c_str();
-    const int StrLen = (int)OsStr.length();
+    const char * pStr = Os.m_Str.c_str();
+    const int StrLen = (int)Os.m_Str.length();
 
     if (StrLen <= MaxOutUtf8StrByteCount) {
         memcpy(pOutUtf8Str, pStr, StrLen);
@@ -453,176 +741,2582 @@ const int TextToWordsWithOffsets(const char * pInUtf8Str, int InUtf8StrByteCount
     return StrLen;
 }
 
+
 //
-// Splits plain-text in UTF-8 encoding into words.
+// Same as TextToSentencesWithLimit, but only counts the sentences, no output is made, useful for bucketing
+// the inputs by length. Returns the number of sentences, at most MaxSentCount if it is positive, or -1 in case
+// of an error. pStopOffset can be NULL.
 //
-// Input:  UTF-8 string of one sentence or paragraph or document
-// Output: Size in bytes of the output string and UTF-8 string of ' ' delimited words, if the return size <= MaxOutUtf8StrByteCount
+extern "C"
+const int TextToSentencesCount(const char * pInUtf8Str, int InUtf8StrByteCount, const int MaxSentCount, int * pStopOffset)
+{
+    FACountOutput Output;
+    return TextToSentencesImpl(pInUtf8Str, InUtf8StrByteCount, NULL, NULL, 0, Output, MaxSentCount, pStopOffset);
+}
+
+
+//
+// See TextToSentences description below, this one also returns original offsets from the input buffer for each sentence.
+//
+// pStartOffsets is an array of integers (first character of each sentence) with upto MaxOutUtf8StrByteCount elements
+// pEndOffsets is an array of integers (last character of each sentence) with upto MaxOutUtf8StrByteCount elements
+//
+extern "C"
+const int TextToSentencesWithOffsets(const char * pInUtf8Str, int InUtf8StrByteCount,
+    char * pOutUtf8Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf8StrByteCount)
+{
+    return TextToSentencesWithLimit(pInUtf8Str, InUtf8StrByteCount, pOutUtf8Str, pStartOffsets, pEndOffsets,
+        MaxOutUtf8StrByteCount, 0, NULL);
+}
+
+//
+// Splits plain-text in UTF-8 encoding into sentences.
+//
+// Input:  UTF-8 string of one paragraph or document
+// Output: Size in bytes of the output string and UTF-8 string of '\n' delimited sentences, if the return size <= MaxOutUtf8StrByteCount
 //
 //  Notes:  
 //
 //  1. The return value is -1 in case of an error (make sure your input is a valid UTF-8, BOM is not required)
-//  2. Words from the word-breaker will not contain spaces
+//  2. We do not use "\r\n" to delimit sentences, it is always '\n'
+//  3. It is not necessary to remove '\n' from the input paragraph, sentence breaking algorithm will take care of them
+//  4. The output sentences will not contain '\n' in them
 //
 extern "C"
-const int TextToWords(const char * pInUtf8Str, int InUtf8StrByteCount, char * pOutUtf8Str, const int MaxOutUtf8StrByteCount)
+const int TextToSentences(const char * pInUtf8Str, int InUtf8StrByteCount, char * pOutUtf8Str, const int MaxOutUtf8StrByteCount)
 {
-    return TextToWordsWithOffsets(pInUtf8Str, InUtf8StrByteCount, pOutUtf8Str, NULL, NULL, MaxOutUtf8StrByteCount);
+    return TextToSentencesWithOffsets(pInUtf8Str, InUtf8StrByteCount, pOutUtf8Str, NULL, NULL, MaxOutUtf8StrByteCount);
 }
 
 
-// This function implements the fasttext hashing function
-inline const uint32_t GetHash(const char * str, size_t strLen) {
-    uint32_t h = 2166136261;
-    for (size_t i = 0; i < strLen; i++) {
-        h = h ^ uint32_t(str[i]);
-        h = h * 16777619;
+//
+// Same as TextToSentences, but the output is sent to the pfnCallback in chunks as soon as it
+// is computed, so the work is never repeated because of a small output buffer.
+// The chunks are parts of the '\n' delimited UTF-8 string of sentences, a sentence may be
+// split between two chunks, there is no terminating 0. ChunkCount is the number of bytes
+// in the chunk, if the callback returns a non-zero value the processing stops.
+//
+// Returns the number of bytes passed to the callback, -1 in case of an error.
+//
+extern "C"
+const int TextToSentencesStream(const char * pInUtf8Str, int InUtf8StrByteCount, FAStreamCallback pfnCallback, void * pContext)
+{
+    if (NULL == pfnCallback) {
+        return -1;
     }
-    return h;
-}
 
-// EOS symbol
-int32_t EOS_HASH = GetHash("</s>", 4);
+    FAStreamOutput < char > Output(pfnCallback, pContext);
 
-const void AddWordNgrams(int32_t * hashArray, int& hashCount, int32_t wordNgrams, int32_t bucket) {
-    // hash size
-    const int tokenCount = hashCount;
-    for (int32_t i = 0; i < tokenCount; i++) {
-        uint64_t h = hashArray[i];
-        for (int32_t j = i + 1; j < i + wordNgrams; j++) {
-            uint64_t tempHash = (j < tokenCount) ? hashArray[j] : EOS_HASH;  // for computing ngram, we pad by EOS_HASH to allow each word has ngram which begins at itself.
-            h = h * 116049371 + tempHash;
-            hashArray[hashCount] = (h % bucket);
-            ++hashCount;
-        }
+    if (0 > TextToSentencesImpl(pInUtf8Str, InUtf8StrByteCount, NULL, NULL, 0, Output)) {
+        return -1;
     }
+    Output.Flush();
+    return Output.GetCount();
 }
 
-// Get the tokens count by inspecting the spaces in input buffer
-inline const int GetTokenCount(const char * input, const int bufferSize)
+
+//
+// Splits plain-text in UTF-8 or UTF-16LE encoding into words and puts them into the Output in
+// the same encoding, the words are delimited with ' ', offsets are stored for upto MaxOffsetCount
+// words. The sizes and offsets are in code units of the input, see FATextCodec.
+//
+// If MaxWordCount is positive, the processing stops after MaxWordCount words and only the
+// beginning of the input needed to find them is processed. *pStopOffset, if not NULL, gets the
+// offset right after the last word if the limit is reached, InStrLen otherwise.
+//
+// Returns the number of words and -1 in case of an error.
+//
+template < class Ty, class OutputT >
+const int TextToWordsImpl(const Ty * pInStr, int InStrLen,
+    int * pStartOffsets, int * pEndOffsets, const int MaxOffsetCount, OutputT & Output,
+    const int MaxWordCount = 0, int * pStopOffset = NULL)
 {
-    if (bufferSize == 0)
-    {
+    // check if the initilization is needed
+    FAEnsureInitialized();
+
+    if (pStopOffset) {
+        *pStopOffset = 0;
+    }
+
+    // validate the parameters
+    if (0 == InStrLen) {
         return 0;
     }
-    else
-    {
-        int spaceCount = 0;
-        for (int i = 0; i < bufferSize; ++i)
-        {
-            if (input[i] == ' ')
-            {
-                spaceCount++;
-            }
-        }
-        return spaceCount + 1;
+    if (0 > InStrLen || InStrLen > FALimits::MaxArrSize) {
+        return -1;
+    }
+    if (NULL == pInStr) {
+        return -1;
     }
-}
 
-// Port the fast text getline function with modifications
-// 1. do not have vocab
-// 2. do not compute subwords info
+    // make sure there are no uninitialized offsets
+    if (pStartOffsets) {
+        memset(pStartOffsets, 0, MaxOffsetCount * sizeof(int));
+    }
+    if (pEndOffsets) {
+        memset(pEndOffsets, 0, MaxOffsetCount * sizeof(int));
+    }
 
-const int ComputeHashes(const char * input, const int strLen, int32_t * hashArr, int wordNgrams, int bucketSize)
-{
-    int hashCount = 0;
-    char * pTemp = (char *)input;
-    char * pWordStart = &pTemp[0];
-    size_t wordLength = 0;
+    // convert input, or its prefix, to UTF-32 and get the word breaking results
+    std::vector< int > utf32input;
+    std::vector< int > utf32offsets;
+    std::vector< int > WbdRes;
+    int MaxBuffSize = 0;
+    int WbdOutSize = 0;
+    int PrefixLen = 0;
+    bool fAll = false;
+
+    if (0 != FALexPrefix(g_Wbd, FAWordCounter(), FA_AVG_WORD_SIZE,
+            pInStr, InStrLen, MaxWordCount, utf32input, utf32offsets, &MaxBuffSize,
+            WbdRes, &WbdOutSize, &PrefixLen, &fAll)) {
+        return -1;
+    }
+    const int * pBuff = utf32input.data();
+    const int * pOffsets = utf32offsets.data();
+    const int * pWbdRes = WbdRes.data();
+
+    // allocated a buffer for the output, nothing is converted if only the count is needed
+    std::vector< Ty > TmpOutput;
+    if (!Output.IsCountOnly()) {
+        TmpOutput.resize(PrefixLen + 1);
+    }
+    Ty * pTmpOut = TmpOutput.data();
 
-    // add unigram hash first while reading the tokens. Unlike fasttext, there's no EOS padding here. 
-    for (int pos = 0; pos < strLen; pos++)
-    {
-        if (pTemp[pos] == ' ' || pos == strLen - 1)  // if we hit word boundary pushback wordhash or end of sentence
-        {
-            uint32_t wordhash = GetHash(pWordStart, wordLength);
-            hashArr[hashCount] = wordhash;
-            ++hashCount;
-            // move pointer to next word and reset length
-            pWordStart = &pTemp[pos + 1];
-            wordLength = 0;
+    // keep track of the word count
+    int WordCount = 0;
+    // keep track if a word was already added
+    bool fAdded = false;
+    // the offset right after the last word
+    int StopOffset = 0;
+
+    for (int i = 0; i < WbdOutSize && !Output.IsStopped(); i += 3) {
+
+        // ignore tokens with IGNORE tag
+        const int Tag = pWbdRes[i];
+        if (WBD_IGNORE_TAG == Tag) {
+            continue;
         }
-        else // otherwise keep moving temp pointer
-        {
-            ++wordLength;
+        if (0 < MaxWordCount && MaxWordCount == WordCount) {
+            break;
         }
-    }
 
-    //Add higher order ngrams (bigrams and up), each token has a ngram starting from itself makes the size ngram * ntokens. 
-    AddWordNgrams(hashArr, hashCount, wordNgrams, bucketSize);
+        const int From = pWbdRes[i + 1];
+        const int To = pWbdRes[i + 2];
+        const int Len = To - From + 1;
 
-    return hashCount;
-}
+        // offset of the last code unit of the last UTF-32 character in the original string
+        const int LastUnit = FATextCodec < Ty >::GetLastUnit(pInStr, pOffsets[To], pBuff[To]);
+        if (pStartOffsets && WordCount < MaxOffsetCount) {
+            pStartOffsets[WordCount] = pOffsets[From];
+        }
+        if (pEndOffsets && WordCount < MaxOffsetCount) {
+            pEndOffsets[WordCount] = LastUnit;
+        }
+        WordCount++;
+        StopOffset = LastUnit + 1;
 
+        if (Output.IsCountOnly()) {
+            continue;
+        }
 
-// memory cap for stack memory allocation
-const int MAX_ALLOCA_SIZE = 204800;
+        // convert buffer to the encoding of the input
+        const int StrOutSize = FATextCodec < Ty >::Encode(pBuff + From, Len, pTmpOut, PrefixLen);
+
+        // check the output size
+        if (0 > StrOutSize || StrOutSize > PrefixLen) {
+            // should never happen, but happened :-(
+            return -1;
+        }
+        else {
+            // add a new line separator
+            if (fAdded) {
+                Output.Put(' ');
+            }
+            // make sure this buffer does not contain ' ' since it is a delimiter
+            std::replace(pTmpOut, pTmpOut + StrOutSize, ' ', '_');
+            // actually copy the data into the output
+            Output.Put(pTmpOut, StrOutSize);
+            fAdded = true;
+        }
+    }
+
+    if (pStopOffset) {
+        const bool fLimit = 0 < MaxWordCount && MaxWordCount == WordCount;
+        *pStopOffset = fLimit ? StopOffset : InStrLen;
+    }
+    return WordCount;
+}
 
 
 //
-// This function implements the fasttext-like hashing logics. It first calls the tokenizer and then convert them into ngram hashes
-//
-// Example:   input :  "This is ok."
-//            output (bigram):  hash(this), hash(is), hash(ok), hash(.), hash(this is), hash(is ok), hash(ok .), hash(. EOS)
-//
-//            This is different from fasttext hashing:
-//            1. no EOS padding by default for unigram.
-//            2. do not take vocab as input, all unigrams are hashed too.
-//               and ngram hashes are not shifted.
+// Same as TextToWordsWithOffsets, but at most MaxWordCount words are returned, if MaxWordCount is positive.
+// The processing stops as soon as they are found, so only the beginning of a long input is decoded and
+// processed. *pStopOffset gets the byte offset right after the last returned word if the limit is
+// reached and InUtf8StrByteCount otherwise, the rest of the input can be processed from there.
 //
 extern "C"
-const int TextToHashes(const char * pInUtf8Str, int InUtf8StrByteCount, int32_t * pHashArr, const int MaxHashArrLength, int wordNgrams, int bucketSize = 2000000)
+const int TextToWordsWithLimit(const char * pInUtf8Str, int InUtf8StrByteCount,
+    char * pOutUtf8Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf8StrByteCount,
+    const int MaxWordCount, int * pStopOffset)
 {
-    // must have positive ngram
-    if (wordNgrams <= 0)
-    {
-        return -1;
+    if (pStopOffset) {
+        *pStopOffset = 0;
+    }
+    if (0 == InUtf8StrByteCount) {
+        return 0;
     }
 
-    //first we call tokenizer to get word arr
-    int maxOutputSize = InUtf8StrByteCount * 2 + 1;
-    int hashArrSize = 0;
-    char * pTokenizedStr = nullptr;
+    // accumulate the output here
+    FAStringOutput Os;
 
-    // cap memory usage
-    if (maxOutputSize < MAX_ALLOCA_SIZE)
-    {
-        pTokenizedStr = (char*)alloca(maxOutputSize);
-    }
-    else
-    {
-        pTokenizedStr = new char[maxOutputSize];
+    if (0 > TextToWordsImpl(pInUtf8Str, InUtf8StrByteCount, pStartOffsets, pEndOffsets, MaxOutUtf8StrByteCount, Os,
+            MaxWordCount, pStopOffset)) {
+        return -1;
     }
 
-    // tokenize the string
-    int strLen = TextToWords(pInUtf8Str, InUtf8StrByteCount, pTokenizedStr, maxOutputSize);
+    // we will include the 0 just in case some scriping languages expect 0-terminated buffers and cannot use the size
+    Os.Put(char(0));
 
-    // if tokenizer has errors,
-    if (0 > strLen)
-    {
-        return strLen;
+    // get the actual output buffer as one string
+    const char * pStr = Os.m_Str.c_str();
+    const int StrLen = (int)Os.m_Str.length();
+
+    if (StrLen <= MaxOutUtf8StrByteCount) {
+        memcpy(pOutUtf8Str, pStr, StrLen);
     }
+    return StrLen;
+}
 
-    // get tokensize
-    int tokenCount = GetTokenCount(pTokenizedStr, strLen);
 
-    // if memory allocation is not enough for current output, return requested memory amount
+//
+// Same as TextToWordsWithLimit, but only counts the words, no output is made, useful for bucketing
+// the inputs by length. Returns the number of words, at most MaxWordCount if it is positive, or -1 in case
+// of an error. pStopOffset can be NULL.
+//
+extern "C"
+const int TextToWordsCount(const char * pInUtf8Str, int InUtf8StrByteCount, const int MaxWordCount, int * pStopOffset)
+{
+    FACountOutput Output;
+    return TextToWordsImpl(pInUtf8Str, InUtf8StrByteCount, NULL, NULL, 0, Output, MaxWordCount, pStopOffset);
+}
+
+
+//
+// Same as TextToWords, but also returns original offsets from the input buffer for each word.
+//
+// pStartOffsets is an array of integers (first character of each word) with upto MaxOutUtf8StrByteCount elements
+// pEndOffsets is an array of integers (last character of each word) with upto MaxOutUtf8StrByteCount elements
+//
+extern "C"
+const int TextToWordsWithOffsets(const char * pInUtf8Str, int InUtf8StrByteCount,
+    char * pOutUtf8Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf8StrByteCount)
+{
+    return TextToWordsWithLimit(pInUtf8Str, InUtf8StrByteCount, pOutUtf8Str, pStartOffsets, pEndOffsets,
+        MaxOutUtf8StrByteCount, 0, NULL);
+}
+
+//
+// Splits plain-text in UTF-8 encoding into words.
+//
+// Input:  UTF-8 string of one sentence or paragraph or document
+// Output: Size in bytes of the output string and UTF-8 string of ' ' delimited words, if the return size <= MaxOutUtf8StrByteCount
+//
+//  Notes:  
+//
+//  1. The return value is -1 in case of an error (make sure your input is a valid UTF-8, BOM is not required)
+//  2. Words from the word-breaker will not contain spaces
+//
+extern "C"
+const int TextToWords(const char * pInUtf8Str, int InUtf8StrByteCount, char * pOutUtf8Str, const int MaxOutUtf8StrByteCount)
+{
+    return TextToWordsWithOffsets(pInUtf8Str, InUtf8StrByteCount, pOutUtf8Str, NULL, NULL, MaxOutUtf8StrByteCount);
+}
+
+
+//
+// Same as TextToWords, but the output is sent to the pfnCallback in chunks as soon as it
+// is computed, so the work is never repeated because of a small output buffer.
+// The chunks are parts of the ' ' delimited UTF-8 string of words, a word may be split
+// between two chunks, there is no terminating 0. ChunkCount is the number of bytes
+// in the chunk, if the callback returns a non-zero value the processing stops.
+//
+// Returns the number of bytes passed to the callback, -1 in case of an error.
+//
+extern "C"
+const int TextToWordsStream(const char * pInUtf8Str, int InUtf8StrByteCount, FAStreamCallback pfnCallback, void * pContext)
+{
+    if (NULL == pfnCallback) {
+        return -1;
+    }
+
+    FAStreamOutput < char > Output(pfnCallback, pContext);
+
+    if (0 > TextToWordsImpl(pInUtf8Str, InUtf8StrByteCount, NULL, NULL, 0, Output)) {
+        return -1;
+    }
+    Output.Flush();
+    return Output.GetCount();
+}
+
+//
+// Arrow C Data Interface structures, see https://arrow.apache.org/docs/format/CDataInterface.html
+// this is a stable C ABI, so no Arrow library is needed on either side.
+//
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    // array type description
+    const char * format;
+    const char * name;
+    const char * metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema ** children;
+    struct ArrowSchema * dictionary;
+
+    // release callback
+    void (*release)(struct ArrowSchema *);
+    // opaque producer-specific data
+    void * private_data;
+};
+
+struct ArrowArray {
+    // array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void ** buffers;
+    struct ArrowArray ** children;
+    struct ArrowArray * dictionary;
+
+    // release callback
+    void (*release)(struct ArrowArray *);
+    // opaque producer-specific data
+    void * private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+
+//
+// Called when the input of TextToWordsArrow is not referenced anymore.
+//
+typedef void (*FAArrowInputCallback)(void * pContext);
+
+// TextToWordsArrow flags
+enum {
+    FA_ARROW_WORDS_TEXT = 1,    // add the "text" column with the words as the slices of the input
+};
+
+
+// keeps all the memory of the Arrow arrays and schemas made by TextToWordsArrow, each of the structures
+// can be released separately (the consumer may move the children out), so the last release frees it
+class FAArrowWordsData {
+public:
+    FAArrowWordsData(FAArrowInputCallback pfnInputCallback, void * pContext) :
+        m_RefCount(0),
+        m_pfnInputCallback(pfnInputCallback),
+        m_pContext(pContext),
+        m_DataSize(0)
+    {
+        memset(m_Arrays, 0, sizeof(m_Arrays));
+        memset(m_Schemas, 0, sizeof(m_Schemas));
+        memset(m_Buffers, 0, sizeof(m_Buffers));
+        memset(m_pArrayChildren, 0, sizeof(m_pArrayChildren));
+        memset(m_pSchemaChildren, 0, sizeof(m_pSchemaChildren));
+    }
+    ~FAArrowWordsData()
+    {
+        if (m_pfnInputCallback) {
+            (*m_pfnInputCallback)(m_pContext);
+        }
+    }
+
+public:
+    enum {
+        // the struct, then a list and its item for each column
+        MaxColumnCount = 3,
+        MaxNodeCount = 1 + (2 * MaxColumnCount),
+        MaxBufferCount = 4,
+    };
+
+    std::atomic < int > m_RefCount;
+    FAArrowInputCallback m_pfnInputCallback;
+    void * m_pContext;
+
+    // the list offsets, DocCount + 1, common for all the columns
+    std::vector< int32_t > m_ListOffsets;
+    // the validity bitmap of the lists, empty if all documents are processed
+    std::vector< uint8_t > m_Validity;
+    // the byte offsets of the first and of the last byte of each word, from the document start
+    std::vector< int32_t > m_Starts;
+    std::vector< int32_t > m_Ends;
+    // the string views of the words, 16 bytes each
+    std::vector< int32_t > m_Views;
+    // the size of the input, the only variadic buffer of the string views
+    int64_t m_DataSize;
+
+    ArrowArray m_Arrays[MaxNodeCount];
+    ArrowSchema m_Schemas[MaxNodeCount];
+    const void * m_Buffers[MaxNodeCount][MaxBufferCount];
+    // the children of the struct, then the item of each list
+    ArrowArray * m_pArrayChildren[2 * MaxColumnCount];
+    ArrowSchema * m_pSchemaChildren[2 * MaxColumnCount];
+};
+
+
+static void FAArrowReleaseArray(ArrowArray * pArray)
+{
+    for (int64_t i = 0; i < pArray->n_children; ++i) {
+        ArrowArray * pChild = pArray->children[i];
+        if (pChild->release) {
+            pChild->release(pChild);
+        }
+    }
+    FAArrowWordsData * pData = (FAArrowWordsData *) pArray->private_data;
+    pArray->release = NULL;
+    if (1 == pData->m_RefCount.fetch_sub(1)) {
+        delete pData;
+    }
+}
+
+
+static void FAArrowReleaseSchema(ArrowSchema * pSchema)
+{
+    for (int64_t i = 0; i < pSchema->n_children; ++i) {
+        ArrowSchema * pChild = pSchema->children[i];
+        if (pChild->release) {
+            pChild->release(pChild);
+        }
+    }
+    FAArrowWordsData * pData = (FAArrowWordsData *) pSchema->private_data;
+    pSchema->release = NULL;
+    if (1 == pData->m_RefCount.fetch_sub(1)) {
+        delete pData;
+    }
+}
+
+
+// sets up the array and the schema of the node Idx
+static void FAArrowSetNode(FAArrowWordsData * pData, ArrowArray * pArray, ArrowSchema * pSchema, const int Idx,
+    const char * pFormat, const char * pName, const int64_t Flags, const int64_t Length, const int64_t NullCount,
+    const int BufferCount, const int ChildCount, ArrowArray ** pArrayChildren, ArrowSchema ** pSchemaChildren)
+{
+    pArray->length = Length;
+    pArray->null_count = NullCount;
+    pArray->offset = 0;
+    pArray->n_buffers = BufferCount;
+    pArray->n_children = ChildCount;
+    pArray->buffers = pData->m_Buffers[Idx];
+    pArray->children = 0 < ChildCount ? pArrayChildren : NULL;
+    pArray->dictionary = NULL;
+    pArray->release = FAArrowReleaseArray;
+    pArray->private_data = pData;
+
+    pSchema->format = pFormat;
+    pSchema->name = pName;
+    pSchema->metadata = NULL;
+    pSchema->flags = Flags;
+    pSchema->n_children = ChildCount;
+    pSchema->children = 0 < ChildCount ? pSchemaChildren : NULL;
+    pSchema->dictionary = NULL;
+    pSchema->release = FAArrowReleaseSchema;
+    pSchema->private_data = pData;
+
+    pData->m_RefCount += 2;
+}
+
+
+//
+// Splits a batch of plain-text documents in UTF-8 encoding into words and returns the result as an
+// Arrow struct array with DocCount rows (format "+s"), so it can be imported as a record batch.
+// The documents are laid out as an Arrow string column: the document i is the bytes from
+// pDocOffsets[i] to pDocOffsets[i + 1] - 1 of pInUtf8Str.
+//
+// The columns:
+//  "start" list<int32> - the byte offsets of the first byte of each word, from the document start
+//  "end"   list<int32> - the byte offsets of the last byte of each word, from the document start
+//  "text"  list<string_view> - the words, only if FA_ARROW_WORDS_TEXT is set in Flags
+//
+// The words in the "text" column are not copied, they are views into pInUtf8Str, so the input must be
+// kept until pfnInputCallback(pContext) is called, which happens when the last of the returned structures
+// is released. pfnInputCallback can be NULL. The rows of the documents which cannot be processed (e.g.
+// not a valid UTF-8) are null.
+//
+// On success fills in *pSchema and *pArray, the caller must release them with their release callbacks,
+// and returns the total number of words. Returns -1 in case of an error, then nothing is filled in and
+// the callback is not called.
+//
+extern "C"
+const int TextToWordsArrow(const char * pInUtf8Str, const int * pDocOffsets, const int DocCount, const int Flags,
+    FAArrowInputCallback pfnInputCallback, void * pContext, ArrowSchema * pSchema, ArrowArray * pArray)
+{
+    // validate the parameters
+    if (0 > DocCount || NULL == pDocOffsets || NULL == pSchema || NULL == pArray) {
+        return -1;
+    }
+    for (int i = 0; i < DocCount; ++i) {
+        if (pDocOffsets[i] < 0 || pDocOffsets[i] > pDocOffsets[i + 1]) {
+            return -1;
+        }
+    }
+    if (0 < pDocOffsets[DocCount] && NULL == pInUtf8Str) {
+        return -1;
+    }
+
+    const bool fText = 0 != (FA_ARROW_WORDS_TEXT & Flags);
+
+    std::unique_ptr < FAArrowWordsData > Data(new FAArrowWordsData(pfnInputCallback, pContext));
+    FAArrowWordsData * pData = Data.get();
+    pData->m_DataSize = pDocOffsets[DocCount];
+    pData->m_ListOffsets.resize(DocCount + 1);
+    pData->m_ListOffsets[0] = 0;
+
+    // the offsets of the words of one document
+    std::vector< int > Starts;
+    std::vector< int > Ends;
+    FACountOutput Output;
+    int NullCount = 0;
+
+    for (int i = 0; i < DocCount; ++i) {
+
+        const char * pDoc = pInUtf8Str + pDocOffsets[i];
+        const int DocSize = pDocOffsets[i + 1] - pDocOffsets[i];
+
+        // each word has at least one byte
+        if ((int) Starts.size() < DocSize) {
+            Starts.resize(DocSize);
+            Ends.resize(DocSize);
+        }
+
+        const int WordCount = TextToWordsImpl(pDoc, DocSize, Starts.data(), Ends.data(), DocSize, Output);
+
+        if (0 > WordCount || WordCount > DocSize) {
+            // make this row null
+            if (pData->m_Validity.empty()) {
+                pData->m_Validity.resize((DocCount + 7) / 8, 0xFF);
+            }
+            pData->m_Validity[i / 8] &= ~(1 << (i % 8));
+            pData->m_ListOffsets[i + 1] = pData->m_ListOffsets[i];
+            NullCount++;
+            continue;
+        }
+
+        pData->m_Starts.insert(pData->m_Starts.end(), Starts.begin(), Starts.begin() + WordCount);
+        pData->m_Ends.insert(pData->m_Ends.end(), Ends.begin(), Ends.begin() + WordCount);
+        pData->m_ListOffsets[i + 1] = pData->m_ListOffsets[i] + WordCount;
+
+        if (!fText) {
+            continue;
+        }
+
+        // make a view for each word: the length, then the whole word if it is short or the prefix,
+        // the buffer index and the offset in the buffer if it is long
+        for (int j = 0; j < WordCount; ++j) {
+
+            const int Len = Ends[j] - Starts[j] + 1;
+            const char * pWord = pDoc + Starts[j];
+
+            int32_t View[4] = { Len, 0, 0, 0 };
+            if (12 >= Len) {
+                memcpy(View + 1, pWord, Len);
+            } else {
+                memcpy(View + 1, pWord, 4);
+                View[2] = 0;
+                View[3] = pDocOffsets[i] + Starts[j];
+            }
+            pData->m_Views.insert(pData->m_Views.end(), View, View + 4);
+        }
+    }
+
+    const int WordCount = pData->m_ListOffsets[DocCount];
+    const void * pValidity = pData->m_Validity.empty() ? NULL : pData->m_Validity.data();
+    const int64_t ListFlags = ARROW_FLAG_NULLABLE;
+
+    // the nodes: struct, start list, start item, end list, end item, text list, text item
+    const int ColumnCount = fText ? 3 : 2;
+
+    pData->m_Buffers[1][0] = pValidity;
+    pData->m_Buffers[1][1] = pData->m_ListOffsets.data();
+    pData->m_Buffers[2][1] = pData->m_Starts.data();
+    pData->m_Buffers[3][0] = pValidity;
+    pData->m_Buffers[3][1] = pData->m_ListOffsets.data();
+    pData->m_Buffers[4][1] = pData->m_Ends.data();
+    pData->m_Buffers[5][0] = pValidity;
+    pData->m_Buffers[5][1] = pData->m_ListOffsets.data();
+    pData->m_Buffers[6][1] = pData->m_Views.data();
+    pData->m_Buffers[6][2] = pInUtf8Str;
+    pData->m_Buffers[6][3] = &pData->m_DataSize;
+
+    FAArrowSetNode(pData, pArray, pSchema, 0, "+s", "", 0, DocCount, 0, 1, ColumnCount,
+        pData->m_pArrayChildren, pData->m_pSchemaChildren);
+
+    const char * pNames[3] = { "start", "end", "text" };
+
+    for (int i = 0; i < ColumnCount; ++i) {
+
+        const int ListIdx = 1 + (2 * i);
+        const int ItemIdx = ListIdx + 1;
+        const int ItemChildIdx = FAArrowWordsData::MaxColumnCount + i;
+
+        pData->m_pArrayChildren[i] = pData->m_Arrays + ListIdx;
+        pData->m_pSchemaChildren[i] = pData->m_Schemas + ListIdx;
+        pData->m_pArrayChildren[ItemChildIdx] = pData->m_Arrays + ItemIdx;
+        pData->m_pSchemaChildren[ItemChildIdx] = pData->m_Schemas + ItemIdx;
+
+        FAArrowSetNode(pData, pData->m_Arrays + ListIdx, pData->m_Schemas + ListIdx, ListIdx,
+            "+l", pNames[i], ListFlags, DocCount, NullCount, 2, 1,
+            pData->m_pArrayChildren + ItemChildIdx, pData->m_pSchemaChildren + ItemChildIdx);
+
+        if (2 == i) {
+            // a string view array has one variadic buffer, the input, followed by the buffer sizes
+            FAArrowSetNode(pData, pData->m_Arrays + ItemIdx, pData->m_Schemas + ItemIdx, ItemIdx,
+                "vu", "item", 0, WordCount, 0, 4, 0, NULL, NULL);
+        } else {
+            FAArrowSetNode(pData, pData->m_Arrays + ItemIdx, pData->m_Schemas + ItemIdx, ItemIdx,
+                "i", "item", 0, WordCount, 0, 2, 0, NULL, NULL);
+        }
+    }
+
+    Data.release();
+    return WordCount;
+}
+
+
+// copies the UTF-16LE output with the terminating 0, returns the size in UTF-16 code units
+inline const int FACopyUtf16Output(std::vector< uint16_t > & Out, uint16_t * pOutUtf16Str, const int MaxOutUtf16StrLen)
+{
+    // we will include the 0 just in case some scriping languages expect 0-terminated buffers and cannot use the size
+    Out.push_back(0);
+
+    const int OutLen = (int) Out.size();
+
+    if (OutLen <= MaxOutUtf16StrLen) {
+        memcpy(pOutUtf16Str, Out.data(), OutLen * sizeof(uint16_t));
+    }
+    return OutLen;
+}
+
+
+//
+// Same as TextToSentencesWithLimit but the input and output strings are in UTF-16LE encoding.
+//
+// InUtf16StrLen, MaxOutUtf16StrLen, *pStopOffset and returned size are in UTF-16 code units (not bytes)
+// pStartOffsets, pEndOffsets are offsets in UTF-16 code units of the first and last code unit of each sentence
+//
+extern "C"
+const int TextToSentencesUtf16WithLimit(const uint16_t * pInUtf16Str, int InUtf16StrLen,
+    uint16_t * pOutUtf16Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf16StrLen,
+    const int MaxSentCount, int * pStopOffset)
+{
+    if (pStopOffset) {
+        *pStopOffset = 0;
+    }
+    if (0 == InUtf16StrLen) {
+        return 0;
+    }
+
+    // accumulate the output here
+    FAUtf16StringOutput Os;
+
+    if (0 > TextToSentencesImpl(pInUtf16Str, InUtf16StrLen, pStartOffsets, pEndOffsets, MaxOutUtf16StrLen, Os,
+            MaxSentCount, pStopOffset)) {
+        return -1;
+    }
+
+    return FACopyUtf16Output(Os.m_Str, pOutUtf16Str, MaxOutUtf16StrLen);
+}
+
+
+//
+// Same as TextToSentencesWithOffsets but the input and output strings are in UTF-16LE encoding.
+//
+// InUtf16StrLen, MaxOutUtf16StrLen and returned size are in UTF-16 code units (not bytes)
+// pStartOffsets, pEndOffsets are offsets in UTF-16 code units of the first and last code unit of each sentence
+//
+// This allows .NET and Java hosts to call the library without transcoding strings to UTF-8 and back.
+//
+extern "C"
+const int TextToSentencesUtf16WithOffsets(const uint16_t * pInUtf16Str, int InUtf16StrLen,
+    uint16_t * pOutUtf16Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf16StrLen)
+{
+    return TextToSentencesUtf16WithLimit(pInUtf16Str, InUtf16StrLen, pOutUtf16Str, pStartOffsets, pEndOffsets,
+        MaxOutUtf16StrLen, 0, NULL);
+}
+
+
+//
+// Same as TextToSentences but the input and output strings are in UTF-16LE encoding,
+// InUtf16StrLen, MaxOutUtf16StrLen and returned size are in UTF-16 code units.
+//
+extern "C"
+const int TextToSentencesUtf16(const uint16_t * pInUtf16Str, int InUtf16StrLen, uint16_t * pOutUtf16Str, const int MaxOutUtf16StrLen)
+{
+    return TextToSentencesUtf16WithOffsets(pInUtf16Str, InUtf16StrLen, pOutUtf16Str, NULL, NULL, MaxOutUtf16StrLen);
+}
+
+
+//
+// Same as TextToWordsWithLimit but the input and output strings are in UTF-16LE encoding.
+//
+// InUtf16StrLen, MaxOutUtf16StrLen, *pStopOffset and returned size are in UTF-16 code units (not bytes)
+// pStartOffsets, pEndOffsets are offsets in UTF-16 code units of the first and last code unit of each word
+//
+extern "C"
+const int TextToWordsUtf16WithLimit(const uint16_t * pInUtf16Str, int InUtf16StrLen,
+    uint16_t * pOutUtf16Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf16StrLen,
+    const int MaxWordCount, int * pStopOffset)
+{
+    if (pStopOffset) {
+        *pStopOffset = 0;
+    }
+    if (0 == InUtf16StrLen) {
+        return 0;
+    }
+
+    // accumulate the output here
+    FAUtf16StringOutput Os;
+
+    if (0 > TextToWordsImpl(pInUtf16Str, InUtf16StrLen, pStartOffsets, pEndOffsets, MaxOutUtf16StrLen, Os,
+            MaxWordCount, pStopOffset)) {
+        return -1;
+    }
+
+    return FACopyUtf16Output(Os.m_Str, pOutUtf16Str, MaxOutUtf16StrLen);
+}
+
+
+//
+// Same as TextToWordsWithOffsets but the input and output strings are in UTF-16LE encoding.
+//
+// InUtf16StrLen, MaxOutUtf16StrLen and returned size are in UTF-16 code units (not bytes)
+// pStartOffsets, pEndOffsets are offsets in UTF-16 code units of the first and last code unit of each word
+//
+extern "C"
+const int TextToWordsUtf16WithOffsets(const uint16_t * pInUtf16Str, int InUtf16StrLen,
+    uint16_t * pOutUtf16Str, int * pStartOffsets, int * pEndOffsets, const int MaxOutUtf16StrLen)
+{
+    return TextToWordsUtf16WithLimit(pInUtf16Str, InUtf16StrLen, pOutUtf16Str, pStartOffsets, pEndOffsets,
+        MaxOutUtf16StrLen, 0, NULL);
+}
+
+
+//
+// Same as TextToWords but the input and output strings are in UTF-16LE encoding,
+// InUtf16StrLen, MaxOutUtf16StrLen and returned size are in UTF-16 code units.
+//
+extern "C"
+const int TextToWordsUtf16(const uint16_t * pInUtf16Str, int InUtf16StrLen, uint16_t * pOutUtf16Str, const int MaxOutUtf16StrLen)
+{
+    return TextToWordsUtf16WithOffsets(pInUtf16Str, InUtf16StrLen, pOutUtf16Str, NULL, NULL, MaxOutUtf16StrLen);
+}
+
+
+// This function implements the fasttext hashing function
+inline const uint32_t GetHash(const char * str, size_t strLen) {
+    uint32_t h = 2166136261;
+    for (size_t i = 0; i < strLen; i++) {
+        h = h ^ uint32_t(str[i]);
+        h = h * 16777619;
+    }
+    return h;
+}
+
+// EOS symbol
+int32_t EOS_HASH = GetHash("</s>", 4);
+
+const void AddWordNgrams(int32_t * hashArray, int& hashCount, int32_t wordNgrams, int32_t bucket) {
+    // hash size
+    const int tokenCount = hashCount;
+    for (int32_t i = 0; i < tokenCount; i++) {
+        uint64_t h = hashArray[i];
+        for (int32_t j = i + 1; j < i + wordNgrams; j++) {
+            uint64_t tempHash = (j < tokenCount) ? hashArray[j] : EOS_HASH;  // for computing ngram, we pad by EOS_HASH to allow each word has ngram which begins at itself.
+            h = h * 116049371 + tempHash;
+            hashArray[hashCount] = (h % bucket);
+            ++hashCount;
+        }
+    }
+}
+
+// Get the tokens count by inspecting the spaces in input buffer
+inline const int GetTokenCount(const char * input, const int bufferSize)
+{
+    if (bufferSize == 0)
+    {
+        return 0;
+    }
+    else
+    {
+        int spaceCount = 0;
+        for (int i = 0; i < bufferSize; ++i)
+        {
+            if (input[i] == ' ')
+            {
+                spaceCount++;
+            }
+        }
+        return spaceCount + 1;
+    }
+}
+
+// Port the fast text getline function with modifications
+// 1. do not have vocab
+// 2. do not compute subwords info
+
+const int ComputeHashes(const char * input, const int strLen, int32_t * hashArr, int wordNgrams, int bucketSize)
+{
+    int hashCount = 0;
+    char * pTemp = (char *)input;
+    char * pWordStart = &pTemp[0];
+    size_t wordLength = 0;
+
+    // add unigram hash first while reading the tokens. Unlike fasttext, there's no EOS padding here. 
+    for (int pos = 0; pos < strLen; pos++)
+    {
+        if (pTemp[pos] == ' ' || pos == strLen - 1)  // if we hit word boundary pushback wordhash or end of sentence
+        {
+            uint32_t wordhash = GetHash(pWordStart, wordLength);
+            hashArr[hashCount] = wordhash;
+            ++hashCount;
+            // move pointer to next word and reset length
+            pWordStart = &pTemp[pos + 1];
+            wordLength = 0;
+        }
+        else // otherwise keep moving temp pointer
+        {
+            ++wordLength;
+        }
+    }
+
+    //Add higher order ngrams (bigrams and up), each token has a ngram starting from itself makes the size ngram * ntokens. 
+    AddWordNgrams(hashArr, hashCount, wordNgrams, bucketSize);
+
+    return hashCount;
+}
+
+
+// memory cap for stack memory allocation
+const int MAX_ALLOCA_SIZE = 204800;
+
+
+//
+// This function implements the fasttext-like hashing logics. It first calls the tokenizer and then convert them into ngram hashes
+//
+// Example:   input :  "This is ok."
+//            output (bigram):  hash(this), hash(is), hash(ok), hash(.), hash(this is), hash(is ok), hash(ok .), hash(. EOS)
+//
+//            This is different from fasttext hashing:
+//            1. no EOS padding by default for unigram.
+//            2. do not take vocab as input, all unigrams are hashed too.
+//               and ngram hashes are not shifted.
+//
+extern "C"
+const int TextToHashes(const char * pInUtf8Str, int InUtf8StrByteCount, int32_t * pHashArr, const int MaxHashArrLength, int wordNgrams, int bucketSize = 2000000)
+{
+    // must have positive ngram
+    if (wordNgrams <= 0)
+    {
+        return -1;
+    }
+
+    //first we call tokenizer to get word arr
+    int maxOutputSize = InUtf8StrByteCount * 2 + 1;
+    int hashArrSize = 0;
+    char * pTokenizedStr = nullptr;
+
+    // cap memory usage
+    if (maxOutputSize < MAX_ALLOCA_SIZE)
+    {
+        pTokenizedStr = (char*)alloca(maxOutputSize);
+    }
+    else
+    {
+        pTokenizedStr = new char[maxOutputSize];
+    }
+
+    // tokenize the string
+    int strLen = TextToWords(pInUtf8Str, InUtf8StrByteCount, pTokenizedStr, maxOutputSize);
+
+    // if tokenizer has errors,
+    if (0 > strLen)
+    {
+        return strLen;
+    }
+
+    // get tokensize
+    int tokenCount = GetTokenCount(pTokenizedStr, strLen);
+
+    // if memory allocation is not enough for current output, return requested memory amount
     if (tokenCount * wordNgrams >= MaxHashArrLength)
     {
-        return strLen * wordNgrams;
+        return strLen * wordNgrams;
+    }
+
+    // if correctly tokenized and the memory usage is within the limit
+    hashArrSize = ComputeHashes(pTokenizedStr, strLen, pHashArr, wordNgrams, bucketSize);
+
+    assert(hashArrSize == wordNgrams * tokenCount);
+
+    // clean up heap memo if allocated
+    if (maxOutputSize >= MAX_ALLOCA_SIZE)
+    {
+        delete[]  pTokenizedStr;
+    }
+
+    return hashArrSize;
+
+}
+
+
+// updates the fasttext hash value with the UTF-8 bytes of the symbol
+inline const uint32_t UpdateHash(uint32_t h, const char * pUtf8, const int Utf8Len) {
+    for (int i = 0; i < Utf8Len; i++) {
+        h = h ^ uint32_t(pUtf8[i]);
+        h = h * 16777619;
+    }
+    return h;
+}
+
+
+// computes the hashes of TextToHashesEx and puts them into the Output, returns 0 on success and -1 in case of an error
+template < class OutputT >
+const int TextToHashesImpl(const char * pInUtf8Str, int InUtf8StrByteCount,
+    int wordNgrams, int minn, int maxn, int bucketSize, OutputT & Output)
+{
+    // validate the parameters
+    if (0 >= wordNgrams || 0 > minn || minn > maxn || 0 >= bucketSize) {
+        return -1;
+    }
+    if (0 == InUtf8StrByteCount) {
+        return 0;
+    }
+    if (0 > InUtf8StrByteCount || InUtf8StrByteCount > FALimits::MaxArrSize) {
+        return -1;
+    }
+    if (NULL == pInUtf8Str) {
+        return -1;
+    }
+
+    // check if the initilization is needed
+    FAEnsureInitialized();
+
+    // allocate buffer for UTF-32
+    std::vector< int > utf32input(InUtf8StrByteCount);
+    int * pBuff = utf32input.data();
+    if (NULL == pBuff) {
+        return -1;
+    }
+
+    // convert input to UTF-32
+    const int MaxBuffSize = ::FAStrUtf8ToArray(pInUtf8Str, InUtf8StrByteCount, pBuff, InUtf8StrByteCount);
+    if (MaxBuffSize <= 0 || MaxBuffSize > InUtf8StrByteCount) {
+        return -1;
+    }
+    // make sure the utf32input does not contain 'U+0000' elements
+    std::replace(pBuff, pBuff + MaxBuffSize, 0, 0x20);
+
+    // keep word boundary information here
+    std::vector< int > WbdRes(MaxBuffSize * 3);
+    int * pWbdRes = WbdRes.data();
+    if (NULL == pWbdRes) {
+        return -1;
+    }
+
+    // get the word breaking results
+    const int WbdOutSize = g_Wbd.Process(pBuff, MaxBuffSize, pWbdRes, MaxBuffSize * 3);
+    if (WbdOutSize > MaxBuffSize * 3 || 0 != WbdOutSize % 3) {
+        return -1;
+    }
+
+    // UTF-8 bytes of the current word with boundary symbols and the offset of each symbol
+    std::vector< char > WordUtf8((MaxBuffSize + 2) * FAUtf8Const::MAX_CHAR_SIZE);
+    char * pWordUtf8 = WordUtf8.data();
+    std::vector< int > WordOffsets(MaxBuffSize + 3);
+    int * pWordOffsets = WordOffsets.data();
+
+    // word hashes for the word ngrams
+    std::vector< int32_t > WordHashes;
+
+    for (int i = 0; i < WbdOutSize && !Output.IsStopped(); i += 3) {
+
+        // ignore tokens with IGNORE tag
+        const int Tag = pWbdRes[i];
+        if (WBD_IGNORE_TAG == Tag) {
+            continue;
+        }
+
+        const int From = pWbdRes[i + 1];
+        const int To = pWbdRes[i + 2];
+
+        // encode "<" word ">" into UTF-8, spaces are replaced with '_' as in TextToWords
+        int Utf8Len = 0;
+        int SymbolCount = 0;
+
+        pWordOffsets[SymbolCount++] = Utf8Len;
+        pWordUtf8[Utf8Len++] = '<';
+
+        for (int j = From; j <= To; ++j) {
+            const int C = (' ' == pBuff[j]) ? '_' : pBuff[j];
+            pWordOffsets[SymbolCount++] = Utf8Len;
+            const char * pEnd = ::FAIntToUtf8(C, pWordUtf8 + Utf8Len, FAUtf8Const::MAX_CHAR_SIZE);
+            if (NULL == pEnd) {
+                return -1;
+            }
+            Utf8Len = (int)(pEnd - pWordUtf8);
+        }
+
+        pWordOffsets[SymbolCount++] = Utf8Len;
+        pWordUtf8[Utf8Len++] = '>';
+        pWordOffsets[SymbolCount] = Utf8Len;
+
+        // add the word hash, computed without the boundary symbols
+        const int32_t WordHash = UpdateHash(2166136261, pWordUtf8 + 1, Utf8Len - 2);
+        WordHashes.push_back(WordHash);
+
+        Output.Put(WordHash);
+
+        // add character ngrams, all ngrams starting from the same symbol share the hash computation
+        for (int j = 0; j < SymbolCount; ++j) {
+
+            uint32_t h = 2166136261;
+
+            for (int n = 1; n <= maxn && j + n <= SymbolCount; ++n) {
+
+                const int Last = j + n - 1;
+                h = UpdateHash(h, pWordUtf8 + pWordOffsets[Last], pWordOffsets[Last + 1] - pWordOffsets[Last]);
+
+                // skip too short ngrams and single boundary symbols
+                if (n < minn || (1 == n && (0 == j || SymbolCount == j + n))) {
+                    continue;
+                }
+
+                Output.Put(h % bucketSize);
+            }
+        }
+    }
+
+    // add higher order word ngrams, each word has an ngram which begins at itself
+    const int tokenCount = (int) WordHashes.size();
+
+    for (int i = 0; i < tokenCount && 1 < wordNgrams && !Output.IsStopped(); i++) {
+        uint64_t h = WordHashes[i];
+        for (int j = i + 1; j < i + wordNgrams; j++) {
+            uint64_t tempHash = (j < tokenCount) ? WordHashes[j] : EOS_HASH;
+            h = h * 116049371 + tempHash;
+            Output.Put(h % bucketSize);
+        }
+    }
+
+    return 0;
+}
+
+
+//
+// Same as TextToHashes but in addition to word unigram and word ngram hashes also
+// returns fasttext-like character ngram hashes for every word, the hashes are
+// computed directly from the word-breaker output without making the string of words.
+//
+// Output layout (the same as fasttext's getLine):
+//
+//   for each word: hash(word), hash(<w) % bucket, hash(<wo) % bucket, ... hash(d>) % bucket
+//   then word ngrams: hash(word_1 word_2) % bucket, ...
+//
+// Parameters:
+//
+//   wordNgrams - word ngram order, 1 means no word ngram hashes are added
+//   minn, maxn - min and max length of character ngrams, 0 == maxn means no character ngrams,
+//     each word is surrounded by '<' and '>' boundary symbols, just like in fasttext
+//   bucketSize - the number of buckets for ngram hashes
+//
+// Returns the number of hashes, if the number is bigger than MaxHashArrLength then only
+// MaxHashArrLength hashes are copied into the output, -1 in case of an error.
+//
+extern "C"
+const int TextToHashesEx(const char * pInUtf8Str, int InUtf8StrByteCount, int32_t * pHashArr, const int MaxHashArrLength,
+    int wordNgrams, int minn, int maxn, int bucketSize)
+{
+    // validate the parameters
+    if (0 > MaxHashArrLength || (0 < MaxHashArrLength && NULL == pHashArr)) {
+        return -1;
+    }
+
+    FAArrayOutput < int32_t > Output(pHashArr, MaxHashArrLength);
+
+    if (0 != TextToHashesImpl(pInUtf8Str, InUtf8StrByteCount, wordNgrams, minn, maxn, bucketSize, Output)) {
+        return -1;
+    }
+    return Output.GetCount();
+}
+
+
+//
+// Same as TextToHashesEx, but the hashes are sent to the pfnCallback in chunks as soon as
+// they are computed, so the caller does not need to guess the size of the output array.
+// ChunkCount is the number of int32_t hashes in the chunk, if the callback returns
+// a non-zero value the processing stops.
+//
+// Returns the number of hashes passed to the callback, -1 in case of an error.
+//
+extern "C"
+const int TextToHashesStream(const char * pInUtf8Str, int InUtf8StrByteCount, FAStreamCallback pfnCallback, void * pContext,
+    int wordNgrams, int minn, int maxn, int bucketSize)
+{
+    if (NULL == pfnCallback) {
+        return -1;
+    }
+
+    FAStreamOutput < int32_t > Output(pfnCallback, pContext);
+
+    if (0 != TextToHashesImpl(pInUtf8Str, InUtf8StrByteCount, wordNgrams, minn, maxn, bucketSize, Output)) {
+        return -1;
+    }
+    Output.Flush();
+    return Output.GetCount();
+}
+
+// the maximum number of words in a shingle of TextToMinHash and TextToSimHash
+const int FA_MAX_SHINGLE_SIZE = 64;
+
+
+// mixes the bits of the 64-bit hash value, the finalizer of MurmurHash3
+inline const uint64_t FAMix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+
+//
+// Computes the hash of every shingle, ShingleSize consecutive words, and passes it to the
+// Consumer, the words are hashed the same way as in TextToHashes and the shingle hash is
+// the mixed word ngram hash, a text with less than ShingleSize words is one shingle.
+//
+// Returns the number of shingles and -1 in case of an error.
+//
+template < class ConsumerT >
+const int TextToShinglesImpl(const char * pInUtf8Str, int InUtf8StrByteCount, const int ShingleSize,
+    ConsumerT & Consumer)
+{
+    // check if the initilization is needed
+    FAEnsureInitialized();
+
+    // validate the parameters
+    if (0 >= ShingleSize || FA_MAX_SHINGLE_SIZE < ShingleSize) {
+        return -1;
+    }
+    if (0 == InUtf8StrByteCount) {
+        return 0;
+    }
+    if (0 > InUtf8StrByteCount || InUtf8StrByteCount > FALimits::MaxArrSize) {
+        return -1;
+    }
+    if (NULL == pInUtf8Str) {
+        return -1;
+    }
+
+    // convert input to UTF-32 and get the word breaking results
+    std::vector< int > utf32input;
+    std::vector< int > utf32offsets;
+    std::vector< int > WbdRes;
+    int MaxBuffSize = 0;
+    int WbdOutSize = 0;
+    int ByteCount = 0;
+    bool fAll = false;
+
+    if (0 != FALexPrefix(g_Wbd, FAWordCounter(), FA_AVG_WORD_SIZE,
+            pInUtf8Str, InUtf8StrByteCount, 0, utf32input, utf32offsets, &MaxBuffSize,
+            WbdRes, &WbdOutSize, &ByteCount, &fAll)) {
+        return -1;
+    }
+    const int * pBuff = utf32input.data();
+    const int * pWbdRes = WbdRes.data();
+
+    // the hashes of the last ShingleSize words, a ring buffer
+    uint32_t WordHashes[FA_MAX_SHINGLE_SIZE];
+    int WordCount = 0;
+    int ShingleCount = 0;
+
+    for (int i = 0; i < WbdOutSize; i += 3) {
+
+        // ignore tokens with IGNORE tag
+        const int Tag = pWbdRes[i];
+        if (WBD_IGNORE_TAG == Tag) {
+            continue;
+        }
+
+        const int From = pWbdRes[i + 1];
+        const int To = pWbdRes[i + 2];
+
+        // hash the UTF-8 bytes of the word, spaces are replaced with '_' as in TextToWords
+        uint32_t WordHash = 2166136261;
+
+        for (int j = From; j <= To; ++j) {
+            const int C = (' ' == pBuff[j]) ? '_' : pBuff[j];
+            char Utf8[FAUtf8Const::MAX_CHAR_SIZE];
+            const char * pEnd = ::FAIntToUtf8(C, Utf8, FAUtf8Const::MAX_CHAR_SIZE);
+            if (NULL == pEnd) {
+                return -1;
+            }
+            WordHash = UpdateHash(WordHash, Utf8, (int)(pEnd - Utf8));
+        }
+
+        WordHashes[WordCount % ShingleSize] = WordHash;
+        WordCount++;
+
+        if (WordCount < ShingleSize) {
+            continue;
+        }
+
+        // the word ngram hash, as in AddWordNgrams
+        uint64_t h = WordHashes[WordCount % ShingleSize];
+        for (int j = 1; j < ShingleSize; ++j) {
+            h = h * 116049371 + WordHashes[(WordCount + j) % ShingleSize];
+        }
+        Consumer(FAMix64(h));
+        ShingleCount++;
+    }
+
+    // a short text is one shingle
+    if (0 < WordCount && WordCount < ShingleSize) {
+        uint64_t h = WordHashes[0];
+        for (int j = 1; j < WordCount; ++j) {
+            h = h * 116049371 + WordHashes[j];
+        }
+        Consumer(FAMix64(h));
+        ShingleCount++;
+    }
+
+    return ShingleCount;
+}
+
+
+// keeps the minimum of each of the k hash permutations, a permutation is A * h + B with an odd A
+class FAMinHashConsumer {
+public:
+    FAMinHashConsumer(const uint64_t * pA, const uint64_t * pB, uint64_t * pMins, const int K) :
+        m_pA(pA),
+        m_pB(pB),
+        m_pMins(pMins),
+        m_K(K)
+    {}
+
+    inline void operator()(const uint64_t h)
+    {
+        // independent element-wise operations, vectorized by the compiler
+        for (int i = 0; i < m_K; ++i) {
+            const uint64_t v = m_pA[i] * h + m_pB[i];
+            m_pMins[i] = v < m_pMins[i] ? v : m_pMins[i];
+        }
+    }
+
+private:
+    const uint64_t * m_pA;
+    const uint64_t * m_pB;
+    uint64_t * m_pMins;
+    const int m_K;
+};
+
+
+// counts the ones of each bit of the shingle hashes
+class FASimHashConsumer {
+public:
+    FASimHashConsumer()
+    {
+        memset(m_Ones, 0, sizeof(m_Ones));
+    }
+
+    inline void operator()(const uint64_t h)
+    {
+        for (int i = 0; i < 64; ++i) {
+            m_Ones[i] += (int)((h >> i) & 1);
+        }
+    }
+
+    // a bit is set if it is set in more than half of the hashes
+    inline const uint64_t GetHash(const int Count) const
+    {
+        uint64_t Res = 0;
+        for (int i = 0; i < 64; ++i) {
+            if (Count < 2 * m_Ones[i]) {
+                Res |= (uint64_t(1) << i);
+            }
+        }
+        return Res;
+    }
+
+private:
+    int m_Ones[64];
+};
+
+
+//
+// Computes the MinHash signature of the text over the shingles of ShingleSize consecutive words,
+// in the same pass as the word breaking, no hashes are stored.
+//
+// Parameters:
+//
+//   K - the number of hash permutations, the size of the pSignature array
+//   ShingleSize - the number of words in a shingle, from 1 to 64, a text with fewer words is one shingle
+//   pSeeds - K seeds of the permutations, or NULL to use 1, 2, ..., K; the same seeds should be
+//     used for all the documents which are compared
+//   pSignature - gets the minimum of each permutation over the shingle hashes, all bits are set
+//     if the text has no words
+//
+// Returns the number of shingles, -1 in case of an error.
+//
+extern "C"
+const int TextToMinHash(const char * pInUtf8Str, int InUtf8StrByteCount, const int K, const int ShingleSize,
+    const uint64_t * pSeeds, uint64_t * pSignature)
+{
+    // validate the parameters
+    if (0 >= K || NULL == pSignature) {
+        return -1;
+    }
+
+    // make the permutations out of the seeds
+    std::vector< uint64_t > AB(2 * (size_t) K);
+    uint64_t * pA = AB.data();
+    uint64_t * pB = pA + K;
+
+    for (int i = 0; i < K; ++i) {
+        const uint64_t Seed = pSeeds ? pSeeds[i] : (uint64_t) i + 1;
+        pA[i] = FAMix64(Seed ^ 0x9e3779b97f4a7c15ULL) | 1;
+        pB[i] = FAMix64(pA[i] + 0x9e3779b97f4a7c15ULL);
+    }
+
+    for (int i = 0; i < K; ++i) {
+        pSignature[i] = UINT64_MAX;
+    }
+
+    FAMinHashConsumer Consumer(pA, pB, pSignature, K);
+
+    return TextToShinglesImpl(pInUtf8Str, InUtf8StrByteCount, ShingleSize, Consumer);
+}
+
+
+//
+// Computes the 64-bit SimHash of the text over the shingles of ShingleSize consecutive words,
+// in the same pass as the word breaking. The documents are near-duplicates if their SimHash
+// values differ in a few bits. *pSimHash is 0 if the text has no words.
+//
+// Returns the number of shingles, -1 in case of an error.
+//
+extern "C"
+const int TextToSimHash(const char * pInUtf8Str, int InUtf8StrByteCount, const int ShingleSize, uint64_t * pSimHash)
+{
+    if (NULL == pSimHash) {
+        return -1;
+    }
+
+    FASimHashConsumer Consumer;
+
+    const int ShingleCount = TextToShinglesImpl(pInUtf8Str, InUtf8StrByteCount, ShingleSize, Consumer);
+    if (0 > ShingleCount) {
+        return -1;
+    }
+
+    *pSimHash = Consumer.GetHash(ShingleCount);
+    return ShingleCount;
+}
+
+
+// the number of models loaded so far, gives every model a unique id
+std::atomic < uint64_t > g_ModelCount (0);
+
+// types of the model handles
+enum {
+    FA_HANDLE_MODEL = 0x4C444D31,       // FAModelData, returned by LoadModel
+    FA_HANDLE_RELOADABLE = 0x4C444D32,  // FAReloadableModel, returned by LoadReloadableModel
+};
+
+//
+// Common part of the model handles, tells which kind of handle the caller passed
+//
+struct FAModelHandle {
+
+    explicit FAModelHandle (const int HandleType) :
+        m_HandleType (HandleType)
+    {}
+
+    const int m_HandleType;
+};
+
+//
+// Keeps the data and processors of a model loaded by LoadModel
+//
+struct FAModelData : public FAModelHandle {
+
+    FAModelData () :
+        FAModelHandle (FA_HANDLE_MODEL),
+        m_Id (++g_ModelCount),
+        m_fWbd (false),
+        m_fWp (false),
+        m_fVocab (false),
+        m_fMwe (false),
+        m_fTagger (false)
+    {}
+
+    // unique model id, never reused, so per-thread states can tell models apart
+    const uint64_t m_Id;
+
+    // model image and the LDB on top of it
+    FAImageDump m_Img;
+    FAMorphLDB_t < int > m_Ldb;
+
+    // word-breaking rules, if the model does not have them the built-in ones are used
+    FAWbdConfKeeper m_WbdConf;
+    FALexTools_t < int > m_Wbd;
+    bool m_fWbd;
+
+    // WordPiece vocabulary
+    FAWordPieceConfKeeper m_WpConf;
+    FAWordPieceTools_t < int > m_Wp;
+    bool m_fWp;
+
+    // whole word vocabulary, MPH or Moore dictionary
+    FADictConfKeeper m_VocabConf;
+    FADictInterpreter_t < int > m_Vocab;
+    bool m_fVocab;
+
+    // phrase dictionary over the vocabulary ids
+    FADictConfKeeper m_MweConf;
+    FAMweTools m_Mwe;
+    bool m_fMwe;
+
+    // P(T) and P(T|T-1) tables of the HMM tagger, P(T|W) is taken from the m_Ldb
+    FAT2PTable m_T2P;
+    FATs2PTable m_TT2P;
+    bool m_fTagger;
+};
+
+
+//
+// Read-side critical sections of the model calls (epoch based RCU).
+//
+// A thread which uses a model stores the current epoch in its own record for
+// the duration of the call. ReloadModel publishes the new model, advances the
+// epoch and waits until no thread is left in an older epoch, after that nobody
+// can reference the old model and it is freed. SetModelDelta waits the same
+// way for the previous vocabulary delta. Readers never take a lock, they only
+// write to their own record.
+//
+struct FAReaderRecord {
+
+    FAReaderRecord () :
+        m_Epoch (0),
+        m_fInUse (true),
+        m_pNext (NULL)
+    {}
+
+    // the epoch the thread entered with, 0 if the thread is outside
+    std::atomic < uint64_t > m_Epoch;
+    // false if the thread has exited and the record can be reused
+    std::atomic < bool > m_fInUse;
+    // records are never freed, so the list can be traversed without locks
+    FAReaderRecord * m_pNext;
+    // keep records of different threads in different cache lines
+    char m_Padding [64];
+};
+
+std::atomic < FAReaderRecord * > g_pReaders (NULL);
+std::atomic < uint64_t > g_Epoch (1);
+
+
+// releases the record of the thread at the thread exit
+struct FAReaderRecordOwner {
+
+    FAReaderRecordOwner () :
+        m_pRecord (NULL)
+    {}
+
+    ~FAReaderRecordOwner ()
+    {
+        if (m_pRecord) {
+            m_pRecord->m_Epoch.store(0);
+            m_pRecord->m_fInUse.store(false);
+        }
+    }
+
+    FAReaderRecord * m_pRecord;
+};
+
+thread_local FAReaderRecordOwner t_ReaderRecord;
+
+
+// returns the record of the current thread, registers the thread on its first call
+inline FAReaderRecord * FAGetReaderRecord()
+{
+    if (NULL != t_ReaderRecord.m_pRecord) {
+        return t_ReaderRecord.m_pRecord;
+    }
+
+    FAReaderRecord * pRecord = g_pReaders.load();
+
+    // reuse a record of an exited thread, if any
+    for (; NULL != pRecord; pRecord = pRecord->m_pNext) {
+        bool fInUse = false;
+        if (pRecord->m_fInUse.compare_exchange_strong(fInUse, true)) {
+            break;
+        }
+    }
+
+    // add a new record to the list
+    if (NULL == pRecord) {
+        pRecord = new FAReaderRecord();
+        FAReaderRecord * pHead = g_pReaders.load();
+        do {
+            pRecord->m_pNext = pHead;
+        } while (!g_pReaders.compare_exchange_weak(pHead, pRecord));
+    }
+
+    t_ReaderRecord.m_pRecord = pRecord;
+    return pRecord;
+}
+
+
+//
+// Read-side critical section, nested sections of the same thread are allowed
+//
+class FAReadSection {
+
+public:
+    FAReadSection () :
+        m_pRecord (NULL)
+    {}
+
+    ~FAReadSection ()
+    {
+        if (m_pRecord) {
+            m_pRecord->m_Epoch.store(0);
+        }
+    }
+
+    inline void Enter()
+    {
+        FAReaderRecord * pRecord = FAGetReaderRecord();
+        // the outermost section of the thread owns the record
+        if (0 == pRecord->m_Epoch.load()) {
+            pRecord->m_Epoch.store(g_Epoch.load());
+            m_pRecord = pRecord;
+        }
+    }
+
+private:
+    FAReaderRecord * m_pRecord;
+};
+
+
+// waits until all the read-side sections entered before the call are left
+void FASynchronizeReaders()
+{
+    const uint64_t NewEpoch = g_Epoch.fetch_add(1) + 1;
+
+    for (FAReaderRecord * pRecord = g_pReaders.load(); NULL != pRecord; pRecord = pRecord->m_pNext) {
+        while (true) {
+            const uint64_t Epoch = pRecord->m_Epoch.load();
+            if (0 == Epoch || NewEpoch <= Epoch) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+//
+// Keeps the current version of the model loaded by LoadReloadableModel
+//
+struct FAReloadableModel : public FAModelHandle {
+
+    explicit FAReloadableModel (FAModelData * pModelData) :
+        FAModelHandle (FA_HANDLE_RELOADABLE),
+        m_pModelData (pModelData),
+        m_pDelta (NULL)
+    {}
+
+    // the current version of the model
+    std::atomic < FAModelData * > m_pModelData;
+    // the vocabulary delta set by SetModelDelta, attached to each new version
+    const FADictInterpreter_t < int > * m_pDelta;
+    // serializes ReloadModel and SetModelDelta calls, readers do not use it
+    std::mutex m_ReloadMutex;
+};
+
+
+//
+// Gives access to the model data of any kind of the model handle, the data
+// stays valid for the lifetime of this object even if the model is reloaded,
+// the access is a read-side section for both kinds of handles, so that the
+// vocabulary delta swapped by SetModelDelta can be waited for too
+//
+class FAModelAccess {
+
+public:
+    explicit FAModelAccess (void * ModelPtr) :
+        m_pModelData (NULL)
+    {
+        if (NULL == ModelPtr) {
+            return;
+        }
+
+        FAModelHandle * pHandle = (FAModelHandle *)ModelPtr;
+
+        m_Section.Enter();
+
+        if (FA_HANDLE_MODEL == pHandle->m_HandleType) {
+
+            m_pModelData = static_cast < FAModelData * > (pHandle);
+
+        } else if (FA_HANDLE_RELOADABLE == pHandle->m_HandleType) {
+
+            m_pModelData = static_cast < FAReloadableModel * > (pHandle)->m_pModelData.load();
+        }
+    }
+
+    inline FAModelData * Get() const
+    {
+        return m_pModelData;
+    }
+
+private:
+    FAReadSection m_Section;
+    FAModelData * m_pModelData;
+};
+
+
+// loads the model data from the LDB file, returns NULL in case of an error
+FAModelData * FALoadModelData(const char * pszLdbFileName)
+{
+    if (NULL == pszLdbFileName) {
+        return NULL;
+    }
+
+    FAModelData * pNewModelData = NULL;
+
+    try {
+
+        pNewModelData = new FAModelData();
+        if (NULL == pNewModelData) {
+            return NULL;
+        }
+
+        pNewModelData->m_Img.Load(pszLdbFileName, true);
+        const unsigned char * pImgBytes = pNewModelData->m_Img.GetImageDump();
+        if (NULL == pImgBytes) {
+            delete pNewModelData;
+            return NULL;
+        }
+        pNewModelData->m_Ldb.SetImage(pImgBytes);
+
+        const FAMultiMapCA * pHeader = pNewModelData->m_Ldb.GetHeader();
+        const int * pValues = NULL;
+        int iSize = 0;
+
+        // initialize WBD, if the model has it
+        iSize = pHeader->Get(FAFsmConst::FUNC_WBD, &pValues);
+        if (-1 != iSize) {
+            pNewModelData->m_WbdConf.Initialize(&(pNewModelData->m_Ldb), pValues, iSize);
+            pNewModelData->m_Wbd.SetConf(&(pNewModelData->m_WbdConf));
+            pNewModelData->m_fWbd = true;
+        }
+
+        // initialize WordPiece, if the model has it
+        pValues = NULL;
+        iSize = pHeader->Get(FAFsmConst::FUNC_WORDPIECE, &pValues);
+        if (-1 != iSize) {
+            pNewModelData->m_WpConf.Initialize(&(pNewModelData->m_Ldb), pValues, iSize);
+            pNewModelData->m_Wp.SetConf(&(pNewModelData->m_WpConf));
+            pNewModelData->m_fWp = true;
+        }
+
+        // initialize the vocabulary, if the model has it
+        pValues = NULL;
+        iSize = pHeader->Get(FAFsmConst::FUNC_VOCAB, &pValues);
+        if (-1 != iSize) {
+            pNewModelData->m_VocabConf.SetLDB(&(pNewModelData->m_Ldb));
+            pNewModelData->m_VocabConf.Init(pValues, iSize);
+            pNewModelData->m_Vocab.SetConf(&(pNewModelData->m_VocabConf), NULL);
+            pNewModelData->m_fVocab = true;
+        }
+
+        // initialize the phrase dictionary, if the model has it
+        pValues = NULL;
+        iSize = pHeader->Get(FAFsmConst::FUNC_MWE, &pValues);
+        if (-1 != iSize) {
+            pNewModelData->m_MweConf.SetLDB(&(pNewModelData->m_Ldb));
+            pNewModelData->m_MweConf.Init(pValues, iSize);
+            pNewModelData->m_Mwe.SetConf(&(pNewModelData->m_MweConf));
+            pNewModelData->m_fMwe = true;
+        }
+
+        // initialize the POS tagger tables, if the model has [w2tp], [t2p] and [tt2p]
+        const FAMorphLDB_t < int > * pLdb = &(pNewModelData->m_Ldb);
+        if (pLdb->GetW2TPConf() && pLdb->GetT2PConf() && pLdb->GetTT2PConf()) {
+            pNewModelData->m_T2P.SetConf(pLdb->GetT2PConf());
+            pNewModelData->m_TT2P.SetConf(pLdb->GetTT2PConf());
+            pNewModelData->m_fTagger = true;
+        }
+
+    } catch (...) {
+
+        if (pNewModelData) {
+            delete pNewModelData;
+        }
+        return NULL;
+    }
+
+    return pNewModelData;
+}
+
+
+//
+// Loads a model from the LDB file, returns a model handle or NULL in case of an error.
+//
+// The LDB may contain [wbd] section with its own word-breaking rules,
+// [wordpiece] section with the WordPiece vocabulary, [vocab] section with the
+// whole word vocabulary, [mwe] section with the phrase dictionary over the [vocab]
+// ids and/or [w2tp], [t2p], [tt2p] sections of the HMM POS tagger.
+//
+extern "C"
+void * LoadModel(const char * pszLdbFileName)
+{
+    FAModelHandle * pHandle = FALoadModelData(pszLdbFileName);
+    return pHandle;
+}
+
+
+//
+// Same as LoadModel, but the returned handle can be passed to ReloadModel to
+// replace the model with a new version while other threads keep using it.
+// The handle can be used with all the functions which take a model handle.
+//
+extern "C"
+void * LoadReloadableModel(const char * pszLdbFileName)
+{
+    FAModelData * pModelData = FALoadModelData(pszLdbFileName);
+    if (NULL == pModelData) {
+        return NULL;
+    }
+
+    FAModelHandle * pHandle = new FAReloadableModel(pModelData);
+    return pHandle;
+}
+
+
+//
+// Replaces the model of the handle returned by LoadReloadableModel with the
+// model from the LDB file. The calls which have already started keep using
+// the old version, the new calls use the new one. The function returns when
+// the old version is not used by anybody anymore and is freed (its memory is
+// released). The vocabulary delta attached by SetModelDelta is kept.
+//
+// The calls with this handle never wait for the reload. Note, this function
+// should not be called from within a callback of another call of this library.
+//
+// Returns 0 on success, -1 in case of an error, then the old model is kept.
+//
+extern "C"
+const int ReloadModel(void * ModelPtr, const char * pszLdbFileName)
+{
+    FAModelHandle * pHandle = (FAModelHandle *)ModelPtr;
+    if (NULL == pHandle || FA_HANDLE_RELOADABLE != pHandle->m_HandleType) {
+        return -1;
+    }
+    FAReloadableModel * pModel = static_cast < FAReloadableModel * > (pHandle);
+
+    FAModelData * pNewModelData = FALoadModelData(pszLdbFileName);
+    if (NULL == pNewModelData) {
+        return -1;
+    }
+
+    std::lock_guard < std::mutex > guard(pModel->m_ReloadMutex);
+
+    // keep the vocabulary delta, if any
+    if (pNewModelData->m_fVocab) {
+        pNewModelData->m_Vocab.SetDelta(pModel->m_pDelta);
+    }
+    FAModelData * pOldModelData = pModel->m_pModelData.load();
+
+    // publish the new version and wait for the readers of the old one
+    pModel->m_pModelData.store(pNewModelData);
+    FASynchronizeReaders();
+
+    delete pOldModelData;
+    return 0;
+}
+
+
+//
+// Frees the memory and resources of the model loaded by LoadModel or LoadReloadableModel,
+// returns 0 on success and -1 if the handle is NULL.
+//
+extern "C"
+const int FreeModel(void * ModelPtr)
+{
+    FAModelHandle * pHandle = (FAModelHandle *)ModelPtr;
+    if (NULL == pHandle) {
+        return -1;
+    }
+
+    if (FA_HANDLE_RELOADABLE == pHandle->m_HandleType) {
+        FAReloadableModel * pModel = static_cast < FAReloadableModel * > (pHandle);
+        delete pModel->m_pModelData.load();
+        delete pModel;
+    } else {
+        delete static_cast < FAModelData * > (pHandle);
+    }
+    return 0;
+}
+
+
+//
+// Attaches the [vocab] dictionary of the DeltaModelPtr model as a delta to the
+// [vocab] dictionary of the ModelPtr model. The delta is checked first, it
+// can add new words, change ids of the existing ones or remove them, see
+// fa_vocab2dfa --delta. The DeltaModelPtr of NULL detaches the current delta.
+//
+// The delta can be replaced while other threads call TextToIds with ModelPtr,
+// a call running during the swap may see the previous delta for some words and
+// the new one for the others. The function returns when the calls which could
+// see the previous delta are over, so the previous delta model can be freed
+// after that. The attached delta model should not be freed while it is
+// attached. For the handle returned by LoadReloadableModel the delta stays
+// attached to the new versions of the model loaded by ReloadModel. Note, this
+// function should not be called from within a callback of another call of
+// this library.
+//
+// Returns 0 on success and -1 in case of an error.
+//
+extern "C"
+const int SetModelDelta(void * ModelPtr, void * DeltaModelPtr)
+{
+    if (ModelPtr == DeltaModelPtr) {
+        return -1;
+    }
+
+    FAModelHandle * pHandle = (FAModelHandle *)ModelPtr;
+    if (NULL == pHandle) {
+        return -1;
+    }
+
+    const FADictInterpreter_t < int > * pDelta = NULL;
+
+    if (NULL != DeltaModelPtr) {
+        // the delta cannot be reloadable, as it is referenced by the model
+        const FAModelHandle * pDeltaHandle = (const FAModelHandle *)DeltaModelPtr;
+        if (FA_HANDLE_MODEL != pDeltaHandle->m_HandleType) {
+            return -1;
+        }
+        const FAModelData * pDeltaData = static_cast < const FAModelData * > (pDeltaHandle);
+        if (!pDeltaData->m_fVocab) {
+            return -1;
+        }
+        pDelta = &(pDeltaData->m_Vocab);
+    }
+
+    if (FA_HANDLE_RELOADABLE == pHandle->m_HandleType) {
+
+        FAReloadableModel * pModel = static_cast < FAReloadableModel * > (pHandle);
+
+        // the version cannot change while the mutex is held, and a concurrent
+        // ReloadModel attaches the delta set here to the version it loads
+        std::lock_guard < std::mutex > guard(pModel->m_ReloadMutex);
+
+        FAModelData * pModelData = pModel->m_pModelData.load();
+        if (!pModelData->m_fVocab) {
+            return -1;
+        }
+        pModel->m_pDelta = pDelta;
+        pModelData->m_Vocab.SetDelta(pDelta);
+
+        // wait for the calls which may still use the previous delta
+        FASynchronizeReaders();
+        return 0;
+
+    } else if (FA_HANDLE_MODEL == pHandle->m_HandleType) {
+
+        FAModelData * pModelData = static_cast < FAModelData * > (pHandle);
+        if (!pModelData->m_fVocab) {
+            return -1;
+        }
+        pModelData->m_Vocab.SetDelta(pDelta);
+
+        // wait for the calls which may still use the previous delta
+        FASynchronizeReaders();
+        return 0;
+    }
+
+    return -1;
+}
+
+
+//
+// Splits plain-text in UTF-8 encoding into words and each word into WordPiece
+// subwords, returns subword ids and original offsets from the input buffer.
+//
+// If the model does not have [wordpiece] section but has [vocab] section then
+// each word is looked up in the vocabulary as a whole, with case folding and
+// character normalization as configured, words which are not in the vocabulary
+// get the id specified by the unknown parameter (-1 by default).
+//
+// ModelPtr - a handle returned by LoadModel or LoadReloadableModel, the model should have [wordpiece] or [vocab] section
+// pIdsArr - array of ids with upto MaxIdsArrLength elements
+// pStartOffsets - array of integers (first byte of each subword) with upto MaxIdsArrLength elements, can be NULL
+// pEndOffsets - array of integers (last byte of each subword) with upto MaxIdsArrLength elements, can be NULL
+//
+// Returns the number of ids or -1 in case of an error. The processing stops when
+// MaxIdsArrLength ids are produced, so the output is truncated to the first
+// MaxIdsArrLength subwords.
+//
+extern "C"
+const int TextToIdsWithOffsets(void * ModelPtr, const char * pInUtf8Str, int InUtf8StrByteCount,
+    int32_t * pIdsArr, int * pStartOffsets, int * pEndOffsets, const int MaxIdsArrLength)
+{
+    // validate the parameters
+    if (NULL == ModelPtr || 0 > MaxIdsArrLength || NULL == pIdsArr) {
+        return -1;
+    }
+    FAModelAccess Model(ModelPtr);
+    const FAModelData * pModelData = Model.Get();
+    if (NULL == pModelData || (!pModelData->m_fWp && !pModelData->m_fVocab)) {
+        return -1;
+    }
+    if (0 == InUtf8StrByteCount || 0 == MaxIdsArrLength) {
+        return 0;
+    }
+    if (0 > InUtf8StrByteCount || InUtf8StrByteCount > FALimits::MaxArrSize) {
+        return -1;
+    }
+    if (NULL == pInUtf8Str) {
+        return -1;
+    }
+
+    // use the built-in word-breaker, if the model does not have one
+    const FALexTools_t < int > * pWbd = &(pModelData->m_Wbd);
+    int IgnoreTag = pModelData->m_WbdConf.GetWbdTagIgnore();
+
+    if (!pModelData->m_fWbd) {
+
+        // check if the initilization is needed
+        FAEnsureInitialized();
+
+        pWbd = &g_Wbd;
+        IgnoreTag = WBD_IGNORE_TAG;
+    }
+
+    // allocate buffer for UTF-32, word-breaking results
+    std::vector< int > utf32input(InUtf8StrByteCount);
+    int * pBuff = utf32input.data();
+    if (NULL == pBuff) {
+        return -1;
+    }
+    std::vector< int > utf32offsets(InUtf8StrByteCount);
+    int * pOffsets = utf32offsets.data();
+    if (NULL == pOffsets) {
+        return -1;
+    }
+
+    // convert input to UTF-32
+    const int MaxBuffSize = ::FAStrUtf8ToArray(pInUtf8Str, InUtf8StrByteCount, pBuff, pOffsets, InUtf8StrByteCount);
+    if (MaxBuffSize <= 0 || MaxBuffSize > InUtf8StrByteCount) {
+        return -1;
+    }
+    // make sure the utf32input does not contain 'U+0000' elements
+    std::replace(pBuff, pBuff + MaxBuffSize, 0, 0x20);
+
+    // keep word boundary information here
+    std::vector< int > WbdRes(MaxBuffSize * 3);
+    int * pWbdRes = WbdRes.data();
+    if (NULL == pWbdRes) {
+        return -1;
+    }
+
+    // get the word breaking results
+    const int WbdOutSize = pWbd->Process(pBuff, MaxBuffSize, pWbdRes, MaxBuffSize * 3);
+    if (WbdOutSize > MaxBuffSize * 3 || 0 != WbdOutSize % 3) {
+        return -1;
+    }
+
+    // keep subword boundary information here
+    const int MaxWpOutSize = FALimits::MaxWordLen * 3;
+    int WpRes [MaxWpOutSize];
+
+    int IdCount = 0;
+
+    for (int i = 0; i < WbdOutSize && IdCount < MaxIdsArrLength; i += 3) {
+
+        // ignore tokens with IGNORE tag
+        const int Tag = pWbdRes[i];
+        if (IgnoreTag == Tag) {
+            continue;
+        }
+
+        const int From = pWbdRes[i + 1];
+        const int To = pWbdRes[i + 2];
+        const int Len = To - From + 1;
+
+        int WpOutSize = 3;
+
+        if (pModelData->m_fWp) {
+            // get the subwords of the token
+            WpOutSize = pModelData->m_Wp.Process(pBuff + From, Len, WpRes, MaxWpOutSize);
+            if (0 > WpOutSize || 0 != WpOutSize % 3) {
+                return -1;
+            }
+        } else {
+            // look up the whole token, unknown tokens get the OOV id
+            const int Id = pModelData->m_Vocab.GetInfoId(pBuff + From, Len);
+            WpRes[0] = (-1 != Id) ? Id : pModelData->m_VocabConf.GetUnkId();
+            WpRes[1] = 0;
+            WpRes[2] = Len - 1;
+        }
+
+        for (int j = 0; j < WpOutSize && IdCount < MaxIdsArrLength; j += 3) {
+
+            const int SubFrom = From + WpRes[j + 1];
+            const int SubTo = From + WpRes[j + 2];
+
+            pIdsArr[IdCount] = WpRes[j];
+
+            if (pStartOffsets) {
+                pStartOffsets[IdCount] = pOffsets[SubFrom];
+            }
+            if (pEndOffsets) {
+                // offset of last UTF-32 character plus its length in bytes in the original string - 1
+                const int ToCharSize = ::FAUtf8Size(pInUtf8Str + pOffsets[SubTo]);
+                pEndOffsets[IdCount] = pOffsets[SubTo] + (0 < ToCharSize ? ToCharSize - 1 : 0);
+            }
+            IdCount++;
+        }
+    }
+
+    return IdCount;
+}
+
+
+//
+// Same as TextToIdsWithOffsets but does not return the offsets.
+//
+extern "C"
+const int TextToIds(void * ModelPtr, const char * pInUtf8Str, int InUtf8StrByteCount,
+    int32_t * pIdsArr, const int MaxIdsArrLength)
+{
+    return TextToIdsWithOffsets(ModelPtr, pInUtf8Str, InUtf8StrByteCount, pIdsArr, NULL, NULL, MaxIdsArrLength);
+}
+
+
+//
+// Per-thread state of the POS tagger, the tagger and the P(T|W) guesser keep
+// intermediate results so they cannot be shared among threads, the state is
+// reused by all calls of the thread as long as they are made with the same model.
+//
+struct FATaggerState {
+
+    explicit FATaggerState (const FAModelData * pModelData) :
+        m_ModelId (pModelData->m_Id)
+    {
+        const FAWgConfKeeper * pW2TPConf = pModelData->m_Ldb.GetW2TPConf();
+        LogAssert(pW2TPConf);
+
+        const FAState2OwsCA * pOws = pW2TPConf->GetState2Ows();
+        LogAssert(pOws);
+
+        const int MaxTagsPerWord = pOws->GetMaxOwsCount();
+        const int EosTag = pW2TPConf->GetEosTag();
+
+        m_W2TP.Initialize(pW2TPConf, pModelData->m_Ldb.GetInTr());
+        m_Tagger.Initialize(&m_W2TP, &(pModelData->m_T2P), &(pModelData->m_TT2P), EosTag, MaxTagsPerWord, &m_Alloc);
     }
 
-    // if correctly tokenized and the memory usage is within the limit
-    hashArrSize = ComputeHashes(pTokenizedStr, strLen, pHashArr, wordNgrams, bucketSize);
+    // the id of the model this state was made for
+    const uint64_t m_ModelId;
 
-    assert(hashArrSize == wordNgrams * tokenCount);
+    FAAllocator m_Alloc;
+    FAWordGuesser_prob_t < int > m_W2TP;
+    FAHmmTagger_l1 m_Tagger;
 
-    // clean up heap memo if allocated
-    if (maxOutputSize >= MAX_ALLOCA_SIZE)
+    // word boundaries and tags of the last call
+    std::vector < int > m_Words;
+    std::vector < int > m_Tags;
+};
+
+thread_local std::unique_ptr < FATaggerState > t_pTaggerState;
+
+
+//
+// Splits the text into words and assigns a POS tag to each word with the
+// HMM tagger of the model, the text is tagged as one sequence so it is
+// best to call this function for one sentence at a time.
+//
+// pTagsArr receives the tag ids (see the tagset of the model), pStartOffsets
+// and pEndOffsets (can be NULL) receive the UTF-8 byte offsets of the first
+// and last byte of each word.
+//
+// Returns the number of words, if the number is bigger than MaxWordCount
+// only the first MaxWordCount words are returned, -1 in case of an error.
+//
+extern "C"
+const int TextToTaggedWords(void * ModelPtr, const char * pInUtf8Str, int InUtf8StrByteCount,
+    int32_t * pTagsArr, int * pStartOffsets, int * pEndOffsets, const int MaxWordCount)
+{
+    // validate the parameters
+    if (NULL == ModelPtr || 0 > MaxWordCount || (0 < MaxWordCount && NULL == pTagsArr)) {
+        return -1;
+    }
+    FAModelAccess Model(ModelPtr);
+    const FAModelData * pModelData = Model.Get();
+    if (NULL == pModelData || !pModelData->m_fTagger) {
+        return -1;
+    }
+    if (0 == InUtf8StrByteCount) {
+        return 0;
+    }
+    if (0 > InUtf8StrByteCount || InUtf8StrByteCount > FALimits::MaxArrSize) {
+        return -1;
+    }
+    if (NULL == pInUtf8Str) {
+        return -1;
+    }
+
+    // use the built-in word-breaker, if the model does not have one
+    const FALexTools_t < int > * pWbd = &(pModelData->m_Wbd);
+    int IgnoreTag = pModelData->m_WbdConf.GetWbdTagIgnore();
+
+    if (!pModelData->m_fWbd) {
+
+        // check if the initilization is needed
+        FAEnsureInitialized();
+
+        pWbd = &g_Wbd;
+        IgnoreTag = WBD_IGNORE_TAG;
+    }
+
+    try {
+
+        // create the tagger state, if this thread has not used this model before
+        if (!t_pTaggerState || t_pTaggerState->m_ModelId != pModelData->m_Id) {
+            t_pTaggerState.reset();
+            t_pTaggerState.reset(new FATaggerState(pModelData));
+        }
+        FATaggerState * pState = t_pTaggerState.get();
+
+        // allocate buffer for UTF-32, word-breaking results
+        std::vector< int > utf32input(InUtf8StrByteCount);
+        int * pBuff = utf32input.data();
+        std::vector< int > utf32offsets(InUtf8StrByteCount);
+        int * pOffsets = utf32offsets.data();
+
+        // convert input to UTF-32
+        const int MaxBuffSize = ::FAStrUtf8ToArray(pInUtf8Str, InUtf8StrByteCount, pBuff, pOffsets, InUtf8StrByteCount);
+        if (MaxBuffSize <= 0 || MaxBuffSize > InUtf8StrByteCount) {
+            return -1;
+        }
+        // make sure the utf32input does not contain 'U+0000' elements
+        std::replace(pBuff, pBuff + MaxBuffSize, 0, 0x20);
+
+        // keep word boundary information here
+        std::vector< int > WbdRes(MaxBuffSize * 3);
+        int * pWbdRes = WbdRes.data();
+
+        // get the word breaking results
+        const int WbdOutSize = pWbd->Process(pBuff, MaxBuffSize, pWbdRes, MaxBuffSize * 3);
+        if (WbdOutSize > MaxBuffSize * 3 || 0 != WbdOutSize % 3) {
+            return -1;
+        }
+
+        // add all the words to the tagger
+        pState->m_Words.clear();
+
+        for (int i = 0; i < WbdOutSize; i += 3) {
+
+            // ignore tokens with IGNORE tag
+            const int Tag = pWbdRes[i];
+            if (IgnoreTag == Tag) {
+                continue;
+            }
+
+            const int From = pWbdRes[i + 1];
+            const int To = pWbdRes[i + 2];
+
+            // words longer than FALimits::MaxWordLen are cut, just like in the WBD
+            const int Len = std::min(To - From + 1, (int)FALimits::MaxWordLen);
+            pState->m_Tagger.AddWord(pBuff + From, Len);
+
+            pState->m_Words.push_back(From);
+            pState->m_Words.push_back(To);
+        }
+
+        const int WordCount = (int) pState->m_Words.size() / 2;
+        if (0 == WordCount) {
+            return 0;
+        }
+
+        // get the most likely tag sequence
+        pState->m_Tags.resize(WordCount);
+        const int TagCount = pState->m_Tagger.Process(pState->m_Tags.data(), WordCount);
+        if (TagCount != WordCount) {
+            return -1;
+        }
+
+        // copy the results
+        for (int i = 0; i < WordCount && i < MaxWordCount; ++i) {
+
+            const int From = pState->m_Words[2 * i];
+            const int To = pState->m_Words[(2 * i) + 1];
+
+            pTagsArr[i] = pState->m_Tags[i];
+
+            if (pStartOffsets) {
+                pStartOffsets[i] = pOffsets[From];
+            }
+            if (pEndOffsets) {
+                // offset of last UTF-32 character plus its length in bytes in the original string - 1
+                const int ToCharSize = ::FAUtf8Size(pInUtf8Str + pOffsets[To]);
+                pEndOffsets[i] = pOffsets[To] + (0 < ToCharSize ? ToCharSize - 1 : 0);
+            }
+        }
+
+        return WordCount;
+
+    } catch (...) {
+
+        // the state may be inconsistent after an error
+        t_pTaggerState.reset();
+        return -1;
+    }
+}
+
+//
+// Finds the phrases in one document and stores its spans starting from the SpanCount index,
+// spans which do not fit into MaxCount are counted but not stored.
+//
+// Returns the new span count or -1 in case of an error.
+//
+const int FATextToPhrasesImpl(const FAModelData * pModelData, const char * pInUtf8Str, int InUtf8StrByteCount,
+    int32_t * pPhraseIds, int * pStartOffsets, int * pEndOffsets, const int MaxCount, int SpanCount)
+{
+    if (0 == InUtf8StrByteCount) {
+        return SpanCount;
+    }
+    if (0 > InUtf8StrByteCount || InUtf8StrByteCount > FALimits::MaxArrSize) {
+        return -1;
+    }
+    if (NULL == pInUtf8Str) {
+        return -1;
+    }
+
+    // use the built-in word-breaker, if the model does not have one
+    const FALexTools_t < int > * pWbd = &(pModelData->m_Wbd);
+    int IgnoreTag = pModelData->m_WbdConf.GetWbdTagIgnore();
+
+    if (!pModelData->m_fWbd) {
+
+        // check if the initilization is needed
+        FAEnsureInitialized();
+
+        pWbd = &g_Wbd;
+        IgnoreTag = WBD_IGNORE_TAG;
+    }
+
+    // convert input to UTF-32 and get the word breaking results
+    std::vector< int > utf32input;
+    std::vector< int > utf32offsets;
+    std::vector< int > WbdRes;
+    int MaxBuffSize = 0;
+    int WbdOutSize = 0;
+    int ByteCount = 0;
+    bool fAll = false;
+
+    if (0 != FALexPrefix(*pWbd, FAWordCounter(), FA_AVG_WORD_SIZE,
+            pInUtf8Str, InUtf8StrByteCount, 0, utf32input, utf32offsets, &MaxBuffSize,
+            WbdRes, &WbdOutSize, &ByteCount, &fAll)) {
+        return -1;
+    }
+    const int * pBuff = utf32input.data();
+    const int * pOffsets = utf32offsets.data();
+    const int * pWbdRes = WbdRes.data();
+
+    // the words and their vocabulary ids, -1 for unknown words
+    std::vector< int > Words;
+    std::vector< int > Ids;
+
+    for (int i = 0; i < WbdOutSize; i += 3) {
+
+        // ignore tokens with IGNORE tag
+        const int Tag = pWbdRes[i];
+        if (IgnoreTag == Tag) {
+            continue;
+        }
+
+        const int From = pWbdRes[i + 1];
+        const int To = pWbdRes[i + 2];
+
+        Words.push_back(From);
+        Words.push_back(To);
+        Ids.push_back(pModelData->m_Vocab.GetInfoId(pBuff + From, To - From + 1));
+    }
+
+    // find the phrases over the word ids
+    const int WordCount = (int) Ids.size();
+    std::vector< int > MweRes(WordCount * 3);
+
+    const int MweOutSize = pModelData->m_Mwe.Process(Ids.data(), WordCount, MweRes.data(), WordCount * 3);
+    if (0 > MweOutSize || 0 != MweOutSize % 3) {
+        return -1;
+    }
+
+    // make the spans, a phrase or a single word each
+    int j = 0;
+
+    for (int i = 0; i < WordCount; ++i) {
+
+        int PhraseId = -1;
+        int Last = i;
+
+        if (j < MweOutSize && i == MweRes[j + 1]) {
+            PhraseId = MweRes[j];
+            Last = MweRes[j + 2];
+            j += 3;
+        }
+
+        if (SpanCount < MaxCount) {
+
+            const int From = Words[2 * i];
+            const int To = Words[(2 * Last) + 1];
+
+            pPhraseIds[SpanCount] = PhraseId;
+
+            if (pStartOffsets) {
+                pStartOffsets[SpanCount] = pOffsets[From];
+            }
+            if (pEndOffsets) {
+                // offset of last UTF-32 character plus its length in bytes in the original string - 1
+                const int ToCharSize = ::FAUtf8Size(pInUtf8Str + pOffsets[To]);
+                pEndOffsets[SpanCount] = pOffsets[To] + (0 < ToCharSize ? ToCharSize - 1 : 0);
+            }
+        }
+        SpanCount++;
+
+        // skip the middle words of the phrase
+        i = Last;
+    }
+
+    return SpanCount;
+}
+
+
+//
+// Finds the phrases (multi-word expressions) of the model's [mwe] dictionary in the text.
+// The words are looked up in the [vocab] section, so the model should have both, and the
+// phrases are matched over the word ids by the left-most-longest algorithm.
+//
+// The output is the stream of spans, each span is either a phrase or a single word which
+// is not a part of any phrase:
+//
+// pPhraseIds - array of phrase ids with upto MaxCount elements, -1 for a single word
+// pStartOffsets - array of integers (first byte of each span) with upto MaxCount elements, can be NULL
+// pEndOffsets - array of integers (last byte of each span) with upto MaxCount elements, can be NULL
+//
+// Returns the number of spans or -1 in case of an error, if the number is bigger than
+// MaxCount then only first MaxCount spans are stored.
+//
+extern "C"
+const int TextToPhrases(void * ModelPtr, const char * pInUtf8Str, int InUtf8StrByteCount,
+    int32_t * pPhraseIds, int * pStartOffsets, int * pEndOffsets, const int MaxCount)
+{
+    // validate the parameters
+    if (NULL == ModelPtr || 0 > MaxCount || (0 < MaxCount && NULL == pPhraseIds)) {
+        return -1;
+    }
+    FAModelAccess Model(ModelPtr);
+    const FAModelData * pModelData = Model.Get();
+    if (NULL == pModelData || !pModelData->m_fVocab || !pModelData->m_fMwe) {
+        return -1;
+    }
+
+    return FATextToPhrasesImpl(pModelData, pInUtf8Str, InUtf8StrByteCount,
+        pPhraseIds, pStartOffsets, pEndOffsets, MaxCount, 0);
+}
+
+
+//
+// Same as TextToPhrases but for a batch of documents laid out as an Arrow string column:
+// the document i is the bytes from pDocOffsets[i] to pDocOffsets[i + 1] - 1 of pInUtf8Str.
+//
+// The spans of all the documents are stored one after another, pDocSpanOffsets gets DocCount + 1
+// elements, the spans of the document i are from pDocSpanOffsets[i] to pDocSpanOffsets[i + 1] - 1,
+// the offsets of the spans are from the beginning of their document.
+//
+// Returns the total number of spans or -1 in case of an error (e.g. one of the documents is not
+// a valid UTF-8), if the number is bigger than MaxCount then only first MaxCount spans are stored,
+// pDocSpanOffsets is filled in anyway.
+//
+extern "C"
+const int TextToPhrasesBatch(void * ModelPtr, const char * pInUtf8Str, const int * pDocOffsets, const int DocCount,
+    int * pDocSpanOffsets, int32_t * pPhraseIds, int * pStartOffsets, int * pEndOffsets, const int MaxCount)
+{
+    // validate the parameters
+    if (NULL == ModelPtr || 0 > DocCount || NULL == pDocOffsets || NULL == pDocSpanOffsets ||
+        0 > MaxCount || (0 < MaxCount && NULL == pPhraseIds)) {
+        return -1;
+    }
+    for (int i = 0; i < DocCount; ++i) {
+        if (pDocOffsets[i] < 0 || pDocOffsets[i] > pDocOffsets[i + 1]) {
+            return -1;
+        }
+    }
+    FAModelAccess Model(ModelPtr);
+    const FAModelData * pModelData = Model.Get();
+    if (NULL == pModelData || !pModelData->m_fVocab || !pModelData->m_fMwe) {
+        return -1;
+    }
+
+    int SpanCount = 0;
+    pDocSpanOffsets[0] = 0;
+
+    for (int i = 0; i < DocCount; ++i) {
+
+        // the offsets are from the beginning of the document
+        SpanCount = FATextToPhrasesImpl(pModelData, pInUtf8Str + pDocOffsets[i], pDocOffsets[i + 1] - pDocOffsets[i],
+            pPhraseIds, pStartOffsets, pEndOffsets, MaxCount, SpanCount);
+        if (0 > SpanCount) {
+            return -1;
+        }
+        pDocSpanOffsets[i + 1] = SpanCount;
+    }
+
+    return SpanCount;
+}
+
+
+//
+// Per-thread state of the fuzzy lookup, the lookup object keeps the results of
+// the last call, the state is reused as long as the thread calls it with the same model.
+//
+struct FAFuzzyState {
+
+    explicit FAFuzzyState (const FAModelData * pModelData) :
+        m_ModelId (pModelData->m_Id),
+        m_Lookup (&m_Alloc)
     {
-        delete[]  pTokenizedStr;
+        m_Lookup.SetConf(&(pModelData->m_VocabConf));
     }
 
-    return hashArrSize;
+    // the id of the model this state was made for
+    const uint64_t m_ModelId;
+
+    FAAllocator m_Alloc;
+    FAFuzzyLookup_t < int > m_Lookup;
+};
+
+thread_local std::unique_ptr < FAFuzzyState > t_pFuzzyState;
+
+
+//
+// Finds the words of the model's vocabulary within MaxDist (0, 1 or 2) edits from
+// the input word, e.g. for spelling correction. The vocabulary delta, if any, is
+// not searched.
+//
+// pIds - array of vocabulary ids with upto MaxCount elements
+// pDists - array of edit distances with upto MaxCount elements, can be NULL
+// pOutUtf8Str - receives ' ' delimited UTF-8 words, normalized as the vocabulary keeps
+//  them, can be NULL, if the words do not fit into MaxOutUtf8StrByteCount bytes (including
+//  the terminating 0) the function fails
+//
+// Results are sorted by the distance and then by the id, returns the
+// number of results upto MaxCount or -1 in case of an error.
+//
+extern "C"
+const int FuzzyLookup(void * ModelPtr, const char * pInUtf8Str, int InUtf8StrByteCount, const int MaxDist,
+    int32_t * pIds, int * pDists, char * pOutUtf8Str, const int MaxOutUtf8StrByteCount, const int MaxCount)
+{
+    // validate the parameters
+    if (NULL == ModelPtr || 0 > MaxCount || (0 < MaxCount && NULL == pIds) ||
+        0 > MaxDist || FAFuzzyLookup_t < int >::MaxEditDist < MaxDist) {
+        return -1;
+    }
+    FAModelAccess Model(ModelPtr);
+    const FAModelData * pModelData = Model.Get();
+    if (NULL == pModelData || !pModelData->m_fVocab) {
+        return -1;
+    }
+    if (0 >= InUtf8StrByteCount || NULL == pInUtf8Str) {
+        return -1;
+    }
+
+    // convert input to UTF-32, words longer than FALimits::MaxWordLen are not looked up
+    int Word[FALimits::MaxWordLen + 1];
+    const int WordLen = ::FAStrUtf8ToArray(pInUtf8Str, InUtf8StrByteCount, Word, FALimits::MaxWordLen + 1);
+    if (0 >= WordLen || FALimits::MaxWordLen < WordLen) {
+        return -1;
+    }
+
+    try {
+
+        if (!t_pFuzzyState || t_pFuzzyState->m_ModelId != pModelData->m_Id) {
+            t_pFuzzyState.reset();
+            t_pFuzzyState.reset(new FAFuzzyState(pModelData));
+        }
+        FAFuzzyLookup_t < int > * pLookup = &(t_pFuzzyState->m_Lookup);
+
+        const int Count = pLookup->Process(Word, WordLen, MaxDist, MaxCount);
+        if (0 > Count) {
+            return -1;
+        }
+
+        int OutSize = 0;
+
+        for (int i = 0; i < Count; ++i) {
 
+            pIds[i] = pLookup->GetId(i);
+
+            if (pDists) {
+                pDists[i] = pLookup->GetDist(i);
+            }
+            if (pOutUtf8Str) {
+
+                const int * pWord;
+                const int Len = pLookup->GetWord(i, &pWord);
+
+                // the delimiter or the terminating 0 always follows the word
+                const int MaxSize = MaxOutUtf8StrByteCount - OutSize - 1;
+                if (0 >= MaxSize) {
+                    return -1;
+                }
+                const int Size = ::FAArrayToStrUtf8(pWord, Len, pOutUtf8Str + OutSize, MaxSize);
+                if (0 >= Size || MaxSize < Size) {
+                    return -1;
+                }
+                OutSize += Size;
+                pOutUtf8Str[OutSize++] = ' ';
+            }
+        }
+        if (pOutUtf8Str) {
+            if (0 < OutSize) {
+                OutSize--;
+            } else if (0 >= MaxOutUtf8StrByteCount) {
+                return -1;
+            }
+            pOutUtf8Str[OutSize] = 0;
+        }
+
+        return Count;
+
+    } catch (...) {
+
+        t_pFuzzyState.reset();
+        return -1;
+    }
 }
@@ -14,11 +14,16 @@
 #include "FAStringTokenizer.h"
 #include "FAMultiMap_pack_fixed.h"
 #include "FAImageDump.h"
+#include "FAStrAligner.h"
 #include "FAException.h"
 
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <memory>
 
 
 const char * __PROG__ = "";
@@ -54,21 +59,50 @@ bool g_no_epsilon = false;
 bool g_no_output = false;
 bool g_no_process = false;
 
+int g_Band = 8;
+int g_Threads = 1;
+
 const int MaxBuffSize = 1024;
+const int MaxOutStr = (FAUtf8Const::MAX_CHAR_SIZE * MaxBuffSize * 4) + 1;
+
+// the number of lines read at once per thread
+const int LinesPerThread = 4096;
+
+
+///
+/// Per-thread data: the aligner with its scratch memory and the buffers.
+///
+class FAAlignWorker {
+
+public:
+    FAAlignWorker () :
+        m_aligner (&g_alloc)
+    {
+        m_aligner.SetGap1 (g_Gap1);
+        m_aligner.SetGap2 (g_Gap2);
+        m_aligner.SetNotEqual (g_NotEqual);
+        m_aligner.SetNotEqual2 (g_NotEqual2);
+        m_aligner.SetEqual2 (g_Equal2);
+        m_aligner.SetMinPos (g_MinPos);
+        m_aligner.SetReverse (g_rev);
+        m_aligner.SetFiller (g_Filler);
+        m_aligner.SetBand (g_Band);
+    }
 
-int g_Buff1 [MaxBuffSize];
-int g_Count1;
+public:
+    FAStrAligner m_aligner;
 
-int g_Buff2 [MaxBuffSize];
-int g_Count2;
+    int m_Buff1 [MaxBuffSize];
+    int m_Count1;
 
-int g_OutBuff [4 * MaxBuffSize];
-int g_OutCount;
+    int m_Buff2 [MaxBuffSize];
+    int m_Count2;
 
-int g_D [MaxBuffSize][MaxBuffSize];
+    int m_OutBuff [4 * MaxBuffSize];
+    int m_OutCount;
 
-const int MaxOutStr = (FAUtf8Const::MAX_CHAR_SIZE * MaxBuffSize * 4) + 1;
-char OutStr [MaxOutStr];
+    char m_OutStr [MaxOutStr];
+};
 
 
 void usage ()
@@ -126,6 +160,13 @@ right-string character, if there is a gap the filler character is used.\n\
 \n\
   --charmap=<mmap-dump> - applies a custom character normalization procedure\n\
     according to the <mmap-dump>, the dump should be in \"fixed\" format\n\
+\n\
+  --band=N - computes the score matrix within the diagonal band of N cells\n\
+    first, the band is widened until the result is exact, 0 computes the\n\
+    whole matrix, 8 is used by default\n\
+\n\
+  --threads=N - the number of threads to align the lines, the output order\n\
+    is the same as the input one, 1 is used by default\n\
 \n\
  Note: the scrore of 1 is used for equal characters\n\
 \n\
@@ -209,121 +250,207 @@ void process_args (int& argc, char**& argv)
             g_ignore_case = true;
             continue;
         }
+        if (0 == strncmp ("--band=", *argv, 7)) {
+            g_Band = atoi (&((*argv) [7]));
+            continue;
+        }
+        if (0 == strncmp ("--threads=", *argv, 10)) {
+            g_Threads = atoi (&((*argv) [10]));
+            continue;
+        }
     }
 }
 
 
-inline static const int Score (const int IwPos, const int Iw, const int Ow)
+///
+/// Aligns one input line, Out gets the output line (including '\n') or
+/// stays empty if nothing is printed.
+///
+static void ProcessLine (
+        FAAlignWorker * pW,
+        const std::string & line,
+        std::string & Out
+    )
 {
-    DebugLogAssert (0 <= g_Count1 - IwPos);
+    DebugLogAssert (pW);
 
-    bool fLeft = IwPos <= g_MinPos;
-    if (g_rev) {
-        fLeft = g_Count1 - IwPos - 1 <= g_MinPos;
-    }
+    Out.clear ();
 
-    if (fLeft) {
-        return Iw == Ow ? g_Equal2 : g_NotEqual2 ;
-    } else {
-        return Iw == Ow ? 1 : g_NotEqual;
+    const char * pLine = line.c_str ();
+    int LineLen = (const int) line.length ();
+
+    if (0 < LineLen) {
+        DebugLogAssert (pLine);
+        if (0x0D == (unsigned char) pLine [LineLen - 1])
+            LineLen--;
+    }
+    if (0 >= LineLen) {
+        return;
     }
-}
 
-static void Process ()
-{
-    int i, j, k;
+    /// read the input
 
-    if (g_rev) {
-        for (k = 0; k < g_Count1 / 2; ++k) {
-            const int T = g_Buff1 [k];
-            g_Buff1 [k] = g_Buff1 [g_Count1 - k - 1];
-            g_Buff1 [g_Count1 - k - 1] = T;
-        }
-        for (k = 0; k < g_Count2 / 2; ++k) {
-            const int T = g_Buff2 [k];
-            g_Buff2 [k] = g_Buff2 [g_Count2 - k - 1];
-            g_Buff2 [g_Count2 - k - 1] = T;
-        }
-    }
+    FAStringTokenizer tokenizer;
+    tokenizer.SetSpaces ("\t");
+    tokenizer.SetString (pLine, LineLen);
+
+    const char * pStr1 = NULL;
+    int Len1 = 0;
+    tokenizer.GetNextStr (&pStr1, &Len1);
 
-    /// g_D [i][j] keeps an alignament score of str2 [0..i-1] with str1 [0..j-1]
+    const char * pStr2 = NULL;
+    int Len2 = 0;
+    tokenizer.GetNextStr (&pStr2, &Len2);
 
-    g_D [0][0] = 0;
+    FAAssert (pStr1 && 0 < Len1 && pStr2 && 0 < Len2, FAMsg::IOError);
+
+    int * pBuff1 = pW->m_Buff1;
+    int * pBuff2 = pW->m_Buff2;
+    int * pOutBuff = pW->m_OutBuff;
+    char * pOutStr = pW->m_OutStr;
+
+    int Count1 = ::FAStrUtf8ToArray (pStr1, Len1, pBuff1, MaxBuffSize);
+    // normalize the case, if needed
+    if (g_ignore_case) {
+        ::FAUtf32StrLower (pBuff1, Count1);
+    }
+    // normalize a word
+    if (g_pCharMapFile) {
+        Count1 = ::FANormalizeWord (pBuff1, Count1, \
+            pBuff1, MaxBuffSize, &g_charmap);
+    }
+    FAAssert (0 < Count1 && MaxBuffSize > Count1, FAMsg::IOError);
 
-    for (j = 0; j < g_Count1; ++j) {
-        g_D [0][j + 1] = (j + 1) * g_Gap2;
+    int Count2 = ::FAStrUtf8ToArray (pStr2, Len2, pBuff2, MaxBuffSize);
+    // normalize the case, if needed
+    if (g_ignore_case) {
+        ::FAUtf32StrLower (pBuff2, Count2);
     }
-    for (i = 0; i < g_Count2; ++i) {
-        g_D [i + 1][0] = (i + 1) * g_Gap1;
+    // normalize a word
+    if (g_pCharMapFile) {
+        Count2 = ::FANormalizeWord (pBuff2, Count2, \
+            pBuff2, MaxBuffSize, &g_charmap);
     }
+    FAAssert (0 < Count2 && MaxBuffSize > Count2, FAMsg::IOError);
+
+    pW->m_Count1 = Count1;
+    pW->m_Count2 = Count2;
+
+    if (g_no_process)
+        return;
+
+    /// make the alignment
+
+    const int OutCount = pW->m_aligner.Process (pBuff1, Count1, \
+        pBuff2, Count2, pOutBuff, 4 * MaxBuffSize);
+    FAAssert (0 < OutCount, FAMsg::InternalError);
+
+    pW->m_OutCount = OutCount;
+
+    if (g_no_output)
+        return;
+
+    /// print the results
+
+    if (false == g_no_epsilon) {
+
+        const int OutLen = ::FAArrayToStrUtf8 (pOutBuff, \
+            OutCount, pOutStr, MaxOutStr);
+        FAAssert (0 < OutLen && OutLen < MaxOutStr, FAMsg::IOError);
+        pOutStr [OutLen] = 0;
+
+    } else {
 
-	for (i = 1; i < g_Count2 + 1; ++i) {
-	    for (j = 1;  j < g_Count1 + 1; ++j) {
+        char * pOut = pOutStr;
 
-            const int S1 = g_D [i - 1][j - 1] + \
-                Score (j - 1, g_Buff1 [j - 1], g_Buff2 [i - 1]);
-            const int S2 = g_D [i][j - 1] + g_Gap2;
-            const int S3 = g_D [i - 1][j] + g_Gap1;
+        if (-1 != g_spec_l_anchor) {
+            pOut = ::FAIntToUtf8 (g_spec_l_anchor, pOut, \
+                                    FAUtf8Const::MAX_CHAR_SIZE);
+            FAAssert (pOut, FAMsg::IOError);
+            *pOut++ = ' ';
+            pOut = ::FAIntToUtf8 (g_Filler2, pOut, \
+                                    FAUtf8Const::MAX_CHAR_SIZE);
+            FAAssert (pOut, FAMsg::IOError);
+        }
+
+        bool fStart = true;
+        int PrevIw = -1;
+
+        for (int i = 0; i < OutCount; ++i) {
+
+            int C = pOutBuff [i];
+
+            // a character from string 1
+            if (0 == i % 2) {
+
+                if (g_Filler == C) {
+                    continue;
+                }
+
+                if (!fStart) {
+                    *pOut++ = ' ';
+                }
+                fStart = false;
+
+                PrevIw = C;
+                pOut = ::FAIntToUtf8 (C, pOut, \
+                                      FAUtf8Const::MAX_CHAR_SIZE);
+                FAAssert (pOut, FAMsg::IOError);
+                *pOut++ = ' ';
 
-            if (S1 >= S2 && S1 >= S3) {
-                g_D [i][j] = S1;
-            } else if (S2 >= S1 && S2 >= S3) {
-                g_D [i][j] = S2;
+            // a character from string 2
             } else {
-                g_D [i][j] = S3;
+
+                // if the output is g_Filler and there will be
+                // something attached to the left, then don't
+                // print g_Filler2
+                if (g_Filler == C && i + 1 < OutCount && \
+                    g_Filler == pOutBuff [i + 1]) {
+                    continue;
+                }
+
+                if (C == PrevIw) {
+                    C = g_Filler2;
+                }
+
+                pOut = ::FAIntToUtf8 (C, pOut, \
+                                      FAUtf8Const::MAX_CHAR_SIZE);
+                FAAssert (pOut, FAMsg::IOError);
+                fStart = false;
             }
-        }
-    }
 
-    i = g_Count2;
-    j = g_Count1;
-
-    const int n = g_rev ? 1 : 0;
-    const int m = g_rev ? 0 : 1;
-
-    g_OutCount = 0;
-
-    while (i > 0 && j > 0) {
-
-        if (g_D [i][j] - Score (j - 1, g_Buff1 [j - 1], g_Buff2 [i - 1]) == \
-            g_D [i - 1][j - 1]) {
-            g_OutBuff [g_OutCount + n] = g_Buff2 [i - 1];
-            g_OutBuff [g_OutCount + m] = g_Buff1 [j - 1];
-            g_OutCount += 2;
-            j--;
-            i--;
-        } else if (g_D [i][j] - g_Gap2 == g_D [i][j - 1]) {
-            g_OutBuff [g_OutCount + n] = g_Filler;
-            g_OutBuff [g_OutCount + m] = g_Buff1 [j - 1];
-            g_OutCount += 2;
-            j--;
-        } else {
-            DebugLogAssert (g_D [i][j] - g_Gap1 == g_D [i - 1][j]);
-            g_OutBuff [g_OutCount + n] = g_Buff2 [i - 1];
-            g_OutBuff [g_OutCount + m] = g_Filler;
-            g_OutCount += 2;
-            i--;
-        }
-    } // of while (i > 0 && j > 0) ...
+        } // of for (int i = 0; ...
 
-    while (i > 0) {
-        g_OutBuff [g_OutCount + n] = g_Buff2 [i - 1];
-        g_OutBuff [g_OutCount + m] = g_Filler;
-        g_OutCount += 2;
-        i--;
-    }
-    while (j > 0) {
-        g_OutBuff [g_OutCount + n] = g_Filler;
-        g_OutBuff [g_OutCount + m] = g_Buff1 [j - 1];
-        g_OutCount += 2;
-        j--;
+        *pOut = 0;
     }
 
-    if (!g_rev) {
-        for (k = 0; k < g_OutCount / 2; ++k) {
-            const int T = g_OutBuff [k];
-            g_OutBuff [k] = g_OutBuff [g_OutCount - k - 1];
-            g_OutBuff [g_OutCount - k - 1] = T;
+    Out.assign (pOutStr);
+    Out.push_back ('\n');
+}
+
+
+///
+/// Aligns lines ThreadId, ThreadId + ThreadCount, ... of the chunk, an error
+/// is kept with the line it has happened at.
+///
+static void ProcessLines (
+        FAAlignWorker * pW,
+        const int ThreadId,
+        const int ThreadCount,
+        const std::vector < std::string > * pLines,
+        std::vector < std::string > * pOuts,
+        std::vector < std::exception_ptr > * pErrors
+    )
+{
+    DebugLogAssert (pW && pLines && pOuts && pErrors);
+
+    const int LineCount = (int) pLines->size ();
+
+    for (int i = ThreadId; i < LineCount; i += ThreadCount) {
+        try {
+            ProcessLine (pW, (*pLines) [i], (*pOuts) [i]);
+        } catch (...) {
+            (*pErrors) [i] = std::current_exception ();
         }
     }
 }
@@ -362,154 +489,69 @@ int __cdecl main (int argc, char ** argv)
             g_charmap.SetImage (pImg);
         }
 
-        FAStringTokenizer tokenizer;
-        tokenizer.SetSpaces ("\t");
+        if (1 > g_Threads) {
+            g_Threads = 1;
+        }
 
-        while (!(g_pIs->eof ())) {
+        std::vector < std::unique_ptr < FAAlignWorker > > workers (g_Threads);
+        for (int t = 0; t < g_Threads; ++t) {
+            workers [t].reset (new FAAlignWorker ());
+        }
 
-            if (!std::getline (*g_pIs, line))
-                break;
+        const int MaxChunkSize = g_Threads * LinesPerThread;
+
+        std::vector < std::string > lines;
+        std::vector < std::string > outs;
+        std::vector < std::exception_ptr > errors;
+        std::vector < std::thread > threads;
 
-            LineNum++;
+        while (!(g_pIs->eof ())) {
 
-            const char * pLine = line.c_str ();
-            int LineLen = (const int) line.length ();
+            // read the next chunk of lines
+            lines.clear ();
 
-            if (0 < LineLen) {
-                DebugLogAssert (pLine);
-                if (0x0D == (unsigned char) pLine [LineLen - 1])
-                    LineLen--;
+            while ((int) lines.size () < MaxChunkSize) {
+                if (!std::getline (*g_pIs, line))
+                    break;
+                lines.push_back (line);
             }
-            if (0 < LineLen) {
 
-                /// read the input
+            const int LineCount = (int) lines.size ();
+            if (0 == LineCount)
+                break;
 
-                tokenizer.SetString (pLine, LineLen);
+            outs.assign (LineCount, std::string ());
+            errors.assign (LineCount, std::exception_ptr ());
 
-                const char * pStr1 = NULL;
-                int Len1 = 0;
-                tokenizer.GetNextStr (&pStr1, &Len1);
+            // align the chunk
+            if (1 == g_Threads) {
 
-                const char * pStr2 = NULL;
-                int Len2 = 0;
-                tokenizer.GetNextStr (&pStr2, &Len2);
+                ProcessLines (workers [0].get (), 0, 1, &lines, &outs, &errors);
 
-                FAAssert (pStr1 && 0 < Len1 && pStr2 && 0 < Len2, \
-                    FAMsg::IOError);
+            } else {
 
-                g_Count1 = \
-                    ::FAStrUtf8ToArray (pStr1, Len1, g_Buff1, MaxBuffSize);
-                // normalize the case, if needed
-                if (g_ignore_case) {
-                    ::FAUtf32StrLower (g_Buff1, g_Count1);
-                }
-                // normalize a word
-                if (g_pCharMapFile) {
-                    g_Count1 = ::FANormalizeWord (g_Buff1, g_Count1, \
-                        g_Buff1, MaxBuffSize, &g_charmap);
+                threads.clear ();
+                for (int t = 0; t < g_Threads; ++t) {
+                    threads.push_back (std::thread (ProcessLines, \
+                        workers [t].get (), t, g_Threads, &lines, &outs, \
+                        &errors));
                 }
-                FAAssert (0 < g_Count1 && MaxBuffSize > g_Count1, \
-                    FAMsg::IOError);
-
-                g_Count2 = \
-                    ::FAStrUtf8ToArray (pStr2, Len2, g_Buff2, MaxBuffSize);
-                // normalize the case, if needed
-                if (g_ignore_case) {
-                    ::FAUtf32StrLower (g_Buff2, g_Count2);
+                for (int t = 0; t < g_Threads; ++t) {
+                    threads [t].join ();
                 }
-                // normalize a word
-                if (g_pCharMapFile) {
-                    g_Count2 = ::FANormalizeWord (g_Buff2, g_Count2, \
-                        g_Buff2, MaxBuffSize, &g_charmap);
-                }
-                FAAssert (0 < g_Count2 && MaxBuffSize > g_Count2, \
-                    FAMsg::IOError);
-
-                if (g_no_process)
-                    continue;
-
-                /// make the alignment
-
-                Process ();
-
-                if (g_no_output)
-                    continue;
-
-                /// print the results
-
-                if (false == g_no_epsilon) {
-
-                    const int OutLen = ::FAArrayToStrUtf8 (g_OutBuff, \
-                        g_OutCount, OutStr, MaxOutStr);
-                    FAAssert (0 < OutLen && OutLen < MaxOutStr, FAMsg::IOError);
-                    OutStr [OutLen] = 0;
-
-                } else {
-
-                    char * pOut = OutStr;
-
-                    if (-1 != g_spec_l_anchor) {
-                        pOut = ::FAIntToUtf8 (g_spec_l_anchor, pOut, \
-                                                FAUtf8Const::MAX_CHAR_SIZE);
-                        FAAssert (pOut, FAMsg::IOError);
-                        *pOut++ = ' ';
-                        pOut = ::FAIntToUtf8 (g_Filler2, pOut, \
-                                                FAUtf8Const::MAX_CHAR_SIZE);
-                        FAAssert (pOut, FAMsg::IOError);
-                    }
-
-                    bool fStart = true;
-                    int PrevIw = -1;
-
-                    for (int i = 0; i < g_OutCount; ++i) {
-
-                        int C = g_OutBuff [i];
-
-                        // a character from string 1
-                        if (0 == i % 2) {
-
-                            if (g_Filler == C) {
-                                continue;
-                            }
-
-                            if (!fStart) {
-                                *pOut++ = ' ';
-                            }
-                            fStart = false;
-
-                            PrevIw = C;
-                            pOut = ::FAIntToUtf8 (C, pOut, \
-                                                  FAUtf8Const::MAX_CHAR_SIZE);
-                            FAAssert (pOut, FAMsg::IOError);
-                            *pOut++ = ' ';
-
-                        // a character from string 2
-                        } else {
-
-                            // if the output is g_Filler and there will be
-                            // something attached to the left, then don't
-                            // print g_Filler2
-                            if (g_Filler == C && i + 1 < g_OutCount && \
-                                g_Filler == g_OutBuff [i + 1]) {
-                                continue;
-                            }
-
-                            if (C == PrevIw) {
-                                C = g_Filler2;
-                            }
+            }
 
-                            pOut = ::FAIntToUtf8 (C, pOut, \
-                                                  FAUtf8Const::MAX_CHAR_SIZE);
-                            FAAssert (pOut, FAMsg::IOError);
-                            fStart = false;
-                        }
+            // print the results in the input order
+            for (int i = 0; i < LineCount; ++i) {
 
-                    } // of for (int i = 0; ...
+                LineNum++;
 
-                    *pOut = 0;
+                if (errors [i]) {
+                    line = lines [i];
+                    std::rethrow_exception (errors [i]);
                 }
 
-                (*g_pOs) << OutStr << '\n';
+                (*g_pOs) << outs [i];
             }
 
         } // of while (!(g_pIs->eof ())) ...
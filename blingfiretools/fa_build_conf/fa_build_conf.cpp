@@ -106,6 +106,10 @@ void SetupConfParams ()
     g_parser.AddSection ("n2tp", FAFsmConst::FUNC_N2TP);
     g_parser.AddSection ("lad", FAFsmConst::FUNC_LAD);
     g_parser.AddSection ("u2l", FAFsmConst::FUNC_U2L);
+    g_parser.AddSection ("wordpiece", FAFsmConst::FUNC_WORDPIECE);
+    g_parser.AddSection ("vocab", FAFsmConst::FUNC_VOCAB);
+    g_parser.AddSection ("mwe", FAFsmConst::FUNC_MWE);
+    g_parser.AddSection ("wre-cascade", FAFsmConst::FUNC_WRE_CASCADE);
 
     // parameters
     g_parser.AddNumParam ("trim", FAFsmConst::PARAM_TRIM);
@@ -0,0 +1,1081 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "FAConfig.h"
+#include "FAUtils.h"
+#include "FAAllocator.h"
+#include "FAMergeDumps.h"
+#include "FAException.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+const char * __PROG__ = "";
+
+int g_Threads = 1;
+bool g_Force = false;
+bool g_DryRun = false;
+bool g_Quiet = false;
+const char * g_pTarget = NULL;
+const char * g_pMakefile = "Makefile.gnu";
+
+// command line variables, override the makefile
+std::map < std::string, std::string > g_overrides;
+
+
+void usage () {
+
+  std::cout << "\n\
+Usage: fa_build_ldb [OPTIONS] [var=value [var=value [...]]]\n\
+\n\
+This program compiles an LDB the same way as ldbsrc/Makefile.gnu does:\n\
+\n\
+  make -f Makefile.gnu lang=<lang> [ mode=<mode> ] all\n\
+\n\
+It reads the variables and the rules of the makefile, builds the graph of\n\
+the build steps needed for $(OUTPUT) and runs the independent steps\n\
+concurrently. Intermediate files are kept in $(tmpdir), a step is skipped if\n\
+the hash of its command and of the contents of its input files is the same\n\
+as at the time the step has been run last (see $(tmpdir)/ldb.build.<mode>.txt),\n\
+so only steps affected by the changed sources are rerun. The fa_* tools\n\
+should be in the PATH. The final merge of the dumps is done in-process.\n\
+\n\
+  var=value - sets up a variable, e.g. lang=wbd, mode=small, dstdir=ldb,\n\
+    the command line variables override the makefile\n\
+\n\
+  --makefile=<file> - the makefile with the rules, Makefile.gnu is used\n\
+    by default\n\
+\n\
+  --threads=N - the maximum number of steps run at once, 1 is used by default\n\
+\n\
+  --target=<file> - builds the <file> only, $(OUTPUT) is built by default\n\
+\n\
+  --force - reruns all the steps regardless of the hashes\n\
+\n\
+  --dry-run - prints the commands of all the steps in the build order,\n\
+    does not run them\n\
+\n\
+  --quiet - does not print the commands\n\
+\n\
+";
+}
+
+
+void process_args (int& argc, char**& argv)
+{
+    for (; argc--; ++argv){
+
+        if (!strcmp ("--help", *argv)) {
+            usage ();
+            exit (0);
+        }
+        if (0 == strncmp ("--threads=", *argv, 10)) {
+            g_Threads = atoi (&((*argv) [10]));
+            if (1 > g_Threads) {
+                g_Threads = 1;
+            }
+            continue;
+        }
+        if (0 == strncmp ("--makefile=", *argv, 11)) {
+            g_pMakefile = &((*argv) [11]);
+            continue;
+        }
+        if (0 == strncmp ("--target=", *argv, 9)) {
+            g_pTarget = &((*argv) [9]);
+            continue;
+        }
+        if (!strcmp ("--force", *argv)) {
+            g_Force = true;
+            continue;
+        }
+        if (!strcmp ("--dry-run", *argv)) {
+            g_DryRun = true;
+            continue;
+        }
+        if (!strcmp ("--quiet", *argv)) {
+            g_Quiet = true;
+            continue;
+        }
+        const char * pEq = strchr (*argv, '=');
+        if (NULL != pEq && '-' != **argv && pEq != *argv) {
+            const std::string Name (*argv, pEq - *argv);
+            g_overrides [Name] = std::string (pEq + 1);
+            continue;
+        }
+        std::cerr << "ERROR: Unknown parameter \"" << *argv \
+            << "\" in program " << __PROG__ << '\n';
+        exit (1);
+    }
+}
+
+
+// splits an expanded list of files by spaces
+void Split (const std::string & Str, std::vector < std::string > * pList)
+{
+    std::istringstream is (Str);
+    std::string Item;
+    while (is >> Item) {
+        pList->push_back (Item);
+    }
+}
+
+
+///
+/// An explicit rule of the makefile. The targets and the prerequisites are
+/// expanded when the rule is read, the recipe is expanded when it is used.
+///
+
+struct FARule {
+    // targets
+    std::vector < std::string > m_outs;
+    // prerequisites
+    std::vector < std::string > m_ins;
+    // unexpanded recipe, lines are joined with " && "
+    std::string m_cmd;
+};
+
+
+///
+/// Reads the variables and the explicit rules of ldbsrc/Makefile.gnu, the
+/// subset of make syntax it uses is supported:
+///
+///   "name = value", "name := value", "name += value", "include file",
+///   "ifeq (a, b)", "ifneq (a, b)", "else", "endif", "targets: prerequisites"
+///   followed by the recipe lines starting with TAB, "\" continues a line,
+///   "#" starts a comment line, "$(name)" is expanded, "$$" is a literal "$",
+///   "$@", "$<" and "$^" are expanded in recipes.
+///
+
+class FAMakefile {
+
+public:
+    FAMakefile () :
+        m_RuleIdx (-1)
+    {}
+
+public:
+    // sets up a variable unless it is overridden from the command line
+    void Set (const std::string & Name, const std::string & Value)
+    {
+        if (g_overrides.end () == g_overrides.find (Name)) {
+            m_vars [Name] = Value;
+        }
+    }
+
+    // returns unexpanded value or an empty string
+    const std::string Get (const std::string & Name) const
+    {
+        std::map < std::string, std::string >::const_iterator it = \
+            g_overrides.find (Name);
+        if (g_overrides.end () != it) {
+            return it->second;
+        }
+        it = m_vars.find (Name);
+        if (m_vars.end () != it) {
+            return it->second;
+        }
+        return std::string ();
+    }
+
+    const std::string Expand (const std::string & Str) const
+    {
+        return Expand (Str, NULL, 0);
+    }
+
+    // returns the rule making the file or NULL
+    const FARule * GetRule (const std::string & FileName) const
+    {
+        std::map < std::string, int >::const_iterator it = \
+            m_target2rule.find (FileName);
+        if (m_target2rule.end () == it) {
+            return NULL;
+        }
+        return & m_rules [it->second];
+    }
+
+    // expands the recipe of the rule, $@ is its first target
+    const std::string ExpandRecipe (const FARule * pRule) const
+    {
+        std::map < std::string, std::string > autos;
+
+        if (!pRule->m_outs.empty ()) {
+            autos ["@"] = pRule->m_outs [0];
+        }
+        if (!pRule->m_ins.empty ()) {
+            autos ["<"] = pRule->m_ins [0];
+        }
+        std::string All;
+        std::set < std::string > Seen;
+        for (size_t i = 0; i < pRule->m_ins.size (); ++i) {
+            if (Seen.insert (pRule->m_ins [i]).second) {
+                if (!All.empty ()) {
+                    All.push_back (' ');
+                }
+                All += pRule->m_ins [i];
+            }
+        }
+        autos ["^"] = All;
+
+        return Expand (pRule->m_cmd, &autos, 0);
+    }
+
+    // reads the makefile, returns false if it cannot be opened
+    const bool Load (const char * pFileName)
+    {
+        std::ifstream ifs (pFileName, std::ios::in);
+        if (!ifs.is_open ()) {
+            return false;
+        }
+
+        const size_t CondDepth = m_conds.size ();
+        m_RuleIdx = -1;
+
+        std::string line;
+        std::string stmt;
+        bool Cont = false;
+        int LineNum = 0;
+
+        while (std::getline (ifs, line)) {
+
+            LineNum++;
+
+            if (!line.empty () && '\r' == line [line.length () - 1]) {
+                line.erase (line.length () - 1);
+            }
+            // backslash-newline and the spaces around it become one space
+            if (Cont) {
+                const size_t Beg = line.find_first_not_of (" \t");
+                stmt.push_back (' ');
+                if (std::string::npos != Beg) {
+                    stmt += line.substr (Beg);
+                }
+            } else {
+                stmt = line;
+            }
+            Cont = !stmt.empty () && '\\' == stmt [stmt.length () - 1];
+            if (Cont) {
+                stmt.erase (stmt.find_last_not_of (" \t\\") + 1);
+                continue;
+            }
+            ParseStmt (stmt, pFileName, LineNum);
+        }
+        if (Cont) {
+            ParseStmt (stmt, pFileName, LineNum);
+        }
+        if (CondDepth != m_conds.size ()) {
+            std::cerr << "ERROR: Missing endif in " << pFileName \
+                << " in program " << __PROG__ << '\n';
+            exit (1);
+        }
+
+        m_RuleIdx = -1;
+        return true;
+    }
+
+private:
+    const std::string Expand (
+            const std::string & Str,
+            const std::map < std::string, std::string > * pAutos,
+            const int Depth
+        ) const
+    {
+        if (MaxDepth < Depth) {
+            std::cerr << "ERROR: Recursive variable reference in \"" \
+                << Str << "\" in program " << __PROG__ << '\n';
+            exit (1);
+        }
+
+        std::string Out;
+        const size_t Len = Str.length ();
+
+        for (size_t i = 0; i < Len; ++i) {
+
+            if ('$' != Str [i] || i + 1 == Len) {
+                Out.push_back (Str [i]);
+                continue;
+            }
+            if ('$' == Str [i + 1]) {
+                Out.push_back ('$');
+                i++;
+                continue;
+            }
+
+            std::string Name;
+
+            if ('(' == Str [i + 1]) {
+                const size_t End = Str.find (')', i + 2);
+                if (std::string::npos == End) {
+                    Out.push_back (Str [i]);
+                    continue;
+                }
+                Name = Str.substr (i + 2, End - i - 2);
+                i = End;
+            } else {
+                // a single character name, e.g. $@
+                Name = Str.substr (i + 1, 1);
+                i++;
+            }
+
+            if (NULL != pAutos) {
+                std::map < std::string, std::string >::const_iterator it = \
+                    pAutos->find (Name);
+                if (pAutos->end () != it) {
+                    Out += it->second;
+                    continue;
+                }
+            }
+            Out += Expand (Get (Name), pAutos, Depth + 1);
+        }
+        return Out;
+    }
+
+    void ParseStmt (
+            const std::string & Stmt,
+            const char * pFileName,
+            const int LineNum
+        )
+    {
+        // a recipe line of the current rule
+        if (!Stmt.empty () && '\t' == Stmt [0] && -1 != m_RuleIdx) {
+            if (IsActive ()) {
+                AddRecipe (Stmt);
+            }
+            return;
+        }
+
+        const size_t Beg = Stmt.find_first_not_of (" \t");
+        if (std::string::npos == Beg || '#' == Stmt [Beg]) {
+            return;
+        }
+
+        const size_t WordEnd = Stmt.find_first_of (" \t(", Beg);
+        const std::string Word = Stmt.substr (Beg, WordEnd - Beg);
+        const std::string Rest = std::string::npos == WordEnd ? \
+            std::string () : Trim (Stmt.substr (WordEnd));
+
+        m_RuleIdx = -1;
+
+        // conditionals
+        if ("ifeq" == Word || "ifneq" == Word) {
+            char State = CondSkip;
+            if (IsActive ()) {
+                const bool Equal = ParseCond (Rest, pFileName, LineNum);
+                State = (Equal == ("ifeq" == Word)) ? CondTrue : CondFalse;
+            }
+            m_conds.push_back (State);
+            return;
+        }
+        if ("else" == Word || "endif" == Word) {
+            if (m_conds.empty () || !Rest.empty ()) {
+                Error (pFileName, LineNum);
+            }
+            if ("endif" == Word) {
+                m_conds.pop_back ();
+            } else if (CondFalse == m_conds.back ()) {
+                m_conds.back () = CondTrue;
+            } else {
+                m_conds.back () = CondSkip;
+            }
+            return;
+        }
+        if (!IsActive ()) {
+            return;
+        }
+
+        if ("include" == Word) {
+            std::vector < std::string > Files;
+            Split (Expand (Rest), &Files);
+            for (size_t i = 0; i < Files.size (); ++i) {
+                if (!Load (Files [i].c_str ())) {
+                    std::cerr << "ERROR: Cannot open " << Files [i] \
+                        << " in program " << __PROG__ << '\n';
+                    exit (1);
+                }
+            }
+            return;
+        }
+
+        // find the first "=" or ":" outside of $(...)
+        size_t i = Beg;
+        int Depth = 0;
+        for (; i < Stmt.length (); ++i) {
+            const char C = Stmt [i];
+            if ('(' == C) {
+                Depth++;
+            } else if (')' == C) {
+                Depth--;
+            } else if (0 == Depth && ('=' == C || ':' == C)) {
+                break;
+            }
+        }
+        if (i == Stmt.length ()) {
+            Error (pFileName, LineNum);
+        }
+
+        if (':' == Stmt [i] && '=' != Stmt [i + 1]) {
+            AddRule (Stmt.substr (Beg, i - Beg), Stmt.substr (i + 1));
+            return;
+        }
+
+        size_t NameEnd = i;
+        size_t Eq = i;
+        char Op = '=';
+        if (':' == Stmt [i]) {
+            Op = ':';
+            Eq++;
+        } else if (Beg < i && '+' == Stmt [i - 1]) {
+            Op = '+';
+            NameEnd--;
+        }
+        const std::string Name = Trim (Stmt.substr (Beg, NameEnd - Beg));
+        const std::string Value = Trim (Stmt.substr (Eq + 1));
+        if (Name.empty ()) {
+            Error (pFileName, LineNum);
+        }
+
+        if (':' == Op) {
+            Set (Name, Expand (Value));
+        } else if ('+' == Op) {
+            const std::string Prev = Get (Name);
+            Set (Name, Prev.empty () ? Value : Prev + " " + Value);
+        } else {
+            Set (Name, Value);
+        }
+    }
+
+    // parses "(a, b)", returns true if the expanded a and b are equal
+    const bool ParseCond (
+            const std::string & Args,
+            const char * pFileName,
+            const int LineNum
+        ) const
+    {
+        if (2 > Args.length () || '(' != Args [0] || \
+            ')' != Args [Args.length () - 1]) {
+            Error (pFileName, LineNum);
+        }
+        int Depth = 0;
+        for (size_t i = 1; i + 1 < Args.length (); ++i) {
+            const char C = Args [i];
+            if ('(' == C) {
+                Depth++;
+            } else if (')' == C) {
+                Depth--;
+            } else if (0 == Depth && ',' == C) {
+                const std::string A = Args.substr (1, i - 1);
+                const std::string B = Args.substr (i + 1, Args.length () - i - 2);
+                return Trim (Expand (A)) == Trim (Expand (B));
+            }
+        }
+        Error (pFileName, LineNum);
+        return false;
+    }
+
+    void AddRule (const std::string & Targets, const std::string & Prereqs)
+    {
+        FARule Rule;
+        Split (Expand (Targets), &(Rule.m_outs));
+        Split (Expand (Prereqs), &(Rule.m_ins));
+
+        m_RuleIdx = (int) m_rules.size ();
+        for (size_t i = 0; i < Rule.m_outs.size (); ++i) {
+            m_target2rule [Rule.m_outs [i]] = m_RuleIdx;
+        }
+        m_rules.push_back (Rule);
+    }
+
+    void AddRecipe (const std::string & Line)
+    {
+        // "@" only turns off echoing in make
+        const size_t Beg = Line.find_first_not_of (" \t@");
+        if (std::string::npos == Beg) {
+            return;
+        }
+        std::string & Cmd = m_rules [m_RuleIdx].m_cmd;
+        if (!Cmd.empty ()) {
+            Cmd += " && ";
+        }
+        Cmd += Trim (Line.substr (Beg));
+    }
+
+    const bool IsActive () const
+    {
+        for (size_t i = 0; i < m_conds.size (); ++i) {
+            if (CondTrue != m_conds [i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void Error (const char * pFileName, const int LineNum)
+    {
+        std::cerr << "ERROR: Unsupported statement in " << pFileName \
+            << " at line " << LineNum << " in program " << __PROG__ << '\n';
+        exit (1);
+    }
+
+    static const std::string Trim (const std::string & Str)
+    {
+        const size_t Beg = Str.find_first_not_of (" \t");
+        if (std::string::npos == Beg) {
+            return std::string ();
+        }
+        const size_t End = Str.find_last_not_of (" \t");
+        return Str.substr (Beg, End - Beg + 1);
+    }
+
+private:
+    std::map < std::string, std::string > m_vars;
+    // all the rules in the order of the makefile
+    std::vector < FARule > m_rules;
+    // target --> the last rule for it
+    std::map < std::string, int > m_target2rule;
+    // the rule whose recipe is being read or -1
+    int m_RuleIdx;
+    // a state for each of the open conditionals
+    std::vector < char > m_conds;
+
+    enum {
+        MaxDepth = 64,
+        CondTrue = 0,   // the current branch is read
+        CondFalse,      // the current branch is skipped, else is read
+        CondSkip        // the rest of the conditional is skipped
+    };
+};
+
+
+const bool FileExists (const std::string & FileName)
+{
+    struct stat st;
+    return 0 == stat (FileName.c_str (), &st);
+}
+
+
+void MakeDir (const std::string & DirName)
+{
+    std::string Dir;
+    for (size_t i = 0; i <= DirName.length (); ++i) {
+        if (i == DirName.length () || '/' == DirName [i] || \
+            '\\' == DirName [i]) {
+            if (!Dir.empty () && !FileExists (Dir)) {
+#ifdef _WIN32
+                _mkdir (Dir.c_str ());
+#else
+                mkdir (Dir.c_str (), 0777);
+#endif
+            }
+        }
+        if (i < DirName.length ()) {
+            Dir.push_back (DirName [i]);
+        }
+    }
+}
+
+
+///
+/// FNV-1a 64 bit hash
+///
+
+class FAHash64 {
+
+public:
+    FAHash64 () :
+        m_Hash (0xCBF29CE484222325ULL)
+    {}
+
+    void Add (const void * pData, const size_t Size)
+    {
+        const unsigned char * pBytes = (const unsigned char *) pData;
+        unsigned long long Hash = m_Hash;
+        for (size_t i = 0; i < Size; ++i) {
+            Hash ^= pBytes [i];
+            Hash *= 0x100000001B3ULL;
+        }
+        m_Hash = Hash;
+    }
+
+    void Add (const std::string & Str)
+    {
+        // the terminating 0 separates strings
+        Add (Str.c_str (), Str.length () + 1);
+    }
+
+    // returns false if the file cannot be read
+    const bool AddFile (const std::string & FileName)
+    {
+        FILE * pFile = fopen (FileName.c_str (), "rb");
+        if (NULL == pFile) {
+            return false;
+        }
+        std::vector < char > Buff (BuffSize);
+        size_t Size;
+        while (0 < (Size = fread (Buff.data (), 1, BuffSize, pFile))) {
+            Add (Buff.data (), Size);
+        }
+        fclose (pFile);
+        return true;
+    }
+
+    const std::string ToStr () const
+    {
+        char Buff [32];
+        snprintf (Buff, sizeof (Buff), "%016llx", m_Hash);
+        return std::string (Buff);
+    }
+
+private:
+    unsigned long long m_Hash;
+
+    enum { BuffSize = 1 << 16 };
+};
+
+
+///
+/// A node of the build graph.
+///
+
+class FABuildStep {
+
+public:
+    FABuildStep () :
+        m_Merge (false),
+        m_Pending (0)
+    {}
+
+public:
+    // output files
+    std::vector < std::string > m_outs;
+    // input files
+    std::vector < std::string > m_ins;
+    // the shell command
+    std::string m_cmd;
+    // true if this is the merge of the dumps
+    bool m_Merge;
+    // steps which use the outputs of this step
+    std::vector < int > m_next;
+    // the number of steps this step waits for
+    int m_Pending;
+
+public:
+    // a key for the hash records
+    const std::string GetKey () const
+    {
+        std::string Key;
+        for (size_t i = 0; i < m_outs.size (); ++i) {
+            if (0 < i) {
+                Key.push_back (' ');
+            }
+            Key += m_outs [i];
+        }
+        return Key;
+    }
+};
+
+
+///
+/// Builds the graph of steps and runs it.
+///
+
+class FALdbBuilder {
+
+public:
+    FALdbBuilder (const FAMakefile * pMake) :
+        m_pMake (pMake),
+        m_Running (0),
+        m_Done (0),
+        m_Failed (false)
+    {}
+
+public:
+    // adds the step building the file, returns false on error
+    const bool AddTarget (const std::string & FileName)
+    {
+        return -2 != GetStep (FileName);
+    }
+
+    void LoadHashes (const std::string & FileName)
+    {
+        m_HashFile = FileName;
+
+        std::ifstream ifs (FileName.c_str (), std::ios::in);
+        std::string line;
+
+        while (std::getline (ifs, line)) {
+            const size_t Tab = line.find ('\t');
+            if (std::string::npos != Tab) {
+                m_key2hash [line.substr (Tab + 1)] = line.substr (0, Tab);
+            }
+        }
+    }
+
+    // runs all the steps, returns false if any of them has failed
+    const bool Run (const int Threads)
+    {
+        for (size_t i = 0; i < m_steps.size (); ++i) {
+            if (0 == m_steps [i]->m_Pending) {
+                m_ready.push_back ((int) i);
+            }
+        }
+
+        std::vector < std::thread > threads;
+        for (int t = 0; t < Threads; ++t) {
+            threads.push_back (std::thread (&FALdbBuilder::Worker, this));
+        }
+        for (size_t t = 0; t < threads.size (); ++t) {
+            threads [t].join ();
+        }
+
+        if (!g_DryRun) {
+            SaveHashes ();
+        }
+        return !m_Failed;
+    }
+
+private:
+    const bool AddStep (std::unique_ptr < FABuildStep > & pStep)
+    {
+        const int Idx = (int) m_steps.size ();
+        FABuildStep * pS = pStep.get ();
+        m_steps.push_back (std::move (pStep));
+
+        for (size_t i = 0; i < pS->m_outs.size (); ++i) {
+            m_file2step [pS->m_outs [i]] = Idx;
+        }
+        // make sure the steps producing inputs exist
+        std::set < int > Deps;
+        for (size_t i = 0; i < pS->m_ins.size (); ++i) {
+            const int Dep = GetStep (pS->m_ins [i]);
+            if (-2 == Dep) {
+                return false;
+            }
+            if (0 <= Dep) {
+                Deps.insert (Dep);
+            }
+        }
+        for (std::set < int >::const_iterator it = Deps.begin ();
+             it != Deps.end (); ++it) {
+            m_steps [*it]->m_next.push_back (Idx);
+            pS->m_Pending++;
+        }
+        return true;
+    }
+
+    // returns step index, -1 for a source file or -2 on error
+    const int GetStep (const std::string & FileName)
+    {
+        std::map < std::string, int >::const_iterator it = \
+            m_file2step.find (FileName);
+        if (m_file2step.end () != it) {
+            return it->second;
+        }
+        if (m_inProgress.end () != m_inProgress.find (FileName)) {
+            std::cerr << "ERROR: Circular dependency on " << FileName \
+                << " in program " << __PROG__ << '\n';
+            return -2;
+        }
+
+        const FARule * pRule = m_pMake->GetRule (FileName);
+
+        if (NULL != pRule) {
+
+            std::unique_ptr < FABuildStep > pStep (new FABuildStep);
+            pStep->m_outs = pRule->m_outs;
+            pStep->m_ins = pRule->m_ins;
+            pStep->m_cmd = m_pMake->ExpandRecipe (pRule);
+            pStep->m_Merge = IsMerge (pStep.get ());
+
+            m_inProgress.insert (FileName);
+            const bool Res = AddStep (pStep);
+            m_inProgress.erase (FileName);
+
+            if (!Res) {
+                return -2;
+            }
+            return m_file2step [FileName];
+        }
+
+        if (!FileExists (FileName)) {
+            std::cerr << "ERROR: No rule to make " << FileName \
+                << " in program " << __PROG__ << '\n';
+            return -2;
+        }
+        return -1;
+    }
+
+    // returns true if the command is "fa_merge_dumps --out=$@ $^", such a
+    // step is run in-process
+    static const bool IsMerge (const FABuildStep * pStep)
+    {
+        std::vector < std::string > Args;
+        Split (pStep->m_cmd, &Args);
+
+        if (Args.size () != pStep->m_ins.size () + 2 || \
+            "fa_merge_dumps" != Args [0] || \
+            "--out=" + pStep->m_outs [0] != Args [1]) {
+            return false;
+        }
+        for (size_t i = 0; i < pStep->m_ins.size (); ++i) {
+            if (pStep->m_ins [i] != Args [i + 2]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // computes the hash of the command and of the inputs
+    const bool GetHash (const FABuildStep * pStep, std::string * pHash) const
+    {
+        FAHash64 hash;
+        hash.Add (pStep->m_cmd);
+
+        for (size_t i = 0; i < pStep->m_ins.size (); ++i) {
+            const std::string & FileName = pStep->m_ins [i];
+            hash.Add (FileName);
+            if (!hash.AddFile (FileName)) {
+                return false;
+            }
+        }
+        *pHash = hash.ToStr ();
+        return true;
+    }
+
+    const bool IsUpToDate (const FABuildStep * pStep, const std::string & Hash)
+    {
+        if (g_Force) {
+            return false;
+        }
+        for (size_t i = 0; i < pStep->m_outs.size (); ++i) {
+            if (!FileExists (pStep->m_outs [i])) {
+                return false;
+            }
+        }
+        std::lock_guard < std::mutex > guard (m_mutex);
+        std::map < std::string, std::string >::const_iterator it = \
+            m_key2hash.find (pStep->GetKey ());
+        return m_key2hash.end () != it && it->second == Hash;
+    }
+
+    // runs the step, returns an error message or an empty string
+    const std::string RunStep (const FABuildStep * pStep)
+    {
+        // a rule without a recipe, e.g. all: dirs $(OUTPUT)
+        if (pStep->m_cmd.empty ()) {
+            return std::string ();
+        }
+        std::string Hash;
+        if (!g_DryRun && !GetHash (pStep, &Hash)) {
+            return "Cannot read input files of " + pStep->GetKey ();
+        }
+        if (!g_DryRun && IsUpToDate (pStep, Hash)) {
+            return std::string ();
+        }
+
+        if (!g_Quiet || g_DryRun) {
+            std::lock_guard < std::mutex > guard (m_mutex);
+            std::cout << pStep->m_cmd << std::endl;
+        }
+        if (g_DryRun) {
+            return std::string ();
+        }
+
+        // forget the old hash, the outputs are being rewritten
+        {
+            std::lock_guard < std::mutex > guard (m_mutex);
+            m_key2hash.erase (pStep->GetKey ());
+        }
+
+        if (pStep->m_Merge) {
+
+            FAAllocator alloc;
+            FAMergeDumps merger (&alloc);
+
+            for (size_t i = 0; i < pStep->m_ins.size (); ++i) {
+                merger.AddDumpFile (pStep->m_ins [i].c_str ());
+            }
+
+            std::ofstream ofs (pStep->m_outs [0].c_str (), \
+                std::ios::out | std::ios::binary);
+            if (!ofs.is_open ()) {
+                return "Cannot create " + pStep->m_outs [0];
+            }
+            merger.Save (&ofs);
+
+        } else {
+
+            fflush (NULL);
+            const int Res = system (pStep->m_cmd.c_str ());
+            if (0 != Res) {
+                return "Command failed: " + pStep->m_cmd;
+            }
+        }
+
+        std::lock_guard < std::mutex > guard (m_mutex);
+        m_key2hash [pStep->GetKey ()] = Hash;
+        return std::string ();
+    }
+
+    void Worker ()
+    {
+        while (true) {
+
+            int Idx;
+            {
+                std::unique_lock < std::mutex > lock (m_mutex);
+                while (m_ready.empty () && !m_Failed && \
+                       m_Done < m_steps.size () && 0 < m_Running) {
+                    m_cond.wait (lock);
+                }
+                if (m_ready.empty () || m_Failed) {
+                    m_cond.notify_all ();
+                    return;
+                }
+                Idx = m_ready.front ();
+                m_ready.pop_front ();
+                m_Running++;
+            }
+
+            std::string Err;
+            try {
+                Err = RunStep (m_steps [Idx].get ());
+            } catch (const FAException & e) {
+                std::ostringstream os;
+                os << e.GetErrMsg () << " in " << e.GetSourceName () \
+                   << " at line " << e.GetSourceLine ();
+                Err = os.str ();
+            } catch (...) {
+                Err = "Unknown error";
+            }
+
+            std::lock_guard < std::mutex > guard (m_mutex);
+            m_Running--;
+            m_Done++;
+
+            if (!Err.empty ()) {
+                std::cerr << "ERROR: " << Err << " in program " \
+                    << __PROG__ << '\n';
+                m_Failed = true;
+            } else {
+                const std::vector < int > & Next = m_steps [Idx]->m_next;
+                for (size_t i = 0; i < Next.size (); ++i) {
+                    if (0 == --(m_steps [Next [i]]->m_Pending)) {
+                        m_ready.push_back (Next [i]);
+                    }
+                }
+            }
+            m_cond.notify_all ();
+        }
+    }
+
+    void SaveHashes () const
+    {
+        std::ofstream ofs (m_HashFile.c_str (), std::ios::out);
+        if (!ofs.is_open ()) {
+            std::cerr << "WARNING: Cannot write " << m_HashFile \
+                << " in program " << __PROG__ << '\n';
+            return;
+        }
+        std::map < std::string, std::string >::const_iterator it;
+        for (it = m_key2hash.begin (); it != m_key2hash.end (); ++it) {
+            ofs << it->second << '\t' << it->first << '\n';
+        }
+    }
+
+private:
+    const FAMakefile * m_pMake;
+
+    std::vector < std::unique_ptr < FABuildStep > > m_steps;
+    // output file name --> step
+    std::map < std::string, int > m_file2step;
+    // files whose steps are being added
+    std::set < std::string > m_inProgress;
+
+    // step key --> hash of the inputs it has been built from
+    std::map < std::string, std::string > m_key2hash;
+    std::string m_HashFile;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque < int > m_ready;
+    int m_Running;
+    size_t m_Done;
+    bool m_Failed;
+};
+
+
+int __cdecl main (int argc, char** argv)
+{
+    __PROG__ = argv [0];
+
+    --argc, ++argv;
+
+    ::FAIOSetup ();
+
+    // parse a command line
+    process_args (argc, argv);
+
+    FAMakefile make;
+
+    if (!make.Load (g_pMakefile)) {
+        std::cerr << "ERROR: Cannot open " << g_pMakefile \
+            << " in program " << __PROG__ << '\n';
+        return 1;
+    }
+
+    const std::string TmpDir = make.Expand ("$(tmpdir)");
+    const std::string Output = make.Expand ("$(OUTPUT)");
+
+    FALdbBuilder builder (&make);
+
+    if (NULL != g_pTarget) {
+
+        if (!builder.AddTarget (make.Expand (g_pTarget))) {
+            return 1;
+        }
+
+    } else {
+
+        if (!builder.AddTarget (Output)) {
+            return 1;
+        }
+        if (!g_DryRun) {
+            const size_t Slash = Output.find_last_of ("/\\");
+            if (std::string::npos != Slash) {
+                MakeDir (Output.substr (0, Slash));
+            }
+        }
+    }
+
+    if (!g_DryRun) {
+        MakeDir (TmpDir);
+    }
+
+    builder.LoadHashes (make.Expand ("$(tmpdir)/ldb.build.$(mode).txt"));
+
+    if (!builder.Run (g_Threads)) {
+        return 2;
+    }
+
+    return 0;
+}
@@ -27,6 +27,10 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <memory>
 
 const char * __PROG__ = "";
 
@@ -44,9 +48,6 @@ bool g_use_pref = false;
 
 FAAllocator g_alloc;
 
-// recode
-FAStr2Utf16 g_recode (&g_alloc);
-
 FAImageDump g_pref_dfa_image;
 FARSDfa_pack_triv g_pref_fsm_dump;
 
@@ -69,14 +70,13 @@ FAImageDump g_charmap_image;
 FAMultiMap_pack_fixed g_charmap;
 const FAMultiMapCA * g_pCharMap = NULL;
 
-// input chain
+// max input/output chain size
 const int MaxChainSize = 4096;
-int g_InChain [MaxChainSize];
-int g_InChainSize;
 
-// output chain
-const int * g_pOutChain;
-int g_OutChainSize;
+int g_Threads = 1;
+
+// the number of lines read at once per thread
+const int LinesPerThread = 4096;
 
 std::string line;
 unsigned int LineNum = 0;
@@ -126,6 +126,9 @@ This program converts input word pairs (optionally with tags) into suffix rules.
     according to the <mmap-dump>, the dump should be in \"fixed\" format\n\
 \n\
   --use-pref - generates exteded rules with for both prefixes and suffixes\n\
+\n\
+  --threads=N - converts the input in N threads, the output order is the\n\
+    same as the input one, 1 is used by default\n\
 \n\
 \n\
 Input format:\n\
@@ -306,58 +309,153 @@ void process_args (int& argc, char**& argv)
             g_use_pref = true;
             continue;
         }
+        if (0 == strncmp ("--threads=", *argv, 10)) {
+            g_Threads = atoi (&((*argv) [10]));
+            continue;
+        }
     }
 }
 
 
-void Line2Chain (const char * pStr, const int StrLen)
+///
+/// Per-thread data: the converter and its buffers.
+///
+class FADict2SuffWorker {
+
+public:
+    FADict2SuffWorker ();
+
+public:
+    /// converts lines ThreadId, ThreadId + ThreadCount, ... of the chunk
+    void Process (
+            const int ThreadId,
+            const int ThreadCount,
+            const std::vector < std::string > * pLines,
+            std::vector < std::string > * pOuts,
+            std::vector < const char * > * pErrMsgs,
+            std::vector < std::exception_ptr > * pErrors
+        );
+
+private:
+    // converts the input line into m_InChain, returns an error or NULL
+    const char * Line2Chain (const char * pStr, const int StrLen);
+    // converts one line, Out gets the output line or stays empty
+    const char * ProcessLine (const std::string & line, std::string & Out);
+
+private:
+    FAStr2Utf16 m_recode;
+    FADictStr2SuffixRule m_dict2suff;
+
+    // input chain
+    int m_InChain [MaxChainSize];
+    int m_InChainSize;
+
+    // output string
+    char m_OutStr [MaxChainSize];
+};
+
+
+FADict2SuffWorker::FADict2SuffWorker () :
+    m_recode (&g_alloc),
+    m_dict2suff (&g_alloc),
+    m_InChainSize (0)
+{
+    m_recode.SetEncodingName (g_pInEnc);
+
+    m_dict2suff.SetInTr (g_pInTr);
+    m_dict2suff.SetOutTr (g_pOutTr);
+    m_dict2suff.SetIgnoreCase (g_ignore_case);
+    m_dict2suff.SetUsePref (g_use_pref);
+    m_dict2suff.SetCharmap (g_pCharMap);
+}
+
+
+const char * FADict2SuffWorker::
+    Line2Chain (const char * pStr, const int StrLen)
 {
     DebugLogAssert (0 < StrLen && pStr);
 
     if (MaxChainSize < StrLen) {
-        std::cerr << "ERROR: \"Input string is too long\""
-                  << " in program " << __PROG__ << '\n';
-        exit (1);
+        return "Input string is too long";
     }
 
     if (g_is_utf8) {
-
-        g_InChainSize = \
-            ::FAStrUtf8ToArray (pStr, StrLen, g_InChain, MaxChainSize);
-
+        m_InChainSize = \
+            ::FAStrUtf8ToArray (pStr, StrLen, m_InChain, MaxChainSize);
     } else {
-
-        g_InChainSize = \
-            g_recode.Process (pStr, StrLen, g_InChain, MaxChainSize);
-
+        m_InChainSize = \
+            m_recode.Process (pStr, StrLen, m_InChain, MaxChainSize);
     } // if (g_is_utf8) ...
 
-    if (-1 == g_InChainSize) {
-        std::cerr << "ERROR: \"Conversion is not possible\""
-                  << " in program " << __PROG__ << '\n';
-        exit (1);
+    if (-1 == m_InChainSize) {
+        return "Conversion is not possible";
     }
+
+    return NULL;
 }
 
 
-void Print (std::ostream * pOs)
+const char * FADict2SuffWorker::
+    ProcessLine (const std::string & line, std::string & Out)
 {
-    DebugLogAssert (pOs);
-    DebugLogAssert (0 < g_OutChainSize && g_pOutChain);
+    Out.clear ();
+
+    const char * pLine = line.c_str ();
+    int LineLen = (const int) line.length ();
+
+    if (0 < LineLen) {
+        DebugLogAssert (pLine);
+        if (0x0D == (unsigned char) pLine [LineLen - 1])
+            LineLen--;
+    }
+    if (0 < LineLen) {
+
+        const char * pErrMsg = Line2Chain (pLine, LineLen);
+        if (pErrMsg) {
+            return pErrMsg;
+        }
 
-    const int MaxOutStr = MaxChainSize;
-    char OutStr [MaxChainSize];
+        const int * pOutChain = NULL;
+        const int OutChainSize = \
+            m_dict2suff.Process (m_InChain, m_InChainSize, &pOutChain);
+        DebugLogAssert (0 < OutChainSize && pOutChain);
 
-    const int OutStrLen = \
-        ::FAArrayToStrUtf8 (g_pOutChain, g_OutChainSize, OutStr, MaxOutStr - 1);
+        const int OutStrLen = ::FAArrayToStrUtf8 (pOutChain, OutChainSize, \
+            m_OutStr, MaxChainSize - 1);
 
-    if (0 > OutStrLen || MaxChainSize - 1 < OutStrLen) {
-        throw FAException (FAMsg::IOError, __FILE__, __LINE__);
+        if (0 > OutStrLen || MaxChainSize - 1 < OutStrLen) {
+            throw FAException (FAMsg::IOError, __FILE__, __LINE__);
+        }
+
+        Out.assign (m_OutStr, OutStrLen);
+        Out.push_back ('\n');
     }
 
-    OutStr [OutStrLen] = 0;
+    return NULL;
+}
+
+
+void FADict2SuffWorker::
+    Process (
+        const int ThreadId,
+        const int ThreadCount,
+        const std::vector < std::string > * pLines,
+        std::vector < std::string > * pOuts,
+        std::vector < const char * > * pErrMsgs,
+        std::vector < std::exception_ptr > * pErrors
+    )
+{
+    DebugLogAssert (pLines && pOuts && pErrMsgs && pErrors);
+
+    const int LineCount = (int) pLines->size ();
 
-    (*pOs) << OutStr;
+    for (int i = ThreadId; i < LineCount; i += ThreadCount) {
+        try {
+            (*pErrMsgs) [i] = ProcessLine ((*pLines) [i], (*pOuts) [i]);
+        } catch (...) {
+            (*pErrors) [i] = std::current_exception ();
+        }
+    }
 }
 
 
@@ -401,8 +499,6 @@ int __cdecl main (int argc, char ** argv)
         DebugLogAssert (pIs);
         DebugLogAssert (pOs);
 
-        g_recode.SetEncodingName (g_pInEnc);
-
         if (g_pInPrefFsmFile) {
 
             g_pref_dfa_image.Load (g_pInPrefFsmFile);
@@ -425,38 +521,77 @@ int __cdecl main (int argc, char ** argv)
             g_tr_ucf_rev.SetDelim (g_ucf_delim);
         }
 
-        FADictStr2SuffixRule dict2suff (&g_alloc);
+        if (1 > g_Threads) {
+            g_Threads = 1;
+        }
+
+        std::vector < std::unique_ptr < FADict2SuffWorker > > workers (g_Threads);
+        for (int t = 0; t < g_Threads; ++t) {
+            workers [t].reset (new FADict2SuffWorker ());
+        }
 
-        dict2suff.SetInTr (g_pInTr);
-        dict2suff.SetOutTr (g_pOutTr);
-        dict2suff.SetIgnoreCase (g_ignore_case);
-        dict2suff.SetUsePref (g_use_pref);
-        dict2suff.SetCharmap (g_pCharMap);
+        const int MaxChunkSize = g_Threads * LinesPerThread;
+
+        std::vector < std::string > lines;
+        std::vector < std::string > outs;
+        std::vector < const char * > errmsgs;
+        std::vector < std::exception_ptr > errors;
+        std::vector < std::thread > threads;
 
         while (!(pIs->eof ())) {
 
-            if (!std::getline (*pIs, line))
+            // read the next chunk of lines
+            lines.clear ();
+
+            while ((int) lines.size () < MaxChunkSize) {
+                if (!std::getline (*pIs, line))
+                    break;
+                lines.push_back (line);
+            }
+
+            const int LineCount = (int) lines.size ();
+            if (0 == LineCount)
                 break;
 
-            LineNum++;
+            outs.assign (LineCount, std::string ());
+            errmsgs.assign (LineCount, (const char *) NULL);
+            errors.assign (LineCount, std::exception_ptr ());
+
+            // convert the chunk
+            if (1 == g_Threads) {
 
-            const char * pLine = line.c_str ();
-            int LineLen = (const int) line.length ();
+                workers [0]->Process (0, 1, &lines, &outs, &errmsgs, &errors);
 
-            if (0 < LineLen) {
-                DebugLogAssert (pLine);
-                if (0x0D == (unsigned char) pLine [LineLen - 1])
-                    LineLen--;
+            } else {
+
+                threads.clear ();
+                for (int t = 0; t < g_Threads; ++t) {
+                    threads.push_back (std::thread (&FADict2SuffWorker::Process, \
+                        workers [t].get (), t, g_Threads, &lines, &outs, \
+                        &errmsgs, &errors));
+                }
+                for (int t = 0; t < g_Threads; ++t) {
+                    threads [t].join ();
+                }
             }
-            if (0 < LineLen) {
 
-                Line2Chain (pLine, LineLen);
+            // print the results in the input order
+            for (int i = 0; i < LineCount; ++i) {
+
+                LineNum++;
 
-                g_OutChainSize = \
-                    dict2suff.Process (g_InChain, g_InChainSize, &g_pOutChain);
+                if (errors [i]) {
+                    line = lines [i];
+                    std::rethrow_exception (errors [i]);
+                }
+                if (errmsgs [i]) {
+                    (*pOs).flush ();
+                    std::cerr << "ERROR: \"" << errmsgs [i] << "\""
+                              << " in program " << __PROG__ << '\n';
+                    exit (1);
+                }
 
-                Print (pOs);
-                (*pOs) << '\n';
+                (*pOs) << outs [i];
             }
         }
 
@@ -44,6 +44,9 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <thread>
+#include <exception>
 
 const char * __PROG__ = "";
 
@@ -61,10 +64,12 @@ bool g_remap_iws = false;
 bool g_imp_mmap = false;
 bool g_use_iwia = false;
 bool g_use_ranges = false;
+bool g_ow_first = false;
 bool g_force_flat = false;
 bool g_no_output = false;
 bool g_no_process = false;
 bool g_auto_test = false;
+int g_Threads = 1;
 
 FAAllocator g_alloc;
 FAAutIOTools g_fsm_io (&g_alloc);
@@ -170,6 +175,9 @@ This program builds packed contiguous automaton image.\n\
   --use-ranges - uses ranges of Iws storing just one destination state per\n\
     each range, used only when gives smaller representation\n\
     Note: This option cannot be used for Mealy and MHP automata representation\n\
+\n\
+  --ow-first - stores Ow right after the state info byte, makes reaction\n\
+    lookup O(1), used only with --alg=triv for Moore automata\n\
 \n\
   --dir=<direction> - specifies direction of reading, currently used only\n\
     with --type=mmap and --alg=mph, the possible values are:\n\
@@ -182,7 +190,11 @@ This program builds packed contiguous automaton image.\n\
     the default value is 3 (only 1, 2, 3, 4 are possible)\n\
 \n\
   --auto-test - compares two interfaces to be equivalent (original one and\n\
-    its memory dump counterpart) before saving the output\n\
+    its memory dump counterpart) before saving the output, prints an\n\
+    input or the first key with different behaviour\n\
+\n\
+  --threads=N - compares multi-maps in N threads for --auto-test,\n\
+    1 is used by default\n\
 \n\
   --no-output - does not do any output\n\
 \n\
@@ -224,6 +236,10 @@ void process_args (int& argc, char**& argv)
         g_use_ranges = true;
         continue;
     }
+    if (0 == strcmp ("--ow-first", *argv)) {
+        g_ow_first = true;
+        continue;
+    }
     if (0 == strncmp ("--in=", *argv, 5)) {
         g_pInFsmFile = &((*argv) [5]);
         continue;
@@ -304,6 +320,10 @@ void process_args (int& argc, char**& argv)
         g_auto_test = true;
         continue;
     }
+    if (0 == strncmp ("--threads=", *argv, 10)) {
+        g_Threads = atoi (&((*argv) [10]));
+        continue;
+    }
   }
 }
 
@@ -386,6 +406,46 @@ void Load ()
 }
 
 
+///
+/// Compares multi-maps for the keys [FromKey, ToKey], sets up *pDiffKey
+/// to the first key with different values, -1 if there is no such key or
+/// -2 if the maps cannot be compared.
+///
+void CmpMultiMaps (
+        const FAMultiMapCA * pMMap1,
+        const FAMultiMapCA * pMMap2,
+        const int FromKey,
+        const int ToKey,
+        int * pDiffKey,
+        std::exception_ptr * pError
+    )
+{
+    DebugLogAssert (pDiffKey && pError);
+
+    try {
+
+        FATestCmpMultiMap cmp_mmaps (&g_alloc);
+
+        cmp_mmaps.SetMap1 (pMMap1);
+        cmp_mmaps.SetMap2 (pMMap2);
+
+        *pDiffKey = -1;
+
+        if (!cmp_mmaps.Process (FromKey, ToKey)) {
+
+            *pDiffKey = cmp_mmaps.GetDiffKey ();
+
+            if (-1 == *pDiffKey) {
+                *pDiffKey = -2;
+            }
+        }
+
+    } catch (...) {
+        *pError = std::current_exception ();
+    }
+}
+
+
 const bool AutoTest (const unsigned char * pDump, const int DumpSize)
 {
     FAAssert (0 < DumpSize && pDump, FAMsg::InvalidParameters);
@@ -434,6 +494,18 @@ const bool AutoTest (const unsigned char * pDump, const int DumpSize)
         const int MaxIw = g_pInDfa->GetMaxIw ();
 
         const bool Res = cmp_dfa.Process (MaxState, MaxIw);
+
+        const int * pIws;
+        const int IwCount = cmp_dfa.GetCounterExample (&pIws);
+
+        if (false == Res && -1 != IwCount) {
+            std::cerr << "ERROR: Different behaviour for the input:";
+            for (int i = 0; i < IwCount; ++i) {
+                std::cerr << ' ' << pIws [i];
+            }
+            std::cerr << " in program " << __PROG__ << '\n';
+        }
+
         return Res;
 
     // position Nfa test
@@ -473,28 +545,72 @@ const bool AutoTest (const unsigned char * pDump, const int DumpSize)
             Size = g_pMMap->Prev (&Key, &pValues);
         }
 
-        FATestCmpMultiMap cmp_mmaps (&g_alloc);
-
-        cmp_mmaps.SetMap1 (g_pMMap);
+        const FAMultiMapCA * pMMap2 = NULL;
 
         if (FAFsmConst::MODE_PACK_TRIV == g_alg) {
 
             g_mmap_dump.SetImage (pDump);
-            cmp_mmaps.SetMap2 (&g_mmap_dump);
+            pMMap2 = &g_mmap_dump;
 
         } else if (FAFsmConst::MODE_PACK_MPH == g_alg) {
 
             g_mmap_mph_dump.SetImage (pDump);
-            cmp_mmaps.SetMap2 (&g_mmap_mph_dump);
+            pMMap2 = &g_mmap_mph_dump;
 
         } else if (FAFsmConst::MODE_PACK_FIXED == g_alg) {
 
             g_mmap_fixed_dump.SetImage (pDump);
-            cmp_mmaps.SetMap2 (&g_mmap_fixed_dump);
+            pMMap2 = &g_mmap_fixed_dump;
         }
 
-        const bool Res = cmp_mmaps.Process (MaxKey);
-        return Res;
+        // split keys into equal ranges, one per thread
+        int Threads = 1 < g_Threads ? g_Threads : 1;
+        if (Threads > MaxKey + 1) {
+            Threads = 0 < MaxKey ? MaxKey + 1 : 1;
+        }
+        const int RangeSize = ((MaxKey + 1) / Threads) + 1;
+
+        std::vector < int > DiffKeys (Threads, -1);
+        std::vector < std::exception_ptr > errors (Threads);
+        std::vector < std::thread > threads;
+
+        for (int t = 0; t < Threads; ++t) {
+
+            const int FromKey = t * RangeSize;
+            int ToKey = FromKey + RangeSize - 1;
+            if (ToKey > MaxKey) {
+                ToKey = MaxKey;
+            }
+
+            if (1 == Threads) {
+                CmpMultiMaps (g_pMMap, pMMap2, FromKey, ToKey, \
+                    &(DiffKeys [t]), &(errors [t]));
+            } else {
+                threads.push_back (std::thread (CmpMultiMaps, g_pMMap, \
+                    pMMap2, FromKey, ToKey, &(DiffKeys [t]), &(errors [t])));
+            }
+        }
+        for (size_t t = 0; t < threads.size (); ++t) {
+            threads [t].join ();
+        }
+
+        // ranges are ordered, the first difference has the smallest key
+        for (int t = 0; t < Threads; ++t) {
+
+            if (errors [t]) {
+                std::rethrow_exception (errors [t]);
+            }
+            if (-2 == DiffKeys [t]) {
+                return false;
+            }
+            if (-1 != DiffKeys [t]) {
+                std::cerr << "ERROR: Different values for the key " \
+                    << DiffKeys [t] << " in program " << __PROG__ << '\n';
+                return false;
+            }
+        }
+
+        return true;
 
     } else if (FAFsmConst::TYPE_ARRAY == g_type) {
 
@@ -505,8 +621,16 @@ const bool AutoTest (const unsigned char * pDump, const int DumpSize)
         if (g_array_dump.GetCount () != g_ArraySize) {
             return false;
         }
-        for (int i = 0; i < g_ArraySize; ++i) {
-            if (g_array_dump.GetAt (i) != g_Array [i]) {
+
+        // compare block by block
+        const int BlockSize = 1024;
+        int Block [BlockSize];
+
+        for (int i = 0; i < g_ArraySize; i += BlockSize) {
+
+            const int Size = g_array_dump.GetRange (i, BlockSize, Block);
+
+            if (0 != memcmp (Block, g_Array + i, sizeof (int) * Size)) {
                 return false;
             }
         }
@@ -608,6 +732,7 @@ int __cdecl main (int argc, char ** argv)
                     g_dfa_pack.SetRemapIws (g_remap_iws);
                     g_dfa_pack.SetUseIwIA (g_use_iwia);
                     g_dfa_pack.SetUseRanges (g_use_ranges);
+                    g_dfa_pack.SetOwFirst (g_ow_first);
                     g_dfa_pack.SetDstSize (g_DstSize);
                     g_dfa_pack.Process ();
 
@@ -8,9 +8,9 @@
 #include "FAFsmConst.h"
 #include "FAAllocator.h"
 #include "FAImageDump.h"
-#include "FATaggedText.h"
 #include "FAMapIOTools.h"
 #include "FACorpusIOTools_utf8.h"
+#include "FACorpusReader_utf8.h"
 #include "FAPrintUtils.h"
 #include "FAException.h"
 #include "FATagSet.h"
@@ -39,9 +39,6 @@ const char * g_pTagsetFile = "tagset.txt";
 const char * g_pInFile = NULL;
 const char * g_pOutFile = NULL;
 
-std::istream * g_pIs = &std::cin;
-std::ifstream g_ifs;
-
 std::ostream * g_pOs = &std::cout;
 std::ofstream g_ofs;
 
@@ -72,7 +69,8 @@ is read from the separate line in FACorpusIOTools_utf8 format.\n\
     tagset.txt is used by default\n\
 \n\
   --in=<input> - reads input text from the <input> file,\n\
-    if omited stdin is used\n\
+    if omited stdin is used, the file can also be a binary corpus\n\
+    created by fa_ts2stat --out-bin\n\
 \n\
   --out=<output> - writes output to the <output> file,\n\
     if omited stdout is used\n\
@@ -326,8 +324,8 @@ int __cdecl main (int argc, char ** argv)
         // IO
         FAMapIOTools g_map_io (&g_alloc);
         FACorpusIOTools_utf8 g_txt_io (&g_alloc);
-        // input tagged text
-        FATaggedText g_text (&g_alloc);
+        // input tagged text, the reader keeps the current sentence
+        FACorpusReader_utf8 g_text (&g_alloc);
         // debug actions
         FADebugActions g_acts;
 
@@ -336,11 +334,13 @@ int __cdecl main (int argc, char ** argv)
         ///
         g_txt_io.SetTagSet (&g_tagset);
         g_txt_io.SetNoPosTags (g_no_pos_tags);
+        g_text.SetTagSet (&g_tagset);
+        g_text.SetNoPosTags (g_no_pos_tags);
 
         if (g_pInFile) {
-            g_ifs.open (g_pInFile, std::ios::in);
-            FAAssertStream (&g_ifs, g_pInFile);
-            g_pIs = &g_ifs;
+            g_text.Open (g_pInFile);
+        } else {
+            g_text.Open (&std::cin);
         }
         if (g_pOutFile) {
             g_ofs.open (g_pOutFile, std::ios::out);
@@ -385,9 +385,9 @@ int __cdecl main (int argc, char ** argv)
         /// process data
         ///
 
-        while (!g_pIs->eof ()) {
+        while (!g_text.IsEof ()) {
 
-            g_txt_io.Read (*g_pIs, &g_text);
+            g_text.Read ();
 
             if (g_print_input && !g_no_output) {
                 DebugLogAssert (g_pOs);
@@ -414,7 +414,7 @@ int __cdecl main (int argc, char ** argv)
                 g_proc.Process ();
             }
 
-        } // of while (!g_pIs->eof ()) ...
+        } // of while (!g_text.IsEof ()) ...
 
     } catch (const FAException & e) {
 
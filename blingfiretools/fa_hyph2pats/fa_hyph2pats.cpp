@@ -0,0 +1,852 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "FAConfig.h"
+#include "FALimits.h"
+#include "FAFsmConst.h"
+#include "FAAllocator.h"
+#include "FAUtils.h"
+#include "FAUtf8Utils.h"
+#include "FAPrintUtils.h"
+#include "FATrWordIOTools_utf8.h"
+#include "FAIwOwSuffArr2Patterns.h"
+#include "FAMultiMap_pack_fixed.h"
+#include "FAImageDump.h"
+#include "FAException.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+const char * __PROG__ = "";
+
+FAAllocator g_alloc;
+
+int g_MinPatLen = 3;
+int g_MaxPatLen = 8;
+int g_spec_l_anchor = FAFsmConst::IW_L_ANCHOR;
+int g_spec_r_anchor = FAFsmConst::IW_R_ANCHOR;
+
+float g_MinPatPrec = 100.0f;
+int g_MinPatFreq = 1;
+bool g_NoEmpty = false;
+bool g_DontCarePats = false;
+int g_MaxLeftCx = 4;
+
+int g_Threads = 1;
+
+const char * pInFile = NULL;
+const char * pOutFile = NULL;
+
+bool g_ignore_case = false;
+
+const char * g_pCharMapFile = NULL;
+FAImageDump g_charmap_image;
+FAMultiMap_pack_fixed g_charmap;
+const FAMultiMapCA * g_pMap = NULL;
+
+// the number of lines read at once per thread
+const int LinesPerThread = 4096;
+// the number of shards per thread the sorted chains are split into
+const int ShardsPerThread = 16;
+
+// chain text --> frequency
+typedef std::unordered_map < std::string, int > FAChain2Freq;
+// sorted chains
+typedef std::vector < std::pair < std::string, int > > FAChainFreqs;
+
+
+void usage () {
+
+  std::cout << "\n\
+Usage: fa_hyph2pats [OPTIONS]\n\
+\n\
+This program builds a list of patterns from the hyphenation dictionary\n\
+entries. It does the same as the following pipeline, but in-process and\n\
+in several threads:\n\
+\n\
+  fa_hyph2chains | LC_ALL=C sort | uniq -c | fa_iwowsuff2pats\n\
+\n\
+The output is identical to the output of the pipeline. Input should be\n\
+in UTF-8.\n\
+\n\
+  --in=<input-file> - reads input from the <input-file>,\n\
+    if omited stdin is used\n\
+\n\
+  --out=<output-file> - writes output to the <output-file>,\n\
+    if omited stdout is used\n\
+\n\
+  --min-length=N - sets up mimimal suffix and pattern length,\n\
+    3 is used by default\n\
+\n\
+  --max-length=N - sets up maximal suffix length, 8 is used by default\n\
+\n\
+  --spec-l-anchor=N - specifies weight for the beginning of the sequence,\n\
+    the default is 1\n\
+\n\
+  --spec-r-anchor=N - specifies weight for the end of the sequence,\n\
+    the default is 2\n\
+\n\
+  --ignore-case - converts input symbols to the lower case,\n\
+    uses simple case folding algorithm due to Unicode 4.1.0\n\
+\n\
+  --charmap=<mmap-dump> - applies a custom character normalization procedure\n\
+    according to the <mmap-dump>, the dump should be in \"fixed\" format\n\
+\n\
+  --min-prec=N - sets up a mimimal pattern precision, 100.0 is used by default\n\
+\n\
+  --min-freq=N - sets up a mimimal pattern frequency, 1 is used by default\n\
+\n\
+  --no-empty - will not produce patterns without hypenation points\n\
+\n\
+  --dont-care-pats - generates patterns with \"don't care\" output symbols\n\
+\n\
+  --max-context=N - specifies the maximum left context for the \"don't care\"\n\
+    patterns, 4 is used by default\n\
+\n\
+  --threads=N - the number of threads, 1 is used by default\n\
+\n\
+";
+}
+
+
+void process_args (int& argc, char**& argv)
+{
+    for (; argc--; ++argv){
+
+        if (!strcmp ("--help", *argv)) {
+            usage ();
+            exit (0);
+        }
+        if (0 == strncmp ("--in=", *argv, 5)) {
+            pInFile = &((*argv) [5]);
+            continue;
+        }
+        if (0 == strncmp ("--out=", *argv, 6)) {
+            pOutFile = &((*argv) [6]);
+            continue;
+        }
+        if (0 == strncmp ("--min-length=", *argv, 13)) {
+            g_MinPatLen = atoi (&((*argv) [13]));
+            continue;
+        }
+        if (0 == strncmp ("--max-length=", *argv, 13)) {
+            g_MaxPatLen = atoi (&((*argv) [13]));
+            continue;
+        }
+        if (0 == strncmp ("--spec-l-anchor=", *argv, 16)) {
+            g_spec_l_anchor = atoi (&((*argv) [16]));
+            continue;
+        }
+        if (0 == strncmp ("--spec-r-anchor=", *argv, 16)) {
+            g_spec_r_anchor = atoi (&((*argv) [16]));
+            continue;
+        }
+        if (0 == strncmp ("--charmap=", *argv, 10)) {
+            g_pCharMapFile = &((*argv) [10]);
+            g_pMap = &g_charmap;
+            continue;
+        }
+        if (0 == strcmp ("--ignore-case", *argv)) {
+            g_ignore_case = true;
+            continue;
+        }
+        if (0 == strncmp ("--min-prec=", *argv, 11)) {
+            g_MinPatPrec = float (atof (&((*argv) [11])));
+            continue;
+        }
+        if (0 == strncmp ("--min-freq=", *argv, 11)) {
+            g_MinPatFreq = atoi (&((*argv) [11]));
+            continue;
+        }
+        if (!strcmp ("--no-empty", *argv)) {
+            g_NoEmpty = true;
+            continue;
+        }
+        if (!strcmp ("--dont-care-pats", *argv)) {
+            g_DontCarePats = true;
+            continue;
+        }
+        if (0 == strncmp ("--max-context=", *argv, 14)) {
+            g_MaxLeftCx = atoi (&((*argv) [14]));
+            FAAssert (0 <= g_MaxLeftCx && 10 > g_MaxLeftCx, \
+                FAMsg::InvalidParameters);
+            continue;
+        }
+        if (0 == strncmp ("--threads=", *argv, 10)) {
+            g_Threads = atoi (&((*argv) [10]));
+            continue;
+        }
+    }
+}
+
+
+///
+/// Appends Value the same way as FAPrintValue (os, Value, Width, true) does.
+///
+inline static void AppendHex (std::string & Str, const int Value, const int Width)
+{
+    const char * const pDigits = "0123456789abcdef";
+
+    char Buff [16];
+    int Len = 0;
+    unsigned int V = (unsigned int) Value;
+
+    do {
+        Buff [Len++] = pDigits [V & 0xF];
+        V >>= 4;
+    } while (0 != V);
+
+    for (int i = Len; i < Width; ++i) {
+        Str.push_back ('0');
+    }
+    while (0 < Len) {
+        Str.push_back (Buff [--Len]);
+    }
+}
+
+
+///
+/// Stage 1: extracts chain suffixes from the input lines and counts them,
+/// the chain text is the same as fa_hyph2chains prints.
+///
+
+class FAChainCounter {
+
+public:
+    FAChainCounter ();
+
+public:
+    /// counts suffixes of lines ThreadId, ThreadId + ThreadCount, ...
+    void Process (
+            const int ThreadId,
+            const int ThreadCount,
+            const std::vector < std::string > * pLines,
+            std::exception_ptr * pError
+        );
+    /// returns the counts
+    FAChain2Freq & GetCounts ();
+
+private:
+    void AddLine (const std::string & line);
+
+private:
+    FAChain2Freq m_chain2freq;
+    std::string m_key;
+
+    int m_Iws [FALimits::MaxWordLen];
+    int m_Ows [FALimits::MaxWordLen];
+};
+
+
+FAChainCounter::FAChainCounter ()
+{
+    /// add left anchor
+    m_Iws [0] = g_spec_l_anchor;
+    m_Ows [0] = FAFsmConst::HYPH_NO_HYPH;
+}
+
+
+FAChain2Freq & FAChainCounter::GetCounts ()
+{
+    return m_chain2freq;
+}
+
+
+void FAChainCounter::AddLine (const std::string & line)
+{
+    const char * pLine = line.c_str ();
+    int LineLen = (const int) line.length ();
+
+    if (0 < LineLen) {
+        DebugLogAssert (pLine);
+        if (0x0D == (unsigned char) pLine [LineLen - 1])
+            LineLen--;
+    }
+    if (0 >= LineLen) {
+        return;
+    }
+
+    /// str -> chains
+    int Count = FATrWordIOTools_utf8::Str2IwOw (pLine, LineLen, \
+        m_Iws + 1, m_Ows + 1, FALimits::MaxWordLen - 2,
+        g_ignore_case, g_pMap);
+
+    /// add right anchor
+    if (Count + 1 < FALimits::MaxWordLen) {
+        m_Iws [Count + 1] = g_spec_r_anchor;
+        m_Ows [Count + 1] = FAFsmConst::HYPH_NO_HYPH;
+    }
+
+    Count += 2;
+
+    /// count all suffixes not greater than g_MaxPatLen and
+    /// not less than g_MinPatLen
+    const int iMax = Count - g_MinPatLen;
+
+    for (int i = 0; i <= iMax; ++i) {
+
+        int L = g_MaxPatLen;
+        if (g_MaxPatLen + i > Count) {
+            L = Count - i;
+        }
+
+        m_key.clear ();
+
+        AppendHex (m_key, m_Iws [i], 4);
+        for (int j = 1; j < L; ++j) {
+            m_key.push_back (' ');
+            AppendHex (m_key, m_Iws [i + j], 4);
+        }
+        m_key.push_back (' ');
+        AppendHex (m_key, m_Ows [i], 1);
+        for (int j = 1; j < L; ++j) {
+            m_key.push_back (' ');
+            AppendHex (m_key, m_Ows [i + j], 1);
+        }
+
+        m_chain2freq [m_key]++;
+    }
+}
+
+
+void FAChainCounter::
+    Process (
+        const int ThreadId,
+        const int ThreadCount,
+        const std::vector < std::string > * pLines,
+        std::exception_ptr * pError
+    )
+{
+    DebugLogAssert (pLines && pError);
+
+    try {
+
+        const int LineCount = (int) pLines->size ();
+
+        for (int i = ThreadId; i < LineCount; i += ThreadCount) {
+            AddLine ((*pLines) [i]);
+        }
+
+    } catch (...) {
+        *pError = std::current_exception ();
+    }
+}
+
+
+///
+/// Stage 2: builds patterns from a range of sorted chains, the output is
+/// kept in segments tagged with the position in the sequential output.
+///
+
+struct FAPatSegment {
+
+    // the input chain index at which the sequential code prints it
+    int m_Idx;
+    // the left context position (the suff2pats object index)
+    int m_Pos;
+    // printed patterns
+    std::string m_Text;
+
+    const bool operator < (const FAPatSegment & s) const
+    {
+        return m_Idx < s.m_Idx || (m_Idx == s.m_Idx && m_Pos < s.m_Pos);
+    }
+};
+
+
+class FATmpSuff2Pats : public FAIwOwSuffArr2Patterns {
+
+public:
+    FATmpSuff2Pats (FAAllocatorA * pAlloc);
+
+public:
+    /// sets up the output and the tag for the next patterns
+    void SetOutput (std::vector < FAPatSegment > * pOut, const int Idx, const int Pos);
+    void PutPattern (const int * pPat, const int Size, const int Freq);
+
+private:
+    std::vector < FAPatSegment > * m_pOut;
+    int m_Idx;
+    int m_Pos;
+};
+
+
+FATmpSuff2Pats::FATmpSuff2Pats (FAAllocatorA * pAlloc) :
+    FAIwOwSuffArr2Patterns (pAlloc),
+    m_pOut (NULL),
+    m_Idx (0),
+    m_Pos (0)
+{}
+
+
+void FATmpSuff2Pats::
+    SetOutput (std::vector < FAPatSegment > * pOut, const int Idx, const int Pos)
+{
+    m_pOut = pOut;
+    m_Idx = Idx;
+    m_Pos = Pos;
+}
+
+
+void FATmpSuff2Pats::
+    PutPattern (const int * pPat, const int Size, const int Freq)
+{
+    DebugLogAssert (m_pOut);
+    DebugLogAssert (0 == (Size % 2));
+
+    char Utf8Char [FAUtf8Const::MAX_CHAR_SIZE + 1];
+    int i;
+
+    /// check the frequency limit
+    if (g_MinPatFreq > Freq) {
+        return;
+    }
+    /// see if pattern consists of DontCare symbols only
+    if (g_DontCarePats) {
+        for (i = 1; i < Size; i += 2) {
+            const int Ow = pPat [i];
+            if (FAFsmConst::HYPH_DONT_CARE != Ow)
+                break;
+        }
+        if (i >= Size) {
+            return;
+        }
+    }
+    /// see whether pattern is not empty
+    if (g_NoEmpty) {
+        for (i = 1; i < Size; i += 2) {
+            const int Ow = pPat [i];
+            if (FAFsmConst::HYPH_NO_HYPH != Ow && \
+                FAFsmConst::HYPH_DONT_CARE != Ow) {
+                break;
+            }
+        }
+        if (i >= Size) {
+            return;
+        }
+    }
+
+    /// start a new segment, if the tag has changed
+    if (m_pOut->empty () || m_pOut->back ().m_Idx != m_Idx || \
+        m_pOut->back ().m_Pos != m_Pos) {
+        m_pOut->push_back (FAPatSegment ());
+        m_pOut->back ().m_Idx = m_Idx;
+        m_pOut->back ().m_Pos = m_Pos;
+    }
+
+    std::string & Text = m_pOut->back ().m_Text;
+
+    /// print the Key string
+    for (i = 0; i < Size; i += 2) {
+
+        const int Iw = pPat [i];
+
+        DebugLogAssert (0 < ::FAUtf8Size (Iw) && \
+            FAUtf8Const::MAX_CHAR_SIZE >= ::FAUtf8Size (Iw));
+
+        char * pEnd = ::FAIntToUtf8 (Iw, Utf8Char, FAUtf8Const::MAX_CHAR_SIZE);
+        DebugLogAssert (pEnd);
+        *pEnd = 0;
+
+        Text.append (Utf8Char);
+    }
+
+    /// print the tab-separated action with frequency
+    Text.push_back ('\t');
+    Text.append (std::to_string (Freq));
+
+    for (i = 1; i < Size; i += 2) {
+        const int Ow = pPat [i];
+        Text.push_back ('\t');
+        Text.append (std::to_string (Ow));
+    }
+
+    Text.push_back ('\n');
+}
+
+
+///
+/// Parses chain text, the same way fa_iwowsuff2pats does, returns the size.
+///
+static const int Str2Chain (const std::string & Str, int * pChain)
+{
+    const char * pChainStr = Str.c_str ();
+    const char * pChainStrEnd = pChainStr + Str.length ();
+
+    int ChainSize = 0;
+
+    while (pChainStr < pChainStrEnd) {
+
+        FAAssert (ChainSize < 2 * FALimits::MaxWordLen, FAMsg::IOError);
+
+        pChain [ChainSize] = strtol (pChainStr, NULL, 16);
+        ChainSize++;
+
+        pChainStr = strchr (pChainStr, ' ');
+
+        if (NULL == pChainStr)
+            break;
+
+        pChainStr++;
+    }
+
+    return ChainSize;
+}
+
+
+///
+/// Returns the index of the first chain not less than From which is added
+/// to the suff2pats object Pos, or the chain count if there is none.
+///
+static const int GetNextIdx (
+        const FAChainFreqs & chains,
+        const std::vector < int > & lens,
+        const int From,
+        const int Pos
+    )
+{
+    const int ChainCount = (int) chains.size ();
+
+    int Idx = From;
+
+    if (g_DontCarePats) {
+        while (Idx < ChainCount && lens [Idx] <= Pos) {
+            Idx++;
+        }
+    }
+
+    return Idx;
+}
+
+
+///
+/// Builds patterns of the chains [From, To) for the suff2pats object Pos,
+/// the suff2pats object gets exactly the same input as in fa_iwowsuff2pats.
+///
+static void BuildPatterns (
+        const FAChainFreqs & chains,
+        const std::vector < int > & lens,
+        const int From,
+        const int To,
+        const int Pos,
+        std::vector < FAPatSegment > * pOut
+    )
+{
+    int Chain [2 * FALimits::MaxWordLen];
+    int Chain2 [2 * FALimits::MaxWordLen];
+
+    FATmpSuff2Pats suff2pat (&g_alloc);
+
+    suff2pat.SetMinPatPrec (g_MinPatPrec);
+
+    if (g_DontCarePats && Pos + 1 > g_MinPatLen) {
+        suff2pat.SetMinPatLen (Pos + 1);
+    } else {
+        suff2pat.SetMinPatLen (g_MinPatLen);
+    }
+
+    for (int Idx = From; Idx < To; ++Idx) {
+
+        const int ChainSize_2 = lens [Idx];
+
+        if (g_DontCarePats && ChainSize_2 <= Pos) {
+            continue;
+        }
+
+        const int ChainSize = Str2Chain (chains [Idx].first, Chain);
+        const int Freq = chains [Idx].second;
+
+        if (g_DontCarePats) {
+
+            for (int i = 0; i < ChainSize_2; ++i) {
+                Chain2 [i << 1] = Chain [i];
+                Chain2 [(i << 1) + 1] = FAFsmConst::HYPH_DONT_CARE;
+            }
+            // store the actual Ow for the given position
+            Chain2 [(Pos << 1) + 1] = Chain [Pos + ChainSize_2];
+
+        } else {
+
+            for (int i = 0; i < ChainSize_2; ++i) {
+                Chain2 [i << 1] = Chain [i];
+                Chain2 [(i << 1) + 1] = Chain [i + ChainSize_2];
+            }
+        }
+
+        // patterns of the previous group are printed before this chain
+        suff2pat.SetOutput (pOut, Idx, Pos);
+        suff2pat.AddChain (Chain2, ChainSize, Freq);
+    }
+
+    // the last group is printed before the next chain this object gets
+    const int NextIdx = GetNextIdx (chains, lens, To, Pos);
+
+    suff2pat.SetOutput (pOut, NextIdx, Pos);
+    suff2pat.Process ();
+}
+
+
+///
+/// Returns true if two chain texts have different first g_MinPatLen Iws,
+/// the same as FAIwOwSuffArr2Patterns does for the parsed chains.
+///
+static const bool HasPrefChanged (const std::string & Prev, const std::string & Curr)
+{
+    const char * p1 = Prev.c_str ();
+    const char * p2 = Curr.c_str ();
+
+    for (int i = 0; i < g_MinPatLen; ++i) {
+
+        const int Len1 = (int) strcspn (p1, " ");
+        const int Len2 = (int) strcspn (p2, " ");
+
+        if (Len1 != Len2 || 0 != strncmp (p1, p2, Len1)) {
+            return true;
+        }
+        if (0 == p1 [Len1] || 0 == p2 [Len2]) {
+            break;
+        }
+
+        p1 += (Len1 + 1);
+        p2 += (Len2 + 1);
+    }
+
+    return false;
+}
+
+
+int __cdecl main (int argc, char ** argv)
+{
+    __PROG__ = argv [0];
+
+    --argc, ++argv;
+
+    ::FAIOSetup ();
+
+    // parse a command line
+    process_args (argc, argv);
+
+    try {
+
+        // adjust input/output
+
+        std::istream * pIs = &std::cin;
+        std::ifstream ifs;
+
+        std::ostream * pOs = &std::cout;
+        std::ofstream ofs;
+
+        if (NULL != pInFile) {
+            ifs.open (pInFile, std::ios::in);
+            FAAssertStream (&ifs, pInFile);
+            pIs = &ifs;
+        }
+        if (NULL != pOutFile) {
+            ofs.open (pOutFile, std::ios::out);
+            pOs = &ofs;
+        }
+        // load normalization map, if needed
+        if (g_pCharMapFile) {
+            g_charmap_image.Load (g_pCharMapFile);
+            const unsigned char * pImg = g_charmap_image.GetImageDump ();
+            DebugLogAssert (pImg);
+            g_charmap.SetImage (pImg);
+        }
+
+        DebugLogAssert (pIs);
+        DebugLogAssert (pOs);
+
+        FAAssert (0 < g_MinPatLen && g_MinPatLen <= g_MaxPatLen, \
+            FAMsg::InvalidParameters);
+
+        if (1 > g_Threads) {
+            g_Threads = 1;
+        }
+
+        int t;
+        std::vector < std::thread > threads;
+        std::vector < std::exception_ptr > errors (g_Threads);
+
+        /// Stage 1: count chains in per-thread tables
+
+        std::vector < std::unique_ptr < FAChainCounter > > counters (g_Threads);
+        for (t = 0; t < g_Threads; ++t) {
+            counters [t].reset (new FAChainCounter ());
+        }
+
+        const int MaxChunkSize = g_Threads * LinesPerThread;
+        std::vector < std::string > lines;
+        std::string line;
+
+        while (!(pIs->eof ())) {
+
+            lines.clear ();
+
+            while ((int) lines.size () < MaxChunkSize) {
+                if (!std::getline (*pIs, line))
+                    break;
+                lines.push_back (line);
+            }
+            if (lines.empty ())
+                break;
+
+            threads.clear ();
+            for (t = 0; t < g_Threads; ++t) {
+                threads.push_back (std::thread (&FAChainCounter::Process, \
+                    counters [t].get (), t, g_Threads, &lines, &(errors [t])));
+            }
+            for (t = 0; t < g_Threads; ++t) {
+                threads [t].join ();
+            }
+            for (t = 0; t < g_Threads; ++t) {
+                if (errors [t]) {
+                    std::rethrow_exception (errors [t]);
+                }
+            }
+        }
+
+        /// merge the tables and sort the chains as LC_ALL=C sort does
+
+        FAChain2Freq & chain2freq = counters [0]->GetCounts ();
+
+        for (t = 1; t < g_Threads; ++t) {
+
+            FAChain2Freq & chain2freq_t = counters [t]->GetCounts ();
+
+            FAChain2Freq::const_iterator I = chain2freq_t.begin ();
+            for (; I != chain2freq_t.end (); ++I) {
+                chain2freq [I->first] += I->second;
+            }
+            chain2freq_t.clear ();
+        }
+
+        FAChainFreqs chains (chain2freq.begin (), chain2freq.end ());
+        chain2freq.clear ();
+
+        std::sort (chains.begin (), chains.end ());
+
+        const int ChainCount = (int) chains.size ();
+
+        // chain lengths (in Iws) and the group boundaries
+        std::vector < int > lens (ChainCount);
+        std::vector < int > groups;
+
+        for (int i = 0; i < ChainCount; ++i) {
+
+            const std::string & Str = chains [i].first;
+            const int TokenCount = \
+                (int) std::count (Str.begin (), Str.end (), ' ') + 1;
+            lens [i] = TokenCount / 2;
+
+            if (0 == i || HasPrefChanged (chains [i - 1].first, Str)) {
+                groups.push_back (i);
+            }
+        }
+
+        /// Stage 2: build patterns for shards of groups in parallel
+
+        // every shard starts at a group boundary
+        std::vector < int > shards;
+        const int MaxShardSize = \
+            (ChainCount / (g_Threads * ShardsPerThread)) + 1;
+
+        for (int i = 0; i < (int) groups.size (); ++i) {
+            const int From = groups [i];
+            if (shards.empty () || From - shards.back () >= MaxShardSize) {
+                shards.push_back (From);
+            }
+        }
+        const int ShardCount = (int) shards.size ();
+        shards.push_back (ChainCount);
+
+        // a task is a shard for one suff2pats object
+        const int ObjCount = g_DontCarePats ? g_MaxLeftCx : 1;
+        const int TaskCount = ShardCount * ObjCount;
+
+        std::vector < std::vector < FAPatSegment > > outs (TaskCount);
+        std::vector < std::exception_ptr > task_errors (TaskCount);
+        std::atomic < int > NextTask (0);
+
+        auto Worker = [&] () {
+            while (true) {
+                const int Task = NextTask++;
+                if (Task >= TaskCount)
+                    break;
+                const int Shard = Task / ObjCount;
+                const int Pos = Task % ObjCount;
+                try {
+                    BuildPatterns (chains, lens, shards [Shard], \
+                        shards [Shard + 1], Pos, &(outs [Task]));
+                } catch (...) {
+                    task_errors [Task] = std::current_exception ();
+                }
+            }
+        };
+
+        threads.clear ();
+        for (t = 0; t < g_Threads; ++t) {
+            threads.push_back (std::thread (Worker));
+        }
+        for (t = 0; t < g_Threads; ++t) {
+            threads [t].join ();
+        }
+        for (int Task = 0; Task < TaskCount; ++Task) {
+            if (task_errors [Task]) {
+                std::rethrow_exception (task_errors [Task]);
+            }
+        }
+
+        /// print the patterns in the sequential order
+
+        std::vector < FAPatSegment > segments;
+
+        for (int Task = 0; Task < TaskCount; ++Task) {
+            std::vector < FAPatSegment > & out = outs [Task];
+            for (int i = 0; i < (int) out.size (); ++i) {
+                segments.push_back (FAPatSegment ());
+                segments.back ().m_Idx = out [i].m_Idx;
+                segments.back ().m_Pos = out [i].m_Pos;
+                segments.back ().m_Text.swap (out [i].m_Text);
+            }
+            out.clear ();
+        }
+
+        std::stable_sort (segments.begin (), segments.end ());
+
+        for (int i = 0; i < (int) segments.size (); ++i) {
+            (*pOs) << segments [i].m_Text;
+        }
+
+    } catch (const FAException & e) {
+
+        const char * const pErrMsg = e.GetErrMsg ();
+        const char * const pFile = e.GetSourceName ();
+        const int Line = e.GetSourceLine ();
+
+        std::cerr << "ERROR: " << pErrMsg << " in " << pFile \
+            << " at line " << Line << " in program " << __PROG__ << '\n';
+
+        return 2;
+
+    } catch (...) {
+
+        std::cerr << "ERROR: Unknown error in program " << __PROG__ << '\n';
+        return 1;
+    }
+
+    // print out memory leaks, if any
+    FAPrintLeaks(&g_alloc, std::cerr);
+
+    return 0;
+}
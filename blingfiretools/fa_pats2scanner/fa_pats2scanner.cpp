@@ -0,0 +1,151 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "FAConfig.h"
+#include "FAAllocator.h"
+#include "FAUtils.h"
+#include "FAScannerCompiler.h"
+#include "FAException.h"
+
+#include <string>
+#include <iostream>
+#include <fstream>
+
+const char * __PROG__ = "";
+
+FAAllocator g_alloc;
+
+const char * pInFile = NULL;
+const char * pOutFile = NULL;
+
+
+void usage () {
+
+  std::cout << "\n\
+Usage: fa_pats2scanner [OPTION] [< patterns.txt] [> scanner.bin]\n\
+\n\
+This program compiles a set of regular expressions, one UTF-8 pattern per\n\
+line, into a single scanner image, the pattern id is the 0-based number of\n\
+the pattern among the non-empty lines. The scanner finds leftmost-longest\n\
+matches of all patterns together and extracts triangular brackets,\n\
+see FAScannerTools_t and test_scanner.\n\
+\n\
+  --in=<input-file>  - reads input from the <input-file>,\n\
+    if omited stdin is used\n\
+\n\
+  --out=<output-file> - writes output to the <output-file>,\n\
+    if omited stdout is used\n\
+\n\
+Example:\n\
+\n\
+  fa_pats2scanner --in=patterns.txt --out=scanner.bin\n\
+  test_scanner --scanner=scanner.bin < text.utf8\n\
+\n\
+";
+}
+
+
+void process_args (int& argc, char**& argv)
+{
+  for (; argc--; ++argv) {
+
+    if (!strcmp ("--help", *argv)) {
+      usage ();
+      exit (0);
+    }
+    if (0 == strncmp ("--in=", *argv, 5)) {
+      pInFile = &((*argv) [5]);
+      continue;
+    }
+    if (0 == strncmp ("--out=", *argv, 6)) {
+      pOutFile = &((*argv) [6]);
+      continue;
+    }
+  }
+}
+
+
+int __cdecl main (int argc, char ** argv)
+{
+    __PROG__ = argv [0];
+
+    --argc, ++argv;
+
+    ::FAIOSetup ();
+
+    // parse a command line
+    process_args (argc, argv);
+
+    try {
+
+        std::istream * pIs = &std::cin;
+        std::ifstream ifs;
+        std::ostream * pOs = &std::cout;
+        std::ofstream ofs;
+
+        if (NULL != pInFile) {
+            ifs.open (pInFile, std::ios::in);
+            FAAssertStream (&ifs, pInFile);
+            pIs = &ifs;
+        }
+        if (NULL != pOutFile) {
+            ofs.open (pOutFile, std::ios::out | std::ios::binary);
+            pOs = &ofs;
+        }
+        DebugLogAssert (pIs && pOs);
+
+        FAScannerCompiler pats2scanner (&g_alloc);
+
+        std::string line;
+        int PatCount = 0;
+
+        while (std::getline (*pIs, line)) {
+
+            // allow DOS line endings
+            if (!line.empty () && '\r' == line [line.length () - 1]) {
+                line.erase (line.length () - 1);
+            }
+            if (line.empty ()) {
+                continue;
+            }
+
+            pats2scanner.AddPattern (line.c_str (), (int) line.length ());
+            PatCount++;
+        }
+
+        if (0 == PatCount) {
+            std::cerr << "ERROR: No patterns in program " << __PROG__ << '\n';
+            return 2;
+        }
+
+        pats2scanner.Process ();
+
+        const unsigned char * pDump = NULL;
+        const int DumpSize = pats2scanner.GetDump (&pDump);
+        DebugLogAssert (0 < DumpSize && pDump);
+
+        pOs->write ((const char *) pDump, DumpSize);
+        pOs->flush ();
+
+    } catch (const FAException & e) {
+
+        const char * const pErrMsg = e.GetErrMsg ();
+        const char * const pFile = e.GetSourceName ();
+        const int Line = e.GetSourceLine ();
+
+        std::cerr << "ERROR: " << pErrMsg << " in " << pFile \
+            << " at line " << Line << " in program " << __PROG__ << '\n';
+
+        return 2;
+
+    } catch (...) {
+
+        std::cerr << "ERROR: Unknown error in program " << __PROG__ << '\n';
+        return 1;
+    }
+
+    return 0;
+}
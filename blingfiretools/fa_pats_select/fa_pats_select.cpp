@@ -30,8 +30,13 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <iomanip>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <memory>
 
 const char * __PROG__ = "";
 
@@ -73,6 +78,11 @@ const FAMultiMapCA * g_pI2Info = NULL;
 bool g_NoEmpty = false;
 bool g_TakeAll = false;
 
+int g_Threads = 1;
+
+// the number of lines read at once per thread
+const int LinesPerThread = 4096;
+
 
 void usage () {
 
@@ -119,6 +129,10 @@ patterns from the set of all existing patterns.\n\
 \n\
   --take-all-pats - takes all patterns, skips the stage of calculating a subset\n\
     this key should be used to improve recall on unknown words\n\
+\n\
+  --threads=N - matches patterns against the input in N threads, the\n\
+    selection is made in the input order, so the output does not depend\n\
+    on N, 1 is used by default\n\
 \n\
 ";
 }
@@ -189,6 +203,10 @@ void process_args (int& argc, char**& argv)
             g_TakeAll = true;
             continue;
         }
+        if (0 == strncmp ("--threads=", *argv, 10)) {
+            g_Threads = atoi (&((*argv) [10]));
+            continue;
+        }
     }
 }
 
@@ -307,6 +325,202 @@ void  FASelectTrPatterns_print::
 }
 
 
+///
+/// Per-thread data: matches patterns against the input lines, keeps covers
+/// and the unsolved entries of each line.
+///
+
+class FAPatsSelectWorker {
+
+public:
+    FAPatsSelectWorker (std::ostream * pUnOs);
+
+public:
+    /// calculates covers of lines ThreadId, ThreadId + ThreadCount, ...
+    void Process (
+            const int ThreadId,
+            const int ThreadCount,
+            const std::vector < std::string > * pLines,
+            std::vector < std::vector < int > > * pCovers,
+            std::vector < std::string > * pUnsolved,
+            std::vector < std::exception_ptr > * pErrors
+        );
+
+private:
+    void ProcessLine (
+            const std::string & line,
+            std::vector < int > & Cover,
+            std::string & Unsolved
+        );
+
+private:
+    std::ostringstream m_un_os;
+    FASelectTrPatterns_print m_pat2pat;
+
+    int m_Iws [FALimits::MaxWordLen];
+    int m_Ows [FALimits::MaxWordLen];
+};
+
+
+FAPatsSelectWorker::FAPatsSelectWorker (std::ostream * pUnOs) :
+    m_pat2pat (&g_alloc, NULL, pUnOs ? &m_un_os : NULL)
+{
+    m_pat2pat.SetNoEmpty (g_NoEmpty);
+    m_pat2pat.SetFsm (g_pDfa, g_pMealy, g_pOw2Iw);
+    m_pat2pat.SetK2I (g_pK2I);
+    m_pat2pat.SetI2Info (g_pI2Info);
+
+    /// add left anchor
+    m_Iws [0] = g_spec_l_anchor;
+    m_Ows [0] = FAFsmConst::HYPH_NO_HYPH;
+}
+
+
+void FAPatsSelectWorker::
+    ProcessLine (
+        const std::string & line,
+        std::vector < int > & Cover,
+        std::string & Unsolved
+    )
+{
+    Cover.clear ();
+    Unsolved.clear ();
+
+    const char * pLine = line.c_str ();
+    int LineLen = (const int) line.length ();
+
+    if (0 < LineLen) {
+        DebugLogAssert (pLine);
+        if (0x0D == (unsigned char) pLine [LineLen - 1])
+            LineLen--;
+    }
+    if (0 < LineLen) {
+
+        /// str -> chains
+        int Count = FATrWordIOTools_utf8::Str2IwOw (pLine, LineLen, \
+            m_Iws + 1, m_Ows + 1, FALimits::MaxWordLen - 2,
+            g_ignore_case, g_pMap);
+
+        /// add right anchor
+        if (Count + 1 < FALimits::MaxWordLen) {
+            m_Iws [Count + 1] = g_spec_r_anchor;
+            m_Ows [Count + 1] = FAFsmConst::HYPH_NO_HYPH;
+        }
+
+        Count += 2;
+
+        const int * pCover = NULL;
+        const int Size = m_pat2pat.GetCover (m_Iws, m_Ows, Count, &pCover);
+
+        Cover.assign (pCover, pCover + Size);
+
+        // take the unsolved entries printed for this line
+        Unsolved = m_un_os.str ();
+        m_un_os.str (std::string ());
+    }
+}
+
+
+void FAPatsSelectWorker::
+    Process (
+        const int ThreadId,
+        const int ThreadCount,
+        const std::vector < std::string > * pLines,
+        std::vector < std::vector < int > > * pCovers,
+        std::vector < std::string > * pUnsolved,
+        std::vector < std::exception_ptr > * pErrors
+    )
+{
+    DebugLogAssert (pLines && pCovers && pUnsolved && pErrors);
+
+    const int LineCount = (int) pLines->size ();
+
+    for (int i = ThreadId; i < LineCount; i += ThreadCount) {
+        try {
+            ProcessLine ((*pLines) [i], (*pCovers) [i], (*pUnsolved) [i]);
+        } catch (...) {
+            (*pErrors) [i] = std::current_exception ();
+        }
+    }
+}
+
+
+///
+/// Makes the selection with the matching done in g_Threads threads.
+///
+
+void SelectMt (
+        std::istream * pIs,
+        std::ostream * pUnOs,
+        FASelectTrPatterns * pPat2Pat
+    )
+{
+    DebugLogAssert (pIs && pPat2Pat);
+    DebugLogAssert (1 < g_Threads);
+
+    std::vector < std::unique_ptr < FAPatsSelectWorker > > workers (g_Threads);
+    for (int t = 0; t < g_Threads; ++t) {
+        workers [t].reset (new FAPatsSelectWorker (pUnOs));
+    }
+
+    const int MaxChunkSize = g_Threads * LinesPerThread;
+
+    std::vector < std::string > lines;
+    std::vector < std::vector < int > > covers;
+    std::vector < std::string > unsolved;
+    std::vector < std::exception_ptr > errors;
+    std::vector < std::thread > threads;
+    std::string line;
+
+    while (!(pIs->eof ())) {
+
+        // read the next chunk of lines
+        lines.clear ();
+
+        while ((int) lines.size () < MaxChunkSize) {
+            if (!std::getline (*pIs, line))
+                break;
+            lines.push_back (line);
+        }
+
+        const int LineCount = (int) lines.size ();
+        if (0 == LineCount)
+            break;
+
+        covers.resize (LineCount);
+        unsolved.resize (LineCount);
+        errors.assign (LineCount, std::exception_ptr ());
+
+        // calculate covers
+        threads.clear ();
+        for (int t = 0; t < g_Threads; ++t) {
+            threads.push_back (std::thread (&FAPatsSelectWorker::Process, \
+                workers [t].get (), t, g_Threads, &lines, &covers, \
+                &unsolved, &errors));
+        }
+        for (int t = 0; t < g_Threads; ++t) {
+            threads [t].join ();
+        }
+
+        // make the selection in the input order
+        for (int i = 0; i < LineCount; ++i) {
+
+            if (errors [i]) {
+                std::rethrow_exception (errors [i]);
+            }
+            if (pUnOs) {
+                (*pUnOs) << unsolved [i];
+            }
+
+            const std::vector < int > & Cover = covers [i];
+            const int Size = (int) Cover.size ();
+            pPat2Pat->AddCover (0 < Size ? Cover.data () : NULL, Size);
+        }
+
+    } // of while (!(pIs->eof ())) ...
+}
+
+
 int __cdecl main (int argc, char ** argv)
 {
     __PROG__ = argv [0];
@@ -422,7 +636,18 @@ int __cdecl main (int argc, char ** argv)
         FASelectTrPatterns_print Pat2Pat (&g_alloc, pOs, pUnOs);
 
         // see if a subset should be calculated
-        if (false == g_TakeAll) {
+        if (false == g_TakeAll && 1 < g_Threads) {
+
+            Pat2Pat.SetNoEmpty (g_NoEmpty);
+            Pat2Pat.SetFsm (g_pDfa, g_pMealy, g_pOw2Iw);
+            Pat2Pat.SetK2I (g_pK2I);
+            Pat2Pat.SetI2Info (g_pI2Info);
+
+            SelectMt (pIs, pUnOs, &Pat2Pat);
+
+            Pat2Pat.Process ();
+
+        } else if (false == g_TakeAll) {
 
             Pat2Pat.SetNoEmpty (g_NoEmpty);
             Pat2Pat.SetFsm (g_pDfa, g_pMealy, g_pOw2Iw);
@@ -17,6 +17,7 @@
 #include "FAMultiMap_pack.h"
 #include "FAParser_triv_t.h"
 #include "FAParser_nest_t.h"
+#include "FAParserCascade_t.h"
 #include "FAWreLexTools_t.h"
 #include "FAWreLexTools_t.h"
 #include "FAParserConfKeeper.h"
@@ -52,6 +53,7 @@ bool g_no_pos_tags = false;
 bool g_no_output = false;
 bool g_no_process = false;
 bool g_verbose = false;
+bool g_cascade = false;
 
 int g_MaxPassCount = 1;
 int g_AlgType = FAFsmConst::PARSER_TRIV;
@@ -93,6 +95,8 @@ space separated.\n\
     triv - no overlaps, no inclusions, left most longest\n\
     nest - no overlaps, no same tag inclusions, left most longest\n\
     wre-lex - uses FAWreLexTools_t algorithm, allows to have _function calls\n\
+    cascade - runs all the stages from the wre-cascade section of the --ldb=\n\
+      LDB one after another, words are digitized once per distinct digitizer\n\
 \n\
   --max-pass-count=N - specifies the maximum number of passes for parser,\n\
     1 is used by default\n\
@@ -156,6 +160,10 @@ void process_args (int& argc, char**& argv)
         g_AlgType = FAFsmConst::PARSER_WRE_LEX;
         continue;
     }
+    if (0 == strcmp ("--alg=cascade", *argv)) {
+        g_cascade = true;
+        continue;
+    }
     if (0 == strncmp ("--max-pass-count=", *argv, 17)) {
         g_MaxPassCount = atoi (&((*argv) [17]));
         continue;
@@ -223,6 +231,7 @@ int __cdecl main (int argc, char ** argv)
         FAParser_triv_t < int > g_parser_triv (&g_alloc);
         FAParser_nest_t < int > g_parser_nest (&g_alloc);
         FAParser_base_t < int > * g_pParser = NULL;
+        FAParserCascade_t < int > g_cascade_parser (&g_alloc);
         // input tagged text
         FATaggedText g_text (&g_alloc);
         FATaggedTextA * pInText = &g_text;
@@ -275,7 +284,26 @@ int __cdecl main (int argc, char ** argv)
         }
 
         // load and set up the compiled grammar
-        if (g_pStageFile) {
+        if (g_cascade) {
+
+            FAAssert (g_pInLDBFile, FAMsg::InvalidParameters);
+
+            const int * pValues = NULL;
+            const int Size = g_ldb.GetHeader ()->Get (FAFsmConst::FUNC_WRE_CASCADE, &pValues);
+            FAAssert (0 < Size, FAMsg::IOError);
+
+            g_cascade_parser.Initialize (&g_ldb, pValues, Size);
+            g_cascade_parser.SetTagDict (&g_tag_dict);
+            g_cascade_parser.SetParseTree (&g_tree);
+            g_cascade_parser.SetResume (g_resume);
+
+            if (g_verbose) {
+                std::cerr << "stages: " << g_cascade_parser.GetStageCount ()
+                    << ", text digitizers: "
+                    << g_cascade_parser.GetTxtDigitizerCount () << '\n';
+            }
+
+        } else if (g_pStageFile) {
 
             g_StageImg.Load (g_pStageFile);
             const unsigned char * pImg = g_StageImg.GetImageDump ();
@@ -302,7 +330,11 @@ int __cdecl main (int argc, char ** argv)
             g_conf.Initialize (&g_ldb, pValues, Size);
         }
 
-        if (FAFsmConst::PARSER_TRIV == g_AlgType || \
+        if (g_cascade) {
+
+            // already set up
+
+        } else if (FAFsmConst::PARSER_TRIV == g_AlgType || \
             FAFsmConst::PARSER_NEST == g_AlgType) {
 
             const FAWREConfCA * pWre = g_conf.GetWre ();
@@ -341,7 +373,29 @@ int __cdecl main (int argc, char ** argv)
 
             if (!g_no_process && 0 < WordCount) {
 
-                if (FAFsmConst::PARSER_TRIV == g_AlgType || \
+                if (g_cascade) {
+
+                    for (int i = 0; i < WordCount; ++i) {
+
+                        const int * pWord;
+                        const int WordLen = pInText->GetWord (i, &pWord);
+                        DebugLogAssert (0 < WordLen && pWord);
+
+                        const int Tag = pInText->GetTag (i);
+                        DebugLogAssert (0 < Tag);
+
+                        g_cascade_parser.AddWord (pWord, WordLen, Tag);
+                    }
+
+                    g_cascade_parser.Process ();
+
+                    if (false == g_no_output) {
+                        g_txt_io.SetNoPosTags (false);
+                        g_txt_io.Print (*g_pOs, pInText, &g_tree);
+                        g_txt_io.SetNoPosTags (g_no_pos_tags);
+                    }
+
+                } else if (FAFsmConst::PARSER_TRIV == g_AlgType || \
                     FAFsmConst::PARSER_NEST == g_AlgType) {
 
                     for (int i = 0; i < WordCount; ++i) {
@@ -8,8 +8,9 @@
 #include "FAAllocator.h"
 #include "FAMapIOTools.h"
 #include "FACorpusIOTools_utf8.h"
+#include "FACorpusReader_utf8.h"
+#include "FACorpusWriter_bin.h"
 #include "FATagSet.h"
-#include "FATaggedText.h"
 #include "FATaggedTextStat.h"
 #include "FAPrintUtils.h"
 #include "FAUtils.h"
@@ -26,6 +27,7 @@ const char * __PROG__ = "";
 FAAllocator g_alloc;
 
 const char * g_pInFile = NULL;
+const char * g_pOutBinFile = NULL;
 const char * g_pTagsetFile = NULL;
 
 const FATagSet * g_pTagSet = NULL;
@@ -44,8 +46,7 @@ const char * g_pOutFile_tttt = NULL;
 const char * g_pOutFile_w_t = NULL;
 const char * g_pOutFile_tw = NULL;
 
-std::istream * g_pIs = &std::cin;
-std::ifstream g_ifs;
+std::ofstream g_ofs_bin;
 
 std::ofstream g_ofs_w ;
 std::ofstream g_ofs_ww ;
@@ -98,7 +99,10 @@ This program collects different kinds of statistics from the tagged text.\n\
 Input/Output:\n\
 \n\
   --in=<input> - reads input text from the <input> file,\n\
-    if omited stdin is used\n\
+    if omited stdin is used, the file can also be a binary corpus\n\
+\n\
+  --out-bin=<output> - writes the input corpus in binary format to the\n\
+    <output> file, reading it back with --in is faster than the text\n\
 \n\
   --tagset=<tagset> - reads input tagset from the <tagset> file,\n\
     have to be specified\n\
@@ -219,6 +223,10 @@ void process_args (int& argc, char**& argv)
         g_pInFile = &((*argv) [5]);
         continue;
     }
+    if (0 == strncmp ("--out-bin=", *argv, 10)) {
+        g_pOutBinFile = &((*argv) [10]);
+        continue;
+    }
     if (0 == strncmp ("--out-w=", *argv, 8)) {
         g_pOutFile_w = &((*argv) [8]);
         g_StatMask |= FAFsmConst::STAT_TYPE_W;
@@ -649,16 +657,25 @@ int __cdecl main (int argc, char ** argv)
         // tagset
         FATagSet g_tagset (&g_alloc);
         g_pTagSet = &g_tagset;
-        // input tagged text
-        FATaggedText g_text (&g_alloc);
+        // input tagged text, the reader keeps the current sentence
+        FACorpusReader_utf8 g_text (&g_alloc);
+        // binary corpus output
+        FACorpusWriter_bin g_bin_out (&g_alloc);
 
         g_txt_io.SetTagSet (&g_tagset);
+        g_text.SetTagSet (&g_tagset);
 
-        /// adjust IO pointers; stdin is used if g_pInFile is not specified.
+        /// the file is memory mapped; stdin is used if g_pInFile is not specified.
         if (g_pInFile) {
-            g_ifs.open (g_pInFile, std::ios::in);
-            FAAssertStream (&g_ifs, g_pInFile);
-            g_pIs = &g_ifs;
+            g_text.Open (g_pInFile);
+        } else {
+            g_text.Open (&std::cin);
+        }
+
+        if (g_pOutBinFile) {
+            g_ofs_bin.open (g_pOutBinFile, std::ios::out | std::ios::binary);
+            FAAssertStream (&g_ofs_bin, g_pOutBinFile);
+            g_bin_out.SetStream (&g_ofs_bin);
         }
 
         /// load POS tagset and get the EOS/BOS tag IDs from the input args.
@@ -707,21 +724,25 @@ int __cdecl main (int argc, char ** argv)
         unsigned int sc = 0;
 
         /// process input, line by line
-        while (!g_pIs->eof ()) {
+        while (!g_text.IsEof ()) {
 
             LineNum++;
 
             // see if the IO errors should not be ignored
             if (false == g_force) {
-                g_txt_io.Read (*g_pIs, &g_text);
+                g_text.Read ();
             } else {
                 try {
-                    g_txt_io.Read (*g_pIs, &g_text);
+                    g_text.Read ();
                 } catch (const FAException & ) {
                     g_text.Clear ();
                 }
             }
 
+            if (g_pOutBinFile) {
+                g_bin_out.Print (&g_text);
+            }
+
             if (g_print_input) {
                 g_txt_io.Print (std::cout, &g_text);
             }
@@ -756,7 +777,11 @@ int __cdecl main (int argc, char ** argv)
                 }
             }
 
-        } // of while (!g_pIs->eof ()) ...
+        } // of while (!g_text.IsEof ()) ...
+
+        if (g_pOutBinFile) {
+            g_bin_out.Finish ();
+        }
 
         if (g_verbose) {
             std::cerr << "              \r" << wc << '\n';
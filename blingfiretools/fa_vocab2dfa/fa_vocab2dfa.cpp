@@ -0,0 +1,500 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "FAConfig.h"
+#include "FAAllocator.h"
+#include "FAUtils.h"
+#include "FAAutIOTools.h"
+#include "FAMapIOTools.h"
+#include "FARSDfa_ro.h"
+#include "FAState2Ow.h"
+#include "FAChains2MinDfa_sort.h"
+#include "FARSDfa2MooreDfa.h"
+#include "FAUtf8Utils.h"
+#include "FAUtf32Utils.h"
+#include "FALimits.h"
+#include "FAFsmConst.h"
+#include "FAException.h"
+
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <string>
+#include <iostream>
+#include <fstream>
+
+const char * __PROG__ = "";
+
+FAAllocator g_alloc;
+FAAutIOTools g_io (&g_alloc);
+
+const char * pInFile = NULL;
+const char * pOutFile = NULL;
+
+const char * pK2IFile = NULL;
+const char * pVocabFile = NULL;
+
+bool g_ignore_case = false;
+bool g_mph = false;
+bool g_mwe = false;
+bool g_delta = false;
+
+// Ows are encoded as Iws bigger than any Unicode symbol
+const int DefOwBase = 0x110000;
+
+// phrase words are separated with spaces
+const int MweDelim = ' ';
+
+
+void usage () {
+
+  std::cout << "\n\
+Usage: fa_vocab2dfa [OPTION] [< vocab.txt] [> output.txt]\n\
+\n\
+This program builds a minimal Moore automaton from the vocabulary of\n\
+tokens, one UTF-8 token per line, the token id is the 0-based line number.\n\
+The output automaton maps tokens into ids, it is used by the WordPiece\n\
+runtime, see FAWordPieceTools_t, continuation tokens are expected to be\n\
+prefixed with \"##\".\n\
+\n\
+  --in=<input-file>  - reads input from the <input-file>,\n\
+    if omited stdin is used\n\
+\n\
+  --out=<output-file> - writes output to the <output-file>,\n\
+    if omited stdout is used\n\
+\n\
+  --ignore-case - converts input tokens to the lower case, if a duplicate\n\
+    token appears after that, the smallest id is kept\n\
+\n\
+  --type=moore-dfa - builds Moore automaton with ids as reactions,\n\
+    this is the default\n\
+\n\
+  --type=mph - builds Rabin-Scott automaton of tokens only, it is used as an\n\
+    input for fa_dfa2mph, token ids are written by the --out-k2i\n\
+\n\
+  --out-k2i=<output-file> - writes the array of token ids in the order of\n\
+    MPH keys, used only with --type=mph\n\
+\n\
+  --delta - reads a delta vocabulary, every line is a token and its id\n\
+    separated by a tab, the id of -1 removes the token from the main\n\
+    vocabulary, the ids are the ids of the main vocabulary (the InfoIds of\n\
+    the main dictionary), see FADictInterpreter_t::SetDelta\n\
+\n\
+  --type=mwe - reads a phrase dictionary, one phrase of space separated\n\
+    words per line, the phrase id is the 0-based line number, and builds\n\
+    Moore automaton from the sequences of the word ids into the phrase ids,\n\
+    it is used by FAMweTools, the words are expected to be broken the same\n\
+    way as the word-breaker does it\n\
+\n\
+  --vocab=<input-file> - the vocabulary of the whole word ids, used only\n\
+    with --type=mwe, should be the same as for the [vocab] section, phrases\n\
+    with words not in the vocabulary are skipped\n\
+\n\
+Example:\n\
+\n\
+  fa_vocab2dfa --in=vocab.txt --ignore-case --out=vocab.fsa.txt\n\
+  fa_fsm2fsm_pack --alg=triv --type=moore-dfa --in=vocab.fsa.txt --out=vocab.fsa.dump --auto-test\n\
+\n\
+  and in the ldb.conf:\n\
+\n\
+  [wordpiece]\n\
+  fsm N\n\
+  unknown <[UNK] id>\n\
+  ignore-case\n\
+  max-length 100\n\
+\n\
+Example of the MPH vocabulary for the whole words:\n\
+\n\
+  fa_vocab2dfa --in=vocab.txt --type=mph --out=vocab.dfa.txt --out-k2i=vocab.k2i.txt\n\
+  fa_dfa2mph --type=mealy-dfa < vocab.dfa.txt > vocab.mph.txt\n\
+  fa_fsm2fsm_pack --alg=triv --type=mealy-dfa --in=vocab.mph.txt --out=vocab.mph.dump --auto-test\n\
+  fa_fsm2fsm_pack --type=arr --force-flat --in=vocab.k2i.txt --out=vocab.k2i.dump --auto-test\n\
+\n\
+  and in the ldb.conf:\n\
+\n\
+  [vocab]\n\
+  fsm-type mealy-dfa\n\
+  fsm N\n\
+  array M\n\
+  unknown <[UNK] id>\n\
+  ignore-case\n\
+\n\
+Example of the phrase dictionary over the vocabulary above:\n\
+\n\
+  fa_vocab2dfa --in=phrases.txt --type=mwe --vocab=vocab.txt --ignore-case --out=mwe.fsa.txt\n\
+  fa_fsm2fsm_pack --alg=triv --type=moore-dfa --in=mwe.fsa.txt --out=mwe.fsa.dump --auto-test\n\
+\n\
+  and in the ldb.conf:\n\
+\n\
+  [mwe]\n\
+  fsm-type moore-dfa\n\
+  fsm K\n\
+\n\
+";
+}
+
+
+void process_args (int& argc, char**& argv)
+{
+  for (; argc--; ++argv) {
+
+    if (!strcmp ("--help", *argv)) {
+      usage ();
+      exit (0);
+    }
+    if (0 == strncmp ("--in=", *argv, 5)) {
+      pInFile = &((*argv) [5]);
+      continue;
+    }
+    if (0 == strncmp ("--out=", *argv, 6)) {
+      pOutFile = &((*argv) [6]);
+      continue;
+    }
+    if (0 == strcmp ("--ignore-case", *argv)) {
+      g_ignore_case = true;
+      continue;
+    }
+    if (0 == strcmp ("--type=moore-dfa", *argv)) {
+      g_mph = false;
+      g_mwe = false;
+      continue;
+    }
+    if (0 == strcmp ("--type=mph", *argv)) {
+      g_mph = true;
+      g_mwe = false;
+      continue;
+    }
+    if (0 == strcmp ("--type=mwe", *argv)) {
+      g_mph = false;
+      g_mwe = true;
+      continue;
+    }
+    if (0 == strncmp ("--vocab=", *argv, 8)) {
+      pVocabFile = &((*argv) [8]);
+      continue;
+    }
+    if (0 == strncmp ("--out-k2i=", *argv, 10)) {
+      pK2IFile = &((*argv) [10]);
+      continue;
+    }
+    if (0 == strcmp ("--delta", *argv)) {
+      g_delta = true;
+      continue;
+    }
+  }
+}
+
+
+// compares chains by the token part only, the ids are not compared
+inline const bool KeyEqual (const std::vector < int > & c1, 
+                            const std::vector < int > & c2)
+{
+    if (c1.size () != c2.size ()) {
+        return false;
+    }
+    return std::equal (c1.begin (), c1.end () - 1, c2.begin ());
+}
+
+
+// compares chains by the token part first and by the id next
+inline const bool KeyLess (const std::vector < int > & c1, 
+                           const std::vector < int > & c2)
+{
+    if (std::lexicographical_compare (c1.begin (), c1.end () - 1, \
+            c2.begin (), c2.end () - 1)) {
+        return true;
+    }
+    if (std::lexicographical_compare (c2.begin (), c2.end () - 1, \
+            c1.begin (), c1.end () - 1)) {
+        return false;
+    }
+    return c1.back () < c2.back ();
+}
+
+
+// reads the vocabulary, token -> id, for duplicate tokens the smallest id is kept
+void ReadVocab (
+        std::istream & is,
+        std::map < std::vector < int >, int > & word2id,
+        int * pMaxId
+    )
+{
+    int Chain [FALimits::MaxWordLen];
+    std::string line;
+    int LineNum = 0;
+
+    *pMaxId = -1;
+
+    while (std::getline (is, line)) {
+
+        // allow DOS line endings
+        if (!line.empty () && '\r' == line [line.length () - 1]) {
+            line.erase (line.length () - 1);
+        }
+
+        const int Id = LineNum++;
+
+        const int Size = ::FAStrUtf8ToArray (line.c_str (), \
+            (int) line.length (), Chain, FALimits::MaxWordLen);
+        FAAssert (0 <= Size, FAMsg::IOError);
+
+        if (0 < Size) {
+            if (g_ignore_case) {
+                ::FAUtf32StrLower (Chain, Size);
+            }
+            // std::map::insert keeps the first, the smallest, id
+            word2id.insert (std::make_pair (std::vector < int > (Chain, Chain + Size), Id));
+            *pMaxId = Id;
+        }
+    }
+}
+
+
+// converts the phrase into the word ids, returns false if some word is unknown
+const bool Phrase2Ids (
+        const int * pPhrase,
+        const int Size,
+        const std::map < std::vector < int >, int > & word2id,
+        std::vector < int > & ids
+    )
+{
+    ids.clear ();
+
+    int From = 0;
+
+    while (From < Size) {
+
+        // skip delimiters
+        if (MweDelim == pPhrase [From]) {
+            From++;
+            continue;
+        }
+
+        int To = From;
+        while (To < Size && MweDelim != pPhrase [To]) {
+            To++;
+        }
+
+        std::map < std::vector < int >, int >::const_iterator it = \
+            word2id.find (std::vector < int > (pPhrase + From, pPhrase + To));
+
+        if (word2id.end () == it) {
+            return false;
+        }
+        ids.push_back (it->second);
+        From = To;
+    }
+
+    return !ids.empty ();
+}
+
+
+int __cdecl main (int argc, char ** argv)
+{
+    __PROG__ = argv [0];
+
+    --argc, ++argv;
+
+    ::FAIOSetup ();
+
+    // parse a command line
+    process_args (argc, argv);
+
+    try {
+
+        std::istream * pIs = &std::cin;
+        std::ifstream ifs;
+        std::ostream * pOs = &std::cout;
+        std::ofstream ofs;
+
+        if (NULL != pInFile) {
+            ifs.open (pInFile, std::ios::in);
+            FAAssertStream (&ifs, pInFile);
+            pIs = &ifs;
+        }
+        if (NULL != pOutFile) {
+            ofs.open (pOutFile, std::ios::out);
+            pOs = &ofs;
+        }
+        DebugLogAssert (pIs && pOs);
+
+        // the word vocabulary of the phrases, word ids are the Iws of MWE automaton
+        std::map < std::vector < int >, int > word2id;
+        std::vector < int > ids;
+        int OwBase = DefOwBase;
+        int SkipCount = 0;
+
+        if (g_mwe) {
+
+            if (NULL == pVocabFile) {
+                std::cerr << "ERROR: --vocab is not specified in program " \
+                    << __PROG__ << '\n';
+                return 2;
+            }
+
+            std::ifstream vocab_ifs (pVocabFile, std::ios::in);
+            FAAssertStream (&vocab_ifs, pVocabFile);
+
+            int MaxWordId = -1;
+            ReadVocab (vocab_ifs, word2id, &MaxWordId);
+            OwBase = MaxWordId + 1;
+        }
+
+        // read the vocabulary, every chain is the token followed by its id
+        std::vector < std::vector < int > > chains;
+        int Chain [FALimits::MaxWordLen + 1];
+        std::string line;
+        int LineNum = 0;
+        int MaxId = -1;
+
+        while (std::getline (*pIs, line)) {
+
+            // allow DOS line endings
+            if (!line.empty () && '\r' == line [line.length () - 1]) {
+                line.erase (line.length () - 1);
+            }
+
+            // the id is the line number or is given explicitly for deltas
+            int Id = LineNum++;
+
+            if (g_delta) {
+
+                const size_t Tab = line.rfind ('\t');
+
+                if (std::string::npos == Tab) {
+                    std::cerr << "ERROR: No id at line " << LineNum \
+                        << " in program " << __PROG__ << '\n';
+                    return 2;
+                }
+
+                Id = atoi (line.c_str () + Tab + 1);
+                line.erase (Tab);
+
+                if (-1 == Id) {
+                    Id = FAFsmConst::DICT_DELETED_ID;
+                } else if (0 > Id || FAFsmConst::DICT_DELETED_ID <= Id) {
+                    std::cerr << "ERROR: Bad id at line " << LineNum \
+                        << " in program " << __PROG__ << '\n';
+                    return 2;
+                }
+            }
+
+            const int Size = ::FAStrUtf8ToArray (line.c_str (), \
+                (int) line.length (), Chain, FALimits::MaxWordLen);
+
+            if (0 > Size) {
+                std::cerr << "ERROR: Invalid UTF-8 token at line " << LineNum \
+                    << " in program " << __PROG__ << '\n';
+                return 2;
+            }
+            if (0 < Size) {
+                if (g_ignore_case) {
+                    ::FAUtf32StrLower (Chain, Size);
+                }
+                if (g_mwe) {
+                    // the phrase chain is its word ids followed by the phrase id
+                    if (!Phrase2Ids (Chain, Size, word2id, ids)) {
+                        SkipCount++;
+                        continue;
+                    }
+                    ids.push_back (OwBase + Id);
+                    chains.push_back (ids);
+                    if (MaxId < Id) {
+                        MaxId = Id;
+                    }
+                    continue;
+                }
+                Chain [Size] = OwBase + Id;
+                chains.push_back (std::vector < int > (Chain, Chain + Size + 1));
+                if (MaxId < Id) {
+                    MaxId = Id;
+                }
+            }
+        }
+
+        if (0 < SkipCount) {
+            std::cerr << "WARNING: " << SkipCount << " phrase(s) with words not" \
+                << " in the vocabulary are skipped in program " << __PROG__ << '\n';
+        }
+        if (chains.empty ()) {
+            std::cerr << "ERROR: The vocabulary is empty in program " \
+                << __PROG__ << '\n';
+            return 2;
+        }
+
+        // sort the chains, for equal tokens the smallest id goes first
+        if (g_mph) {
+            // the ids are not a part of the MPH keys
+            std::sort (chains.begin (), chains.end (), KeyLess);
+        } else {
+            std::sort (chains.begin (), chains.end ());
+        }
+
+        FAChains2MinDfa_sort chains2mdfa (&g_alloc);
+
+        // MPH keys are numbered in the lexicographic order of tokens
+        std::vector < int > k2i;
+
+        for (size_t i = 0; i < chains.size (); ++i) {
+            // skip duplicate tokens
+            if (0 < i && KeyEqual (chains [i - 1], chains [i])) {
+                continue;
+            }
+            if (g_mph) {
+                // add the token only and keep its id in the K2I array
+                chains2mdfa.AddChain (chains [i].data (), (int) chains [i].size () - 1);
+                k2i.push_back (chains [i].back () - OwBase);
+            } else {
+                chains2mdfa.AddChain (chains [i].data (), (int) chains [i].size ());
+            }
+        }
+        chains2mdfa.Prepare ();
+
+        if (g_mph) {
+
+            g_io.Print (*pOs, &chains2mdfa);
+
+            if (NULL != pK2IFile) {
+                std::ofstream k2i_ofs (pK2IFile, std::ios::out);
+                FAMapIOTools map_io (&g_alloc);
+                map_io.Print (k2i_ofs, k2i.data (), (int) k2i.size ());
+            }
+
+            return 0;
+        }
+
+        // move ids into the Moore reaction
+        FARSDfa_ro moore_dfa (&g_alloc);
+        FAState2Ow moore_ows (&g_alloc);
+        FARSDfa2MooreDfa rs2moore (&g_alloc);
+
+        rs2moore.SetRSDfa (&chains2mdfa);
+        rs2moore.SetMooreDfa (&moore_dfa);
+        rs2moore.SetState2Ow (&moore_ows);
+        rs2moore.SetOwsRange (OwBase, OwBase + MaxId + 1);
+        rs2moore.Process ();
+
+        g_io.Print (*pOs, &moore_dfa, &moore_ows);
+
+    } catch (const FAException & e) {
+
+        const char * const pErrMsg = e.GetErrMsg ();
+        const char * const pFile = e.GetSourceName ();
+        const int Line = e.GetSourceLine ();
+
+        std::cerr << "ERROR: " << pErrMsg << " in " << pFile \
+            << " at line " << Line << " in program " << __PROG__ << '\n';
+
+        return 2;
+
+    } catch (...) {
+
+        std::cerr << "ERROR: Unknown error in program " << __PROG__ << '\n';
+        return 1;
+    }
+
+    return 0;
+}
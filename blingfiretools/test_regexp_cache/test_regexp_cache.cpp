@@ -0,0 +1,537 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "FAConfig.h"
+#include "FAAllocator.h"
+#include "FAUtils.h"
+#include "FAFsmConst.h"
+#include "FAUtf8Utils.h"
+#include "FARSDfaCA.h"
+#include "FARegexpCache.h"
+#include "FAException.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <exception>
+#include <iostream>
+#include <fstream>
+#include <string.h>
+
+const char * __PROG__ = "";
+
+FAAllocator g_alloc;
+
+const char * pInFile = NULL;
+const char * pOutFile = NULL;
+
+bool g_self_test = false;
+int g_max_count = -2;
+int g_max_states = -2;
+int g_max_nfa_states = -2;
+int g_threads = 4;
+int g_repeat = 1000;
+
+
+void usage () {
+
+  std::cout << "\n\
+Usage: test_regexp_cache [OPTION] [< input.txt] [> output.txt]\n\
+\n\
+This program matches texts against regular expressions compiled in memory\n\
+by FARegexpCache. Every input line is <regexp><TAB><text> in UTF-8, the\n\
+regexp uses the fa_re2nfa --label=char syntax, the output line is the input\n\
+line followed by a tab and 1 if the whole text matches or 0 if it does not.\n\
+\n\
+  --in=<input-file>  - reads input from the <input-file>,\n\
+    if omited stdin is used\n\
+\n\
+  --out=<output-file> - writes output to the <output-file>,\n\
+    if omited stdout is used\n\
+\n\
+  --max-count=N - the maximum number of cached automata, 128 by default\n\
+\n\
+  --max-states=N - the maximum number of DFA states of one pattern,\n\
+    10000 by default\n\
+\n\
+  --max-nfa-states=N - the maximum number of NFA states of one pattern,\n\
+    not limited by default\n\
+\n\
+  --self-test - checks cache hits, misses, the eviction order, the limits\n\
+    and concurrent Get calls, prints the failed checks, does not read input\n\
+\n\
+  --threads=N - the number of threads for --self-test, 4 by default\n\
+\n\
+  --repeat=N - the number of Get calls per thread for --self-test,\n\
+    1000 by default\n\
+\n\
+";
+}
+
+
+void process_args (int& argc, char**& argv)
+{
+  for (; argc--; ++argv) {
+
+    if (!strcmp ("--help", *argv)) {
+      usage ();
+      exit (0);
+    }
+    if (0 == strncmp ("--in=", *argv, 5)) {
+      pInFile = &((*argv) [5]);
+      continue;
+    }
+    if (0 == strncmp ("--out=", *argv, 6)) {
+      pOutFile = &((*argv) [6]);
+      continue;
+    }
+    if (0 == strncmp ("--max-count=", *argv, 12)) {
+      g_max_count = atoi (&((*argv) [12]));
+      continue;
+    }
+    if (0 == strncmp ("--max-states=", *argv, 13)) {
+      g_max_states = atoi (&((*argv) [13]));
+      continue;
+    }
+    if (0 == strncmp ("--max-nfa-states=", *argv, 17)) {
+      g_max_nfa_states = atoi (&((*argv) [17]));
+      continue;
+    }
+    if (!strcmp ("--self-test", *argv)) {
+      g_self_test = true;
+      continue;
+    }
+    if (0 == strncmp ("--threads=", *argv, 10)) {
+      g_threads = atoi (&((*argv) [10]));
+      continue;
+    }
+    if (0 == strncmp ("--repeat=", *argv, 9)) {
+      g_repeat = atoi (&((*argv) [9]));
+      continue;
+    }
+  }
+}
+
+
+// follows the fa_re2nfa conventions, unknown symbols are tried as '.'
+const int GetDest (const FARSDfaCA * pDfa, const int State, const int Iw)
+{
+    const int Dst = pDfa->GetDest (State, Iw);
+
+    if (-1 == Dst && FAFsmConst::IW_ANY != Iw && \
+        FAFsmConst::IW_L_ANCHOR != Iw && FAFsmConst::IW_R_ANCHOR != Iw) {
+        return pDfa->GetDest (State, FAFsmConst::IW_ANY);
+    }
+    return Dst;
+}
+
+
+// returns true if the whole text matches, the anchors are optional
+const bool Match (const FARSDfaCA * pDfa, const std::string & text)
+{
+    DebugLogAssert (pDfa);
+
+    std::vector < int > chain (text.length () + 1);
+    int Size = 0;
+
+    if (!text.empty ()) {
+        Size = ::FAStrUtf8ToArray (text.c_str (), (int) text.length (), \
+            &(chain [0]), (int) chain.size ());
+        FAAssert (0 <= Size, FAMsg::IOError);
+    }
+
+    const int Initial = pDfa->GetInitial ();
+
+    for (int i = 0; i < 2; ++i) {
+
+        int State = Initial;
+
+        // try without and with the left anchor
+        if (1 == i) {
+            State = pDfa->GetDest (State, FAFsmConst::IW_L_ANCHOR);
+        }
+
+        for (int Pos = 0; Pos < Size && 0 <= State; ++Pos) {
+            State = GetDest (pDfa, State, chain [Pos]);
+        }
+
+        if (0 > State) {
+            continue;
+        }
+        if (pDfa->IsFinal (State)) {
+            return true;
+        }
+
+        State = pDfa->GetDest (State, FAFsmConst::IW_R_ANCHOR);
+
+        if (0 <= State && pDfa->IsFinal (State)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+std::shared_ptr < const FARSDfaCA > Get (
+        FARegexpCache * pCache,
+        const char * pRegexp
+    )
+{
+    return pCache->Get (pRegexp, (int) strlen (pRegexp));
+}
+
+
+// returns true if the compilation throws FAException with the message
+const bool Throws (
+        FARegexpCache * pCache,
+        const char * pRegexp,
+        const char * pErrMsg
+    )
+{
+    try {
+        Get (pCache, pRegexp);
+    } catch (const FAException & e) {
+        return NULL == pErrMsg || 0 == strcmp (pErrMsg, e.GetErrMsg ());
+    }
+    return false;
+}
+
+
+int g_failed = 0;
+
+void Check (const bool Res, const char * pName)
+{
+    if (!Res) {
+        std::cerr << "ERROR: Check \"" << pName << "\" failed in program " \
+            << __PROG__ << '\n';
+        g_failed++;
+    }
+}
+
+
+// patterns, texts and the expected results for the concurrent test
+struct FACase {
+    const char * m_pRegexp;
+    const char * m_pText;
+    bool m_Res;
+};
+
+const FACase g_cases [] = {
+    { "a+b", "aaab", true },
+    { "a+b", "ab b", false },
+    { "(ab)*c", "ababc", true },
+    { "(ab)*c", "abac", false },
+    { "^[0-9]+$", "2024", true },
+    { "^[0-9]+$", "20x4", false },
+    { "x<y+>z", "xyyz", true },
+    { "[^\\x20]+\\x20[^\\x20]+", "one two", true },
+    { "[^\\x20]+\\x20[^\\x20]+", "one  two", false },
+    { ".*ж.", "абвжг", true },
+    { ".*ж.", "абвгд", false },
+    { "(a|b)*abb", "babaabb", true },
+};
+
+const int g_case_count = sizeof (g_cases) / sizeof (g_cases [0]);
+
+
+void Worker (
+        FARegexpCache * pCache,
+        const int Seed,
+        std::vector < const FARSDfaCA * > * pLast,
+        int * pErrors,
+        std::exception_ptr * pError
+    )
+{
+    try {
+
+        unsigned int Rand = Seed + 1;
+
+        for (int i = 0; i < g_repeat; ++i) {
+
+            Rand = Rand * 1103515245 + 12345;
+            const int Idx = (Rand >> 16) % g_case_count;
+            const FACase & c = g_cases [Idx];
+
+            std::shared_ptr < const FARSDfaCA > pDfa = Get (pCache, c.m_pRegexp);
+
+            if (c.m_Res != Match (pDfa.get (), c.m_pText)) {
+                (*pErrors)++;
+            }
+
+            (*pLast) [Idx] = pDfa.get ();
+        }
+
+    } catch (...) {
+        *pError = std::current_exception ();
+    }
+}
+
+
+// runs g_threads workers, returns the total number of wrong results, pLast
+// keeps the last automaton each thread got for each case
+const int RunThreads (
+        FARegexpCache * pCache,
+        std::vector < std::vector < const FARSDfaCA * > > * pLast
+    )
+{
+    const int Threads = 1 < g_threads ? g_threads : 1;
+
+    pLast->assign (Threads, \
+        std::vector < const FARSDfaCA * > (g_case_count, NULL));
+
+    std::vector < int > errors (Threads, 0);
+    std::vector < std::exception_ptr > exceptions (Threads);
+    std::vector < std::thread > threads;
+
+    for (int t = 0; t < Threads; ++t) {
+        threads.push_back (std::thread (Worker, pCache, t, \
+            &((*pLast) [t]), &(errors [t]), &(exceptions [t])));
+    }
+    for (size_t t = 0; t < threads.size (); ++t) {
+        threads [t].join ();
+    }
+
+    int Errors = 0;
+
+    for (int t = 0; t < Threads; ++t) {
+        if (exceptions [t]) {
+            std::rethrow_exception (exceptions [t]);
+        }
+        Errors += errors [t];
+    }
+
+    return Errors;
+}
+
+
+void SelfTest ()
+{
+    // hits and misses
+    {
+        FARegexpCache cache (&g_alloc);
+
+        const FARSDfaCA * pA = Get (&cache, "a+b").get ();
+        const FARSDfaCA * pA2 = Get (&cache, "a+b").get ();
+        const FARSDfaCA * pB = Get (&cache, "(ab)*c").get ();
+
+        Check (pA == pA2, "a repeated pattern is a hit");
+        Check (pA != pB, "a new pattern is a miss");
+        Check (2 == cache.GetCount (), "hits are not added");
+
+        cache.Clear ();
+        Check (0 == cache.GetCount (), "Clear empties the cache");
+    }
+
+    // least recently used entries are evicted first
+    {
+        FARegexpCache cache (&g_alloc);
+        cache.SetMaxCount (2);
+
+        std::shared_ptr < const FARSDfaCA > pA = Get (&cache, "a+b");
+        std::shared_ptr < const FARSDfaCA > pB = Get (&cache, "(ab)*c");
+
+        // A becomes the most recently used, so C evicts B
+        Check (pA.get () == Get (&cache, "a+b").get (), "A is a hit");
+        std::shared_ptr < const FARSDfaCA > pC = Get (&cache, "x<y+>z");
+
+        Check (2 == cache.GetCount (), "the count is limited");
+        Check (pA.get () == Get (&cache, "a+b").get (), "A is not evicted");
+        Check (pC.get () == Get (&cache, "x<y+>z").get (), "C is not evicted");
+
+        // B is compiled again and evicts A, which was used before C
+        std::shared_ptr < const FARSDfaCA > pB2 = Get (&cache, "(ab)*c");
+
+        Check (pB.get () != pB2.get (), "B is evicted");
+        Check (pC.get () == Get (&cache, "x<y+>z").get (), "C is kept");
+        Check (pA.get () != Get (&cache, "a+b").get (), "A is evicted");
+
+        // evicted automata stay valid while held
+        Check (Match (pB.get (), "ababc") && !Match (pB.get (), "abc c"), \
+            "an evicted automaton works");
+
+        cache.SetMaxCount (1);
+        Check (1 == cache.GetCount (), "SetMaxCount evicts");
+    }
+
+    // limits and errors
+    {
+        FARegexpCache cache (&g_alloc);
+        cache.SetMaxStateCount (50);
+
+        // 2^7 DFA states
+        Check (Throws (&cache, "(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)", \
+            FAMsg::LimitIsExceeded), "the DFA limit");
+        Check (0 == cache.GetCount (), "failed patterns are not cached");
+
+        // many NFA states, few DFA states
+        const char * pWide = \
+            "(a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|"
+            "a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a|a)+";
+
+        Check (!Throws (&cache, pWide, NULL), \
+            "the DFA limit does not apply to NFA");
+
+        cache.Clear ();
+        cache.SetMaxNfaStateCount (50);
+
+        Check (Throws (&cache, pWide, FAMsg::LimitIsExceeded), \
+            "the NFA limit");
+    }
+
+    // every case matches as expected
+    {
+        FARegexpCache cache (&g_alloc);
+
+        for (int i = 0; i < g_case_count; ++i) {
+            const FACase & c = g_cases [i];
+            const bool Res = Match (Get (&cache, c.m_pRegexp).get (), c.m_pText);
+            Check (c.m_Res == Res, c.m_pRegexp);
+        }
+    }
+
+    // concurrent Get with evictions
+    {
+        FARegexpCache cache (&g_alloc);
+        cache.SetMaxCount (3);
+
+        std::vector < std::vector < const FARSDfaCA * > > last;
+        const int Errors = RunThreads (&cache, &last);
+
+        Check (0 == Errors, "concurrent Get with evictions");
+        Check (3 >= cache.GetCount (), "concurrent Get keeps the limit");
+    }
+
+    // concurrent Get without evictions, all threads share the automata
+    {
+        FARegexpCache cache (&g_alloc);
+        cache.SetMaxCount (-1);
+
+        std::vector < std::vector < const FARSDfaCA * > > last;
+        const int Errors = RunThreads (&cache, &last);
+
+        Check (0 == Errors, "concurrent Get");
+
+        bool Same = true;
+
+        for (int i = 0; i < g_case_count; ++i) {
+
+            const FARSDfaCA * pDfa = NULL;
+
+            for (size_t t = 0; t < last.size (); ++t) {
+
+                if (NULL == last [t][i]) {
+                    continue;
+                }
+                if (NULL == pDfa) {
+                    pDfa = last [t][i];
+                } else if (pDfa != last [t][i]) {
+                    Same = false;
+                }
+            }
+        }
+
+        Check (Same, "concurrent Get returns the cached automaton");
+    }
+}
+
+
+int __cdecl main (int argc, char ** argv)
+{
+    __PROG__ = argv [0];
+
+    --argc, ++argv;
+
+    ::FAIOSetup ();
+
+    // parse a command line
+    process_args (argc, argv);
+
+    try {
+
+        if (g_self_test) {
+
+            SelfTest ();
+
+            if (0 != g_failed) {
+                return 2;
+            }
+
+            return 0;
+        }
+
+        std::istream * pIs = &std::cin;
+        std::ifstream ifs;
+        std::ostream * pOs = &std::cout;
+        std::ofstream ofs;
+
+        if (NULL != pInFile) {
+            ifs.open (pInFile, std::ios::in);
+            FAAssertStream (&ifs, pInFile);
+            pIs = &ifs;
+        }
+        if (NULL != pOutFile) {
+            ofs.open (pOutFile, std::ios::out);
+            pOs = &ofs;
+        }
+        DebugLogAssert (pIs && pOs);
+
+        FARegexpCache cache (&g_alloc);
+
+        if (-2 != g_max_count) {
+            cache.SetMaxCount (g_max_count);
+        }
+        if (-2 != g_max_states) {
+            cache.SetMaxStateCount (g_max_states);
+        }
+        if (-2 != g_max_nfa_states) {
+            cache.SetMaxNfaStateCount (g_max_nfa_states);
+        }
+
+        std::string line;
+
+        while (std::getline (*pIs, line)) {
+
+            if (!line.empty () && '\r' == line [line.length () - 1]) {
+                line.erase (line.length () - 1);
+            }
+            if (line.empty ()) {
+                continue;
+            }
+
+            const size_t Tab = line.find ('\t');
+            FAAssert (std::string::npos != Tab && 0 < Tab, \
+                FAMsg::IOError);
+
+            const std::string re = line.substr (0, Tab);
+            const std::string text = line.substr (Tab + 1);
+
+            std::shared_ptr < const FARSDfaCA > pDfa = \
+                cache.Get (re.c_str (), (int) re.length ());
+
+            *pOs << line << '\t' << (Match (pDfa.get (), text) ? 1 : 0) << '\n';
+        }
+
+    } catch (const FAException & e) {
+
+        const char * const pErrMsg = e.GetErrMsg ();
+        const char * const pFile = e.GetSourceName ();
+        const int Line = e.GetSourceLine ();
+
+        std::cerr << "ERROR: " << pErrMsg << " in " << pFile \
+            << " at line " << Line << " in program " << __PROG__ << '\n';
+
+        return 2;
+
+    } catch (...) {
+
+        std::cerr << "ERROR: Unknown error in program " << __PROG__ << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,426 @@
+/**
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+
+#include "FAConfig.h"
+#include "FAAllocator.h"
+#include "FAUtils.h"
+#include "FAUtf8Utils.h"
+#include "FAImageDump.h"
+#include "FAScannerCompiler.h"
+#include "FAScanner_pack.h"
+#include "FAScannerTools_t.h"
+#include "FAException.h"
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+
+const char * __PROG__ = "";
+
+FAAllocator g_alloc;
+
+const char * pScannerFile = NULL;
+const char * pInFile = NULL;
+const char * pOutFile = NULL;
+const char * pBenchFile = NULL;
+
+int g_repeat = 1;
+
+
+void usage () {
+
+  std::cout << "\n\
+Usage: test_scanner [OPTION] [< text.utf8] [> matches.txt]\n\
+\n\
+This program finds matches of the patterns compiled by fa_pats2scanner,\n\
+every input line is scanned separately. The output line is the input line\n\
+followed by the matches:\n\
+  <PatId>:<From>-<To>[ <BrId>:<From>-<To>]*\n\
+separated by tabs, positions are 0-based inclusive UTF-32 offsets.\n\
+\n\
+  --scanner=<input-file> - the scanner image, memory mapped\n\
+\n\
+  --in=<input-file>  - reads input from the <input-file>,\n\
+    if omited stdin is used\n\
+\n\
+  --out=<output-file> - writes output to the <output-file>,\n\
+    if omited stdout is used\n\
+\n\
+  --bench=<patterns-file> - the patterns the scanner was built from, compiles\n\
+    every pattern into a separate scanner, compares the time of the union\n\
+    scan to the time of scanning the patterns one at a time and checks that\n\
+    the results are the same, prints statistics instead of the matches\n\
+\n\
+  --repeat=N - scans the input N times, used with --bench, 1 by default\n\
+\n\
+";
+}
+
+
+void process_args (int& argc, char**& argv)
+{
+  for (; argc--; ++argv) {
+
+    if (!strcmp ("--help", *argv)) {
+      usage ();
+      exit (0);
+    }
+    if (0 == strncmp ("--scanner=", *argv, 10)) {
+      pScannerFile = &((*argv) [10]);
+      continue;
+    }
+    if (0 == strncmp ("--in=", *argv, 5)) {
+      pInFile = &((*argv) [5]);
+      continue;
+    }
+    if (0 == strncmp ("--out=", *argv, 6)) {
+      pOutFile = &((*argv) [6]);
+      continue;
+    }
+    if (0 == strncmp ("--bench=", *argv, 8)) {
+      pBenchFile = &((*argv) [8]);
+      continue;
+    }
+    if (0 == strncmp ("--repeat=", *argv, 9)) {
+      g_repeat = atoi (&((*argv) [9]));
+      continue;
+    }
+  }
+}
+
+
+// scans the text, returns the matches
+void Scan (
+        FAScannerTools_t < int > * pTools,
+        const std::vector < int > & text,
+        std::vector < int > * pMatches
+    )
+{
+    DebugLogAssert (pTools && pMatches);
+
+    const int InSize = (int) text.size ();
+    const int * pIn = text.empty () ? NULL : &(text [0]);
+
+    int MaxOutSize = (int) pMatches->capacity ();
+    pMatches->resize (MaxOutSize);
+
+    int OutSize = pTools->Process (pIn, InSize, \
+        MaxOutSize ? &((*pMatches) [0]) : NULL, MaxOutSize);
+
+    if (OutSize > MaxOutSize) {
+        pMatches->resize (OutSize);
+        OutSize = pTools->Process (pIn, InSize, &((*pMatches) [0]), OutSize);
+    }
+
+    pMatches->resize (OutSize);
+}
+
+
+// merges matches found one pattern at a time into the union scan order
+void Merge (
+        const std::vector < std::vector < int > > & pat2matches,
+        std::vector < int > * pMatches
+    )
+{
+    DebugLogAssert (pMatches);
+
+    const int PatCount = (int) pat2matches.size ();
+    std::vector < size_t > pat2pos (PatCount, 0);
+
+    pMatches->clear ();
+
+    while (true) {
+
+        // find the leftmost match, the smallest pattern id goes first
+        int BestPat = -1;
+        int BestFrom = -1;
+
+        for (int PatId = 0; PatId < PatCount; ++PatId) {
+
+            const std::vector < int > & m = pat2matches [PatId];
+            const size_t Pos = pat2pos [PatId];
+
+            if (Pos < m.size () && (-1 == BestPat || m [Pos + 1] < BestFrom)) {
+                BestPat = PatId;
+                BestFrom = m [Pos + 1];
+            }
+        }
+        if (-1 == BestPat) {
+            break;
+        }
+
+        const std::vector < int > & m = pat2matches [BestPat];
+        const size_t Pos = pat2pos [BestPat];
+        const size_t RecSize = 4 + (3 * m [Pos + 3]);
+
+        pMatches->push_back (BestPat);
+        pMatches->insert (pMatches->end (), m.begin () + Pos + 1, \
+            m.begin () + Pos + RecSize);
+
+        pat2pos [BestPat] += RecSize;
+    }
+}
+
+
+void PrintMatches (
+        std::ostream & os,
+        const std::string & line,
+        const std::vector < int > & matches
+    )
+{
+    os << line;
+
+    for (size_t i = 0; i < matches.size (); ) {
+
+        os << '\t' << matches [i] << ':' << matches [i + 1] << '-' \
+            << matches [i + 2];
+
+        const int BrCount = matches [i + 3];
+        i += 4;
+
+        for (int j = 0; j < BrCount; ++j, i += 3) {
+            os << ' ' << matches [i] << ':' << matches [i + 1] << '-' \
+                << matches [i + 2];
+        }
+    }
+
+    os << '\n';
+}
+
+
+// reads patterns and compiles every pattern into a separate scanner
+void LoadSeparate (
+        const char * pFileName,
+        std::vector < std::vector < unsigned char > > * pDumps
+    )
+{
+    DebugLogAssert (pFileName && pDumps);
+
+    std::ifstream ifs (pFileName, std::ios::in);
+    FAAssertStream (&ifs, pFileName);
+
+    std::string line;
+
+    while (std::getline (ifs, line)) {
+
+        if (!line.empty () && '\r' == line [line.length () - 1]) {
+            line.erase (line.length () - 1);
+        }
+        if (line.empty ()) {
+            continue;
+        }
+
+        FAScannerCompiler pat2scanner (&g_alloc);
+
+        pat2scanner.AddPattern (line.c_str (), (int) line.length ());
+        pat2scanner.Process ();
+
+        const unsigned char * pDump = NULL;
+        const int DumpSize = pat2scanner.GetDump (&pDump);
+
+        pDumps->push_back (std::vector < unsigned char > (pDump, pDump + DumpSize));
+    }
+}
+
+
+int __cdecl main (int argc, char ** argv)
+{
+    __PROG__ = argv [0];
+
+    --argc, ++argv;
+
+    ::FAIOSetup ();
+
+    // parse a command line
+    process_args (argc, argv);
+
+    try {
+
+        std::istream * pIs = &std::cin;
+        std::ifstream ifs;
+        std::ostream * pOs = &std::cout;
+        std::ofstream ofs;
+
+        if (NULL != pInFile) {
+            ifs.open (pInFile, std::ios::in);
+            FAAssertStream (&ifs, pInFile);
+            pIs = &ifs;
+        }
+        if (NULL != pOutFile) {
+            ofs.open (pOutFile, std::ios::out);
+            pOs = &ofs;
+        }
+        DebugLogAssert (pIs && pOs);
+
+        FAAssert (pScannerFile, FAMsg::InvalidParameters);
+
+        FAImageDump image;
+        image.Load (pScannerFile, true);
+
+        FAScanner_pack scanner;
+        scanner.SetImage (image.GetImageDump ());
+
+        FAScannerTools_t < int > scanner_tools (&g_alloc);
+        scanner_tools.SetScanner (&scanner);
+
+        // read the input
+        std::vector < std::string > lines;
+        std::vector < std::vector < int > > texts;
+        std::string line;
+
+        while (std::getline (*pIs, line)) {
+
+            if (!line.empty () && '\r' == line [line.length () - 1]) {
+                line.erase (line.length () - 1);
+            }
+
+            std::vector < int > text (line.length () + 1);
+            int Size = 0;
+
+            if (!line.empty ()) {
+                Size = ::FAStrUtf8ToArray (line.c_str (), (int) line.length (), \
+                    &(text [0]), (int) text.size ());
+                if (0 > Size) {
+                    std::cerr << "ERROR: Invalid UTF-8 at line " \
+                        << (lines.size () + 1) << " in program " << __PROG__ \
+                        << '\n';
+                    return 2;
+                }
+            }
+            text.resize (Size);
+
+            lines.push_back (line);
+            texts.push_back (text);
+        }
+
+        std::vector < int > matches;
+        matches.reserve (1024);
+
+        if (NULL == pBenchFile) {
+
+            for (size_t i = 0; i < texts.size (); ++i) {
+                Scan (&scanner_tools, texts [i], &matches);
+                PrintMatches (*pOs, lines [i], matches);
+            }
+
+            return 0;
+        }
+
+        // build scanners for the patterns one at a time
+        std::vector < std::vector < unsigned char > > dumps;
+        LoadSeparate (pBenchFile, &dumps);
+
+        const int PatCount = (int) dumps.size ();
+        FAAssert (PatCount == scanner.GetPatternCount (), \
+            FAMsg::InvalidParameters);
+
+        std::vector < FAScanner_pack > pat2scanner (PatCount);
+        std::vector < FAScannerTools_t < int > * > pat2tools (PatCount);
+
+        for (int PatId = 0; PatId < PatCount; ++PatId) {
+            pat2scanner [PatId].SetImage (&(dumps [PatId][0]));
+            pat2tools [PatId] = NEW FAScannerTools_t < int > (&g_alloc);
+            pat2tools [PatId]->SetScanner (&(pat2scanner [PatId]));
+        }
+
+        std::vector < std::vector < int > > pat2matches (PatCount);
+        for (int PatId = 0; PatId < PatCount; ++PatId) {
+            pat2matches [PatId].reserve (1024);
+        }
+        std::vector < int > merged;
+
+        size_t Symbols = 0;
+        size_t MatchCount = 0;
+        size_t Mismatches = 0;
+        double UnionTime = 0;
+        double OneAtATimeTime = 0;
+
+        for (int r = 0; r < g_repeat; ++r) {
+
+            for (size_t i = 0; i < texts.size (); ++i) {
+
+                std::chrono::steady_clock::time_point t0 = \
+                    std::chrono::steady_clock::now ();
+
+                Scan (&scanner_tools, texts [i], &matches);
+
+                std::chrono::steady_clock::time_point t1 = \
+                    std::chrono::steady_clock::now ();
+
+                for (int PatId = 0; PatId < PatCount; ++PatId) {
+                    Scan (pat2tools [PatId], texts [i], &(pat2matches [PatId]));
+                }
+
+                std::chrono::steady_clock::time_point t2 = \
+                    std::chrono::steady_clock::now ();
+
+                UnionTime += \
+                    std::chrono::duration < double > (t1 - t0).count ();
+                OneAtATimeTime += \
+                    std::chrono::duration < double > (t2 - t1).count ();
+
+                Merge (pat2matches, &merged);
+
+                if (0 == r) {
+
+                    Symbols += texts [i].size ();
+
+                    for (size_t j = 0; j < matches.size (); \
+                         j += 4 + (3 * matches [j + 3])) {
+                        MatchCount++;
+                    }
+                    if (merged != matches) {
+                        Mismatches++;
+                        std::cerr << "ERROR: Results differ at line " \
+                            << (i + 1) << '\n';
+                        PrintMatches (std::cerr, lines [i], matches);
+                        PrintMatches (std::cerr, lines [i], merged);
+                    }
+                }
+            }
+        }
+
+        const double MB = double (Symbols) * g_repeat / (1024.0 * 1024.0);
+
+        (*pOs) << "patterns: " << PatCount << '\n' \
+            << "lines: " << texts.size () << '\n' \
+            << "symbols: " << Symbols << '\n' \
+            << "matches: " << MatchCount << '\n' \
+            << "mismatches: " << Mismatches << '\n' \
+            << "union, sec: " << UnionTime << ", Msymbols/sec: " \
+            << (0 < UnionTime ? MB / UnionTime : 0) << '\n' \
+            << "one at a time, sec: " << OneAtATimeTime << ", Msymbols/sec: " \
+            << (0 < OneAtATimeTime ? MB / OneAtATimeTime : 0) << '\n';
+
+        for (int PatId = 0; PatId < PatCount; ++PatId) {
+            delete pat2tools [PatId];
+        }
+
+        if (0 != Mismatches) {
+            return 2;
+        }
+
+    } catch (const FAException & e) {
+
+        const char * const pErrMsg = e.GetErrMsg ();
+        const char * const pFile = e.GetSourceName ();
+        const int Line = e.GetSourceLine ();
+
+        std::cerr << "ERROR: " << pErrMsg << " in " << pFile \
+            << " at line " << Line << " in program " << __PROG__ << '\n';
+
+        return 2;
+
+    } catch (...) {
+
+        std::cerr << "ERROR: Unknown error in program " << __PROG__ << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -7,6 +7,9 @@
 # 2. Auto-test   Makefile.gnu lang=<lang> [ mode=<mode> ] test
 # 3. Performance Makefile.gnu lang=<lang> [ mode=<mode> ] perf
 #
+# fa_build_ldb lang=<lang> [ mode=<mode> ] [ --threads=N ] does the same as 1.
+# in parallel, it reads the variables and the rules below.
+#
 
 mode   = small
 lang   = english
@@ -358,7 +361,8 @@ $(tmpdir)/tag.dict.i2t.txt: $(srcdir)/tag.dict.tagset.txt \
 $(tmpdir)/w2h.file.utf8: $(W2H_DICT)
 	$(cat_w2h_dict) > $(tmpdir)/w2h.file.utf8
 
-$(tmpdir)/w2h.pats.utf8: $(tmpdir)/w2h.file.utf8
+$(tmpdir)/w2h.pats.utf8 \
+$(tmpdir)/w2h.acts.txt: $(tmpdir)/w2h.file.utf8
 	fa_build_pats $(opt_dict2pats) $(opt_dict2pats_w2h) \
 	  --in=$(tmpdir)/w2h.file.utf8  \
 	  --out=$(tmpdir)/w2h.pats.utf8 \
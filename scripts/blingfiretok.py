@@ -58,6 +58,188 @@ def text_to_words(s):
     return o_bytes.value.decode('utf-8')
 
 
+# same as text_to_words, but returns at most max_words words, only the beginning of the text needed for them
+# is processed, returns the words and the byte offset in the UTF-8 text right after the last returned word
+def text_to_words_with_limit(s, max_words):
+    return _call_with_limit(blingfire.TextToWordsWithLimit, s, max_words)
+
+
+# same as text_to_sentences, but returns at most max_sentences sentences, only the beginning of the text needed
+# for them is processed, returns the sentences and the byte offset in the UTF-8 text right after the last one
+def text_to_sentences_with_limit(s, max_sentences):
+    return _call_with_limit(blingfire.TextToSentencesWithLimit, s, max_sentences)
+
+
+def _call_with_limit(func, s, max_count):
+
+    # get the UTF-8 bytes
+    s_bytes = s.encode("utf-8")
+
+    # allocate the output buffer
+    o_bytes = create_string_buffer(len(s_bytes) * 2)
+    o_bytes_count = len(o_bytes)
+    stop_offset = c_int(0)
+
+    o_len = func(c_char_p(s_bytes), c_int(len(s_bytes)), byref(o_bytes), None, None, c_int(o_bytes_count), \
+        c_int(max_count), byref(stop_offset))
+
+    # check if no error has happened
+    if -1 == o_len or o_len > o_bytes_count:
+        return '', 0
+
+    return o_bytes.value.decode('utf-8'), stop_offset.value
+
+
+# returns the number of words in the text, counts at most max_words words if max_words is positive,
+# and the byte offset in the UTF-8 text right after the last counted word, -1 in case of an error
+def text_to_words_count(s, max_words = 0):
+    s_bytes = s.encode("utf-8")
+    stop_offset = c_int(0)
+    count = blingfire.TextToWordsCount(c_char_p(s_bytes), c_int(len(s_bytes)), c_int(max_words), byref(stop_offset))
+    return count, stop_offset.value
+
+
+# returns the number of sentences in the text, counts at most max_sentences sentences if max_sentences is positive,
+# and the byte offset in the UTF-8 text right after the last counted sentence, -1 in case of an error
+def text_to_sentences_count(s, max_sentences = 0):
+    s_bytes = s.encode("utf-8")
+    stop_offset = c_int(0)
+    count = blingfire.TextToSentencesCount(c_char_p(s_bytes), c_int(len(s_bytes)), c_int(max_sentences), byref(stop_offset))
+    return count, stop_offset.value
+
+
+# callback type of the streaming functions: (context, chunk pointer, chunk element count) -> 0 to continue
+STREAM_CALLBACK = CFUNCTYPE(c_int, c_void_p, c_void_p, c_int)
+
+
+# calls one of the *Stream functions, returns the list of received chunks and the element count
+def _call_stream(func, s_bytes, chunk_type, *args):
+    chunks = []
+
+    def on_chunk(ctx, p_chunk, count):
+        chunks.append(string_at(p_chunk, count * sizeof(chunk_type)))
+        return 0
+
+    # keep the callback object alive for the duration of the call
+    callback = STREAM_CALLBACK(on_chunk)
+    o_len = func(c_char_p(s_bytes), c_int(len(s_bytes)), callback, None, *args)
+
+    return chunks, o_len
+
+
+# same as text_to_words, but the output is received in chunks, so no buffer size guessing is needed
+def text_to_words_stream(s):
+    chunks, o_len = _call_stream(blingfire.TextToWordsStream, s.encode("utf-8"), c_char)
+    if -1 == o_len:
+        return ''
+    return b''.join(chunks).decode('utf-8')
+
+
+# same as text_to_sentences, but the output is received in chunks, so no buffer size guessing is needed
+def text_to_sentences_stream(s):
+    chunks, o_len = _call_stream(blingfire.TextToSentencesStream, s.encode("utf-8"), c_char)
+    if -1 == o_len:
+        return ''
+    return b''.join(chunks).decode('utf-8')
+
+
+# same as text_to_hashes_ex, but the output is received in chunks, so no buffer size guessing is needed
+def text_to_hashes_stream(s, word_n_grams, minn, maxn, bucketSize):
+    chunks, o_len = _call_stream(blingfire.TextToHashesStream, s.encode("utf-8"), c_int32, \
+        c_int(word_n_grams), c_int(minn), c_int(maxn), c_int(bucketSize))
+    if -1 == o_len:
+        return ''
+    return np.frombuffer(b''.join(chunks), dtype=c_int32, count = o_len)
+
+
+# returns the MinHash signature of the text as a numpy uint64 array of k values, computed over the shingles
+# of shingle consecutive words, seeds is an optional array of k uint64 seeds of the hash permutations
+def text_to_minhash(s, k, shingle = 3, seeds = None):
+    s_bytes = s.encode("utf-8")
+    signature = (c_uint64 * k)()
+    p_seeds = None
+    if seeds is not None:
+        seeds = np.ascontiguousarray(seeds, dtype = np.uint64)
+        if len(seeds) != k:
+            return None
+        p_seeds = seeds.ctypes.data_as(POINTER(c_uint64))
+    count = blingfire.TextToMinHash(c_char_p(s_bytes), c_int(len(s_bytes)), c_int(k), c_int(shingle), p_seeds, signature)
+    if -1 == count:
+        return None
+    return np.frombuffer(signature, dtype = np.uint64, count = k)
+
+
+# returns the 64-bit SimHash of the text computed over the shingles of shingle consecutive words
+def text_to_simhash(s, shingle = 3):
+    s_bytes = s.encode("utf-8")
+    simhash = c_uint64(0)
+    count = blingfire.TextToSimHash(c_char_p(s_bytes), c_int(len(s_bytes)), c_int(shingle), byref(simhash))
+    if -1 == count:
+        return None
+    return simhash.value
+
+
+# Arrow C Data Interface structures, see https://arrow.apache.org/docs/format/CDataInterface.html
+class ArrowSchema(Structure):
+    _fields_ = [("format", c_char_p), ("name", c_char_p), ("metadata", c_char_p), ("flags", c_int64), \
+        ("n_children", c_int64), ("children", c_void_p), ("dictionary", c_void_p), ("release", c_void_p), \
+        ("private_data", c_void_p)]
+
+
+class ArrowArray(Structure):
+    _fields_ = [("length", c_int64), ("null_count", c_int64), ("offset", c_int64), ("n_buffers", c_int64), \
+        ("n_children", c_int64), ("buffers", c_void_p), ("children", c_void_p), ("dictionary", c_void_p), \
+        ("release", c_void_p), ("private_data", c_void_p)]
+
+
+# TextToWordsArrow flags
+FA_ARROW_WORDS_TEXT = 1
+
+# the inputs of TextToWordsArrow referenced by the returned arrays, context -> input
+ARROW_INPUT_CALLBACK = CFUNCTYPE(None, c_void_p)
+_arrow_inputs = {}
+_arrow_input_count = [0]
+
+def _on_arrow_input_released(ctx):
+    _arrow_inputs.pop(ctx, None)
+
+_arrow_input_callback = ARROW_INPUT_CALLBACK(_on_arrow_input_released)
+
+
+# splits a list of documents (or a pyarrow string array) into words, returns a pyarrow.RecordBatch with
+# "start" and "end" list<int32> columns of the UTF-8 byte offsets of the first and the last byte of each word,
+# and the "text" list<string_view> column, if with_text is True, the words are not copied but point into the input,
+# null documents are treated as empty ones
+def text_to_words_arrow(docs, with_text = False):
+    import pyarrow as pa
+
+    if not isinstance(docs, pa.Array):
+        docs = pa.array(docs, type = pa.string())
+    if docs.type == pa.large_string() or docs.type == pa.string_view():
+        docs = docs.cast(pa.string())
+
+    # use the string array buffers as is, keep the array while the output refers to it
+    _, offsets_buff, data_buff = docs.buffers()
+    p_offsets = offsets_buff.address + (docs.offset * sizeof(c_int32))
+    p_data = data_buff.address if data_buff is not None else None
+
+    _arrow_input_count[0] += 1
+    ctx = _arrow_input_count[0]
+    _arrow_inputs[ctx] = docs
+
+    schema = ArrowSchema()
+    array = ArrowArray()
+    flags = FA_ARROW_WORDS_TEXT if with_text else 0
+
+    count = blingfire.TextToWordsArrow(c_void_p(p_data), c_void_p(p_offsets), c_int(len(docs)), c_int(flags), \
+        _arrow_input_callback, c_void_p(ctx), byref(schema), byref(array))
+    if -1 == count:
+        _arrow_inputs.pop(ctx, None)
+        return None
+
+    return pa.RecordBatch._import_from_c(addressof(array), addressof(schema))
+
+
 # returns the current version of the DLL's algo
 def get_blingfiretok_version():
     return blingfire.GetBlingFireTokVersion()
@@ -82,3 +264,163 @@ def text_to_hashes(s, word_n_grams, bucketSize):
     # return numpy array without copying
     return np.frombuffer(o_bytes, dtype=c_uint32, count = o_len)
 
+
+def text_to_hashes_ex(s, word_n_grams, minn, maxn, bucketSize):
+    # get the UTF-8 bytes
+    s_bytes = s.encode("utf-8")
+
+    # allocate the output buffer, call again with a bigger one if needed
+    o_bytes_count = 2 * len(s_bytes)
+    while True:
+        o_bytes = (c_int32 * o_bytes_count)()
+        o_len = blingfire.TextToHashesEx(c_char_p(s_bytes), c_int(len(s_bytes)), byref(o_bytes), c_int(o_bytes_count), c_int(word_n_grams), c_int(minn), c_int(maxn), c_int(bucketSize))
+        if o_len <= o_bytes_count:
+            break
+        o_bytes_count = o_len
+
+    # check if no error has happened
+    if -1 == o_len:
+        return ''
+
+    # return numpy array without copying
+    return np.frombuffer(o_bytes, dtype=c_int32, count = o_len)
+
+
+# loads a model from the LDB file, returns the model handle
+def load_model(file_name):
+    blingfire.LoadModel.restype = c_void_p
+    return blingfire.LoadModel(c_char_p(file_name.encode('utf-8')))
+
+
+# initializes the built-in models upfront, prefault=True also touches all their memory pages
+def initialize(prefault=False):
+    return blingfire.InitializeBlingFire(c_int(1 if prefault else 0))
+
+
+# loads a model which can be replaced with reload_model while in use
+def load_reloadable_model(file_name):
+    blingfire.LoadReloadableModel.restype = c_void_p
+    return blingfire.LoadReloadableModel(c_char_p(file_name.encode('utf-8')))
+
+
+# replaces the model loaded by load_reloadable_model, returns 0 on success
+def reload_model(h, file_name):
+    return blingfire.ReloadModel(c_void_p(h), c_char_p(file_name.encode('utf-8')))
+
+
+# frees the model loaded by load_model or load_reloadable_model
+def free_model(h):
+    return blingfire.FreeModel(c_void_p(h))
+
+
+# attaches the vocabulary of the delta model to the model, None detaches it
+def set_model_delta(h, h_delta):
+    return blingfire.SetModelDelta(c_void_p(h), c_void_p(h_delta))
+
+
+# Returns numpy array of int32 subword ids, upto max_len ids
+def text_to_ids(h, s, max_len):
+    # get the UTF-8 bytes
+    s_bytes = s.encode("utf-8")
+
+    # allocate the output buffer
+    o_ids = (c_int32 * max_len)()
+
+    # get the ids
+    o_len = blingfire.TextToIds(c_void_p(h), c_char_p(s_bytes), c_int(len(s_bytes)), byref(o_ids), c_int(max_len))
+
+    # check if no error has happened
+    if -1 == o_len:
+        return ''
+
+    # return numpy array without copying
+    return np.frombuffer(o_ids, dtype=c_int32, count = o_len)
+
+
+# returns the words of the text and their POS tag ids
+def text_to_tagged_words(h, s):
+    # get the UTF-8 bytes
+    s_bytes = s.encode("utf-8")
+
+    # allocate the output buffers, there cannot be more words than bytes
+    max_len = len(s_bytes)
+    o_tags = (c_int32 * max_len)()
+    o_starts = (c_int * max_len)()
+    o_ends = (c_int * max_len)()
+
+    # get the words and tags
+    o_len = blingfire.TextToTaggedWords(c_void_p(h), c_char_p(s_bytes), c_int(len(s_bytes)), byref(o_tags), byref(o_starts), byref(o_ends), c_int(max_len))
+
+    # check if no error has happened
+    if -1 == o_len or o_len > max_len:
+        return []
+
+    return [(s_bytes[o_starts[i]:o_ends[i] + 1].decode("utf-8"), o_tags[i]) for i in range(o_len)]
+
+
+# returns the words and the multi-word expressions of the text with their phrase ids, -1 for a single word
+def text_to_phrases(h, s):
+    # get the UTF-8 bytes
+    s_bytes = s.encode("utf-8")
+
+    # allocate the output buffers, there cannot be more spans than bytes
+    max_len = len(s_bytes)
+    o_ids = (c_int32 * max_len)()
+    o_starts = (c_int * max_len)()
+    o_ends = (c_int * max_len)()
+
+    # get the spans
+    o_len = blingfire.TextToPhrases(c_void_p(h), c_char_p(s_bytes), c_int(len(s_bytes)), byref(o_ids), byref(o_starts), byref(o_ends), c_int(max_len))
+
+    # check if no error has happened
+    if -1 == o_len or o_len > max_len:
+        return []
+
+    return [(s_bytes[o_starts[i]:o_ends[i] + 1].decode("utf-8"), o_ids[i]) for i in range(o_len)]
+
+
+# the same as text_to_phrases but for a list of documents in one call
+def text_to_phrases_batch(h, docs):
+    # get the UTF-8 bytes and the document offsets
+    docs_bytes = [d.encode("utf-8") for d in docs]
+    doc_count = len(docs_bytes)
+    o_doc_offsets = (c_int * (doc_count + 1))()
+    for i in range(doc_count):
+        o_doc_offsets[i + 1] = o_doc_offsets[i] + len(docs_bytes[i])
+    s_bytes = b''.join(docs_bytes)
+
+    # allocate the output buffers, there cannot be more spans than bytes
+    max_len = len(s_bytes)
+    o_span_offsets = (c_int * (doc_count + 1))()
+    o_ids = (c_int32 * max_len)()
+    o_starts = (c_int * max_len)()
+    o_ends = (c_int * max_len)()
+
+    o_len = blingfire.TextToPhrasesBatch(c_void_p(h), c_char_p(s_bytes), byref(o_doc_offsets), c_int(doc_count), byref(o_span_offsets), byref(o_ids), byref(o_starts), byref(o_ends), c_int(max_len))
+
+    # check if no error has happened
+    if -1 == o_len or o_len > max_len:
+        return []
+
+    return [[(docs_bytes[d][o_starts[i]:o_ends[i] + 1].decode("utf-8"), o_ids[i]) for i in range(o_span_offsets[d], o_span_offsets[d + 1])] for d in range(doc_count)]
+
+
+# returns the vocabulary words within max_dist (0, 1 or 2) edits from the word as (word, id, distance), the closest first
+def fuzzy_lookup(h, word, max_dist = 1, max_count = 10):
+    # get the UTF-8 bytes
+    s_bytes = word.encode("utf-8")
+
+    # allocate the output buffers, a result has at most max_dist more characters than the word
+    o_ids = (c_int32 * max_count)()
+    o_dists = (c_int * max_count)()
+    max_out_len = max_count * (4 * (len(s_bytes) + max_dist) + 1) + 1
+    o_words = create_string_buffer(max_out_len)
+
+    o_len = blingfire.FuzzyLookup(c_void_p(h), c_char_p(s_bytes), c_int(len(s_bytes)), c_int(max_dist), byref(o_ids), byref(o_dists), o_words, c_int(max_out_len), c_int(max_count))
+
+    # check if no error has happened
+    if -1 == o_len or o_len > max_count:
+        return []
+
+    words = o_words.value.decode("utf-8").split(' ')
+    return [(words[i], o_ids[i], o_dists[i]) for i in range(o_len)]
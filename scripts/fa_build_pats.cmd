@@ -56,6 +56,9 @@ format:  a[XX]b[YY]...c[ZZ], where a,b,c - are non-empty input strings and
   --take-all-pats - takes all patterns, skips the stage of calculating a subset
     this key should be used to improve recall on unknown words
 
+  --threads=N - extracts and selects patterns in N threads with fa_hyph2pats
+    and fa_pats_select --threads=N, the result does not depend on N
+
   --verbose - prints additional information during the compilation
 EOM
 
@@ -78,6 +81,7 @@ $dont_care = "" ;
 $max_context = "" ;
 $format = "--format=dump" ;
 $take_all_pats = "";
+$threads = "" ;
 $verbose = "" ;
 
 
@@ -157,6 +161,10 @@ while (0 < 1 + $#ARGV) {
 
         $take_all_pats = $ARGV [0] ;
 
+    } elsif ($ARGV [0] =~ /^--threads=./) {
+
+        $threads = $ARGV [0];
+
     } elsif ($ARGV [0] =~ /^-.*/) {
 
         print STDERR "ERROR: Unknown parameter $$ARGV[0], see fa_build_pats --help";
@@ -192,6 +200,12 @@ $command = "".
   "sort | uniq -c | ".
   "fa_iwowsuff2pats $min_len $min_prec $min_freq $no_empty $dont_care $max_context --out=$tmp4 ";
 
+if ($threads ne "") {
+  $command = "".
+    "fa_hyph2pats --in=$input $min_len $max_len $left_achor $right_achor $ignore_case ".
+    "$min_prec $min_freq $no_empty $dont_care $max_context $threads --out=$tmp4 ";
+}
+
 `$command` ;
 
 if ($verbose eq "--verbose") {
@@ -224,7 +238,7 @@ if ($verbose eq "--verbose") {
 #
 # Remove redundancies and print out unsolved entries, if asked
 #
-`fa_pats_select $format $no_empty --in=$input --fsm=$tmp1 --k2i=$tmp2 --i2info=$tmp3 $left_achor $right_achor $ignore_case $out_unsolved $take_all_pats $output` ;
+`fa_pats_select $format $no_empty --in=$input --fsm=$tmp1 --k2i=$tmp2 --i2info=$tmp3 $left_achor $right_achor $ignore_case $out_unsolved $take_all_pats $threads $output` ;
 
 if ($verbose eq "--verbose") {
   print STDERR "\nfa_build_pats\tSubset has been extracted and validated.\n" ;